@@ -43,6 +43,7 @@ namespace prox_cmd
     bool          m_save_contact_data;
     
     std::string   m_matlab_file;
+    std::string   m_trace_file;
     std::string   m_procedural_scene;
     std::string   m_xml_save_scene_file;
     std::string   m_xml_save_channel_file;
@@ -75,6 +76,7 @@ namespace prox_cmd
       m_save_contact_data        = false;
       
       m_matlab_file              = "out.m";
+      m_trace_file               = "";
       m_procedural_scene         = "wall";
       m_xml_save_channel_file    = "out_channels.xml";
       m_xml_save_scene_file      = "out_scene.xml";
@@ -120,6 +122,7 @@ namespace prox_cmd
       m_output_path            = m_config_file.get_value( "output_path",             ""                   );
       
       m_matlab_file            = m_config_file.get_value( "matlab_file",             "output.m"           );
+      m_trace_file             = m_config_file.get_value( "trace_file",              ""                   );
       m_procedural_scene       = m_config_file.get_value( "procedural_scene",        "wall"               );
       m_xml_save_scene_file    = m_config_file.get_value( "xml_save_scene_file",     "out_scene.xml"      );
       m_xml_save_channel_file  = m_config_file.get_value( "xml_save_channel_file",   "out_channels.xml"   );
@@ -265,6 +268,11 @@ namespace prox_cmd
         m_engine.write_matlab_profiling_data( m_output_path + m_matlab_file );
       }
       
+      if(!m_trace_file.empty())
+      {
+        m_engine.write_chrome_trace_data( m_output_path + m_trace_file );
+      }
+      
       if(m_xml_record)
       {
         save_xml_file();
@@ -7,7 +7,6 @@
 
 #include <tiny.h>
 
-#include <vector>
 #include <cassert>
 
 namespace geometry
@@ -34,10 +33,10 @@ namespace geometry
     };
 
 
-    std::vector<Triangle<V> >                trianglesA(4u);
-    std::vector<Triangle<V> >                trianglesB(4u);
-    std::vector<details::UnscaledPlane<V> >  planesA(4u);
-    std::vector<details::UnscaledPlane<V> >  planesB(4u);
+    Triangle<V>                trianglesA[4];
+    Triangle<V>                trianglesB[4];
+    details::UnscaledPlane<V>  planesA[4];
+    details::UnscaledPlane<V>  planesB[4];
 
     //--- Pre-computation ---- -------------------------------------------------
     for (unsigned int v =0u; v < 4u; ++v)
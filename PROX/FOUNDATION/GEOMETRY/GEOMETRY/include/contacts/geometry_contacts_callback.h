@@ -1,6 +1,8 @@
 #ifndef GEOMETRY_CONTACTS_CALLBACK_H
 #define GEOMETRY_CONTACTS_CALLBACK_H
 
+#include <cstddef>  // needed for size_t
+
 namespace geometry
 {
   
@@ -30,6 +32,20 @@ namespace geometry
                                   , V const & sA
                                   , V const & sB
                                  ) = 0;
+
+        /**
+         * Callback interface for telling which features the following contact
+         * points are generated from. Contact point generators that know
+         * nothing about features never call this.
+         *
+         * @param feature_a  The index of the feature on body A, e.g. a tetrahedron index.
+         * @param feature_b  The index of the feature on body B, e.g. a tetrahedron index.
+         */
+        virtual void set_features(
+                                  size_t const & /*feature_a*/
+                                  , size_t const & /*feature_b*/
+                                  )
+        {}
     };
   
 }//namespace geometry
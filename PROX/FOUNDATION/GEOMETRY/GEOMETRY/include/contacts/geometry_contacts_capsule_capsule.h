@@ -0,0 +1,187 @@
+#ifndef GEOMETRY_CONTACTS_CAPSULE_CAPSULE_H
+#define GEOMETRY_CONTACTS_CAPSULE_CAPSULE_H
+
+#include <contacts/geometry_contacts_callback.h>
+#include <contacts/geometry_contacts_sphere_sphere.h>
+#include <contacts/geometry_contacts_sphere_capsule.h>
+#include <types/geometry_capsule.h>
+
+#include <tiny_vector_functions.h>
+#include <tiny_precision.h>
+
+#include <algorithm>  // needed for std::min and std::max
+#include <cmath>      // needed for std::fabs
+
+namespace geometry
+{
+
+  namespace detail
+  {
+
+    /**
+     * Compute the closest points between two line segments.
+     *
+     * @param p0   The first end point of the first segment.
+     * @param p1   The second end point of the first segment.
+     * @param q0   The first end point of the second segment.
+     * @param q1   The second end point of the second segment.
+     * @param s    Upon return the parameter in [0..1] of the closest point p0 + (p1-p0)*s.
+     * @param t    Upon return the parameter in [0..1] of the closest point q0 + (q1-q0)*t.
+     */
+    template<typename V>
+    inline void closest_points_segment_segment(
+                                               V const & p0
+                                               , V const & p1
+                                               , V const & q0
+                                               , V const & q1
+                                               , typename V::real_type & s
+                                               , typename V::real_type & t
+                                               )
+    {
+      using std::min;
+      using std::max;
+
+      typedef typename V::real_type    T;
+      typedef typename V::value_traits VT;
+
+      T const epsilon = tiny::working_precision<T>();
+
+      V const u = p1 - p0;
+      V const v = q1 - q0;
+      V const r = p0 - q0;
+
+      T const a = tiny::inner_prod( u, u );
+      T const e = tiny::inner_prod( v, v );
+      T const f = tiny::inner_prod( v, r );
+
+      s = VT::zero();
+      t = VT::zero();
+
+      if( a <= epsilon && e <= epsilon )
+        return;
+
+      if( a <= epsilon )
+      {
+        t = max( VT::zero(), min( VT::one(), f / e ) );
+        return;
+      }
+
+      T const c = tiny::inner_prod( u, r );
+
+      if( e <= epsilon )
+      {
+        s = max( VT::zero(), min( VT::one(), -c / a ) );
+        return;
+      }
+
+      T const b     = tiny::inner_prod( u, v );
+      T const denom = a*e - b*b;
+
+      // Parallel segments have no unique solution, start from p0 then
+      if( denom > epsilon )
+        s = max( VT::zero(), min( VT::one(), (b*f - c*e) / denom ) );
+
+      t = (b*s + f) / e;
+
+      if( t < VT::zero() )
+      {
+        t = VT::zero();
+        s = max( VT::zero(), min( VT::one(), -c / a ) );
+      }
+      else if( t > VT::one() )
+      {
+        t = VT::one();
+        s = max( VT::zero(), min( VT::one(), (b - c) / a ) );
+      }
+    }
+
+  }// namespace detail
+
+  /**
+   * Closed form contact generation between two capsules.
+   *
+   * A single contact is generated at the closest points of the two core
+   * segments. When the segments are (close to) parallel and overlap along
+   * their length, e.g. two capsules lying side by side, a contact is
+   * generated at each end of the overlapping part instead, so the pair
+   * can rest stably against each other.
+   *
+   * The contact normal points from A towards B and the reported distance
+   * is negative when the capsules overlap.
+   *
+   * @param A          The first capsule.
+   * @param B          The second capsule.
+   * @param envelope   Contacts are reported when the capsules are closer than this.
+   * @param callback   The callback used to report the contacts.
+   *
+   * @return           True if any contacts were reported.
+   */
+  template<typename V>
+  inline bool contacts_capsule_capsule(
+                                       Capsule<V> const & A
+                                       , Capsule<V> const & B
+                                       , typename V::real_type const & envelope
+                                       , ContactsCallback<V> & callback
+                                       )
+  {
+    using std::min;
+    using std::max;
+    using std::fabs;
+
+    typedef typename V::real_type    T;
+    typedef typename V::value_traits VT;
+
+    V const u = A.point1() - A.point0();
+    V const v = B.point1() - B.point0();
+
+    T const uu = tiny::inner_prod( u, u );
+    T const vv = tiny::inner_prod( v, v );
+    T const uv = tiny::inner_prod( u, v );
+
+    T const epsilon = tiny::working_precision<T>();
+
+    bool const parallel = uu > epsilon && vv > epsilon && ( uu*vv - uv*uv ) <= VT::numeric_cast(0.0001)*uu*vv;
+
+    if( parallel )
+    {
+      // Project the end points of B onto the segment of A and find the
+      // part of A that is covered by B.
+      T const t0    = tiny::inner_prod( B.point0() - A.point0(), u ) / uu;
+      T const t1    = tiny::inner_prod( B.point1() - A.point0(), u ) / uu;
+      T const first = max( VT::zero(), min( t0, t1 ) );
+      T const last  = min( VT::one(),  max( t0, t1 ) );
+
+      if( last - first > epsilon )
+      {
+        bool found = false;
+
+        T const ends[2] = { first, last };
+
+        for(size_t i = 0u; i < 2u; ++i)
+        {
+          V const p_a = A.point0() + u*ends[i];
+          T const s   = detail::closest_point_on_segment( p_a, B.point0(), B.point1() );
+          V const p_b = B.point0() + v*s;
+
+          found = detail::contacts_ball_ball( p_a, A.radius(), p_b, B.radius(), envelope, callback ) || found;
+        }
+
+        return found;
+      }
+    }
+
+    T s = VT::zero();
+    T t = VT::zero();
+
+    detail::closest_points_segment_segment( A.point0(), A.point1(), B.point0(), B.point1(), s, t );
+
+    V const p_a = A.point0() + u*s;
+    V const p_b = B.point0() + v*t;
+
+    return detail::contacts_ball_ball( p_a, A.radius(), p_b, B.radius(), envelope, callback );
+  }
+
+}// namespace geometry
+
+// GEOMETRY_CONTACTS_CAPSULE_CAPSULE_H
+#endif
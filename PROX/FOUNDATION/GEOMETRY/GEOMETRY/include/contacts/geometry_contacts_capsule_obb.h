@@ -0,0 +1,113 @@
+#ifndef GEOMETRY_CONTACTS_CAPSULE_OBB_H
+#define GEOMETRY_CONTACTS_CAPSULE_OBB_H
+
+#include <contacts/geometry_contacts_callback.h>
+#include <contacts/geometry_contacts_sphere_obb.h>
+#include <types/geometry_capsule.h>
+#include <types/geometry_obb.h>
+
+#include <tiny.h>
+
+namespace geometry
+{
+
+  /**
+   * Closed form contact generation between a capsule and an OBB.
+   *
+   * The end balls of the capsule are tested against the OBB, this gives two
+   * contacts for a capsule lying on a face of the box. The distance from
+   * the core segment to the box is a convex function along the segment, so
+   * its minimum is found by a ternary search. If the minimum lies inside the
+   * segment and is closer than both end balls, e.g. a capsule lying across
+   * an edge of the box, then a contact is generated there as well.
+   *
+   * The contact normal points from A towards B and the reported distance
+   * is negative when the shapes overlap.
+   *
+   * @param A          The capsule.
+   * @param B          The OBB.
+   * @param envelope   Contacts are reported when the shapes are closer than this.
+   * @param callback   The callback used to report the contacts.
+   *
+   * @return           True if any contacts were reported.
+   */
+  template<typename MT>
+  inline bool contacts_capsule_obb(
+                                   Capsule<typename MT::vector3_type> const & A
+                                   , OBB<MT> const & B
+                                   , typename MT::real_type const & envelope
+                                   , ContactsCallback<typename MT::vector3_type> & callback
+                                   )
+  {
+    typedef typename MT::vector3_type V;
+    typedef typename MT::real_type    T;
+    typedef typename MT::value_traits VT;
+
+    V const u = A.point1() - A.point0();
+
+    V p0;
+    V n0;
+    V p1;
+    V n1;
+
+    T const distance0 = detail::compute_ball_obb_contact( A.point0(), A.radius(), B, p0, n0 );
+    T const distance1 = detail::compute_ball_obb_contact( A.point1(), A.radius(), B, p1, n1 );
+
+    bool found = false;
+
+    if( distance0 <= envelope )
+    {
+      callback( p0, n0, distance0, V::zero(), V::zero() );
+      found = true;
+    }
+
+    if( distance1 <= envelope )
+    {
+      callback( p1, n1, distance1, V::zero(), V::zero() );
+      found = true;
+    }
+
+    T lower = VT::zero();
+    T upper = VT::one();
+
+    V p;
+    V n;
+
+    for(size_t i = 0u; i < 32u; ++i)
+    {
+      T const left  = ( VT::two()*lower + upper ) / VT::numeric_cast(3.0);
+      T const right = ( lower + VT::two()*upper ) / VT::numeric_cast(3.0);
+
+      T const distance_left  = detail::compute_ball_obb_contact( V( A.point0() + u*left  ), A.radius(), B, p, n );
+      T const distance_right = detail::compute_ball_obb_contact( V( A.point0() + u*right ), A.radius(), B, p, n );
+
+      if( distance_left < distance_right )
+        upper = right;
+      else
+        lower = left;
+    }
+
+    T const s         = ( lower + upper )*VT::half();
+    T const tolerance = VT::numeric_cast(0.001);
+
+    if( s <= tolerance || s >= VT::one() - tolerance )
+      return found;
+
+    T const distance = detail::compute_ball_obb_contact( V( A.point0() + u*s ), A.radius(), B, p, n );
+
+    // A capsule lying flat on a face is equally close all along the
+    // segment, the end balls already hold that contact.
+    T const closest_end = distance0 < distance1 ? distance0 : distance1;
+
+    if( distance > envelope || distance >= closest_end - tolerance*A.radius() )
+      return found;
+
+    callback( p, n, distance, V::zero(), V::zero() );
+
+    return true;
+  }
+
+}// namespace geometry
+
+// GEOMETRY_CONTACTS_CAPSULE_OBB_H
+#endif
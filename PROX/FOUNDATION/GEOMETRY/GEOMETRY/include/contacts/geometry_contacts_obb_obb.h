@@ -0,0 +1,365 @@
+#ifndef GEOMETRY_CONTACTS_OBB_OBB_H
+#define GEOMETRY_CONTACTS_OBB_OBB_H
+
+#include <contacts/geometry_contacts_callback.h>
+#include <closest_points/geometry_closest_points_line_line.h>
+#include <types/geometry_obb.h>
+
+#include <tiny.h>
+
+#include <algorithm>  // needed for std::min and std::max
+#include <cmath>      // needed for std::fabs
+#include <cassert>
+
+namespace geometry
+{
+
+  namespace detail
+  {
+
+    /**
+     * Clip a convex polygon against the half space n * p <= d.
+     *
+     * @param input    The polygon vertices.
+     * @param N        The number of polygon vertices.
+     * @param n        The normal of the clipping plane.
+     * @param d        The offset of the clipping plane.
+     * @param output   Upon return the vertices of the clipped polygon, must have room for N + 1 vertices.
+     *
+     * @return         The number of vertices of the clipped polygon.
+     */
+    template<typename V>
+    inline size_t clip_polygon(
+                               V const * input
+                               , size_t const & N
+                               , V const & n
+                               , typename V::real_type const & d
+                               , V * output
+                               )
+    {
+      typedef typename V::real_type    T;
+      typedef typename V::value_traits VT;
+
+      size_t M = 0u;
+
+      for(size_t i = 0u; i < N; ++i)
+      {
+        V const & p = input[i];
+        V const & q = input[(i + 1u) % N];
+
+        T const dp = tiny::inner_prod( n, p ) - d;
+        T const dq = tiny::inner_prod( n, q ) - d;
+
+        if( dp <= VT::zero() )
+          output[M++] = p;
+
+        if( (dp < VT::zero() && dq > VT::zero()) || (dp > VT::zero() && dq < VT::zero()) )
+          output[M++] = p + (q - p)*( dp / (dp - dq) );
+      }
+
+      return M;
+    }
+
+    /**
+     * Generate contacts between a reference face of one box and the most
+     * anti-parallel (incident) face of the other box. The incident face is
+     * clipped against the side planes of the reference face and the clipped
+     * vertices that are close to the reference face become contacts.
+     *
+     * @param c_ref      The center of the reference box.
+     * @param ref_axes   The axes of the reference box.
+     * @param h_ref      The half extents of the reference box.
+     * @param axis       The axis of the reference face.
+     * @param n          The outward unit normal of the reference face.
+     * @param c_inc      The center of the incident box.
+     * @param inc_axes   The axes of the incident box.
+     * @param h_inc      The half extents of the incident box.
+     * @param envelope   Contacts are reported when the boxes are closer than this.
+     * @param flip       If true the reported normals are flipped, use this when the reference box is B.
+     * @param callback   The callback used to report the contacts.
+     *
+     * @return           True if any contacts were reported.
+     */
+    template<typename V>
+    inline bool contacts_obb_face(
+                                  V const & c_ref
+                                  , V const ref_axes[3]
+                                  , V const & h_ref
+                                  , size_t const & axis
+                                  , V const & n
+                                  , V const & c_inc
+                                  , V const inc_axes[3]
+                                  , V const & h_inc
+                                  , typename V::real_type const & envelope
+                                  , bool const & flip
+                                  , ContactsCallback<V> & callback
+                                  )
+    {
+      using std::fabs;
+
+      typedef typename V::real_type    T;
+      typedef typename V::value_traits VT;
+
+      //--- Find the incident face, the face of the other box whose normal
+      //--- is most anti-parallel to the reference face normal.
+      size_t k         = 0u;
+      T      alignment = fabs( tiny::inner_prod( inc_axes[0], n ) );
+
+      for(size_t i = 1u; i < 3u; ++i)
+      {
+        T const value = fabs( tiny::inner_prod( inc_axes[i], n ) );
+
+        if( value > alignment )
+        {
+          alignment = value;
+          k         = i;
+        }
+      }
+
+      T const sign  = tiny::inner_prod( inc_axes[k], n ) > VT::zero() ? -VT::one() : VT::one();
+      V const c_face = c_inc + inc_axes[k]*( sign*h_inc(k) );
+
+      size_t const ku = (k + 1u) % 3u;
+      size_t const kv = (k + 2u) % 3u;
+
+      V const u = inc_axes[ku]*h_inc(ku);
+      V const v = inc_axes[kv]*h_inc(kv);
+
+      V polygon[8];
+      V clipped[8];
+
+      polygon[0] = c_face + u + v;
+      polygon[1] = c_face - u + v;
+      polygon[2] = c_face - u - v;
+      polygon[3] = c_face + u - v;
+
+      size_t N = 4u;
+
+      //--- Clip the incident face against the side planes of the reference face
+      for(size_t j = 0u; j < 3u && N > 0u; ++j)
+      {
+        if( j == axis )
+          continue;
+
+        V const & e = ref_axes[j];
+        T const   o = tiny::inner_prod( e, c_ref );
+
+        N = clip_polygon( polygon, N,  e,  o + h_ref(j), clipped );
+        N = clip_polygon( clipped, N, -e, -o + h_ref(j), polygon );
+      }
+
+      bool found = false;
+
+      V const normal = flip ? V( -n ) : n;
+
+      for(size_t i = 0u; i < N; ++i)
+      {
+        T const distance = tiny::inner_prod( polygon[i] - c_ref, n ) - h_ref(axis);
+
+        if( distance > envelope )
+          continue;
+
+        V const p = polygon[i] - n*( distance*VT::half() );
+
+        callback( p, normal, distance, V::zero(), V::zero() );
+
+        found = true;
+      }
+
+      return found;
+    }
+
+  }// namespace detail
+
+  /**
+   * Closed form contact generation between two OBBs.
+   *
+   * The separating axis test is used to find the axis of least penetration
+   * among the 3 face normals of each box and the 9 edge-edge cross
+   * products. Face axes are preferred over edge axes unless the edge axis
+   * is clearly better, this avoids flipping between contact configurations
+   * for boxes resting on each other. For a face axis the incident face of
+   * the other box is clipped against the reference face, which gives up to
+   * 8 contacts. For an edge axis a single contact is generated at the
+   * closest points of the two edges.
+   *
+   * The contact normal points from A towards B and the reported distance
+   * is negative when the boxes overlap.
+   *
+   * @param A          The first OBB.
+   * @param B          The second OBB.
+   * @param envelope   Contacts are reported when the boxes are closer than this.
+   * @param callback   The callback used to report the contacts.
+   *
+   * @return           True if any contacts were reported.
+   */
+  template<typename MT>
+  inline bool contacts_obb_obb(
+                               OBB<MT> const & A
+                               , OBB<MT> const & B
+                               , typename MT::real_type const & envelope
+                               , ContactsCallback<typename MT::vector3_type> & callback
+                               )
+  {
+    using std::fabs;
+    using std::min;
+    using std::max;
+
+    typedef typename MT::vector3_type    V;
+    typedef typename MT::matrix3x3_type  M;
+    typedef typename MT::real_type       T;
+    typedef typename MT::value_traits    VT;
+
+    M const R_a = tiny::make( A.orientation() );
+    M const R_b = tiny::make( B.orientation() );
+
+    V const a[3] = { R_a.get_column_copy(0), R_a.get_column_copy(1), R_a.get_column_copy(2) };
+    V const b[3] = { R_b.get_column_copy(0), R_b.get_column_copy(1), R_b.get_column_copy(2) };
+
+    V const & h_a = A.half_extent();
+    V const & h_b = B.half_extent();
+
+    V const t = B.center() - A.center();
+
+    T const relative = VT::numeric_cast(0.95);
+    T const absolute = VT::numeric_cast(10.0)*tiny::working_precision<T>();
+
+    //--- Face axes of A ------------------------------------------------------
+    T      separation_a = VT::lowest();
+    size_t axis_a       = 0u;
+    V      normal_a     = a[0];
+
+    for(size_t i = 0u; i < 3u; ++i)
+    {
+      T const s   = tiny::inner_prod( t, a[i] );
+      T const r_b = h_b(0)*fabs( tiny::inner_prod( b[0], a[i] ) )
+                  + h_b(1)*fabs( tiny::inner_prod( b[1], a[i] ) )
+                  + h_b(2)*fabs( tiny::inner_prod( b[2], a[i] ) );
+
+      T const separation = fabs( s ) - h_a(i) - r_b;
+
+      if( separation > envelope )
+        return false;
+
+      if( separation > separation_a )
+      {
+        separation_a = separation;
+        axis_a       = i;
+        normal_a     = s < VT::zero() ? V( -a[i] ) : a[i];
+      }
+    }
+
+    //--- Face axes of B ------------------------------------------------------
+    T      separation_b = VT::lowest();
+    size_t axis_b       = 0u;
+    V      normal_b     = b[0];
+
+    for(size_t j = 0u; j < 3u; ++j)
+    {
+      T const s   = tiny::inner_prod( t, b[j] );
+      T const r_a = h_a(0)*fabs( tiny::inner_prod( a[0], b[j] ) )
+                  + h_a(1)*fabs( tiny::inner_prod( a[1], b[j] ) )
+                  + h_a(2)*fabs( tiny::inner_prod( a[2], b[j] ) );
+
+      T const separation = fabs( s ) - r_a - h_b(j);
+
+      if( separation > envelope )
+        return false;
+
+      if( separation > separation_b )
+      {
+        separation_b = separation;
+        axis_b       = j;
+        normal_b     = s < VT::zero() ? V( -b[j] ) : b[j];
+      }
+    }
+
+    //--- Edge-edge axes ------------------------------------------------------
+    T      separation_e = VT::lowest();
+    size_t edge_a       = 0u;
+    size_t edge_b       = 0u;
+    V      normal_e     = a[0];
+
+    for(size_t i = 0u; i < 3u; ++i)
+    {
+      for(size_t j = 0u; j < 3u; ++j)
+      {
+        V const axis   = tiny::cross( a[i], b[j] );
+        T const length = tiny::norm( axis );
+
+        // Parallel edges give no new axis, the face axes cover that case
+        if( length < VT::numeric_cast(0.001) )
+          continue;
+
+        V const L = axis / length;
+
+        T const s   = tiny::inner_prod( t, L );
+        T const r_a = h_a(0)*fabs( tiny::inner_prod( a[0], L ) )
+                    + h_a(1)*fabs( tiny::inner_prod( a[1], L ) )
+                    + h_a(2)*fabs( tiny::inner_prod( a[2], L ) );
+        T const r_b = h_b(0)*fabs( tiny::inner_prod( b[0], L ) )
+                    + h_b(1)*fabs( tiny::inner_prod( b[1], L ) )
+                    + h_b(2)*fabs( tiny::inner_prod( b[2], L ) );
+
+        T const separation = fabs( s ) - r_a - r_b;
+
+        if( separation > envelope )
+          return false;
+
+        if( separation > separation_e )
+        {
+          separation_e = separation;
+          edge_a       = i;
+          edge_b       = j;
+          normal_e     = s < VT::zero() ? V( -L ) : L;
+        }
+      }
+    }
+
+    bool const use_b    = separation_b > relative*separation_a + absolute;
+    T    const face_sep = use_b ? separation_b : separation_a;
+
+    if( separation_e > relative*face_sep + absolute )
+    {
+      V const & n = normal_e;
+
+      // Find the edge of A furthest in the direction of n and the edge of B
+      // furthest in the opposite direction.
+      V p_a = A.center();
+      V p_b = B.center();
+
+      for(size_t k = 0u; k < 3u; ++k)
+      {
+        if( k != edge_a )
+          p_a += a[k]*( tiny::inner_prod( a[k], n ) > VT::zero() ? h_a(k) : -h_a(k) );
+
+        if( k != edge_b )
+          p_b += b[k]*( tiny::inner_prod( b[k], n ) > VT::zero() ? -h_b(k) : h_b(k) );
+      }
+
+      T s = VT::zero();
+      T r = VT::zero();
+
+      closest_points_line_line( p_a, a[edge_a], p_b, b[edge_b], s, r );
+
+      s = max( -h_a(edge_a), min( h_a(edge_a), s ) );
+      r = max( -h_b(edge_b), min( h_b(edge_b), r ) );
+
+      V const q_a = p_a + a[edge_a]*s;
+      V const q_b = p_b + b[edge_b]*r;
+
+      callback( (q_a + q_b)*VT::half(), n, separation_e, V::zero(), V::zero() );
+
+      return true;
+    }
+
+    if( use_b )
+      return detail::contacts_obb_face( B.center(), b, h_b, axis_b, V( -normal_b ), A.center(), a, h_a, envelope, true, callback );
+
+    return detail::contacts_obb_face( A.center(), a, h_a, axis_a, normal_a, B.center(), b, h_b, envelope, false, callback );
+  }
+
+}// namespace geometry
+
+// GEOMETRY_CONTACTS_OBB_OBB_H
+#endif
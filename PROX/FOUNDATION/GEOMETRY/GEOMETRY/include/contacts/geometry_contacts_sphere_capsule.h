@@ -0,0 +1,85 @@
+#ifndef GEOMETRY_CONTACTS_SPHERE_CAPSULE_H
+#define GEOMETRY_CONTACTS_SPHERE_CAPSULE_H
+
+#include <contacts/geometry_contacts_callback.h>
+#include <contacts/geometry_contacts_sphere_sphere.h>
+#include <types/geometry_sphere.h>
+#include <types/geometry_capsule.h>
+
+#include <tiny_vector_functions.h>
+#include <tiny_precision.h>
+
+#include <algorithm>  // needed for std::min and std::max
+
+namespace geometry
+{
+
+  namespace detail
+  {
+
+    /**
+     * Compute the closest point on a line segment to a given point.
+     *
+     * @param p    The point.
+     * @param p0   The first end point of the segment.
+     * @param p1   The second end point of the segment.
+     *
+     * @return     The segment parameter s in [0..1] of the closest point p0 + (p1-p0)*s.
+     */
+    template<typename V>
+    inline typename V::real_type closest_point_on_segment(
+                                                          V const & p
+                                                          , V const & p0
+                                                          , V const & p1
+                                                          )
+    {
+      using std::min;
+      using std::max;
+
+      typedef typename V::real_type    T;
+      typedef typename V::value_traits VT;
+
+      V const u  = p1 - p0;
+      T const uu = tiny::inner_prod( u, u );
+
+      if( uu <= tiny::working_precision<T>() )
+        return VT::zero();
+
+      return max( VT::zero(), min( VT::one(), tiny::inner_prod( p - p0, u ) / uu ) );
+    }
+
+  }// namespace detail
+
+  /**
+   * Closed form contact generation between a sphere and a capsule.
+   *
+   * The contact normal points from A towards B and the reported distance
+   * is negative when the shapes overlap.
+   *
+   * @param A          The sphere.
+   * @param B          The capsule.
+   * @param envelope   Contacts are reported when the shapes are closer than this.
+   * @param callback   The callback used to report the contact.
+   *
+   * @return           True if a contact was reported.
+   */
+  template<typename V>
+  inline bool contacts_sphere_capsule(
+                                      Sphere<V> const & A
+                                      , Capsule<V> const & B
+                                      , typename V::real_type const & envelope
+                                      , ContactsCallback<V> & callback
+                                      )
+  {
+    typedef typename V::real_type T;
+
+    T const s   = detail::closest_point_on_segment( A.center(), B.point0(), B.point1() );
+    V const p_b = B.point0() + ( B.point1() - B.point0() )*s;
+
+    return detail::contacts_ball_ball( A.center(), A.radius(), p_b, B.radius(), envelope, callback );
+  }
+
+}// namespace geometry
+
+// GEOMETRY_CONTACTS_SPHERE_CAPSULE_H
+#endif
@@ -0,0 +1,176 @@
+#ifndef GEOMETRY_CONTACTS_SPHERE_OBB_H
+#define GEOMETRY_CONTACTS_SPHERE_OBB_H
+
+#include <contacts/geometry_contacts_callback.h>
+#include <types/geometry_sphere.h>
+#include <types/geometry_obb.h>
+
+#include <geometry_transform.h>
+
+#include <tiny.h>
+
+#include <algorithm>  // needed for std::min and std::max
+#include <cmath>      // needed for std::fabs
+#include <cassert>
+
+namespace geometry
+{
+
+  namespace detail
+  {
+
+    /**
+     * Compute the closest points between a ball and an OBB. This is the
+     * common core of the sphere-OBB and capsule-OBB contact routines.
+     *
+     * @param c          The center of the ball.
+     * @param radius     The radius of the ball.
+     * @param B          The OBB.
+     * @param p          Upon return the contact point, half way between the surfaces.
+     * @param n          Upon return the unit contact normal pointing from the ball towards the OBB.
+     *
+     * @return           The distance between the surfaces, negative if they overlap.
+     */
+    template<typename MT>
+    inline typename MT::real_type compute_ball_obb_contact(
+                                                           typename MT::vector3_type const & c
+                                                           , typename MT::real_type const & radius
+                                                           , OBB<MT> const & B
+                                                           , typename MT::vector3_type & p
+                                                           , typename MT::vector3_type & n
+                                                           )
+    {
+      using std::min;
+      using std::max;
+      using std::fabs;
+
+      typedef typename MT::vector3_type V;
+      typedef typename MT::real_type    T;
+      typedef typename MT::value_traits VT;
+
+      V const & h       = B.half_extent();
+      V const   c_local = transform_to_obb( c, B );
+
+      V q_local = V::make(
+                          max( -h(0), min( h(0), c_local(0) ) )
+                          , max( -h(1), min( h(1), c_local(1) ) )
+                          , max( -h(2), min( h(2), c_local(2) ) )
+                          );
+
+      V         n_local;     // Normal pointing from the box towards the ball center
+      T         distance;
+
+      V const r = c_local - q_local;
+      T const d = tiny::norm( r );
+
+      if( d > tiny::working_precision<T>() )
+      {
+        // The center of the ball is outside the box
+        n_local  = r / d;
+        distance = d - radius;
+      }
+      else
+      {
+        // The center of the ball is inside the box, push it out through
+        // the face closest to the center
+        size_t axis        = 0u;
+        T      penetration = h(0) - fabs( c_local(0) );
+
+        for(size_t i = 1u; i < 3u; ++i)
+        {
+          T const value = h(i) - fabs( c_local(i) );
+
+          if( value < penetration )
+          {
+            penetration = value;
+            axis        = i;
+          }
+        }
+
+        T const sign = ( c_local(axis) < VT::zero() ) ? -VT::one() : VT::one();
+
+        n_local        = V::zero();
+        n_local(axis)  = sign;
+        q_local(axis)  = sign*h(axis);
+        distance       = - penetration - radius;
+      }
+
+      V const n_world = tiny::rotate( B.orientation(), n_local );
+      V const q_b     = transform_from_obb( q_local, B );
+      V const q_a     = c - n_world*radius;
+
+      assert( is_number( distance ) || !"compute_ball_obb_contact(): nan");
+      assert( is_finite( distance ) || !"compute_ball_obb_contact(): inf");
+
+      p = ( q_a + q_b )*VT::half();
+      n = -n_world;
+
+      return distance;
+    }
+
+    /**
+     * Report the contact between a ball and an OBB.
+     *
+     * @param c          The center of the ball.
+     * @param radius     The radius of the ball.
+     * @param B          The OBB.
+     * @param envelope   Contacts are reported when the ball is closer than this.
+     * @param callback   The callback used to report the contact.
+     *
+     * @return           True if a contact was reported.
+     */
+    template<typename MT>
+    inline bool contacts_ball_obb(
+                                  typename MT::vector3_type const & c
+                                  , typename MT::real_type const & radius
+                                  , OBB<MT> const & B
+                                  , typename MT::real_type const & envelope
+                                  , ContactsCallback<typename MT::vector3_type> & callback
+                                  )
+    {
+      typedef typename MT::vector3_type V;
+      typedef typename MT::real_type    T;
+
+      V p;
+      V n;
+
+      T const distance = compute_ball_obb_contact( c, radius, B, p, n );
+
+      if( distance > envelope )
+        return false;
+
+      callback( p, n, distance, V::zero(), V::zero() );
+
+      return true;
+    }
+
+  }// namespace detail
+
+  /**
+   * Closed form contact generation between a sphere and an OBB.
+   *
+   * The contact normal points from A towards B and the reported distance
+   * is negative when the shapes overlap.
+   *
+   * @param A          The sphere.
+   * @param B          The OBB.
+   * @param envelope   Contacts are reported when the shapes are closer than this.
+   * @param callback   The callback used to report the contact.
+   *
+   * @return           True if a contact was reported.
+   */
+  template<typename MT>
+  inline bool contacts_sphere_obb(
+                                  Sphere<typename MT::vector3_type> const & A
+                                  , OBB<MT> const & B
+                                  , typename MT::real_type const & envelope
+                                  , ContactsCallback<typename MT::vector3_type> & callback
+                                  )
+  {
+    return detail::contacts_ball_obb( A.center(), A.radius(), B, envelope, callback );
+  }
+
+}// namespace geometry
+
+// GEOMETRY_CONTACTS_SPHERE_OBB_H
+#endif
@@ -0,0 +1,99 @@
+#ifndef GEOMETRY_CONTACTS_SPHERE_SPHERE_H
+#define GEOMETRY_CONTACTS_SPHERE_SPHERE_H
+
+#include <contacts/geometry_contacts_callback.h>
+#include <types/geometry_sphere.h>
+
+#include <tiny_vector_functions.h>
+#include <tiny_precision.h>
+#include <tiny_is_number.h>
+#include <tiny_is_finite.h>
+
+#include <cassert>
+
+namespace geometry
+{
+
+  namespace detail
+  {
+
+    /**
+     * Report the contact between two points that are each surrounded by
+     * a ball of given radius. This is the common core of all the closed
+     * form contact routines involving spheres and capsules.
+     *
+     * @param p_a        The center of the ball of A.
+     * @param radius_a   The radius of the ball of A.
+     * @param p_b        The center of the ball of B.
+     * @param radius_b   The radius of the ball of B.
+     * @param envelope   Contacts are reported when the balls are closer than this.
+     * @param callback   The callback used to report the contact.
+     *
+     * @return           True if a contact was reported.
+     */
+    template<typename V>
+    inline bool contacts_ball_ball(
+                                   V const & p_a
+                                   , typename V::real_type const & radius_a
+                                   , V const & p_b
+                                   , typename V::real_type const & radius_b
+                                   , typename V::real_type const & envelope
+                                   , ContactsCallback<V> & callback
+                                   )
+    {
+      typedef typename V::real_type    T;
+      typedef typename V::value_traits VT;
+
+      V const r = p_b - p_a;
+      T const d = tiny::norm( r );
+
+      T const distance = d - radius_a - radius_b;
+
+      if( distance > envelope )
+        return false;
+
+      // Concentric balls have no well defined normal, we just pick one
+      V const n = ( d > tiny::working_precision<T>() ) ? r / d : V::make( VT::zero(), VT::one(), VT::zero() );
+
+      V const q_a = p_a + n*radius_a;
+      V const q_b = p_b - n*radius_b;
+      V const p   = ( q_a + q_b )*VT::half();
+
+      assert( is_number( distance ) || !"contacts_ball_ball(): nan");
+      assert( is_finite( distance ) || !"contacts_ball_ball(): inf");
+
+      callback( p, n, distance, V::zero(), V::zero() );
+
+      return true;
+    }
+
+  }// namespace detail
+
+  /**
+   * Closed form contact generation between two spheres.
+   *
+   * The contact normal points from A towards B and the reported distance
+   * is negative when the spheres overlap.
+   *
+   * @param A          The first sphere.
+   * @param B          The second sphere.
+   * @param envelope   Contacts are reported when the spheres are closer than this.
+   * @param callback   The callback used to report the contact.
+   *
+   * @return           True if a contact was reported.
+   */
+  template<typename V>
+  inline bool contacts_sphere_sphere(
+                                     Sphere<V> const & A
+                                     , Sphere<V> const & B
+                                     , typename V::real_type const & envelope
+                                     , ContactsCallback<V> & callback
+                                     )
+  {
+    return detail::contacts_ball_ball( A.center(), A.radius(), B.center(), B.radius(), envelope, callback );
+  }
+
+}// namespace geometry
+
+// GEOMETRY_CONTACTS_SPHERE_SPHERE_H
+#endif
@@ -6,7 +6,6 @@
 #include <types/geometry_triangle.h>
 #include <tiny.h>
 
-#include <vector>
 #include <cassert>
 
 namespace geometry
@@ -18,10 +17,10 @@ namespace geometry
                                                Tetrahedron<V> const & A
                                                , Tetrahedron<V> const & B
                                                , ContactsCallback<V> & callback
-                                               , std::vector<bool> const & surface_A
-                                               , std::vector<bool> const & surface_B
-                                               , std::vector<V> const & structure_map_A
-                                               , std::vector<V> const & structure_map_B
+                                               , bool const surface_A[4]
+                                               , bool const surface_B[4]
+                                               , V const structure_map_A[4]
+                                               , V const structure_map_B[4]
                                                , CLOSEST_POINTS const & /*algorithm_tag*/
   )
   {
@@ -64,20 +63,20 @@ namespace geometry
 //      , {0,  2,  1}
 //    };
 
-    std::vector<bool>                vertex_A_is_surface(4u,false);
-    std::vector<bool>                vertex_B_is_surface(4u,false);
-    std::vector<bool>                edge_A_is_surface(6u,false);
-    std::vector<bool>                edge_B_is_surface(6u,false);
+    bool                             vertex_A_is_surface[4] = { false, false, false, false };
+    bool                             vertex_B_is_surface[4] = { false, false, false, false };
+    bool                             edge_A_is_surface[6]   = { false, false, false, false, false, false };
+    bool                             edge_B_is_surface[6]   = { false, false, false, false, false, false };
 
-    std::vector<bool>                vertex_A_is_used(4u,false);
-    std::vector<bool>                vertex_B_is_used(4u,false);
-    std::vector<bool>                edge_A_is_used(6u,false);
-    std::vector<bool>                edge_B_is_used(6u,false);
+    bool                             vertex_A_is_used[4]    = { false, false, false, false };
+    bool                             vertex_B_is_used[4]    = { false, false, false, false };
+    bool                             edge_A_is_used[6]      = { false, false, false, false, false, false };
+    bool                             edge_B_is_used[6]      = { false, false, false, false, false, false };
 
-    std::vector<Triangle<V> >                trianglesA(4u);
-    std::vector<Triangle<V> >                trianglesB(4u);
-    std::vector<details::UnscaledPlane<V> >  planesA(4u);
-    std::vector<details::UnscaledPlane<V> >  planesB(4u);
+    Triangle<V>                      trianglesA[4];
+    Triangle<V>                      trianglesB[4];
+    details::UnscaledPlane<V>        planesA[4];
+    details::UnscaledPlane<V>        planesB[4];
 
     //--- Pre-computation ---- -------------------------------------------------
     for (unsigned int v =0u; v < 4u; ++v)
@@ -267,10 +266,10 @@ namespace geometry
         V const   db = tiny::unit(bj - bi);
 
         V const r  =   bi - ai;
-        T const k  =   tiny::inner_prod(da, db);
+        T const c  =   tiny::inner_prod(da, db);
         T const q1 =   tiny::inner_prod(da,r);
         T const q2 = - tiny::inner_prod(db,r);
-        T const w  =   VT::one() - k*k;
+        T const w  =   VT::one() - c*c;
 
         // Test if edges too close to parallel
         bool const too_parallel = fabs(w) < too_small;
@@ -279,8 +278,8 @@ namespace geometry
           continue;
 
         // Compute edge-parameters corresponding to closest points
-        T const t = (q1 + k*q2)/w;
-        T const s = (q2 + k*q1)/w;
+        T const t = (q1 + c*q2)/w;
+        T const s = (q2 + c*q1)/w;
 
         // Test if closest points are interior on edges
         if (t<= VT::zero())
@@ -23,16 +23,15 @@ namespace geometry
     inline void compute_intersection_points(
                                      Tetrahedron<V> const & A
                                      , Tetrahedron<V> const & B
-                                     , std::vector<V>  & intersections
+                                     , IntersectionPoints<V>  & intersections
                                      )
     {
       intersections.clear();
-      intersections.reserve(16);
 
-      std::vector<Triangle<V> >                trianglesA(4u);
-      std::vector<Triangle<V> >                trianglesB(4u);
-      std::vector<details::UnscaledPlane<V> >  planesA(4u);
-      std::vector<details::UnscaledPlane<V> >  planesB(4u);
+      Triangle<V>                trianglesA[4];
+      Triangle<V>                trianglesB[4];
+      details::UnscaledPlane<V>  planesA[4];
+      details::UnscaledPlane<V>  planesB[4];
 
       for (unsigned int v =0u; v < 4u; ++v)
       {
@@ -95,23 +94,18 @@ namespace geometry
     }
 
     template<typename V>
-    inline void project_to_plane(V const & n, V const & p, std::vector<V> & intersections)
+    inline void project_to_plane(V const & n, V const & p, IntersectionPoints<V> & intersections)
     {
-      typedef typename std::vector<V>::iterator   iterator;
-
-      iterator q   = intersections.begin();
-      iterator end = intersections.end();
-
-      for( ; q != end ; ++q )
+      for(unsigned int q = 0u; q < intersections.size(); ++q )
       {
-        (*q) = (*q) - tiny::inner_prod( n, ( (*q) - p ) ) * n;
+        intersections[q] = intersections[q] - tiny::inner_prod( n, ( intersections[q] - p ) ) * n;
       }
     }
 
     template<typename V>
     inline void estimate_overlap(
                                  V const & normal
-                                 , std::vector<V> const & intersections
+                                 , IntersectionPoints<V> const & intersections
                                  , typename V::real_type & max_val
                                  , typename V::real_type & min_val
                                  )
@@ -121,17 +115,13 @@ namespace geometry
 
       typedef typename V::real_type                   T;
       typedef typename V::value_traits                VT;
-      typedef typename std::vector<V>::const_iterator iterator;
-
-      iterator p   = intersections.begin();
-      iterator end = intersections.end();
 
       min_val = VT::highest();
       max_val = VT::lowest();
 
-      for( ;  p!=end; ++p)
+      for(unsigned int p = 0u; p < intersections.size(); ++p)
       {
-        T const d = tiny::inner_prod( (*p), normal );
+        T const d = tiny::inner_prod( intersections[p], normal );
 
         min_val = min( min_val, d );
         max_val = max( max_val, d );
@@ -141,36 +131,28 @@ namespace geometry
 
     template<typename V>
     inline void filter_unique(
-                         std::vector<V> const & intersections
-                       , std::vector<V>       & reduced
+                         IntersectionPoints<V> const & intersections
+                       , IntersectionPoints<V>       & reduced
                        )
     {
       typedef typename V::real_type                     T;
-      typedef typename std::vector<V>::const_iterator   const_iterator;
-      typedef typename std::vector<V>::iterator         iterator;
 
       T const accuracy = tiny::working_precision<T>();
 
       reduced.clear();
-      reduced.reserve( intersections.size() );
 
-      const_iterator p   = intersections.begin();
-      const_iterator end = intersections.end();
-
-      for(; p!= end; ++p)
+      for(unsigned int p = 0u; p < intersections.size(); ++p)
       {
         bool unique = true;
 
-        iterator q    = reduced.begin();
-        iterator endq = reduced.end();
-        for(; q != endq; ++q)
+        for(unsigned int q = 0u; q < reduced.size(); ++q)
         {
-          T const similarity = tiny::norm_1( (*q) - (*p) );
+          T const similarity = tiny::norm_1( reduced[q] - intersections[p] );
           unique = similarity < accuracy ? false : unique;
         }
 
         if(unique)
-          reduced.push_back( (*p) );
+          reduced.push_back( intersections[p] );
       }
     }
 
@@ -178,25 +160,20 @@ namespace geometry
     inline void make_contacts(
                               V const & normal
                               , typename V::real_type const & depth
-                              , std::vector<V> const & positions
+                              , IntersectionPoints<V> const & positions
                               , Tetrahedron<V> const & A
                               , Tetrahedron<V> const & B
-                              , std::vector<V> const & structure_map_A
-                              , std::vector<V> const & structure_map_B
+                              , V const structure_map_A[4]
+                              , V const structure_map_B[4]
                               , ContactsCallback<V> & callback
                               )
     {
-      typedef typename std::vector<V>::const_iterator   const_iterator;
-
-      const_iterator p   = positions.begin();
-      const_iterator end = positions.end();
-
-      for(; p!= end; ++p)
+      for(unsigned int p = 0u; p < positions.size(); ++p)
       {
 
-        V const Sa = interpolate( (*p),structure_map_A, A);
-        V const Sb = interpolate( (*p),structure_map_B, B);
-        callback(*p, normal, depth, Sa, Sb);
+        V const Sa = interpolate( positions[p],structure_map_A, A);
+        V const Sb = interpolate( positions[p],structure_map_B, B);
+        callback(positions[p], normal, depth, Sa, Sb);
       }
     }
 
@@ -212,10 +189,10 @@ namespace geometry
                                                Tetrahedron<V> const & A
                                                , Tetrahedron<V> const & B
                                                , ContactsCallback<V> & callback
-                                               , std::vector<bool> const & surface_A
-                                               , std::vector<bool> const & surface_B
-                                               , std::vector<V> const & structure_map_A
-                                               , std::vector<V> const & structure_map_B
+                                               , bool const surface_A[4]
+                                               , bool const surface_B[4]
+                                               , V const structure_map_A[4]
+                                               , V const structure_map_B[4]
                                                , GROWTH const & /*algorithm_tag*/
   )
   {
@@ -318,7 +295,7 @@ namespace geometry
     // Determine contact normal from highest dimensional feature
     V const normal = pointsA.size() >=  pointsB.size() ? nA : -nB;
 
-    std::vector<V> intersections;
+    details::IntersectionPoints<V> intersections;
     details::compute_intersection_points(A, B, intersections);
     
     if(intersections.empty())
@@ -334,7 +311,7 @@ namespace geometry
     
     //details::project_to_plane(n, mid, intersections);
 
-    std::vector<V> reduced;
+    details::IntersectionPoints<V> reduced;
     details::filter_unique(intersections, reduced);
 
     details::make_contacts(normal, depth, reduced, A, B,structure_map_A,structure_map_B, callback);
@@ -13,7 +13,7 @@
 #include <tiny_precision.h>        // needed for tiny::working_precision
 
 #include <cmath>                   // needed for std::min and std::max
-#include <vector>
+#include <cassert>
 
 namespace geometry
 {
@@ -80,6 +80,52 @@ namespace geometry
       return plane;
     }
 
+    /**
+     * Fixed capacity storage for the intersection points of two tetrahedra.
+     * Each of the 8 vertices may lie inside the other tetrahedron and each
+     * of the 6 edges of a tetrahedron may cross the 4 face planes of the
+     * other tetrahedron, so there are never more than 8 + 2*6*4 = 56 points.
+     * The points live on the stack, so no heap memory is touched for every
+     * overlapping pair of tetrahedra.
+     */
+    template<typename V>
+    class IntersectionPoints
+    {
+    public:
+
+      static unsigned int const capacity = 56u;
+
+    protected:
+
+      V            m_points[capacity];
+      unsigned int m_size;
+
+    public:
+
+      IntersectionPoints()
+      : m_size(0u)
+      {}
+
+    public:
+
+      unsigned int size() const { return this->m_size; }
+
+      bool empty() const { return this->m_size == 0u; }
+
+      void clear() { this->m_size = 0u; }
+
+      void push_back(V const & p)
+      {
+        assert(this->m_size < capacity || !"push_back(): internal error, too many intersection points");
+
+        this->m_points[this->m_size++] = p;
+      }
+
+      V       & operator[](unsigned int const & i)       { return this->m_points[i]; }
+      V const & operator[](unsigned int const & i) const { return this->m_points[i]; }
+
+    };
+
     template<typename V>
     inline typename V::real_type get_signed_distance( V const & q, UnscaledPlane<V> const & plane)
     {
@@ -87,10 +133,8 @@ namespace geometry
     }
 
     template<typename V>
-    inline bool inside_planes(V const & q, std::vector<UnscaledPlane<V> > const & planes)
+    inline bool inside_planes(V const & q, UnscaledPlane<V> const planes[4])
     {
-      assert(planes.size() == 4u || !"inside_planes(): internal error");
-
       typedef typename V::value_traits  VT;
       typedef typename V::real_type     T;
 
@@ -166,8 +210,8 @@ namespace geometry
     inline bool pick_most_opposing_surface_normal(
                             Tetrahedron<V> const & tetA
                             , Tetrahedron<V> const & tetB
-                            , std::vector<bool> const & surface_A
-                            , std::vector<bool> const & surface_B
+                            , bool const surface_A[4]
+                            , bool const surface_B[4]
                             , V & n
                             )
     {
@@ -239,7 +283,7 @@ namespace geometry
      * @return resultant s vector
      */
     template<typename V>
-    inline V interpolate( V const & p, std::vector<V> const & s_map, Tetrahedron<V> const & A)
+    inline V interpolate( V const & p, V const s_map[4], Tetrahedron<V> const & A)
     {
       typedef typename V::real_type T;
       typedef typename V::value_traits VT;
@@ -265,8 +309,8 @@ namespace geometry
                                                     Tetrahedron<V> const & A
                                                     , Tetrahedron<V> const & B
                                                     , ContactsCallback<V> & callback
-                                                    , std::vector<V> const & structure_map_A
-                                                    , std::vector<V> const & structure_map_B
+                                                    , V const structure_map_A[4]
+                                                    , V const structure_map_B[4]
                                                     , V const & n
                                                     )
     {
@@ -276,14 +320,13 @@ namespace geometry
       typedef typename V::value_traits VT;
       typedef typename V::real_type     T;
 
-      std::vector<V> contacts;
-      contacts.reserve(16);
+      IntersectionPoints<V> contacts;
 
-      std::vector<Triangle<V> >                trianglesA(4u);
-      std::vector<Triangle<V> >                trianglesB(4u);
+      Triangle<V>                trianglesA[4];
+      Triangle<V>                trianglesB[4];
 
-      std::vector<details::UnscaledPlane<V> >  planesA(4u);
-      std::vector<details::UnscaledPlane<V> >  planesB(4u);
+      details::UnscaledPlane<V>  planesA[4];
+      details::UnscaledPlane<V>  planesB[4];
 
       for (unsigned int v =0u; v < 4u; ++v)
       {
@@ -356,9 +399,9 @@ namespace geometry
       T max_val = VT::lowest();
 
       {
-        for( typename std::vector<V>::iterator p = contacts.begin(); p!= contacts.end(); ++p)
+        for( unsigned int p = 0u; p < contacts.size(); ++p)
         {
-          T const d = inner_prod( (*p), n );
+          T const d = inner_prod( contacts[p], n );
 
           min_val = min( min_val, d );
           max_val = max( max_val, d );
@@ -370,23 +413,21 @@ namespace geometry
       // Project contact points onto cotact plane
       V const mid =  n * (max_val + min_val)*VT::half();
 
-      for( typename std::vector<V>::iterator p = contacts.begin(); p!= contacts.end(); ++p)
+      for( unsigned int p = 0u; p < contacts.size(); ++p)
       {
-        (*p) = (*p) - inner_prod( n, ( (*p) - mid ) ) * n;
+        contacts[p] = contacts[p] - inner_prod( n, ( contacts[p] - mid ) ) * n;
       }
 
       // Some contacts might have been projected to the same point in the
       // contact plane, so we filter away redundant information before
       // using the callback to report the computed contact point.
-      typename std::vector<V>::iterator p    = contacts.begin();
-      for(; p!= contacts.end(); ++p)
+      for(unsigned int p = 0u; p < contacts.size(); ++p)
       {
         bool unique = true;
         
-        typename std::vector<V>::iterator q = contacts.begin();
-        for(; q != p; ++q)
+        for(unsigned int q = 0u; q < p; ++q)
         {
-          if( tiny::norm_1( (*q) - (*p) ) < tiny::working_precision<T>())
+          if( tiny::norm_1( contacts[q] - contacts[p] ) < tiny::working_precision<T>())
           {
             unique = false;
             break;
@@ -395,9 +436,9 @@ namespace geometry
         
         if(unique)
         {
-          V const Sa = interpolate( (*p),structure_map_A, A);
-          V const Sb = interpolate( (*p),structure_map_B, B);
-          callback( (*p), n, depth, Sa, Sb);
+          V const Sa = interpolate( contacts[p],structure_map_A, A);
+          V const Sb = interpolate( contacts[p],structure_map_B, B);
+          callback( contacts[p], n, depth, Sa, Sb);
         }
       }
       
@@ -416,16 +457,14 @@ namespace geometry
                                                Tetrahedron<V> const & A
                                                , Tetrahedron<V> const & B
                                                , ContactsCallback<V> & callback
-                                               , std::vector<bool> const & surface_A
-                                               , std::vector<bool> const & surface_B
-                                               , std::vector<V> const & structure_map_A
-                                               , std::vector<V> const & structure_map_B
+                                               , bool const surface_A[4]
+                                               , bool const surface_B[4]
+                                               , V const structure_map_A[4]
+                                               , V const structure_map_B[4]
                                                , MOST_OPPOSING_SURFACES const & /*algorithm_tag*/
   )
   {
-    assert(surface_A.size() == 4u                                          || !"contacts_tetrahedron_tetrahedron(): internal error, must have four surface map values");
     assert( (surface_A[0] || surface_A[1] || surface_A[2] || surface_A[3]) || !"contacts_tetrahedron_tetrahedron(): internal error, tetrahedron A must have at least one surface face");
-    assert(surface_B.size() == 4u                                          || !"contacts_tetrahedron_tetrahedron(): internal error, must have four surface map values");
     assert( (surface_B[0] || surface_B[1] || surface_B[2] || surface_B[3]) || !"contacts_tetrahedron_tetrahedron(): internal error, tetrahedron B must have at least one surface face");
 
     using std::min;
@@ -53,6 +53,12 @@
 #include <contacts/geometry_contacts_tetrahedron_tetrahedron_opposing.h>
 #include <contacts/geometry_contacts_tetrahedron_tetrahedron_growth.h>
 #include <contacts/geometry_contacts_tetrahedron_tetrahedron_closest_points.h>
+#include <contacts/geometry_contacts_sphere_sphere.h>
+#include <contacts/geometry_contacts_sphere_capsule.h>
+#include <contacts/geometry_contacts_sphere_obb.h>
+#include <contacts/geometry_contacts_capsule_capsule.h>
+#include <contacts/geometry_contacts_capsule_obb.h>
+#include <contacts/geometry_contacts_obb_obb.h>
 
 //GEOMETRY_H
 #endif
@@ -0,0 +1,308 @@
+#include <geometry.h>
+#include <tiny.h>
+
+#include <cmath>
+#include <vector>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef tiny::MathTypes<float> MT;
+typedef MT::quaternion_type    Q;
+typedef MT::vector3_type       V;
+typedef MT::real_type          T;
+typedef MT::value_traits       VT;
+
+class Recorder
+: public geometry::ContactsCallback<V>
+{
+public:
+
+  std::vector<V> m_points;
+  std::vector<V> m_normals;
+  std::vector<T> m_distances;
+
+  void operator()( V const & p, V const & n, T const & d, V const & /*Sa*/, V const & /*Sb*/)
+  {
+    m_points.push_back( p );
+    m_normals.push_back( n );
+    m_distances.push_back( d );
+  }
+
+  size_t size() const { return m_points.size(); }
+};
+
+void check_vector( V const & a, V const & b )
+{
+  BOOST_CHECK_SMALL( a(0) - b(0), 0.0001f );
+  BOOST_CHECK_SMALL( a(1) - b(1), 0.0001f );
+  BOOST_CHECK_SMALL( a(2) - b(2), 0.0001f );
+}
+
+BOOST_AUTO_TEST_SUITE(geometry);
+
+BOOST_AUTO_TEST_CASE(contacts_sphere_sphere_test)
+{
+  T const envelope = 0.01f;
+
+  // Overlapping along the x-axis
+  {
+    Recorder recorder;
+
+    geometry::Sphere<V> const A = geometry::make_sphere( V::make( 0.0, 0.0, 0.0), 1.0f );
+    geometry::Sphere<V> const B = geometry::make_sphere( V::make( 1.5, 0.0, 0.0), 1.0f );
+
+    BOOST_CHECK( geometry::contacts_sphere_sphere( A, B, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 1u );
+    check_vector( recorder.m_normals[0], V::make( 1.0, 0.0, 0.0) );
+    check_vector( recorder.m_points[0],  V::make( 0.75, 0.0, 0.0) );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], -0.5f, 0.01f );
+  }
+  // Separated by more than the envelope
+  {
+    Recorder recorder;
+
+    geometry::Sphere<V> const A = geometry::make_sphere( V::make( 0.0, 0.0, 0.0), 1.0f );
+    geometry::Sphere<V> const B = geometry::make_sphere( V::make( 0.0, 2.1, 0.0), 1.0f );
+
+    BOOST_CHECK( !geometry::contacts_sphere_sphere( A, B, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 0u );
+  }
+  // Separated but within the envelope
+  {
+    Recorder recorder;
+
+    geometry::Sphere<V> const A = geometry::make_sphere( V::make( 0.0, 0.0, 0.0), 1.0f );
+    geometry::Sphere<V> const B = geometry::make_sphere( V::make( 0.0, -2.005, 0.0), 1.0f );
+
+    BOOST_CHECK( geometry::contacts_sphere_sphere( A, B, envelope, recorder ) );
+    check_vector( recorder.m_normals[0], V::make( 0.0, -1.0, 0.0) );
+    BOOST_CHECK( recorder.m_distances[0] > 0.0f );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(contacts_sphere_capsule_test)
+{
+  Recorder recorder;
+
+  geometry::Sphere<V>  const A = geometry::make_sphere( V::make( 0.5, 1.4, 0.0), 0.5f );
+  geometry::Capsule<V> const B = geometry::make_capsule( 1.0f, V::make( -1.0, 0.0, 0.0), V::make( 1.0, 0.0, 0.0) );
+
+  BOOST_CHECK( geometry::contacts_sphere_capsule( A, B, 0.01f, recorder ) );
+  BOOST_CHECK_EQUAL( recorder.size(), 1u );
+  check_vector( recorder.m_normals[0], V::make( 0.0, -1.0, 0.0) );
+  BOOST_CHECK_CLOSE( recorder.m_distances[0], -0.1f, 0.01f );
+}
+
+BOOST_AUTO_TEST_CASE(contacts_sphere_obb_test)
+{
+  T const envelope = 0.01f;
+
+  geometry::OBB<MT> const box = geometry::make_obb<MT>( V::make( 0.0, 0.0, 0.0), Q::identity(), V::make( 1.0, 1.0, 1.0) );
+
+  // Sphere resting on top face of box
+  {
+    Recorder recorder;
+
+    geometry::Sphere<V> const sphere = geometry::make_sphere( V::make( 0.2, 1.4, 0.3), 0.5f );
+
+    BOOST_CHECK( geometry::contacts_sphere_obb( sphere, box, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 1u );
+    check_vector( recorder.m_normals[0], V::make( 0.0, -1.0, 0.0) );
+    check_vector( recorder.m_points[0],  V::make( 0.2, 0.95, 0.3) );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], -0.1f, 0.01f );
+  }
+  // Sphere center inside the box, closest to the minus x face
+  {
+    Recorder recorder;
+
+    geometry::Sphere<V> const sphere = geometry::make_sphere( V::make( -0.8, 0.0, 0.0), 0.5f );
+
+    BOOST_CHECK( geometry::contacts_sphere_obb( sphere, box, envelope, recorder ) );
+    check_vector( recorder.m_normals[0], V::make( 1.0, 0.0, 0.0) );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], -0.7f, 0.01f );
+  }
+  // Sphere near a corner of a rotated box
+  {
+    Recorder recorder;
+
+    Q const q = Q::Ru( VT::pi_quarter(), V::k() );
+
+    geometry::OBB<MT>   const rotated = geometry::make_obb<MT>( V::make( 0.0, 0.0, 0.0), q, V::make( 1.0, 1.0, 1.0) );
+    geometry::Sphere<V> const sphere  = geometry::make_sphere( V::make( 0.0, 1.9, 0.0), 0.5f );
+
+    BOOST_CHECK( geometry::contacts_sphere_obb( sphere, rotated, envelope, recorder ) );
+    check_vector( recorder.m_normals[0], V::make( 0.0, -1.0, 0.0) );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], 1.9f - 0.5f - std::sqrt(2.0f), 0.1f );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(contacts_capsule_capsule_test)
+{
+  T const envelope = 0.01f;
+
+  // Crossing capsules
+  {
+    Recorder recorder;
+
+    geometry::Capsule<V> const A = geometry::make_capsule( 0.5f, V::make( -1.0, 0.0, 0.0), V::make( 1.0, 0.0, 0.0) );
+    geometry::Capsule<V> const B = geometry::make_capsule( 0.5f, V::make(  0.0, 0.9, -1.0), V::make( 0.0, 0.9, 1.0) );
+
+    BOOST_CHECK( geometry::contacts_capsule_capsule( A, B, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 1u );
+    check_vector( recorder.m_normals[0], V::make( 0.0, 1.0, 0.0) );
+    check_vector( recorder.m_points[0],  V::make( 0.0, 0.45, 0.0) );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], -0.1f, 0.01f );
+  }
+  // Parallel capsules lying side by side, overlapping on x in [0..1]
+  {
+    Recorder recorder;
+
+    geometry::Capsule<V> const A = geometry::make_capsule( 0.5f, V::make( -1.0, 0.0, 0.0), V::make( 1.0, 0.0, 0.0) );
+    geometry::Capsule<V> const B = geometry::make_capsule( 0.5f, V::make(  0.0, 0.0, 0.9), V::make( 2.0, 0.0, 0.9) );
+
+    BOOST_CHECK( geometry::contacts_capsule_capsule( A, B, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 2u );
+    check_vector( recorder.m_points[0], V::make( 0.0, 0.0, 0.45) );
+    check_vector( recorder.m_points[1], V::make( 1.0, 0.0, 0.45) );
+    check_vector( recorder.m_normals[0], V::make( 0.0, 0.0, 1.0) );
+    check_vector( recorder.m_normals[1], V::make( 0.0, 0.0, 1.0) );
+  }
+  // Separated
+  {
+    Recorder recorder;
+
+    geometry::Capsule<V> const A = geometry::make_capsule( 0.5f, V::make( -1.0, 0.0, 0.0), V::make( 1.0, 0.0, 0.0) );
+    geometry::Capsule<V> const B = geometry::make_capsule( 0.5f, V::make(  2.1, 0.0, 0.0), V::make( 3.0, 0.0, 0.0) );
+
+    BOOST_CHECK( !geometry::contacts_capsule_capsule( A, B, envelope, recorder ) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(contacts_capsule_obb_test)
+{
+  T const envelope = 0.01f;
+
+  geometry::OBB<MT> const ground = geometry::make_obb<MT>( V::make( 0.0, -1.0, 0.0), Q::identity(), V::make( 10.0, 1.0, 10.0) );
+
+  // Capsule lying on the ground gives a contact at each end
+  {
+    Recorder recorder;
+
+    geometry::Capsule<V> const capsule = geometry::make_capsule( 0.5f, V::make( -1.0, 0.45, 0.0), V::make( 1.0, 0.45, 0.0) );
+
+    BOOST_CHECK( geometry::contacts_capsule_obb( capsule, ground, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 2u );
+    for(size_t i = 0u; i < recorder.size(); ++i)
+    {
+      check_vector( recorder.m_normals[i], V::make( 0.0, -1.0, 0.0) );
+      BOOST_CHECK_CLOSE( recorder.m_distances[i], -0.05f, 0.1f );
+    }
+  }
+  // Capsule lying across the top edge of a box only touches in the middle
+  {
+    Recorder recorder;
+
+    geometry::OBB<MT>     const box     = geometry::make_obb<MT>( V::make( 0.0, 0.0, 0.0), Q::identity(), V::make( 1.0, 1.0, 1.0) );
+    geometry::Capsule<V>  const capsule = geometry::make_capsule( 0.25f, V::make( 0.0, 2.1, 0.0), V::make( 2.1, 0.0, 0.0) );
+
+    BOOST_CHECK( geometry::contacts_capsule_obb( capsule, box, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 1u );
+    // The ternary search only finds the closest point up to float precision
+    V const n = V::make( -1.0, -1.0, 0.0)/std::sqrt(2.0f);
+    BOOST_CHECK_SMALL( recorder.m_normals[0](0) - n(0), 0.001f );
+    BOOST_CHECK_SMALL( recorder.m_normals[0](1) - n(1), 0.001f );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], 0.1f/std::sqrt(2.0f) - 0.25f, 0.1f );
+  }
+  // Capsule high above the ground
+  {
+    Recorder recorder;
+
+    geometry::Capsule<V> const capsule = geometry::make_capsule( 0.5f, V::make( -1.0, 2.0, 0.0), V::make( 1.0, 2.0, 0.0) );
+
+    BOOST_CHECK( !geometry::contacts_capsule_obb( capsule, ground, envelope, recorder ) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(contacts_obb_obb_test)
+{
+  T const envelope = 0.01f;
+
+  geometry::OBB<MT> const ground = geometry::make_obb<MT>( V::make( 0.0, -1.0, 0.0), Q::identity(), V::make( 10.0, 1.0, 10.0) );
+
+  // Box resting on the ground gives the four corners of its bottom face
+  {
+    Recorder recorder;
+
+    geometry::OBB<MT> const box = geometry::make_obb<MT>( V::make( 1.0, 0.45, 2.0), Q::identity(), V::make( 0.5, 0.5, 0.5) );
+
+    BOOST_CHECK( geometry::contacts_obb_obb( ground, box, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 4u );
+    for(size_t i = 0u; i < recorder.size(); ++i)
+    {
+      check_vector( recorder.m_normals[i], V::make( 0.0, 1.0, 0.0) );
+      BOOST_CHECK_CLOSE( recorder.m_distances[i], -0.05f, 0.1f );
+      BOOST_CHECK_SMALL( recorder.m_points[i](1) + 0.025f, 0.0001f );
+    }
+  }
+  // Same but with the arguments swapped flips the normals
+  {
+    Recorder recorder;
+
+    geometry::OBB<MT> const box = geometry::make_obb<MT>( V::make( 1.0, 0.45, 2.0), Q::identity(), V::make( 0.5, 0.5, 0.5) );
+
+    BOOST_CHECK( geometry::contacts_obb_obb( box, ground, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 4u );
+    for(size_t i = 0u; i < recorder.size(); ++i)
+      check_vector( recorder.m_normals[i], V::make( 0.0, -1.0, 0.0) );
+  }
+  // A box rotated 45 degrees about the y-axis on top of an equal box is
+  // clipped to an octagon
+  {
+    Recorder recorder;
+
+    Q const q = Q::Ru( VT::pi_quarter(), V::j() );
+
+    geometry::OBB<MT> const bottom = geometry::make_obb<MT>( V::make( 0.0, 0.0, 0.0), Q::identity(), V::make( 0.5, 0.5, 0.5) );
+    geometry::OBB<MT> const top    = geometry::make_obb<MT>( V::make( 0.0, 0.99, 0.0), q, V::make( 0.5, 0.5, 0.5) );
+
+    BOOST_CHECK( geometry::contacts_obb_obb( bottom, top, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 8u );
+    for(size_t i = 0u; i < recorder.size(); ++i)
+    {
+      check_vector( recorder.m_normals[i], V::make( 0.0, 1.0, 0.0) );
+      BOOST_CHECK_CLOSE( recorder.m_distances[i], -0.01f, 0.1f );
+    }
+  }
+  // Edge-edge contact between two boxes balanced on their edges
+  {
+    Recorder recorder;
+
+    Q const qa = Q::Ru( VT::pi_quarter(), V::k() );
+    Q const qb = Q::Ru( VT::pi_quarter(), V::i() );
+
+    T const h = std::sqrt(2.0f)*0.5f;
+
+    geometry::OBB<MT> const A = geometry::make_obb<MT>( V::make( 0.0, 0.0, 0.0), qa, V::make( 0.5, 0.5, 0.5) );
+    geometry::OBB<MT> const B = geometry::make_obb<MT>( V::make( 0.0, 2.0*h - 0.02, 0.0), qb, V::make( 0.5, 0.5, 0.5) );
+
+    BOOST_CHECK( geometry::contacts_obb_obb( A, B, envelope, recorder ) );
+    BOOST_CHECK_EQUAL( recorder.size(), 1u );
+    check_vector( recorder.m_normals[0], V::make( 0.0, 1.0, 0.0) );
+    check_vector( recorder.m_points[0],  V::make( 0.0, h - 0.01f, 0.0) );
+    BOOST_CHECK_CLOSE( recorder.m_distances[0], -0.02f, 0.1f );
+  }
+  // Separated boxes
+  {
+    Recorder recorder;
+
+    geometry::OBB<MT> const box = geometry::make_obb<MT>( V::make( 1.0, 0.6, 2.0), Q::identity(), V::make( 0.5, 0.5, 0.5) );
+
+    BOOST_CHECK( !geometry::contacts_obb_obb( ground, box, envelope, recorder ) );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
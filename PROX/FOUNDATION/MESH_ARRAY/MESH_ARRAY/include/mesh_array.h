@@ -34,6 +34,7 @@
 #include <mesh_array_io_poly.h>
 
 #include <mesh_array_tetgen.h>
+#include <mesh_array_tetgen_cache.h>
 #include <mesh_array_is_positive_orientation.h>
 
 #include <factory/mesh_array_make_box.h>
@@ -19,6 +19,7 @@ namespace mesh_array
     bool         m_quiet_output;       ///< keep output spam as silent as possible, great for RELEASE.
     bool         m_verify_input;       ///< DEBUG: detects plc intersections, i.e. verify "bad" input mesh.
     bool         m_suppress_splitting; ///< suppresses splitting of boundary facets/segments
+    std::string  m_cache_path;         ///< if not empty then generated meshes are cached in this folder and reused for identical input.
     
     TetGenSettings();
     
@@ -0,0 +1,87 @@
+#ifndef MESH_ARRAY_TETGEN_CACHE_H
+#define MESH_ARRAY_TETGEN_CACHE_H
+
+#include <mesh_array_t3mesh.h>
+#include <mesh_array_t4mesh.h>
+#include <mesh_array_vertex_attribute.h>
+#include <mesh_array_tetgen.h>
+
+#include <string>
+
+namespace mesh_array
+{
+
+  /**
+   * Compute the cache key of a tetgen run. The key is a hash of the surface
+   * mesh, its coordinates and the settings that affect the resulting
+   * tetrahedral mesh. Settings that only affect console output or the
+   * intermediate files are not part of the key.
+   *
+   * @param surface    The surface mesh.
+   * @param X          The x-coordinates of the surface mesh.
+   * @param Y          The y-coordinates of the surface mesh.
+   * @param Z          The z-coordinates of the surface mesh.
+   * @param settings   The tetgen settings.
+   *
+   * @return           A hexadecimal string that can be used as a file name.
+   */
+  template<typename T>
+  std::string tetgen_cache_key(
+                               T3Mesh const & surface
+                               , VertexAttribute<T,T3Mesh> const & X
+                               , VertexAttribute<T,T3Mesh> const & Y
+                               , VertexAttribute<T,T3Mesh> const & Z
+                               , TetGenSettings const & settings
+                               );
+
+  /**
+   * Read a cached tetrahedral mesh from a compact binary file. The file
+   * also holds the tetgen input it was made from, and it is only used if
+   * that input is identical to the given surface, coordinates and
+   * settings. File names are just hashes of the input, so this guards
+   * against hash collisions and stale files.
+   *
+   * @return    True if the file existed and was read, false if the file is
+   *            missing, was not written by a compatible build or was made
+   *            from a different input. In that case the mesh is left
+   *            untouched.
+   */
+  template<typename T>
+  bool read_tetgen_cache(
+                         std::string const & filename
+                         , T3Mesh const & surface
+                         , VertexAttribute<T,T3Mesh> const & inX
+                         , VertexAttribute<T,T3Mesh> const & inY
+                         , VertexAttribute<T,T3Mesh> const & inZ
+                         , TetGenSettings const & settings
+                         , T4Mesh & mesh
+                         , VertexAttribute<T,T4Mesh> & X
+                         , VertexAttribute<T,T4Mesh> & Y
+                         , VertexAttribute<T,T4Mesh> & Z
+                         );
+
+  /**
+   * Write a tetrahedral mesh and the tetgen input it was made from to a
+   * compact binary cache file. The file is written under a temporary name
+   * and then renamed, so concurrent runs never see a partially written
+   * file. Failing to write the cache is not an error, the mesh is simply
+   * generated again next time.
+   */
+  template<typename T>
+  void write_tetgen_cache(
+                          std::string const & filename
+                          , T3Mesh const & surface
+                          , VertexAttribute<T,T3Mesh> const & inX
+                          , VertexAttribute<T,T3Mesh> const & inY
+                          , VertexAttribute<T,T3Mesh> const & inZ
+                          , TetGenSettings const & settings
+                          , T4Mesh const & mesh
+                          , VertexAttribute<T,T4Mesh> const & X
+                          , VertexAttribute<T,T4Mesh> const & Y
+                          , VertexAttribute<T,T4Mesh> const & Z
+                          );
+
+} // namespace mesh_array
+
+//MESH_ARRAY_TETGEN_CACHE_H
+#endif
@@ -2,10 +2,13 @@
 
 #include <mesh_array_io_tetgen.h>
 #include <mesh_array_io_poly.h>
+#include <mesh_array_tetgen_cache.h>
 
 
 #include <tetgen.h>
 
+#include <boost/filesystem.hpp>
+
 #include <string>
 #include <sstream>
 
@@ -19,6 +22,7 @@ namespace mesh_array
   , m_quiet_output(false)
   , m_verify_input(false)
   , m_suppress_splitting(false)
+  , m_cache_path("")
   {
   }
   
@@ -94,6 +98,20 @@ namespace mesh_array
               )
   {
     assert(!settings.m_filename.empty() || !"tetgen(): intermediate filename is missing");
+
+    // Meshing the same surface with the same settings always gives the same
+    // result, so a cached mesh is used if one exists.
+    std::string cache_file = "";
+
+    if( ! settings.m_cache_path.empty() )
+    {
+      std::string const key = tetgen_cache_key( surface, inX, inY, inZ, settings );
+
+      cache_file = ( boost::filesystem::path( settings.m_cache_path ) / ( key + ".t4c" ) ).string();
+
+      if( read_tetgen_cache( cache_file, surface, inX, inY, inZ, settings, volume, outX, outY, outZ ) )
+        return;
+    }
     
     write_poly( settings.m_filename + ".poly", surface, inX, inY, inZ );
     
@@ -125,6 +143,9 @@ namespace mesh_array
     out.save_nodes(raw_filename);
         
     read_tetgen( settings.m_filename, volume, outX, outY, outZ );
+
+    if( ! cache_file.empty() )
+      write_tetgen_cache( cache_file, surface, inX, inY, inZ, settings, volume, outX, outY, outZ );
   }
 
   template
@@ -0,0 +1,438 @@
+#include <mesh_array_tetgen_cache.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+namespace mesh_array
+{
+
+  namespace detail
+  {
+
+    // The version must be bumped whenever the file layout or the output of
+    // tetgen changes (new TetGen release or changed command line), otherwise
+    // stale meshes are silently reused.
+    uint32_t const tetgen_cache_magic   = 0x43344d41u;  // "AM4C"
+    uint32_t const tetgen_cache_version = 2u;
+
+    /**
+     * 64-bit FNV-1a hash, simple and good enough for telling meshes apart.
+     */
+    class Hasher
+    {
+    protected:
+
+      uint64_t m_value;
+
+    public:
+
+      Hasher()
+      : m_value(14695981039346656037ull)
+      {}
+
+      void add(void const * data, size_t const & bytes)
+      {
+        unsigned char const * ptr = static_cast<unsigned char const *>(data);
+
+        for(size_t i = 0u; i < bytes; ++i)
+        {
+          this->m_value ^= ptr[i];
+          this->m_value *= 1099511628211ull;
+        }
+      }
+
+      template<typename S>
+      void add(S const & value)
+      {
+        this->add( &value, sizeof(S) );
+      }
+
+      uint64_t const & value() const
+      {
+        return this->m_value;
+      }
+    };
+
+    struct TetGenCacheHeader
+    {
+      uint32_t m_magic;
+      uint32_t m_version;
+      uint32_t m_real_bytes;        ///< sizeof(T) of the stored coordinates
+      uint32_t m_reserved;
+      uint64_t m_input_bytes;       ///< Size of the stored tetgen input
+      uint64_t m_vertices;
+      uint64_t m_tetrahedra;
+    };
+
+    template<typename S>
+    inline void append(std::vector<char> & bytes, S const & value)
+    {
+      char const * ptr = reinterpret_cast<char const *>( &value );
+
+      bytes.insert( bytes.end(), ptr, ptr + sizeof(S) );
+    }
+
+    /**
+     * Everything that determines the output of a tetgen run: the settings
+     * that affect the tetrahedral mesh, the surface coordinates and the
+     * surface triangles. The cache key is a hash of these bytes, and the
+     * bytes themselves are stored in the cache file, so a hash collision or
+     * a stale file is detected by comparing them.
+     */
+    template<typename T>
+    inline std::vector<char> make_tetgen_cache_input(
+                                                     T3Mesh const & surface
+                                                     , VertexAttribute<T,T3Mesh> const & X
+                                                     , VertexAttribute<T,T3Mesh> const & Y
+                                                     , VertexAttribute<T,T3Mesh> const & Z
+                                                     , TetGenSettings const & settings
+                                                     )
+    {
+      size_t const V = surface.vertex_size();
+      size_t const F = surface.triangle_size();
+
+      std::vector<char> bytes;
+
+      bytes.reserve( 2u*sizeof(double) + 2u + 2u*sizeof(uint64_t) + 3u*V*sizeof(T) + 3u*F*sizeof(uint64_t) );
+
+      append( bytes, settings.m_quality_ratio                              );
+      append( bytes, settings.m_maximum_volume                             );
+      append( bytes, static_cast<uint8_t>( settings.m_verify_input )       );
+      append( bytes, static_cast<uint8_t>( settings.m_suppress_splitting ) );
+
+      append( bytes, static_cast<uint64_t>( V ) );
+      append( bytes, static_cast<uint64_t>( F ) );
+
+      for(size_t idx = 0u; idx < V; ++idx)
+      {
+        Vertex const & v = surface.vertex(idx);
+
+        append( bytes, X(v) );
+        append( bytes, Y(v) );
+        append( bytes, Z(v) );
+      }
+
+      for(size_t idx = 0u; idx < F; ++idx)
+      {
+        Triangle const & t = surface.triangle(idx);
+
+        append( bytes, static_cast<uint64_t>( t.i() ) );
+        append( bytes, static_cast<uint64_t>( t.j() ) );
+        append( bytes, static_cast<uint64_t>( t.k() ) );
+      }
+
+      return bytes;
+    }
+
+  }// namespace detail
+
+  template<typename T>
+  std::string tetgen_cache_key(
+                               T3Mesh const & surface
+                               , VertexAttribute<T,T3Mesh> const & X
+                               , VertexAttribute<T,T3Mesh> const & Y
+                               , VertexAttribute<T,T3Mesh> const & Z
+                               , TetGenSettings const & settings
+                               )
+  {
+    std::vector<char> const input = detail::make_tetgen_cache_input( surface, X, Y, Z, settings );
+
+    detail::Hasher hasher;
+
+    hasher.add( detail::tetgen_cache_version );
+    hasher.add( static_cast<uint32_t>( sizeof(T) ) );
+
+    if( ! input.empty() )
+      hasher.add( &input[0], input.size() );
+
+    std::stringstream key;
+
+    key << std::hex << std::setw(16) << std::setfill('0') << hasher.value();
+
+    return key.str();
+  }
+
+  template<typename T>
+  bool read_tetgen_cache(
+                         std::string const & filename
+                         , T3Mesh const & surface
+                         , VertexAttribute<T,T3Mesh> const & inX
+                         , VertexAttribute<T,T3Mesh> const & inY
+                         , VertexAttribute<T,T3Mesh> const & inZ
+                         , TetGenSettings const & settings
+                         , T4Mesh & mesh
+                         , VertexAttribute<T,T4Mesh> & X
+                         , VertexAttribute<T,T4Mesh> & Y
+                         , VertexAttribute<T,T4Mesh> & Z
+                         )
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if( ! file.is_open() )
+      return false;
+
+    // The whole file is read with one call, so loading a cached mesh is
+    // bounded by disk bandwidth rather than by parsing.
+    file.seekg(0, std::ios::end);
+    std::streamoff const bytes = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    if( bytes < static_cast<std::streamoff>( sizeof(detail::TetGenCacheHeader) ) )
+      return false;
+
+    std::vector<char> buffer( static_cast<size_t>( bytes ) );
+
+    file.read( &buffer[0], bytes );
+
+    if( ! file )
+      return false;
+
+    detail::TetGenCacheHeader header;
+
+    std::memcpy( &header, &buffer[0], sizeof(header) );
+
+    if( header.m_magic != detail::tetgen_cache_magic )
+      return false;
+    if( header.m_version != detail::tetgen_cache_version )
+      return false;
+    if( header.m_real_bytes != sizeof(T) )
+      return false;
+
+    std::vector<char> const input = detail::make_tetgen_cache_input( surface, inX, inY, inZ, settings );
+
+    size_t const I = static_cast<size_t>( header.m_input_bytes );
+    size_t const N = static_cast<size_t>( header.m_vertices );
+    size_t const K = static_cast<size_t>( header.m_tetrahedra );
+
+    size_t const expected = sizeof(header) + I + 3u*N*sizeof(T) + 4u*K*sizeof(uint32_t);
+
+    if( static_cast<size_t>( bytes ) != expected || N == 0u || K == 0u )
+      return false;
+
+    // The key is only a hash, the file must have been made from this very input
+    if( I != input.size() || ( I > 0u && std::memcmp( &buffer[sizeof(header)], &input[0], I ) != 0 ) )
+      return false;
+
+    // The payload offsets depend on the input size and need not be aligned,
+    // so the data is copied out of the byte buffer rather than cast in place.
+    std::vector<T>        coords( 3u*N );
+    std::vector<uint32_t> indices( 4u*K );
+
+    std::memcpy( &coords[0],  &buffer[sizeof(header) + I],                   3u*N*sizeof(T) );
+    std::memcpy( &indices[0], &buffer[sizeof(header) + I + 3u*N*sizeof(T)], 4u*K*sizeof(uint32_t) );
+
+    for(size_t idx = 0u; idx < 4u*K; ++idx)
+    {
+      if( indices[idx] >= N )
+        return false;
+    }
+
+    mesh.clear();
+
+    mesh.set_capacity(N, K);
+
+    X.bind(mesh);
+    Y.bind(mesh);
+    Z.bind(mesh);
+
+    std::vector<Vertex> vertices(N);
+
+    for(size_t idx = 0u; idx < N; ++idx)
+    {
+      Vertex v = mesh.push_vertex();
+
+      X(v) = coords[idx];
+      Y(v) = coords[N + idx];
+      Z(v) = coords[2u*N + idx];
+
+      vertices[idx] = v;
+    }
+
+    for(size_t idx = 0u; idx < K; ++idx)
+    {
+      mesh.push_tetrahedron(
+                            vertices[ indices[4u*idx     ] ]
+                            , vertices[ indices[4u*idx + 1u] ]
+                            , vertices[ indices[4u*idx + 2u] ]
+                            , vertices[ indices[4u*idx + 3u] ]
+                            );
+    }
+
+    return true;
+  }
+
+  template<typename T>
+  void write_tetgen_cache(
+                          std::string const & filename
+                          , T3Mesh const & surface
+                          , VertexAttribute<T,T3Mesh> const & inX
+                          , VertexAttribute<T,T3Mesh> const & inY
+                          , VertexAttribute<T,T3Mesh> const & inZ
+                          , TetGenSettings const & settings
+                          , T4Mesh const & mesh
+                          , VertexAttribute<T,T4Mesh> const & X
+                          , VertexAttribute<T,T4Mesh> const & Y
+                          , VertexAttribute<T,T4Mesh> const & Z
+                          )
+  {
+    size_t const N = mesh.vertex_size();
+    size_t const K = mesh.tetrahedron_size();
+
+    assert( N < 0xffffffffu || !"write_tetgen_cache(): too many vertices for 32 bit indices");
+
+    boost::filesystem::path const path( filename );
+
+    boost::system::error_code error;
+
+    if( path.has_parent_path() )
+      boost::filesystem::create_directories( path.parent_path(), error );
+
+    std::string const temporary = filename + ".tmp";
+
+    {
+      std::ofstream file(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+      if( ! file.is_open() )
+        return;
+
+      std::vector<char> const input = detail::make_tetgen_cache_input( surface, inX, inY, inZ, settings );
+
+      detail::TetGenCacheHeader header;
+
+      header.m_magic       = detail::tetgen_cache_magic;
+      header.m_version     = detail::tetgen_cache_version;
+      header.m_real_bytes  = sizeof(T);
+      header.m_reserved    = 0u;
+      header.m_input_bytes = input.size();
+      header.m_vertices    = N;
+      header.m_tetrahedra  = K;
+
+      std::vector<T>        coords( 3u*N );
+      std::vector<uint32_t> indices( 4u*K );
+
+      for(size_t idx = 0u; idx < N; ++idx)
+      {
+        Vertex const & v = mesh.vertex(idx);
+
+        assert( v.idx() == idx || !"write_tetgen_cache(): vertices must be stored in index order");
+
+        coords[idx]        = X(v);
+        coords[N + idx]    = Y(v);
+        coords[2u*N + idx] = Z(v);
+      }
+
+      for(size_t idx = 0u; idx < K; ++idx)
+      {
+        Tetrahedron const & t = mesh.tetrahedron(idx);
+
+        indices[4u*idx     ] = static_cast<uint32_t>( t.i() );
+        indices[4u*idx + 1u] = static_cast<uint32_t>( t.j() );
+        indices[4u*idx + 2u] = static_cast<uint32_t>( t.k() );
+        indices[4u*idx + 3u] = static_cast<uint32_t>( t.m() );
+      }
+
+      file.write( reinterpret_cast<char const *>( &header ), sizeof(header) );
+
+      if( ! input.empty() )
+        file.write( &input[0], input.size() );
+      if( N > 0u )
+        file.write( reinterpret_cast<char const *>( &coords[0] ), coords.size()*sizeof(T) );
+      if( K > 0u )
+        file.write( reinterpret_cast<char const *>( &indices[0] ), indices.size()*sizeof(uint32_t) );
+
+      if( ! file )
+      {
+        file.close();
+        boost::filesystem::remove( temporary, error );
+        return;
+      }
+    }
+
+    boost::filesystem::rename( temporary, filename, error );
+
+    if( error )
+      boost::filesystem::remove( temporary, error );
+  }
+
+  template
+  std::string tetgen_cache_key<float>(
+                                      T3Mesh const & surface
+                                      , VertexAttribute<float,T3Mesh> const & X
+                                      , VertexAttribute<float,T3Mesh> const & Y
+                                      , VertexAttribute<float,T3Mesh> const & Z
+                                      , TetGenSettings const & settings
+                                      );
+
+  template
+  std::string tetgen_cache_key<double>(
+                                       T3Mesh const & surface
+                                       , VertexAttribute<double,T3Mesh> const & X
+                                       , VertexAttribute<double,T3Mesh> const & Y
+                                       , VertexAttribute<double,T3Mesh> const & Z
+                                       , TetGenSettings const & settings
+                                       );
+
+  template
+  bool read_tetgen_cache<float>(
+                                std::string const & filename
+                                , T3Mesh const & surface
+                                , VertexAttribute<float,T3Mesh> const & inX
+                                , VertexAttribute<float,T3Mesh> const & inY
+                                , VertexAttribute<float,T3Mesh> const & inZ
+                                , TetGenSettings const & settings
+                                , T4Mesh & mesh
+                                , VertexAttribute<float,T4Mesh> & X
+                                , VertexAttribute<float,T4Mesh> & Y
+                                , VertexAttribute<float,T4Mesh> & Z
+                                );
+
+  template
+  bool read_tetgen_cache<double>(
+                                 std::string const & filename
+                                 , T3Mesh const & surface
+                                 , VertexAttribute<double,T3Mesh> const & inX
+                                 , VertexAttribute<double,T3Mesh> const & inY
+                                 , VertexAttribute<double,T3Mesh> const & inZ
+                                 , TetGenSettings const & settings
+                                 , T4Mesh & mesh
+                                 , VertexAttribute<double,T4Mesh> & X
+                                 , VertexAttribute<double,T4Mesh> & Y
+                                 , VertexAttribute<double,T4Mesh> & Z
+                                 );
+
+  template
+  void write_tetgen_cache<float>(
+                                 std::string const & filename
+                                 , T3Mesh const & surface
+                                 , VertexAttribute<float,T3Mesh> const & inX
+                                 , VertexAttribute<float,T3Mesh> const & inY
+                                 , VertexAttribute<float,T3Mesh> const & inZ
+                                 , TetGenSettings const & settings
+                                 , T4Mesh const & mesh
+                                 , VertexAttribute<float,T4Mesh> const & X
+                                 , VertexAttribute<float,T4Mesh> const & Y
+                                 , VertexAttribute<float,T4Mesh> const & Z
+                                 );
+
+  template
+  void write_tetgen_cache<double>(
+                                  std::string const & filename
+                                  , T3Mesh const & surface
+                                  , VertexAttribute<double,T3Mesh> const & inX
+                                  , VertexAttribute<double,T3Mesh> const & inY
+                                  , VertexAttribute<double,T3Mesh> const & inZ
+                                  , TetGenSettings const & settings
+                                  , T4Mesh const & mesh
+                                  , VertexAttribute<double,T4Mesh> const & X
+                                  , VertexAttribute<double,T4Mesh> const & Y
+                                  , VertexAttribute<double,T4Mesh> const & Z
+                                  );
+
+} // namespace mesh_array
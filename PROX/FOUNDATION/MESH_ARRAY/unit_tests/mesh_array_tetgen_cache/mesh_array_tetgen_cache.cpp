@@ -0,0 +1,259 @@
+#include <mesh_array.h>
+#include <tiny.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <string>
+
+typedef tiny::MathTypes<float> MT;
+typedef MT::real_type          T;
+
+namespace
+{
+
+  size_t count_cache_files(std::string const & folder)
+  {
+    size_t count = 0u;
+
+    boost::filesystem::directory_iterator end;
+
+    for(boost::filesystem::directory_iterator it(folder); it != end; ++it)
+    {
+      if( it->path().extension() == ".t4c" )
+        ++count;
+    }
+
+    return count;
+  }
+
+  void check_equal(
+                   mesh_array::T4Mesh const & A
+                   , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & AX
+                   , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & AY
+                   , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & AZ
+                   , mesh_array::T4Mesh const & B
+                   , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & BX
+                   , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & BY
+                   , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & BZ
+                   )
+  {
+    BOOST_REQUIRE_EQUAL( A.vertex_size(),      B.vertex_size()      );
+    BOOST_REQUIRE_EQUAL( A.tetrahedron_size(), B.tetrahedron_size() );
+
+    for(size_t idx = 0u; idx < A.vertex_size(); ++idx)
+    {
+      BOOST_CHECK_EQUAL( AX( A.vertex(idx) ), BX( B.vertex(idx) ) );
+      BOOST_CHECK_EQUAL( AY( A.vertex(idx) ), BY( B.vertex(idx) ) );
+      BOOST_CHECK_EQUAL( AZ( A.vertex(idx) ), BZ( B.vertex(idx) ) );
+    }
+
+    for(size_t idx = 0u; idx < A.tetrahedron_size(); ++idx)
+    {
+      BOOST_CHECK_EQUAL( A.tetrahedron(idx).i(), B.tetrahedron(idx).i() );
+      BOOST_CHECK_EQUAL( A.tetrahedron(idx).j(), B.tetrahedron(idx).j() );
+      BOOST_CHECK_EQUAL( A.tetrahedron(idx).k(), B.tetrahedron(idx).k() );
+      BOOST_CHECK_EQUAL( A.tetrahedron(idx).m(), B.tetrahedron(idx).m() );
+    }
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE(mesh_array);
+
+BOOST_AUTO_TEST_CASE(mesh_array_tetgen_cache_reuse)
+{
+  std::string const folder = "tetgen_cache_unit_test";
+
+  boost::filesystem::remove_all( folder );
+
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<MT>(1.0f, 2.0f, 3.0f, surface, sX, sY, sZ);
+
+  mesh_array::TetGenSettings settings = mesh_array::tetgen_quality_settings();
+
+  settings.m_cache_path = folder;
+
+  mesh_array::T4Mesh A;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AZ;
+
+  mesh_array::tetgen(surface, sX, sY, sZ, A, AX, AY, AZ, settings);
+
+  BOOST_CHECK( A.tetrahedron_size() > 0u );
+  BOOST_CHECK_EQUAL( count_cache_files(folder), 1u );
+
+  // Second run must come from the cache and give the very same mesh
+  mesh_array::T4Mesh B;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BZ;
+
+  std::string const key  = mesh_array::tetgen_cache_key(surface, sX, sY, sZ, settings);
+  std::string const file = ( boost::filesystem::path(folder) / (key + ".t4c") ).string();
+
+  BOOST_CHECK( mesh_array::read_tetgen_cache(file, surface, sX, sY, sZ, settings, B, BX, BY, BZ) );
+
+  check_equal(A, AX, AY, AZ, B, BX, BY, BZ);
+
+  mesh_array::tetgen(surface, sX, sY, sZ, B, BX, BY, BZ, settings);
+
+  check_equal(A, AX, AY, AZ, B, BX, BY, BZ);
+
+  BOOST_CHECK_EQUAL( count_cache_files(folder), 1u );
+
+  // Different settings or a different surface must give different keys
+  mesh_array::TetGenSettings other = settings;
+
+  other.m_maximum_volume = 0.5;
+
+  BOOST_CHECK( mesh_array::tetgen_cache_key(surface, sX, sY, sZ, other) != key );
+
+  other = settings;
+
+  other.m_quiet_output = false;
+  other.m_filename     = "other";
+
+  BOOST_CHECK( mesh_array::tetgen_cache_key(surface, sX, sY, sZ, other) == key );
+
+  sX( surface.vertex(0) ) += 0.001f;
+
+  BOOST_CHECK( mesh_array::tetgen_cache_key(surface, sX, sY, sZ, settings) != key );
+
+  boost::filesystem::remove_all( folder );
+}
+
+BOOST_AUTO_TEST_CASE(mesh_array_tetgen_cache_corrupt_file)
+{
+  std::string const folder = "tetgen_cache_unit_test_corrupt";
+
+  boost::filesystem::remove_all( folder );
+  boost::filesystem::create_directories( folder );
+
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<MT>(1.0f, 1.0f, 1.0f, surface, sX, sY, sZ);
+
+  mesh_array::TetGenSettings settings = mesh_array::tetgen_quality_settings();
+
+  settings.m_cache_path = folder;
+
+  std::string const key  = mesh_array::tetgen_cache_key(surface, sX, sY, sZ, settings);
+  std::string const file = ( boost::filesystem::path(folder) / (key + ".t4c") ).string();
+
+  {
+    std::ofstream garbage(file.c_str());
+
+    garbage << "this is not a cached mesh";
+  }
+
+  mesh_array::T4Mesh A;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AZ;
+
+  BOOST_CHECK( ! mesh_array::read_tetgen_cache(file, surface, sX, sY, sZ, settings, A, AX, AY, AZ) );
+
+  // A bad file is ignored and replaced by a freshly generated mesh
+  mesh_array::tetgen(surface, sX, sY, sZ, A, AX, AY, AZ, settings);
+
+  BOOST_CHECK( A.tetrahedron_size() > 0u );
+
+  mesh_array::T4Mesh B;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BZ;
+
+  BOOST_CHECK( mesh_array::read_tetgen_cache(file, surface, sX, sY, sZ, settings, B, BX, BY, BZ) );
+
+  check_equal(A, AX, AY, AZ, B, BX, BY, BZ);
+
+  boost::filesystem::remove_all( folder );
+}
+
+BOOST_AUTO_TEST_CASE(mesh_array_tetgen_cache_other_input)
+{
+  std::string const folder = "tetgen_cache_unit_test_other_input";
+
+  boost::filesystem::remove_all( folder );
+
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<MT>(1.0f, 1.0f, 1.0f, surface, sX, sY, sZ);
+
+  mesh_array::T3Mesh other;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> oX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> oY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> oZ;
+
+  mesh_array::make_box<MT>(2.0f, 1.0f, 3.0f, other, oX, oY, oZ);
+
+  mesh_array::TetGenSettings settings = mesh_array::tetgen_quality_settings();
+
+  mesh_array::T4Mesh A;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> AZ;
+
+  mesh_array::tetgen(surface, sX, sY, sZ, A, AX, AY, AZ, settings);
+
+  mesh_array::T4Mesh O;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> OX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> OY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> OZ;
+
+  mesh_array::tetgen(other, oX, oY, oZ, O, OX, OY, OZ, settings);
+
+  // Pretend the key of the other surface collides with ours, or that the
+  // file is stale, by storing its mesh under our key
+  settings.m_cache_path = folder;
+
+  std::string const key  = mesh_array::tetgen_cache_key(surface, sX, sY, sZ, settings);
+  std::string const file = ( boost::filesystem::path(folder) / (key + ".t4c") ).string();
+
+  mesh_array::write_tetgen_cache(file, other, oX, oY, oZ, settings, O, OX, OY, OZ);
+
+  mesh_array::T4Mesh B;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BX;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BY;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> BZ;
+
+  BOOST_CHECK(   mesh_array::read_tetgen_cache(file, other,   oX, oY, oZ, settings, B, BX, BY, BZ) );
+  BOOST_CHECK( ! mesh_array::read_tetgen_cache(file, surface, sX, sY, sZ, settings, B, BX, BY, BZ) );
+
+  mesh_array::TetGenSettings coarse = settings;
+
+  coarse.m_maximum_volume = 0.5;
+
+  BOOST_CHECK( ! mesh_array::read_tetgen_cache(file, other,   oX, oY, oZ, coarse,   B, BX, BY, BZ) );
+
+  // The file is not used, our mesh is generated and replaces it
+  mesh_array::tetgen(surface, sX, sY, sZ, B, BX, BY, BZ, settings);
+
+  check_equal(A, AX, AY, AZ, B, BX, BY, BZ);
+
+  BOOST_CHECK( mesh_array::read_tetgen_cache(file, surface, sX, sY, sZ, settings, B, BX, BY, BZ) );
+
+  check_equal(A, AX, AY, AZ, B, BX, BY, BZ);
+
+  boost::filesystem::remove_all( folder );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -4,6 +4,7 @@
 #include <sparse_if_then_else.h>
 #include <sparse_traits.h>
 #include <sparse_block.h>
+#include <sparse_block_kernels.h>
 #include <sparse_vector.h>
 #include <sparse_compressed_row_matrix.h>
 #include <sparse_compressed_vector.h>
@@ -0,0 +1,128 @@
+#ifndef SPARSE_BLOCK_KERNELS_H
+#define SPARSE_BLOCK_KERNELS_H
+
+#include <sparse_block.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace sparse
+{
+  /**
+   * @file
+   * Specialized block-vector products for the 4x6 and 6x4 single precision
+   * blocks of the contact Jacobian and W J^T. They are picked up by overload
+   * resolution in place of the general block-vector product, so row_prod,
+   * column_prod and the blas2 products get them for free.
+   *
+   * Each SIMD lane holds one row of the block. The columns are gathered by
+   * transposing the rows and the products are accumulated column by column,
+   * that is in the same order as the general version, so the results are
+   * bit identical. Blocks are stored back to back in containers and are not
+   * aligned to the SIMD width, hence all loads and stores are unaligned.
+   */
+
+#if defined(__SSE__)
+
+  /**
+   * Block-vector product for 4x6 blocks, res += lhs*rhs
+   */
+  inline void prod(Block<4,6,float> const& lhs, Block<6,1,float> const& rhs, Block<4,1,float>& res)
+  {
+    float const * A = lhs.begin();
+    float const * x = rhs.begin();
+    float       * y = res.begin();
+
+    // Columns 0 to 3
+    __m128 c0 = _mm_loadu_ps(A     );
+    __m128 c1 = _mm_loadu_ps(A +  6);
+    __m128 c2 = _mm_loadu_ps(A + 12);
+    __m128 c3 = _mm_loadu_ps(A + 18);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    // Columns 2 to 5, only the last two are used
+    __m128 d0 = _mm_loadu_ps(A +  2);
+    __m128 d1 = _mm_loadu_ps(A +  8);
+    __m128 d2 = _mm_loadu_ps(A + 14);
+    __m128 d3 = _mm_loadu_ps(A + 20);
+    _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+
+    __m128 dot = _mm_setzero_ps();
+    dot = _mm_add_ps(dot, _mm_mul_ps(c0, _mm_set1_ps(x[0])));
+    dot = _mm_add_ps(dot, _mm_mul_ps(c1, _mm_set1_ps(x[1])));
+    dot = _mm_add_ps(dot, _mm_mul_ps(c2, _mm_set1_ps(x[2])));
+    dot = _mm_add_ps(dot, _mm_mul_ps(c3, _mm_set1_ps(x[3])));
+    dot = _mm_add_ps(dot, _mm_mul_ps(d2, _mm_set1_ps(x[4])));
+    dot = _mm_add_ps(dot, _mm_mul_ps(d3, _mm_set1_ps(x[5])));
+
+    _mm_storeu_ps(y, _mm_add_ps(_mm_loadu_ps(y), dot));
+  }
+
+  /**
+   * Block-vector product for 6x4 blocks, res += lhs*rhs
+   */
+  inline void prod(Block<6,4,float> const& lhs, Block<4,1,float> const& rhs, Block<6,1,float>& res)
+  {
+    float const * A = lhs.begin();
+    float const * x = rhs.begin();
+    float       * y = res.begin();
+
+    // Columns of rows 0 to 3
+    __m128 c0 = _mm_loadu_ps(A     );
+    __m128 c1 = _mm_loadu_ps(A +  4);
+    __m128 c2 = _mm_loadu_ps(A +  8);
+    __m128 c3 = _mm_loadu_ps(A + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    // Columns of rows 4 and 5, padded with two zero rows
+    __m128 d0 = _mm_loadu_ps(A + 16);
+    __m128 d1 = _mm_loadu_ps(A + 20);
+    __m128 d2 = _mm_setzero_ps();
+    __m128 d3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+
+#if defined(__AVX__)
+    __m256 const col0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), d0, 1);
+    __m256 const col1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), d1, 1);
+    __m256 const col2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), d2, 1);
+    __m256 const col3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), d3, 1);
+
+    __m256 dot = _mm256_setzero_ps();
+    dot = _mm256_add_ps(dot, _mm256_mul_ps(col0, _mm256_set1_ps(x[0])));
+    dot = _mm256_add_ps(dot, _mm256_mul_ps(col1, _mm256_set1_ps(x[1])));
+    dot = _mm256_add_ps(dot, _mm256_mul_ps(col2, _mm256_set1_ps(x[2])));
+    dot = _mm256_add_ps(dot, _mm256_mul_ps(col3, _mm256_set1_ps(x[3])));
+
+    __m128 const lo = _mm256_castps256_ps128(dot);
+    __m128 const hi = _mm256_extractf128_ps(dot, 1);
+#else
+    __m128 lo = _mm_setzero_ps();
+    lo = _mm_add_ps(lo, _mm_mul_ps(c0, _mm_set1_ps(x[0])));
+    lo = _mm_add_ps(lo, _mm_mul_ps(c1, _mm_set1_ps(x[1])));
+    lo = _mm_add_ps(lo, _mm_mul_ps(c2, _mm_set1_ps(x[2])));
+    lo = _mm_add_ps(lo, _mm_mul_ps(c3, _mm_set1_ps(x[3])));
+
+    __m128 hi = _mm_setzero_ps();
+    hi = _mm_add_ps(hi, _mm_mul_ps(d0, _mm_set1_ps(x[0])));
+    hi = _mm_add_ps(hi, _mm_mul_ps(d1, _mm_set1_ps(x[1])));
+    hi = _mm_add_ps(hi, _mm_mul_ps(d2, _mm_set1_ps(x[2])));
+    hi = _mm_add_ps(hi, _mm_mul_ps(d3, _mm_set1_ps(x[3])));
+#endif
+
+    _mm_storeu_ps(y, _mm_add_ps(_mm_loadu_ps(y), lo));
+
+    // Only two rows are left, so load and store the lower half only
+    __m128 y45 = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64 const *>(y + 4));
+    _mm_storel_pi(reinterpret_cast<__m64 *>(y + 4), _mm_add_ps(y45, hi));
+  }
+
+#endif
+
+} // namespace sparse
+
+// SPARSE_BLOCK_KERNELS_H
+#endif
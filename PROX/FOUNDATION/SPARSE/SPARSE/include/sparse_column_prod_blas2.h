@@ -74,6 +74,31 @@ namespace sparse
       prod( lhs(row, column), rhs, res(row) ); // 2010-05-30 mrtn: This lookup is very expensive - optimize if possible
     }
   }
+
+  /**
+   * Column product between the ith column of lhs with the rhs block where
+   * every column of lhs has exactly two non-zero blocks, and these are kept
+   * as the two blocks of the ith row of a two column matrix. The column
+   * indices of the two column matrix are the rows of the blocks in lhs. No
+   * lookup of the blocks is needed, unlike the version above.
+   * res += lhs_column * rhs
+   */
+  template <typename B1, typename B3, typename B4>
+  inline void column_prod(
+                     TwoColumnMatrix<B1> const& lhs_columns
+                   , B3 const& rhs
+                   , Vector<B4>& res
+                   , size_t const column
+                   )
+  {
+    assert(lhs_columns.ncols() == res.nrows() || !"number of rows in lhs must be the same as number of rows in result");
+
+    size_t idx = 2u * column;
+    prod( lhs_columns[idx], rhs, res( lhs_columns.col_of_idx(idx) ) );
+
+    ++idx;
+    prod( lhs_columns[idx], rhs, res( lhs_columns.col_of_idx(idx) ) );
+  }
 } // namespace sparse
 
 // SPARSE_COLUMN_PROD_BLAS2_H
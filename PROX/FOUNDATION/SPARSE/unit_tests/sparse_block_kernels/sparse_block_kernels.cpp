@@ -0,0 +1,120 @@
+#include <sparse.h>
+#include <sparse_fill.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <cstdlib>
+
+typedef sparse::Block<4,1,float> block4x1_type;
+typedef sparse::Block<6,1,float> block6x1_type;
+typedef sparse::Block<4,6,float> block4x6_type;
+typedef sparse::Block<6,4,float> block6x4_type;
+
+namespace
+{
+
+  template<typename B>
+  void random_block(B & block)
+  {
+    for(size_t i = 0u; i < block.size(); ++i)
+      block[i] = -1.0f + 2.0f*( static_cast<float>( std::rand() ) / static_cast<float>( RAND_MAX ) );
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE(SPARSE);
+
+BOOST_AUTO_TEST_CASE(block_kernels_test)
+{
+  std::srand(42);
+
+  for(size_t n = 0u; n < 100u; ++n)
+  {
+    block4x6_type J;
+    block6x4_type JT;
+    block4x1_type x;
+    block6x1_type u;
+
+    random_block(J);
+    random_block(JT);
+    random_block(x);
+    random_block(u);
+
+    // The specialized kernels must give the very same result as the general versions
+    block4x1_type a;
+    block4x1_type b;
+
+    random_block(a);
+    b = a;
+
+    sparse::prod( J, u, a );
+    sparse::prod<4,6,float>( J, u, b );
+
+    for(size_t i = 0u; i < 4u; ++i)
+      BOOST_CHECK_EQUAL( a[i], b[i] );
+
+    block6x1_type c;
+    block6x1_type d;
+
+    random_block(c);
+    d = c;
+
+    sparse::prod( JT, x, c );
+    sparse::prod<6,4,float>( JT, x, d );
+
+    for(size_t i = 0u; i < 6u; ++i)
+      BOOST_CHECK_EQUAL( c[i], d[i] );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(two_column_column_prod_test)
+{
+  typedef sparse::CompressedRowMatrix<block6x4_type> matrix6x4_type;
+  typedef sparse::CompressedRowMatrix<block4x6_type> matrix4x6_type;
+  typedef sparse::TwoColumnMatrix<block6x4_type>     two_column6x4_type;
+  typedef sparse::Vector<block6x1_type>              vector_type;
+
+  matrix6x4_type JT(4,3,6);
+  sparse::fill(JT(0,0), 0.0f);
+  sparse::fill(JT(1,1), 1.0f);
+  sparse::fill(JT(1,2), 2.0f);
+  sparse::fill(JT(2,0), 3.0f);
+  sparse::fill(JT(2,2), 4.0f);
+  sparse::fill(JT(3,1), 5.0f);
+
+  matrix4x6_type J;
+  sparse::transpose(JT, J);
+
+  // Row k holds the two blocks of column k of JT
+  two_column6x4_type JT_columns;
+  JT_columns.resize(3,4,6);
+
+  for(size_t k = 0u; k < J.nrows(); ++k)
+    for(size_t idx = J.row_idx(k); idx < J.row_idx(k+1u); ++idx)
+      JT_columns( k, J.col_of_idx(idx) ) = JT( J.col_of_idx(idx), k );
+
+  vector_type w(4);
+  vector_type v(4);
+  sparse::fill(w(0));
+  sparse::fill(w(1));
+  sparse::fill(w(2));
+  sparse::fill(w(3));
+  v = w;
+
+  block4x1_type delta_x(0);
+  sparse::fill(delta_x);
+
+  for(size_t k = 0u; k < 3u; ++k)
+  {
+    sparse::column_prod( JT, J, delta_x, w, k);
+    sparse::column_prod( JT_columns, delta_x, v, k);
+
+    for(size_t i = 0u; i < 4u; ++i)
+      BOOST_CHECK( w(i) == v(i) );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
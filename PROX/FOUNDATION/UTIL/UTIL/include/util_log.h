@@ -4,10 +4,36 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <utility>   // needed for std::swap
+
+/**
+ * The lowest log level that is compiled in. Logging below this level
+ * compiles to nothing, use 0 for debug, 1 for info, 2 for warning and 3
+ * for error.
+ */
+#ifndef UTIL_LOG_MIN_LEVEL
+#define UTIL_LOG_MIN_LEVEL 0
+#endif
 
 namespace util
 {
 
+  typedef enum
+  {
+    log_debug   = 0
+    , log_info    = 1
+    , log_warning = 2
+    , log_error   = 3
+  } log_level_type;
+
   class LogInfo
   {
   public:
@@ -24,6 +50,28 @@ namespace util
       return value;
     }
 
+    /**
+     * The lowest log level that is written, messages below it are dropped
+     * at run-time.
+     */
+    static int & level()
+    {
+      static int value = log_debug;
+      return value;
+    }
+
+    /**
+     * If true messages are handed to a background thread that writes them,
+     * otherwise they are written before the logging call returns. Turning
+     * it off is useful when chasing a crash, as messages still queued are
+     * lost when the program aborts.
+     */
+    static bool & asynchronous()
+    {
+      static bool value = true;
+      return value;
+    }
+
     static std::ofstream & stream()
     {
       static std::ofstream value;
@@ -44,59 +92,457 @@ namespace util
 
   };
 
-
-  class Log
+  namespace detail
   {
-  public:
 
-    static std::string tab()     { return "\t"; };
-    static std::string newline() { return "\n"; };
+    class LogMessage
+    {
+    public:
 
-    void flush()
+      bool         m_console;    ///< If true the message goes to the console, otherwise to the file.
+      std::string  m_filename;   ///< Name of the log file at the time the message was logged.
+      std::string  m_text;
+
+    };
+
+    /**
+     * Log Buffer.
+     * A fixed size ring of messages written by one thread and read by the
+     * writer thread. Neither side takes a lock.
+     */
+    class LogBuffer
     {
-      if(LogInfo::on())
+    public:
+
+      static size_t const capacity = 1024u;
+
+    protected:
+
+      std::unique_ptr<LogMessage[]>  m_slots;
+      std::atomic<size_t>            m_head;      ///< Next slot to read, only changed by the writer thread.
+      std::atomic<size_t>            m_tail;      ///< Next slot to write, only changed by the owning thread.
+
+    public:
+
+      LogBuffer()
+      : m_slots( new LogMessage[capacity] )
+      , m_head(0u)
+      , m_tail(0u)
+      {}
+
+    public:
+
+      /**
+       * Move a message into the buffer.
+       *
+       * @return   False if the buffer is full, the message is left untouched.
+       */
+      bool push(LogMessage & message)
+      {
+        size_t const tail = this->m_tail.load(std::memory_order_relaxed);
+        size_t const head = this->m_head.load(std::memory_order_acquire);
+
+        if(tail - head >= capacity)
+          return false;
+
+        std::swap( this->m_slots[tail % capacity], message );
+
+        this->m_tail.store(tail + 1u, std::memory_order_release);
+
+        return true;
+      }
+
+      bool pop(LogMessage & message)
+      {
+        size_t const head = this->m_head.load(std::memory_order_relaxed);
+        size_t const tail = this->m_tail.load(std::memory_order_acquire);
+
+        if(head == tail)
+          return false;
+
+        std::swap( message, this->m_slots[head % capacity] );
+
+        this->m_head.store(head + 1u, std::memory_order_release);
+
+        return true;
+      }
+
+      size_t size() const
+      {
+        return this->m_tail.load(std::memory_order_relaxed) - this->m_head.load(std::memory_order_relaxed);
+      }
+
+    };
+
+    /**
+     * Log Writer.
+     * Owns one buffer per logging thread and a background thread that
+     * drains them. The background thread wakes up regularly, or when a
+     * buffer is getting full or someone flushes. The log file is kept open
+     * between writes.
+     */
+    class LogWriter
+    {
+    protected:
+
+      std::mutex                                m_mutex;          ///< Guards the buffer list and the state of the writer thread.
+      std::mutex                                m_output_mutex;   ///< Guards the console and the log file.
+      std::condition_variable                   m_wake;
+      std::condition_variable                   m_done;
+      std::vector< std::unique_ptr<LogBuffer> > m_buffers;
+      std::thread                               m_thread;
+      bool                                      m_stop;
+      bool                                      m_wanted;         ///< Set when the writer thread should drain the buffers right away.
+      std::atomic<size_t>                       m_posted;         ///< Number of messages handed to the buffers.
+      size_t                                    m_written;        ///< Number of messages taken from the buffers and written.
+      std::string                               m_filename;       ///< Name of the log file that is open.
+
+    public:
+
+      LogWriter()
+      : m_stop(false)
+      , m_wanted(false)
+      , m_posted(0u)
+      , m_written(0u)
+      , m_filename("")
+      {
+        // The writer uses these at program exit, so they must be created
+        // before it to be destroyed after it
+        LogInfo::stream();
+        LogInfo::filename();
+        LogInfo::first_time();
+        shut_down();
+      }
+
+      ~LogWriter()
       {
-        if(LogInfo::console())
+        shut_down() = true;
+
         {
-          std::cout.flush();
+          std::lock_guard<std::mutex> lock(this->m_mutex);
+
+          this->m_stop = true;
         }
-        else
+
+        this->m_wake.notify_one();
+
+        if(this->m_thread.joinable())
+          this->m_thread.join();
+
+        std::lock_guard<std::mutex> lock(this->m_output_mutex);
+
+        if(LogInfo::stream().is_open())
+          LogInfo::stream().close();
+      }
+
+    public:
+
+      static LogWriter & instance()
+      {
+        static LogWriter writer;
+
+        return writer;
+      }
+
+      /**
+       * Tells whether the writer has been destroyed at program exit, any
+       * later messages are written right away.
+       */
+      static std::atomic<bool> & shut_down()
+      {
+        static std::atomic<bool> value(false);
+
+        return value;
+      }
+
+    protected:
+
+      LogBuffer & thread_buffer()
+      {
+        thread_local LogBuffer * buffer = 0;
+
+        if(!buffer)
         {
-          LogInfo::stream().flush();
+          std::lock_guard<std::mutex> lock(this->m_mutex);
+
+          this->m_buffers.push_back( std::unique_ptr<LogBuffer>( new LogBuffer() ) );
+
+          buffer = this->m_buffers.back().get();
+
+          if(!this->m_thread.joinable())
+            this->m_thread = std::thread( &LogWriter::run, this );
         }
+
+        return *buffer;
       }
-    }
-  };
 
-  template<typename T>
-  inline Log & operator<<(Log & log, T const & data)
-  {
-    if(LogInfo::on())
-    {
-      if(LogInfo::console())
+      void wake()
       {
-        std::cout << data;
+        {
+          std::lock_guard<std::mutex> lock(this->m_mutex);
+
+          this->m_wanted = true;
+        }
+
+        this->m_wake.notify_one();
       }
-      else
+
+      void write(LogMessage const & message)
       {
-        if(LogInfo::first_time())
+        if(message.m_console)
         {
-          LogInfo::stream().open(LogInfo::filename().c_str(), std::ofstream::out );
-          LogInfo::first_time() = false;
+          std::cout << message.m_text;
+
+          return;
         }
-        else
+
+        std::ofstream & stream = LogInfo::stream();
+
+        if(!stream.is_open() || message.m_filename != this->m_filename)
         {
-          LogInfo::stream().open(LogInfo::filename().c_str(), std::ofstream::out | std::ofstream::app);
+          if(stream.is_open())
+            stream.close();
+
+          if(LogInfo::first_time())
+          {
+            stream.open(message.m_filename.c_str(), std::ofstream::out );
+            LogInfo::first_time() = false;
+          }
+          else
+          {
+            stream.open(message.m_filename.c_str(), std::ofstream::out | std::ofstream::app);
+          }
+
+          this->m_filename = message.m_filename;
         }
-        LogInfo::stream() << data;
-        LogInfo::stream().flush();
-        LogInfo::stream().close();
+
+        stream << message.m_text;
+      }
+
+      void flush_output()
+      {
+        std::cout.flush();
+
+        if(LogInfo::stream().is_open())
+          LogInfo::stream().flush();
       }
+
+      void run()
+      {
+        std::vector<LogBuffer *> buffers;
+
+        LogMessage message;
+
+        std::unique_lock<std::mutex> lock(this->m_mutex);
+
+        while(true)
+        {
+          this->m_wake.wait_for( lock, std::chrono::milliseconds(20), [this]() { return this->m_stop || this->m_wanted; } );
+
+          this->m_wanted = false;
+
+          bool const stop = this->m_stop;
+
+          // Buffers are never removed, so the pointers stay valid while unlocked
+          buffers.clear();
+
+          for(size_t i = 0u; i < this->m_buffers.size(); ++i)
+            buffers.push_back( this->m_buffers[i].get() );
+
+          lock.unlock();
+
+          size_t written = 0u;
+
+          {
+            std::lock_guard<std::mutex> output_lock(this->m_output_mutex);
+
+            for(size_t i = 0u; i < buffers.size(); ++i)
+            {
+              while( buffers[i]->pop(message) )
+              {
+                this->write(message);
+
+                ++written;
+              }
+            }
+
+            if(written > 0u)
+              this->flush_output();
+          }
+
+          lock.lock();
+
+          this->m_written += written;
+
+          this->m_done.notify_all();
+
+          if(stop)
+            break;
+        }
+      }
+
+    public:
+
+      void post(LogMessage & message)
+      {
+        if(!LogInfo::asynchronous() || shut_down())
+        {
+          std::lock_guard<std::mutex> lock(this->m_output_mutex);
+
+          this->write(message);
+          this->flush_output();
+
+          return;
+        }
+
+        LogBuffer & buffer = this->thread_buffer();
+
+        this->m_posted.fetch_add(1u, std::memory_order_relaxed);
+
+        while( !buffer.push(message) )
+        {
+          this->wake();
+
+          std::this_thread::yield();
+        }
+
+        if( buffer.size() > LogBuffer::capacity / 2u )
+          this->wake();
+      }
+
+      /**
+       * Wait until all messages posted so far have been written.
+       */
+      void flush()
+      {
+        size_t const target = this->m_posted.load(std::memory_order_relaxed);
+
+        std::unique_lock<std::mutex> lock(this->m_mutex);
+
+        if(!this->m_thread.joinable())
+          return;
+
+        this->m_wanted = true;
+
+        this->m_wake.notify_one();
+
+        this->m_done.wait( lock, [this, target]() { return this->m_written >= target || this->m_stop; } );
+      }
+
+    };
+
+    inline std::ostringstream & log_stream()
+    {
+      // Formatting state set through the log stays in effect, like it
+      // would on std::cout
+      thread_local std::ostringstream stream;
+
+      return stream;
     }
-    
+
+  }// namespace detail
+
+  /**
+   * Log.
+   * Text is collected in the log object and handed to the writer as one
+   * message when a newline is logged, when the log is flushed or when the
+   * log object goes out of scope.
+   *
+   * @tparam level   The log level of all text written through this object.
+   */
+  template<int level>
+  class BasicLog
+  {
+  protected:
+
+    std::string m_text;
+
+  public:
+
+    static std::string tab()     { return "\t"; };
+    static std::string newline() { return "\n"; };
+
+  public:
+
+    BasicLog()
+    : m_text()
+    {}
+
+    ~BasicLog()
+    {
+      this->commit();
+    }
+
+  public:
+
+    static bool enabled()
+    {
+      return level >= UTIL_LOG_MIN_LEVEL && level >= LogInfo::level() && LogInfo::on();
+    }
+
+    template<typename T>
+    void append(T const & data)
+    {
+      std::ostringstream & stream = detail::log_stream();
+
+      stream.str( std::string() );
+      stream << data;
+
+      this->m_text += stream.str();
+
+      if( !this->m_text.empty() && this->m_text[ this->m_text.size() - 1u ] == '\n' )
+        this->commit();
+    }
+
+    void commit()
+    {
+      if( this->m_text.empty() )
+        return;
+
+      detail::LogMessage message;
+
+      message.m_console = LogInfo::console();
+
+      if( !message.m_console )
+        message.m_filename = LogInfo::filename();
+
+      std::swap( message.m_text, this->m_text );
+
+      detail::LogWriter::instance().post( message );
+
+      this->m_text.clear();
+    }
+
+    /**
+     * Write everything logged so far, also by other log objects, before
+     * returning.
+     */
+    void flush()
+    {
+      this->commit();
+
+      detail::LogWriter::instance().flush();
+    }
+  };
+
+  typedef BasicLog<log_debug>    LogDebug;
+  typedef BasicLog<log_info>     Log;
+  typedef BasicLog<log_warning>  LogWarning;
+  typedef BasicLog<log_error>    LogError;
+
+  template<int level, typename T>
+  inline BasicLog<level> & operator<<(BasicLog<level> & log, T const & data)
+  {
+    // The first test is known at compile-time, so logging below the
+    // minimum level is removed by the compiler
+    if( level >= UTIL_LOG_MIN_LEVEL && BasicLog<level>::enabled() )
+    {
+      log.append( data );
+    }
+
     return log;
   }
-  
+
 } //namespace util
 
 // UTIL_LOG_H
@@ -3,27 +3,41 @@
 
 #include <util_timer.h>
 #include <util_string_helper.h>
+#include <util_quantile_sketch.h>
 
 #include <map>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <sstream>
+#include <ostream>
 #include <cassert>
 
 #ifdef USE_PROFILING
 
-#define START_TIMER(NAME)         util::Profiling::get_timer_monitor(NAME)->start()
-#define PAUSE_TIMER(NAME)         util::Profiling::get_timer_monitor(NAME)->pause()
-#define RESUME_TIMER(NAME)        util::Profiling::get_timer_monitor(NAME)->resume()
-#define STOP_TIMER(NAME)          util::Profiling::get_timer_monitor(NAME)->stop()
-#define RECORD_TIME(NAME,VALUE)   util::Profiling::get_timer_monitor(NAME)->record(VALUE)
-#define RECORD(NAME,VALUE)        util::Profiling::get_monitor(NAME)->record(VALUE)
+/**
+ * Each call site gets its own static handle. The handle remembers the id of
+ * the monitor that the name was resolved to, so only the first call from a
+ * call site has to look up the name.
+ */
+#define PROFILING_HANDLE(NAME)    ([]() -> util::Profiling::Handle & { static util::Profiling::Handle handle(NAME); return handle; }())
+
+#define START_TIMER(NAME)         util::Profiling::get_timer_monitor(PROFILING_HANDLE(NAME))->start()
+#define PAUSE_TIMER(NAME)         util::Profiling::get_timer_monitor(PROFILING_HANDLE(NAME))->pause()
+#define RESUME_TIMER(NAME)        util::Profiling::get_timer_monitor(PROFILING_HANDLE(NAME))->resume()
+#define STOP_TIMER(NAME)          util::Profiling::get_timer_monitor(PROFILING_HANDLE(NAME))->stop()
+#define RECORD_TIME(NAME,VALUE)   util::Profiling::get_timer_monitor(PROFILING_HANDLE(NAME))->record(VALUE)
+#define RECORD(NAME,VALUE)        util::Profiling::get_monitor(PROFILING_HANDLE(NAME))->record(VALUE)
 #define NEW_UNIQUE_NAME(NAME)     util::Profiling::generate_unique_name(NAME)
-#define RECORD_VECTOR(NAME,VALUE) util::Profiling::get_vector_monitor(NAME)->record(VALUE)
+#define RECORD_VECTOR(NAME,VALUE) util::Profiling::get_vector_monitor(PROFILING_HANDLE(NAME))->record(VALUE)
 
 
-#define RECORD_VECTOR_NEW(NAME) util::Profiling::get_vector_monitor(NAME)->record_new()
-#define RECORD_VECTOR_PUSH(NAME,VALUE) util::Profiling::get_vector_monitor(NAME)->record_push(VALUE)
+#define RECORD_VECTOR_NEW(NAME) util::Profiling::get_vector_monitor(PROFILING_HANDLE(NAME))->record_new()
+#define RECORD_VECTOR_PUSH(NAME,VALUE) util::Profiling::get_vector_monitor(PROFILING_HANDLE(NAME))->record_push(VALUE)
 
 
 #else
@@ -35,6 +49,9 @@
 #define RECORD_TIME(NAME,VALUE)
 #define RECORD(NAME,VALUE)
 #define NEW_UNIQUE_NAME(NAME)  ""
+#define RECORD_VECTOR(NAME,VALUE)
+#define RECORD_VECTOR_NEW(NAME)
+#define RECORD_VECTOR_PUSH(NAME,VALUE)
 
 #endif
 
@@ -52,8 +69,11 @@
  * One must be careful to clear the prefix value to the empty string to insure
  * that "naming" behaviour returns to "normal-mode" onece there is no need
  * for this "override" behavior.
+ *
+ * The prefix belongs to the calling thread, it does not affect names used
+ * by other threads.
  */
-#define PREFIX(VALUE)             util::Profiling::prefix() = VALUE
+#define PREFIX(VALUE)             util::Profiling::set_prefix(VALUE)
 
 
 namespace util
@@ -63,11 +83,31 @@ namespace util
    * Profiling Class.
    * This class provides functionality for monitoring/handling multiple
    * timers and recording profiling data.
+   *
+   * Names are mapped to small integer ids once and for all, and every thread
+   * records into its own set of monitors indexed by these ids. Hence
+   * recording never takes a lock and threads never share a timer. The
+   * monitors of all threads are merged when the data is read back through
+   * get_monitors_instance() and its siblings.
+   *
+   * Reading back and resetting the data must not happen while other threads
+   * are recording.
+   *
+   * By default each monitor keeps the last default_window() raw values,
+   * set_window() changes the bound and zero keeps every raw value. For long
+   * runs flush() can be called periodically to move the raw values to disk. Running statistics and
+   * quantile estimates always cover all recorded values.
    */
   class Profiling
   {
   public:
 
+    /**
+     * Monitor.
+     * Keeps running statistics and a quantile sketch of all recorded values,
+     * but only the raw values of the last window() records. Values that
+     * have not been flushed yet can be written to a stream by flush().
+     */
     class Monitor
     {
     protected:
@@ -77,7 +117,10 @@ namespace util
       float       m_max;
       float       m_avg;
       size_t      m_N;
-      std::vector<float> m_values;
+      std::vector<float> m_values;     ///< Raw values, once the window is full the oldest value is found at m_first.
+      size_t      m_first;
+      size_t      m_pending;           ///< Number of the most recent raw values that have not been flushed.
+      QuantileSketch m_sketch;
 
     public:
 
@@ -85,17 +128,63 @@ namespace util
       float get_min() const    { return m_min;    }
       float get_max() const    { return m_max;    }
       float get_total() const  { return m_total;  }
-      std::vector<float> const & get_values() const { return m_values; }
+      float get_quantile(float const & q) const { return m_sketch.quantile(q); }
+      float get_p50() const    { return m_sketch.quantile(0.50f); }
+      float get_p95() const    { return m_sketch.quantile(0.95f); }
+      float get_p99() const    { return m_sketch.quantile(0.99f); }
       size_t get_number_of_entries() const  { return m_N;  }
 
+      /**
+       * The retained raw values, oldest first.
+       */
+      std::vector<float> get_values() const
+      {
+        std::vector<float> values;
+
+        values.reserve( m_values.size() );
+        values.insert( values.end(), m_values.begin() + m_first, m_values.end() );
+        values.insert( values.end(), m_values.begin(), m_values.begin() + m_first );
+
+        return values;
+      }
+
+    protected:
+
+      /**
+       * Insert a raw value, once the window is full the oldest value is
+       * overwritten.
+       */
+      void insert( float const & value )
+      {
+        using std::min;
+
+        size_t const window = Profiling::window();
+
+        if( window == 0u || m_values.size() < window )
+        {
+          m_values.push_back( value );
+        }
+        else
+        {
+          m_values[m_first] = value;
+          m_first = (m_first + 1u) % m_values.size();
+        }
+
+        m_pending = min( m_pending + 1u, m_values.size() );
+      }
+
     public:
 
       Monitor()
       : m_total( 0.0f )
       , m_min( 0.0f )
       , m_max( 0.0f )
+      , m_avg( 0.0f )
       , m_N( 0u )
       , m_values()
+      , m_first( 0u )
+      , m_pending( 0u )
+      , m_sketch()
       {}
 
     public:
@@ -105,7 +194,10 @@ namespace util
         using std::min;
         using std::max;
 
-        m_values.push_back( value );
+        insert( value );
+
+        m_sketch.record( value );
+
         m_min   = min( m_min, value );
         m_max   = max( m_max, value );
         m_avg   =  (m_N*m_avg + value)/ (m_N+1);
@@ -119,14 +211,72 @@ namespace util
         using std::max;
 
         m_values.clear();
+        m_first   = 0u;
+        m_pending = 0u;
+        m_sketch.clear();
         m_min   = 0.0f;
         m_max   = 0.0f;
         m_avg   = 0.0f;
         m_N     = 0u;
         m_total = 0.0f;
       }
+
+      /**
+       * Add the values recorded by another monitor to this monitor. The
+       * retained raw values are inserted oldest first, just as if they had
+       * been recorded here, so the window still applies.
+       */
+      void merge( Monitor const & other )
+      {
+        using std::min;
+        using std::max;
+
+        if( other.m_N == 0u )
+          return;
+
+        std::vector<float> const values = other.get_values();
+
+        for(size_t idx = 0u; idx < values.size(); ++idx)
+          insert( values[idx] );
+
+        m_sketch.merge( other.m_sketch );
+        m_min   = (m_N > 0u) ? min( m_min, other.m_min ) : other.m_min;
+        m_max   = (m_N > 0u) ? max( m_max, other.m_max ) : other.m_max;
+        m_avg   = (m_N*m_avg + other.m_N*other.m_avg) / (m_N + other.m_N);
+        m_N     = m_N + other.m_N;
+        m_total = m_total + other.m_total;
+      }
+
+      /**
+       * Write the raw values recorded since the last flush as a single line
+       * starting with the name. Values that have already left the window
+       * are lost, so the window should hold all the values recorded
+       * between two flushes.
+       */
+      void flush( std::string const & name, std::ostream & output )
+      {
+        if( m_pending == 0u )
+          return;
+
+        size_t const N = m_values.size();
+
+        output << name;
+
+        for(size_t i = N - m_pending; i < N; ++i)
+          output << " " << m_values[ (m_first + i) % N ];
+
+        output << std::endl;
+
+        m_pending = 0u;
+      }
     };
 
+    /**
+     * Timer Monitor.
+     * When tracing is on, starting or resuming the timer adds a begin event
+     * to the trace of the calling thread, and pausing or stopping it adds an
+     * end event.
+     */
     class TimerMonitor
     : public Monitor
     {
@@ -134,6 +284,7 @@ namespace util
 
       util::Timer m_timer;
       float       m_time;
+      size_t      m_id;     ///< Id of the name of the timer, used by trace events.
 
     public:
 
@@ -141,12 +292,21 @@ namespace util
       : Monitor()
       , m_timer()
       , m_time(0.0f)
+      , m_id(0u)
       {}
 
     public:
 
+      void set_id(size_t const & id)
+      {
+        m_id = id;
+      }
+
       void start()
       {
+        if( Profiling::tracing() )
+          Profiling::trace( m_id, 'B' );
+
         m_timer.start();
       }
 
@@ -154,6 +314,9 @@ namespace util
       {
         m_timer.stop();
         m_time += m_timer();
+
+        if( Profiling::tracing() )
+          Profiling::trace( m_id, 'E' );
       }
 
       void resume()
@@ -185,38 +348,63 @@ namespace util
 
     };
 
+    /**
+     * Vector Monitor.
+     * Keeps the vectors of the last window() records, the oldest vector is
+     * found at m_first once the window is full.
+     */
     class VectorMonitor
     {
     protected:
 
       std::vector< std::vector<float>  > m_values;
+      size_t                             m_first;
+      size_t                             m_pending;   ///< Number of the most recent vectors that have not been flushed.
 
     public:
 
-      std::vector<float> const & get_values(size_t const & idx) const { return m_values[idx]; }
+      std::vector<float> const & get_values(size_t const & idx) const { return m_values[ (m_first + idx) % m_values.size() ]; }
       size_t get_number_of_entries() const  { return m_values.size();  }
 
     public:
 
       VectorMonitor()
       : m_values()
+      , m_first( 0u )
+      , m_pending( 0u )
       {}
 
     public:
 
       void record( std::vector<float> const & values )
       {
-        m_values.push_back( values );
+        record_new();
+        newest() = values;
       }
 
       void record_new( )
       {
-        m_values.push_back( std::vector<float>() );
+        using std::min;
+
+        size_t const window = Profiling::window();
+
+        if( window == 0u || m_values.size() < window )
+        {
+          m_values.push_back( std::vector<float>() );
+        }
+        else
+        {
+          // Reuse the oldest vector, it keeps its memory
+          m_values[m_first].clear();
+          m_first = (m_first + 1u) % m_values.size();
+        }
+
+        m_pending = min( m_pending + 1u, m_values.size() );
       }
 
       void record_push( float const & value )
       {
-        m_values.back().push_back( value );
+        newest().push_back( value );
       }
 
       void clear()
@@ -225,6 +413,46 @@ namespace util
         using std::max;
 
         m_values.clear();
+        m_first   = 0u;
+        m_pending = 0u;
+      }
+
+      void merge( VectorMonitor const & other )
+      {
+        for(size_t idx = 0u; idx < other.get_number_of_entries(); ++idx)
+          record( other.get_values(idx) );
+      }
+
+      /**
+       * Write the vectors recorded since the last flush, one line per
+       * vector starting with the name.
+       */
+      void flush( std::string const & name, std::ostream & output )
+      {
+        size_t const N = m_values.size();
+
+        for(size_t idx = N - m_pending; idx < N; ++idx)
+        {
+          std::vector<float> const & values = get_values(idx);
+
+          output << name;
+
+          for(size_t i = 0u; i < values.size(); ++i)
+            output << " " << values[i];
+
+          output << std::endl;
+        }
+
+        m_pending = 0u;
+      }
+
+    protected:
+
+      std::vector<float> & newest()
+      {
+        assert( !m_values.empty() || !"VectorMonitor::newest(): record_new was never invoked");
+
+        return m_values[ (m_first + m_values.size() - 1u) % m_values.size() ];
       }
     };
 
@@ -233,6 +461,213 @@ namespace util
     typedef std::map<std::string, VectorMonitor >         vector_monitors_container;
     typedef std::map<std::string, size_t >                counter_container;
 
+    /**
+     * A begin or end event of a timer as seen by a trace viewer.
+     */
+    class TraceRecord
+    {
+    public:
+
+      std::string m_name;
+      char        m_phase;     ///< 'B' for begin and 'E' for end.
+      double      m_time;      ///< Microseconds since the first event.
+      size_t      m_step;      ///< Number of the simulation step the event happened in.
+      size_t      m_thread;    ///< Number of the thread that recorded the event.
+
+    };
+
+    typedef std::vector<TraceRecord>                      trace_container;
+
+    /**
+     * Call Site Handle.
+     * Holds the name used at a call site together with the ids it has been
+     * resolved to. There is one id for each of the first few prefix values,
+     * names used with any other prefix are looked up every time.
+     */
+    class Handle
+    {
+    public:
+
+      static size_t const max_prefixes = 8u;
+      static size_t const unresolved   = ~static_cast<size_t>(0u);
+
+    protected:
+
+      char const *          m_name;
+      std::atomic<size_t>   m_ids[max_prefixes];
+
+    public:
+
+      /**
+       * The name must be a string literal, it is not copied.
+       */
+      template<size_t N>
+      explicit Handle( char const (&name)[N] )
+      : m_name(name)
+      {
+        for(size_t i = 0u; i < max_prefixes; ++i)
+          m_ids[i].store(unresolved, std::memory_order_relaxed);
+      }
+
+    public:
+
+      char const * name() const { return m_name; }
+
+      size_t get_id(size_t const & prefix_idx) const
+      {
+        if(prefix_idx < max_prefixes)
+          return m_ids[prefix_idx].load(std::memory_order_relaxed);
+
+        return unresolved;
+      }
+
+      void set_id(size_t const & prefix_idx, size_t const & id)
+      {
+        if(prefix_idx < max_prefixes)
+          m_ids[prefix_idx].store(id, std::memory_order_relaxed);
+      }
+
+    };
+
+  protected:
+
+    /**
+     * Name Registry.
+     * Maps decorated names to ids. The ids are never reused or forgotten, not
+     * even by reset(), because call site handles keep them.
+     */
+    class Registry
+    {
+    protected:
+
+      mutable std::mutex              m_mutex;
+      std::map<std::string, size_t>   m_ids;
+      std::vector<std::string>        m_names;
+
+    public:
+
+      size_t get_id(std::string const & name)
+      {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+
+        std::map<std::string, size_t>::const_iterator lookup = this->m_ids.find(name);
+
+        if(lookup != this->m_ids.end())
+          return lookup->second;
+
+        size_t const id = this->m_names.size();
+
+        this->m_ids[name] = id;
+        this->m_names.push_back(name);
+
+        return id;
+      }
+
+      std::vector<std::string> get_names() const
+      {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+
+        return this->m_names;
+      }
+
+    };
+
+    /**
+     * Monitors of a single thread indexed by id. Deques are used so that
+     * monitors do not move when new ids are added, pointers handed out
+     * stay valid until reset() is called.
+     */
+    template<typename M>
+    class Storage
+    {
+    public:
+
+      std::deque<M>        m_monitors;
+      std::vector<char>    m_used;      ///< Tells whether the thread has used the monitor with a given id.
+
+    public:
+
+      M * get(size_t const & id)
+      {
+        if(id >= this->m_monitors.size())
+        {
+          size_t const old_size = this->m_monitors.size();
+
+          this->m_monitors.resize(id + 1u);
+          this->m_used.resize(id + 1u, 0);
+
+          for(size_t i = old_size; i <= id; ++i)
+            Profiling::identify( this->m_monitors[i], i );
+        }
+
+        this->m_used[id] = 1;
+
+        return &this->m_monitors[id];
+      }
+
+      void clear()
+      {
+        this->m_monitors.clear();
+        this->m_used.clear();
+      }
+
+    };
+
+    class TraceEvent
+    {
+    public:
+
+      size_t      m_id;        ///< Id of the timer name.
+      char        m_phase;
+      double      m_time;
+      size_t      m_step;
+
+    };
+
+    class ThreadData
+    {
+    public:
+
+      std::string              m_prefix;
+      size_t                   m_prefix_idx;
+      size_t                   m_thread_number;
+      Storage<Monitor>         m_monitors;
+      Storage<TimerMonitor>    m_timer_monitors;
+      Storage<VectorMonitor>   m_vector_monitors;
+      std::deque<TraceEvent>   m_trace;
+
+    public:
+
+      ThreadData(size_t const & thread_number)
+      : m_prefix("")
+      , m_prefix_idx(0u)
+      , m_thread_number(thread_number)
+      {}
+
+      void clear()
+      {
+        this->m_monitors.clear();
+        this->m_timer_monitors.clear();
+        this->m_vector_monitors.clear();
+        this->m_trace.clear();
+      }
+
+    };
+
+    /**
+     * The data of all threads that have been recording. The data is owned
+     * here and not by the threads, so nothing is lost when a thread ends
+     * before the data has been read back.
+     */
+    class Threads
+    {
+    public:
+
+      std::mutex                                 m_mutex;
+      std::vector< std::unique_ptr<ThreadData> > m_data;
+
+    };
+
   private:
 
     static counter_container & counters()
@@ -242,13 +677,335 @@ namespace util
       return data;
     }
 
+    static std::mutex & counters_mutex()
+    {
+      static std::mutex mutex;
+
+      return mutex;
+    }
+
+    static Registry & monitor_names()
+    {
+      static Registry registry;
+
+      return registry;
+    }
+
+    static Registry & timer_monitor_names()
+    {
+      static Registry registry;
+
+      return registry;
+    }
+
+    static Registry & vector_monitor_names()
+    {
+      static Registry registry;
+
+      return registry;
+    }
+
+    static Registry & prefix_names()
+    {
+      // The empty prefix is always id zero, it is what every thread starts with
+      static Registry registry;
+      static size_t const empty_idx = registry.get_id("");
+
+      assert( empty_idx == 0u || !"util::Profiling::prefix_names(): empty prefix must be id zero");
+
+      return registry;
+    }
+
+    static Threads & threads()
+    {
+      static Threads data;
+
+      return data;
+    }
+
+    static ThreadData & thread_data()
+    {
+      thread_local ThreadData * data = 0;
+
+      if(!data)
+      {
+        Threads & all = threads();
+
+        std::lock_guard<std::mutex> lock(all.m_mutex);
+
+        all.m_data.push_back( std::unique_ptr<ThreadData>( new ThreadData( all.m_data.size() ) ) );
+
+        data = all.m_data.back().get();
+      }
+
+      return *data;
+    }
+
+    template<typename M>
+    static M * resolve(Handle & handle, Registry & registry, Storage<M> & storage, size_t const & prefix_idx, std::string const & prefix_value)
+    {
+      size_t id = handle.get_id(prefix_idx);
+
+      if(id == Handle::unresolved)
+      {
+        std::string const decorated_name = prefix_value + handle.name();
+
+        assert( !util::contains(decorated_name, " ") || !"util::Profiling::resolve(): spaces not allowed in names");
+
+        id = registry.get_id(decorated_name);
+
+        handle.set_id(prefix_idx, id);
+      }
+
+      return storage.get(id);
+    }
+
+    template<typename M>
+    static void merge(Registry const & registry, Storage<M> ThreadData::* storage, std::map<std::string, M> & merged)
+    {
+      std::vector<std::string> const names = registry.get_names();
+
+      merged.clear();
+
+      Threads & all = threads();
+
+      std::lock_guard<std::mutex> lock(all.m_mutex);
+
+      for(size_t t = 0u; t < all.m_data.size(); ++t)
+      {
+        Storage<M> const & data = (*all.m_data[t]).*storage;
+
+        for(size_t id = 0u; id < data.m_monitors.size(); ++id)
+        {
+          if(data.m_used[id])
+            merged[ names[id] ].merge( data.m_monitors[id] );
+        }
+      }
+    }
+
+    static void identify(Monitor &, size_t const &)
+    {
+    }
+
+    static void identify(TimerMonitor & monitor, size_t const & id)
+    {
+      monitor.set_id(id);
+    }
+
+    static void identify(VectorMonitor &, size_t const &)
+    {
+    }
+
+    static std::atomic<bool> & tracing_value()
+    {
+      static std::atomic<bool> value(false);
+
+      return value;
+    }
+
+    static std::atomic<size_t> & trace_steps_value()
+    {
+      static std::atomic<size_t> value(0u);
+
+      return value;
+    }
+
+    static std::atomic<size_t> & step_value()
+    {
+      static std::atomic<size_t> value(0u);
+
+      return value;
+    }
+
+    static std::chrono::steady_clock::time_point const & trace_epoch()
+    {
+      static std::chrono::steady_clock::time_point const epoch = std::chrono::steady_clock::now();
+
+      return epoch;
+    }
+
+    /**
+     * Add an event to the trace of the calling thread. Events of steps that
+     * are more than trace_steps() steps old are dropped.
+     */
+    static void trace(size_t const & id, char const & phase)
+    {
+      std::chrono::duration<double, std::micro> const time = std::chrono::steady_clock::now() - trace_epoch();
+
+      ThreadData & data = thread_data();
+
+      size_t const step  = step_value().load(std::memory_order_relaxed);
+      size_t const steps = trace_steps_value().load(std::memory_order_relaxed);
+
+      if(steps > 0u)
+      {
+        while( !data.m_trace.empty() && data.m_trace.front().m_step + steps <= step )
+          data.m_trace.pop_front();
+      }
+
+      TraceEvent event;
+
+      event.m_id    = id;
+      event.m_phase = phase;
+      event.m_time  = time.count();
+      event.m_step  = step;
+
+      data.m_trace.push_back( event );
+    }
+
+    static std::atomic<size_t> & window_value()
+    {
+      static std::atomic<size_t> value( default_window() );
+
+      return value;
+    }
+
+    template<typename M>
+    static void flush(Registry const & registry, Storage<M> ThreadData::* storage, std::ostream & output)
+    {
+      std::vector<std::string> const names = registry.get_names();
+
+      Threads & all = threads();
+
+      std::lock_guard<std::mutex> lock(all.m_mutex);
+
+      for(size_t t = 0u; t < all.m_data.size(); ++t)
+      {
+        Storage<M> & data = (*all.m_data[t]).*storage;
+
+        for(size_t id = 0u; id < data.m_monitors.size(); ++id)
+        {
+          if(data.m_used[id])
+            data.m_monitors[id].flush( names[id], output );
+        }
+      }
+    }
+
+  public:
+
+    /**
+     * The number of raw values each monitor keeps by default. Profiling is
+     * often left on for long runs, so this is bounded.
+     */
+    static size_t default_window()
+    {
+      return 65536u;
+    }
+
+    /**
+     * The number of raw values each monitor keeps, zero means all values
+     * are kept. Once a monitor is full the oldest value is overwritten.
+     */
+    static size_t window()
+    {
+      return window_value().load(std::memory_order_relaxed);
+    }
+
+    static void set_window(size_t const & window)
+    {
+      window_value().store(window, std::memory_order_relaxed);
+    }
+
+    /**
+     * Turn recording of timer begin and end events on or off. The events are
+     * kept in addition to the timings themselves.
+     */
+    static void set_tracing(bool const & on)
+    {
+      trace_epoch();
+
+      tracing_value().store(on, std::memory_order_relaxed);
+    }
+
+    static bool tracing()
+    {
+      return tracing_value().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * The number of most recent steps for which trace events are kept, zero
+     * means all events are kept.
+     */
+    static void set_trace_steps(size_t const & steps)
+    {
+      trace_steps_value().store(steps, std::memory_order_relaxed);
+    }
+
+    /**
+     * Tell that a new simulation step begins, trace events are tagged with
+     * the number of the step.
+     */
+    static void next_step()
+    {
+      step_value().fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    /**
+     * The trace events of all threads, thread by thread and in the order
+     * they were recorded. The container is rebuilt on every call.
+     */
+    static trace_container * get_trace_instance()
+    {
+      static trace_container events;
+
+      std::vector<std::string> const names = timer_monitor_names().get_names();
+
+      events.clear();
+
+      Threads & all = threads();
+
+      std::lock_guard<std::mutex> lock(all.m_mutex);
+
+      for(size_t t = 0u; t < all.m_data.size(); ++t)
+      {
+        ThreadData const & data = *all.m_data[t];
+
+        for(size_t e = 0u; e < data.m_trace.size(); ++e)
+        {
+          TraceEvent const & event = data.m_trace[e];
+
+          TraceRecord record;
+
+          record.m_name   = names[event.m_id];
+          record.m_phase  = event.m_phase;
+          record.m_time   = event.m_time;
+          record.m_step   = event.m_step;
+          record.m_thread = data.m_thread_number;
+
+          events.push_back( record );
+        }
+      }
+
+      return &events;
+    }
+
+    /**
+     * Write the raw values recorded since the last flush by all threads to
+     * a stream. Each line holds a name followed by values, vector monitors
+     * write one line per recorded vector.
+     */
+    static void flush(std::ostream & output)
+    {
+      flush( monitor_names(), &ThreadData::m_monitors, output );
+      flush( timer_monitor_names(), &ThreadData::m_timer_monitors, output );
+      flush( vector_monitor_names(), &ThreadData::m_vector_monitors, output );
+
+      output.flush();
+    }
+
   public:
 
-    static std::string & prefix()
+    static std::string const & prefix()
+    {
+      return thread_data().m_prefix;
+    }
+
+    static void set_prefix(std::string const & value)
     {
-      static std::string prefix_value = "";
+      ThreadData & data = thread_data();
 
-      return prefix_value;
+      data.m_prefix     = value;
+      data.m_prefix_idx = prefix_names().get_id(value);
     }
 
     static std::string generate_unique_name(std::string const & name)
@@ -257,6 +1014,8 @@ namespace util
 
       assert( !util::contains(decorated_name, " ") || !"util::Profiling::get_last_monitor_name(): spaces not allowed in names");
 
+      std::lock_guard<std::mutex> lock(counters_mutex());
+
       size_t const value = counters()[decorated_name];
 
       ++counters()[decorated_name];
@@ -274,6 +1033,8 @@ namespace util
 
       assert( !util::contains(decorated_name, " ") || !"util::Profiling::get_last_monitor_name(): spaces not allowed in names");
 
+      std::lock_guard<std::mutex> lock(counters_mutex());
+
       size_t const value = counters()[decorated_name]-1; // 20XX-YY-ZZ: Sarah FIX THIS: -1 is because we are off by
                                                          // one when engine::get_convergence is called, this is because
                                                          // there is no collisions detected in frame 0. Does this
@@ -289,10 +1050,17 @@ namespace util
 
   public:
 
+    /**
+     * The monitors of all threads merged into one container. The values of
+     * a monitor used by several threads are appended thread by thread.
+     * The container is rebuilt on every call.
+     */
     static monitors_container * get_monitors_instance()
     {
       static monitors_container  monitors;
 
+      merge( monitor_names(), &ThreadData::m_monitors, monitors );
+
       return &monitors;
     }
 
@@ -300,6 +1068,8 @@ namespace util
     {
       static timer_monitors_container  monitors;
 
+      merge( timer_monitor_names(), &ThreadData::m_timer_monitors, monitors );
+
       return &monitors;
     }
 
@@ -307,54 +1077,96 @@ namespace util
     {
       static vector_monitors_container  monitors;
 
+      merge( vector_monitor_names(), &ThreadData::m_vector_monitors, monitors );
+
       return &monitors;
     }
 
   public:
-    
+
+    static Monitor * get_monitor(Handle & handle)
+    {
+      ThreadData & data = thread_data();
+
+      return resolve( handle, monitor_names(), data.m_monitors, data.m_prefix_idx, data.m_prefix );
+    }
+
+    static TimerMonitor * get_timer_monitor(Handle & handle)
+    {
+      ThreadData & data = thread_data();
+
+      return resolve( handle, timer_monitor_names(), data.m_timer_monitors, data.m_prefix_idx, data.m_prefix );
+    }
+
+    static VectorMonitor * get_vector_monitor(Handle & handle)
+    {
+      ThreadData & data = thread_data();
+
+      return resolve( handle, vector_monitor_names(), data.m_vector_monitors, data.m_prefix_idx, data.m_prefix );
+    }
+
+  public:
+
+    /**
+     * Look up a monitor of the calling thread by name. This is the slow path,
+     * the macros use call site handles instead.
+     */
     static Monitor * get_monitor(std::string const & name)
     {
       std::string const decorated_name = prefix() + name;
 
       assert( !util::contains(decorated_name, " ") || !"util::Profiling::get_monitor(): spaces not allowed in names");
 
-      return &(*Profiling::get_monitors_instance())[decorated_name];
+      return thread_data().m_monitors.get( monitor_names().get_id(decorated_name) );
     }
 
-    
     static TimerMonitor * get_timer_monitor(std::string const & name)
     {
       std::string const decorated_name = prefix() + name;
 
       assert( !util::contains(decorated_name, " ") || !"util::Profiling::get_timer_monitor(): spaces not allowed in names");
 
-      return &(*Profiling::get_timer_monitors_instance())[decorated_name];
+      return thread_data().m_timer_monitors.get( timer_monitor_names().get_id(decorated_name) );
     }
 
-
     static VectorMonitor * get_vector_monitor(std::string const & name)
     {
       std::string const decorated_name = prefix() + name;
 
       assert( !util::contains(decorated_name, " ") || !"util::Profiling::get_vector_monitor(): spaces not allowed in names");
 
-      return &(*Profiling::get_vector_monitors_instance())[decorated_name];
+      return thread_data().m_vector_monitors.get( vector_monitor_names().get_id(decorated_name) );
     }
 
   public:
 
     /**
      * Reset Profiling Data.
-     * Clears all collected data sofar.
+     * Clears all collected data sofar, in all threads.
      */
     static void reset()
     {
+      {
+        Threads & all = threads();
+
+        std::lock_guard<std::mutex> lock(all.m_mutex);
+
+        for(size_t t = 0u; t < all.m_data.size(); ++t)
+          all.m_data[t]->clear();
+      }
+
       get_monitors_instance()->clear();
 
       get_timer_monitors_instance()->clear();
 
       get_vector_monitors_instance()->clear();
 
+      get_trace_instance()->clear();
+
+      step_value().store(0u, std::memory_order_relaxed);
+
+      std::lock_guard<std::mutex> lock(counters_mutex());
+
       counters().clear();
     }
     
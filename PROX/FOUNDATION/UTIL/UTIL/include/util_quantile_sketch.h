@@ -0,0 +1,204 @@
+#ifndef UTIL_QUANTILE_SKETCH_H
+#define UTIL_QUANTILE_SKETCH_H
+
+#include <vector>
+#include <cmath>
+#include <cassert>
+
+namespace util
+{
+
+  /**
+   * Quantile Sketch.
+   * Estimates quantiles of a stream of values without keeping the values.
+   * Values are counted in bins whose bounds grow geometrically, so any
+   * quantile is known up to a fixed relative accuracy. Magnitudes below
+   * min_magnitude() are counted as zero and magnitudes above
+   * max_magnitude() are counted in the last bin, hence the number of bins
+   * and the memory used is bounded no matter how many values are recorded.
+   *
+   * Two sketches with the same accuracy can be merged, the result is the
+   * same as if all values had been recorded by a single sketch.
+   */
+  class QuantileSketch
+  {
+  protected:
+
+    double               m_accuracy;          ///< Relative accuracy of the quantile estimates.
+    double               m_gamma;             ///< Ratio between the upper and lower bound of a bin.
+    double               m_log_gamma;
+    int                  m_min_index;         ///< Index of the bin holding min_magnitude().
+    int                  m_max_index;         ///< Index of the bin holding max_magnitude().
+    std::vector<size_t>  m_positive;          ///< Counts of positive values, bin index i is stored at i - m_positive_offset.
+    std::vector<size_t>  m_negative;          ///< Counts of negative values by magnitude, bin index i is stored at i - m_negative_offset.
+    int                  m_positive_offset;
+    int                  m_negative_offset;
+    size_t               m_zero;              ///< Number of values too small to be put in a bin.
+    size_t               m_N;                 ///< Total number of values recorded.
+
+  public:
+
+    static double min_magnitude() { return 1e-9; }
+    static double max_magnitude() { return 1e9;  }
+
+  public:
+
+    QuantileSketch(double const & accuracy = 0.01)
+    : m_accuracy(accuracy)
+    , m_gamma( (1.0 + accuracy) / (1.0 - accuracy) )
+    , m_log_gamma( std::log( (1.0 + accuracy) / (1.0 - accuracy) ) )
+    , m_min_index(0)
+    , m_max_index(0)
+    , m_positive()
+    , m_negative()
+    , m_positive_offset(0)
+    , m_negative_offset(0)
+    , m_zero(0u)
+    , m_N(0u)
+    {
+      assert( (accuracy > 0.0 && accuracy < 1.0) || !"QuantileSketch(): accuracy must be in (0,1)");
+
+      this->m_min_index = this->index( min_magnitude() );
+      this->m_max_index = this->index( max_magnitude() );
+    }
+
+  protected:
+
+    int index(double const & magnitude) const
+    {
+      return static_cast<int>( std::ceil( std::log(magnitude) / this->m_log_gamma ) );
+    }
+
+    /**
+     * The value that represents all values in a bin, it has the same
+     * relative distance to the lower and upper bound of the bin.
+     */
+    double value(int const & i) const
+    {
+      return 2.0 * std::pow( this->m_gamma, i ) / ( this->m_gamma + 1.0 );
+    }
+
+    static void add(std::vector<size_t> & bins, int & offset, int const & i, size_t const & count)
+    {
+      if( bins.empty() )
+      {
+        bins.assign(1u, 0u);
+        offset = i;
+      }
+
+      if( i < offset )
+      {
+        bins.insert( bins.begin(), offset - i, 0u );
+        offset = i;
+      }
+
+      if( i >= offset + static_cast<int>( bins.size() ) )
+      {
+        bins.resize( i - offset + 1, 0u );
+      }
+
+      bins[i - offset] += count;
+    }
+
+  public:
+
+    void record(float const & value)
+    {
+      double const magnitude = std::fabs( static_cast<double>(value) );
+
+      ++this->m_N;
+
+      if( !(magnitude >= min_magnitude()) )   // Also catches NaN
+      {
+        ++this->m_zero;
+        return;
+      }
+
+      int i = this->index( magnitude );
+
+      i = ( i > this->m_max_index ) ? this->m_max_index : i;
+      i = ( i < this->m_min_index ) ? this->m_min_index : i;
+
+      if( value > 0.0f )
+        add( this->m_positive, this->m_positive_offset, i, 1u );
+      else
+        add( this->m_negative, this->m_negative_offset, i, 1u );
+    }
+
+    /**
+     * Estimate a quantile.
+     *
+     * @param q   The quantile to estimate, 0.5 is the median.
+     *
+     * @return    The estimated value of the quantile, zero if no values
+     *            were recorded.
+     */
+    float quantile(float const & q) const
+    {
+      assert( (q >= 0.0f && q <= 1.0f) || !"QuantileSketch::quantile(): q must be in [0,1]");
+
+      if( this->m_N == 0u )
+        return 0.0f;
+
+      double const rank  = q * ( this->m_N - 1u );
+      size_t       count = 0u;
+
+      // Largest magnitude comes first among the negative values
+      for(int j = static_cast<int>( this->m_negative.size() ) - 1; j >= 0; --j)
+      {
+        count += this->m_negative[j];
+
+        if( count > rank )
+          return static_cast<float>( - this->value( j + this->m_negative_offset ) );
+      }
+
+      count += this->m_zero;
+
+      if( count > rank )
+        return 0.0f;
+
+      for(size_t j = 0u; j < this->m_positive.size(); ++j)
+      {
+        count += this->m_positive[j];
+
+        if( count > rank )
+          return static_cast<float>( this->value( static_cast<int>(j) + this->m_positive_offset ) );
+      }
+
+      return static_cast<float>( this->value( static_cast<int>( this->m_positive.size() ) - 1 + this->m_positive_offset ) );
+    }
+
+    void merge(QuantileSketch const & other)
+    {
+      assert( this->m_accuracy == other.m_accuracy || !"QuantileSketch::merge(): sketches must have the same accuracy");
+
+      for(size_t j = 0u; j < other.m_positive.size(); ++j)
+        if( other.m_positive[j] > 0u )
+          add( this->m_positive, this->m_positive_offset, static_cast<int>(j) + other.m_positive_offset, other.m_positive[j] );
+
+      for(size_t j = 0u; j < other.m_negative.size(); ++j)
+        if( other.m_negative[j] > 0u )
+          add( this->m_negative, this->m_negative_offset, static_cast<int>(j) + other.m_negative_offset, other.m_negative[j] );
+
+      this->m_zero += other.m_zero;
+      this->m_N    += other.m_N;
+    }
+
+    void clear()
+    {
+      this->m_positive.clear();
+      this->m_negative.clear();
+      this->m_positive_offset = 0;
+      this->m_negative_offset = 0;
+      this->m_zero            = 0u;
+      this->m_N               = 0u;
+    }
+
+    size_t get_number_of_entries() const { return this->m_N; }
+
+  };
+
+}//namespace util
+
+// UTIL_QUANTILE_SKETCH_H
+#endif
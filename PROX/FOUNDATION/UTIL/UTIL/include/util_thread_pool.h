@@ -0,0 +1,265 @@
+#ifndef UTIL_THREAD_POOL_H
+#define UTIL_THREAD_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <algorithm>   // needed for std::max
+#include <cassert>
+
+namespace util
+{
+
+  /**
+   * Thread Pool.
+   * A fixed set of worker threads that execute parallel for-loops. The
+   * iteration range is split into one contiguous range per thread. A thread
+   * takes work from the front of its own range and when it runs dry it
+   * steals work from the back of the ranges of the other threads. This
+   * balances the load when the cost of the iterations varies a lot.
+   *
+   * The calling thread participates as thread number zero, so a pool of
+   * size one runs everything on the calling thread without any overhead.
+   */
+  class ThreadPool
+  {
+  public:
+
+    typedef std::function<void(size_t, size_t)> task_type;   ///< Task signature, first argument is iteration index and second is thread index.
+
+  protected:
+
+    /**
+     * The range of iterations that is still to be processed by a thread.
+     */
+    class Range
+    {
+    public:
+
+      std::mutex m_mutex;
+      size_t     m_begin;
+      size_t     m_end;
+
+      Range()
+      : m_begin(0u)
+      , m_end(0u)
+      {}
+    };
+
+    std::vector<std::thread>     m_threads;      ///< Worker threads, thread number i+1 is stored at position i.
+    std::unique_ptr<Range[]>     m_ranges;       ///< One range per thread, including the calling thread.
+    size_t                       m_size;         ///< Total number of threads including the calling thread.
+
+    std::mutex                   m_mutex;
+    std::condition_variable      m_start;        ///< Signalled when a new task is ready for the workers.
+    std::condition_variable      m_done;         ///< Signalled when the last worker has finished the current task.
+    size_t                       m_generation;   ///< Counter identifying the current task.
+    size_t                       m_busy;         ///< Number of workers still working on the current task.
+    bool                         m_stop;         ///< Flag telling the workers to terminate.
+    task_type                    m_task;
+
+  protected:
+
+    ThreadPool( ThreadPool const & );
+    ThreadPool& operator=( ThreadPool const & );
+
+  public:
+
+    ThreadPool(size_t const & number_of_threads = 1u)
+    : m_size(0u)
+    , m_generation(0u)
+    , m_busy(0u)
+    , m_stop(false)
+    {
+      this->resize(number_of_threads);
+    }
+
+    ~ThreadPool()
+    {
+      this->shutdown();
+    }
+
+  protected:
+
+    void shutdown()
+    {
+      {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_stop = true;
+      }
+      this->m_start.notify_all();
+
+      for(size_t i = 0u; i < this->m_threads.size(); ++i)
+        this->m_threads[i].join();
+
+      this->m_threads.clear();
+      this->m_stop = false;
+    }
+
+    bool pop(size_t const & thread_idx, size_t & iteration)
+    {
+      // First try our own range
+      {
+        Range & own = this->m_ranges[thread_idx];
+
+        std::lock_guard<std::mutex> lock(own.m_mutex);
+
+        if(own.m_begin < own.m_end)
+        {
+          iteration = own.m_begin++;
+          return true;
+        }
+      }
+
+      // Then try to steal from the back of the other ranges
+      for(size_t k = 1u; k < this->m_size; ++k)
+      {
+        Range & victim = this->m_ranges[(thread_idx + k) % this->m_size];
+
+        std::lock_guard<std::mutex> lock(victim.m_mutex);
+
+        if(victim.m_begin < victim.m_end)
+        {
+          iteration = --victim.m_end;
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    void work(size_t const & thread_idx)
+    {
+      size_t iteration = 0u;
+
+      while( this->pop(thread_idx, iteration) )
+        this->m_task(iteration, thread_idx);
+    }
+
+    void run(size_t const thread_idx)
+    {
+      size_t seen = 0u;
+
+      for(;;)
+      {
+        {
+          std::unique_lock<std::mutex> lock(this->m_mutex);
+
+          while( !this->m_stop && this->m_generation == seen )
+            this->m_start.wait(lock);
+
+          if( this->m_stop )
+            return;
+
+          seen = this->m_generation;
+        }
+
+        this->work(thread_idx);
+
+        {
+          std::lock_guard<std::mutex> lock(this->m_mutex);
+
+          if( --(this->m_busy) == 0u )
+            this->m_done.notify_all();
+        }
+      }
+    }
+
+  public:
+
+    /**
+     * Get the number of threads in the pool, the calling thread included.
+     */
+    size_t size() const { return this->m_size; }
+
+    /**
+     * Change the number of threads.
+     *
+     * @param number_of_threads   The wanted number of threads, the calling thread included. If
+     *                            zero then the number of hardware threads is used.
+     */
+    void resize(size_t const & number_of_threads)
+    {
+      size_t const wanted = number_of_threads > 0u
+                          ? number_of_threads
+                          : std::max( static_cast<size_t>( std::thread::hardware_concurrency() ), static_cast<size_t>(1u) );
+
+      if( wanted == this->m_size )
+        return;
+
+      this->shutdown();
+
+      this->m_size   = wanted;
+      this->m_ranges.reset( new Range[wanted] );
+
+      for(size_t i = 1u; i < wanted; ++i)
+        this->m_threads.push_back( std::thread( &ThreadPool::run, this, i ) );
+    }
+
+    /**
+     * Parallel For-Loop.
+     * Invokes the task for all iterations in the range [0..N) and returns
+     * when all iterations are done. The order in which iterations are
+     * processed is unspecified. A task must not call parallel_for on the
+     * same pool.
+     *
+     * @param N       The number of iterations.
+     * @param task    The task to invoke, it is called as task(iteration, thread index).
+     */
+    template<typename F>
+    void parallel_for(size_t const & N, F const & task)
+    {
+      if( N == 0u )
+        return;
+
+      if( this->m_size == 1u || N == 1u )
+      {
+        for(size_t i = 0u; i < N; ++i)
+          task(i, 0u);
+        return;
+      }
+
+      for(size_t t = 0u; t < this->m_size; ++t)
+      {
+        this->m_ranges[t].m_begin = (t * N) / this->m_size;
+        this->m_ranges[t].m_end   = ((t + 1u) * N) / this->m_size;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+
+        this->m_task = task;
+        this->m_busy = this->m_size - 1u;
+        ++(this->m_generation);
+      }
+      this->m_start.notify_all();
+
+      this->work(0u);
+
+      {
+        std::unique_lock<std::mutex> lock(this->m_mutex);
+
+        while( this->m_busy > 0u )
+          this->m_done.wait(lock);
+      }
+    }
+
+    /**
+     * Get the thread pool that is shared by all simulation sub systems.
+     * By default it only holds the calling thread.
+     */
+    static ThreadPool & get_instance()
+    {
+      static ThreadPool pool(1u);
+      return pool;
+    }
+
+  };
+
+} // namespace util
+
+// UTIL_THREAD_POOL_H
+#endif
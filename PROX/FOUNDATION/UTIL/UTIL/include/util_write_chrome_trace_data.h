@@ -0,0 +1,74 @@
+#ifndef UTIL_WRITE_CHROME_TRACE_DATA_H
+#define UTIL_WRITE_CHROME_TRACE_DATA_H
+
+#include <util_profiling.h>
+
+#include <sstream>
+#include <string>
+#include <set>
+#include <iomanip>
+
+namespace util
+{
+
+  /**
+   * This function will extract all trace events from util::Profiling and
+   * write them into a string using the Chrome trace event format. The
+   * string can be loaded into chrome://tracing or the Perfetto UI, which
+   * show the timers of every thread as nested bars on a timeline.
+   *
+   * Every event carries the number of the simulation step it belongs to,
+   * it is shown when an event is selected in the viewer.
+   *
+   * @return      Upon return this string holds all the trace events as a
+   *              JSON object.
+   */
+  inline std::string write_chrome_trace_data()
+  {
+    std::stringstream output;
+
+    Profiling::trace_container const * events = Profiling::get_trace_instance();
+
+    std::set<size_t> threads;
+
+    output << "{\"traceEvents\":[" << std::endl;
+
+    output << std::fixed << std::setprecision(3);
+
+    for(size_t e = 0u; e < events->size(); ++e)
+    {
+      Profiling::TraceRecord const & event = (*events)[e];
+
+      threads.insert( event.m_thread );
+
+      output << "{\"name\":\""  << event.m_name  << "\""
+             << ",\"cat\":\"prox\""
+             << ",\"ph\":\""    << event.m_phase << "\""
+             << ",\"ts\":"      << event.m_time
+             << ",\"pid\":0"
+             << ",\"tid\":"     << event.m_thread
+             << ",\"args\":{\"step\":" << event.m_step << "}},"
+             << std::endl;
+    }
+
+    // Name the threads, this also ends the event list without a trailing comma
+    for(std::set<size_t>::const_iterator t = threads.begin(); t != threads.end(); ++t)
+    {
+      output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << *t
+             << ",\"args\":{\"name\":\"thread " << *t << "\"}},"
+             << std::endl;
+    }
+
+    output << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"prox\"}}" << std::endl;
+
+    output << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+
+    output.flush();
+
+    return output.str();
+  }
+
+}// namespace util
+
+// UTIL_WRITE_CHROME_TRACE_DATA_H
+#endif
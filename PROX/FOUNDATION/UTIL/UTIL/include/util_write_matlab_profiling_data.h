@@ -27,6 +27,22 @@ namespace util
     return name.str();
   }
 
+  /**
+   * Convenience function used to collect the 50%, 95% and 99% quantiles of
+   * a monitor. These cover all recorded values, also those that are no
+   * longer kept by the monitor.
+   */
+  inline std::vector<float> quantiles( Profiling::Monitor const & monitor )
+  {
+    std::vector<float> values;
+
+    values.push_back( monitor.get_p50() );
+    values.push_back( monitor.get_p95() );
+    values.push_back( monitor.get_p99() );
+
+    return values;
+  }
+
   /**
    * This function will extract all profiling information from util::Profiling
    * and convert the raw data into matlab arrays and write these into a
@@ -55,6 +71,7 @@ namespace util
         std::vector<float>       const & values  = monitor.get_values();
 
         output <<  write_matlab_vector( name, values ) << std::endl;
+        output <<  write_matlab_vector( name + "_quantiles", quantiles( monitor ) ) << std::endl;
       }
     }
 
@@ -71,6 +88,7 @@ namespace util
         std::vector<float>            const & values  = monitor.get_values();
 
         output <<  write_matlab_vector( name, values ) << std::endl;
+        output <<  write_matlab_vector( name + "_quantiles", quantiles( monitor ) ) << std::endl;
       }
 
     }
@@ -4,6 +4,7 @@
 #include "broad_object.h"
 #include "broad_system.h"
 #include "broad_find_overlaps.h"
+#include "broad_find_ray_overlaps.h"
 
 // BROAD_H
 #endif 
@@ -1,9 +1,12 @@
 #ifndef BROAD_ACCESSOR_H
 #define BROAD_ACCESSOR_H
 
+#include <cstddef>  // needed for size_t
+
 namespace broad
 {
   template< typename T> class System;           ///< Forward declaration of System class
+  template< typename T> class Object;           ///< Forward declaration of Object class
 
   namespace detail
   {
@@ -16,6 +19,22 @@ namespace broad
         
         static typename System<T>::object_ptr_container & get_objects( System<T>  & S ){ return S.m_object_ptrs; }
         
+        static typename System<T>::proxy_container & get_proxies( System<T>  & S ){ return S.m_proxies; }
+        
+        static typename System<T>::proxy_type & get_proxy( System<T>  & S, Object<T> const * obj ){ return S.m_proxies[obj->m_proxy_idx]; }
+        
+        static typename System<T>::object_ptr_container & get_moved( System<T>  & S ){ return S.m_moved; }
+        
+        static bool & get_synchronized( System<T>  & S ){ return S.m_synchronized; }
+        
+        static size_t & get_query_stamp( System<T>  & S ){ return S.m_query_stamp; }
+        
+        static typename System<T>::sap_type & get_sap( System<T>  & S ){ return S.m_sap; }
+        
+        static typename System<T>::tree_type & get_tree( System<T>  & S ){ return S.m_tree; }
+        
+        static size_t const & get_proxy_idx( Object<T> const * obj ){ return obj->m_proxy_idx; }
+        
       };
     
   } //namespace detail
@@ -0,0 +1,566 @@
+#ifndef BROAD_DYNAMIC_TREE_H
+#define BROAD_DYNAMIC_TREE_H
+
+#include <broad_object.h>
+
+#include <vector>      // needed for std::vector
+#include <limits>      // needed for std::numeric_limits
+#include <algorithm>   // needed for std::min and std::max
+#include <cassert>     // needed for assert
+#include <cmath>       // needed for std::fabs
+
+namespace broad
+{
+
+  namespace detail
+  {
+
+    /**
+     * Dynamic Tree Node.
+     * Leaf nodes refer to a single object, internal nodes always have
+     * exactly two children. Boxes are stored as 6 consecutive values
+     * (min x, min y, min z, max x, max y, max z).
+     */
+    template<typename T>
+    class TreeNode
+      {
+      public:
+
+        T             m_box[6];     ///< The (fat) box of the node. For leaves this is the enlarged box of the object, for internal nodes it is the union of the children boxes.
+        size_t        m_parent;     ///< Index of parent node. For free nodes this is the index of the next free node.
+        size_t        m_left;       ///< Index of left child node, undefined for leaves.
+        size_t        m_right;      ///< Index of right child node, undefined for leaves.
+        int           m_height;     ///< Height of sub tree rooted at this node, leaves have height zero and free nodes have negative height.
+        Object<T> *   m_obj;        ///< The object of a leaf node, null for internal nodes.
+
+      public:
+
+        TreeNode()
+        : m_parent( std::numeric_limits<size_t>::max() )
+        , m_left( std::numeric_limits<size_t>::max() )
+        , m_right( std::numeric_limits<size_t>::max() )
+        , m_height(-1)
+        , m_obj(0)
+        {
+          std::fill( this->m_box, this->m_box + 6, T(0) );
+        }
+
+        bool is_leaf() const { return this->m_left == std::numeric_limits<size_t>::max(); }
+
+      };
+
+    /**
+     * Dynamic Bounding Volume Tree.
+     * A binary tree of axis aligned boxes that supports insertion and
+     * removal of leaves in logarithmic time. The tree is kept balanced
+     * by tree rotations. Leaves store fat boxes, ie. object boxes enlarged
+     * by a margin, such that objects that only move slightly do not need
+     * to be re-inserted into the tree.
+     */
+    template<typename T>
+    class DynamicTree
+      {
+      public:
+
+        typedef TreeNode<T>                       node_type;
+        typedef std::vector<node_type>            node_container;
+        typedef Object<T>                         object_type;
+        typedef std::vector<object_type*>         object_ptr_container;
+
+        static size_t UNDEFINED() { return std::numeric_limits<size_t>::max(); }
+
+      protected:
+
+        node_container          m_nodes;          ///< Node storage, nodes are recycled through a free list.
+        size_t                  m_root;           ///< Index of root node.
+        size_t                  m_free;           ///< Index of first free node.
+        std::vector<size_t>     m_stack;          ///< Traversal stack, kept as member to avoid allocations during queries.
+
+      public:
+
+        bool                    m_synchronized;   ///< Boolean flag indicating whether the tree holds a leaf for every object in the system.
+        std::vector<T>          m_boxes;          ///< Tight boxes of all objects from last update, stored as 6 consecutive values per object.
+        T                       m_fat_ratio;      ///< Leaf boxes are enlarged by this ratio of the largest side length of the object box.
+
+      public:
+
+        DynamicTree()
+        : m_nodes()
+        , m_root( UNDEFINED() )
+        , m_free( UNDEFINED() )
+        , m_stack()
+        , m_synchronized(false)
+        , m_boxes()
+        , m_fat_ratio(0.1)
+        {}
+
+      protected:
+
+        static T area(T const * box)
+        {
+          T const dx = box[3] - box[0];
+          T const dy = box[4] - box[1];
+          T const dz = box[5] - box[2];
+          return 2*(dx*dy + dy*dz + dz*dx);
+        }
+
+        static void merge(T const * A, T const * B, T * C)
+        {
+          using std::min;
+          using std::max;
+
+          C[0] = min(A[0], B[0]);
+          C[1] = min(A[1], B[1]);
+          C[2] = min(A[2], B[2]);
+          C[3] = max(A[3], B[3]);
+          C[4] = max(A[4], B[4]);
+          C[5] = max(A[5], B[5]);
+        }
+
+        static bool overlap(T const * A, T const * B)
+        {
+          if(B[3] < A[0]) return false;
+          if(A[3] < B[0]) return false;
+          if(B[4] < A[1]) return false;
+          if(A[4] < B[1]) return false;
+          if(B[5] < A[2]) return false;
+          if(A[5] < B[2]) return false;
+          return true;
+        }
+
+      public:
+
+        /**
+         * Test if a semi-infinite ray hits a box, using the slab method.
+         */
+        static bool ray_hit(T const * p, T const * r, T const * box)
+        {
+          using std::fabs;
+
+          T t_min = T(0);
+          T t_max = std::numeric_limits<T>::max();
+
+          for(size_t a = 0u; a < 3u; ++a)
+          {
+            if( fabs(r[a]) <= std::numeric_limits<T>::epsilon() )
+            {
+              if( p[a] < box[a] || p[a] > box[a+3u] )
+                return false;
+              continue;
+            }
+
+            T t1 = (box[a]    - p[a]) / r[a];
+            T t2 = (box[a+3u] - p[a]) / r[a];
+
+            if( t1 > t2 )
+              std::swap(t1, t2);
+
+            t_min = std::max(t_min, t1);
+            t_max = std::min(t_max, t2);
+
+            if( t_min > t_max )
+              return false;
+          }
+          return true;
+        }
+
+      protected:
+
+        size_t allocate_node()
+        {
+          if( this->m_free == UNDEFINED() )
+          {
+            this->m_nodes.push_back( node_type() );
+            this->m_free = this->m_nodes.size() - 1u;
+            this->m_nodes[this->m_free].m_parent = UNDEFINED();
+          }
+
+          size_t const idx = this->m_free;
+
+          this->m_free = this->m_nodes[idx].m_parent;
+
+          node_type & node = this->m_nodes[idx];
+
+          node.m_parent = UNDEFINED();
+          node.m_left   = UNDEFINED();
+          node.m_right  = UNDEFINED();
+          node.m_height = 0;
+          node.m_obj    = 0;
+
+          return idx;
+        }
+
+        void free_node(size_t const & idx)
+        {
+          node_type & node = this->m_nodes[idx];
+
+          node.m_parent = this->m_free;
+          node.m_height = -1;
+          node.m_obj    = 0;
+
+          this->m_free = idx;
+        }
+
+        /**
+         * Recompute height and box of a node from its children.
+         */
+        void refit(size_t const & idx)
+        {
+          using std::max;
+
+          node_type & node = this->m_nodes[idx];
+
+          node_type const & left  = this->m_nodes[node.m_left];
+          node_type const & right = this->m_nodes[node.m_right];
+
+          node.m_height = 1 + max( left.m_height, right.m_height );
+          merge( left.m_box, right.m_box, node.m_box );
+        }
+
+        void replace_child(size_t const & parent, size_t const & old_child, size_t const & new_child)
+        {
+          if( parent == UNDEFINED() )
+          {
+            this->m_root = new_child;
+            return;
+          }
+
+          if( this->m_nodes[parent].m_left == old_child )
+            this->m_nodes[parent].m_left = new_child;
+          else
+            this->m_nodes[parent].m_right = new_child;
+        }
+
+        /**
+         * Rotate the tree at node A if it is imbalanced.
+         *
+         * @return   The index of the node that took the place of A.
+         */
+        size_t balance(size_t const & iA)
+        {
+          node_type & A = this->m_nodes[iA];
+
+          if( A.is_leaf() || A.m_height < 2 )
+            return iA;
+
+          size_t const iB = A.m_left;
+          size_t const iC = A.m_right;
+
+          node_type & B = this->m_nodes[iB];
+          node_type & C = this->m_nodes[iC];
+
+          int const imbalance = C.m_height - B.m_height;
+
+          if( imbalance > 1 )
+          {
+            // Rotate C up
+            size_t const iF = C.m_left;
+            size_t const iG = C.m_right;
+
+            C.m_left   = iA;
+            C.m_parent = A.m_parent;
+            A.m_parent = iC;
+
+            this->replace_child( C.m_parent, iA, iC );
+
+            if( this->m_nodes[iF].m_height > this->m_nodes[iG].m_height )
+            {
+              C.m_right = iF;
+              A.m_right = iG;
+              this->m_nodes[iG].m_parent = iA;
+            }
+            else
+            {
+              C.m_right = iG;
+              A.m_right = iF;
+              this->m_nodes[iF].m_parent = iA;
+            }
+
+            this->refit( iA );
+            this->refit( iC );
+
+            return iC;
+          }
+
+          if( imbalance < -1 )
+          {
+            // Rotate B up
+            size_t const iD = B.m_left;
+            size_t const iE = B.m_right;
+
+            B.m_left   = iA;
+            B.m_parent = A.m_parent;
+            A.m_parent = iB;
+
+            this->replace_child( B.m_parent, iA, iB );
+
+            if( this->m_nodes[iD].m_height > this->m_nodes[iE].m_height )
+            {
+              B.m_right = iD;
+              A.m_left  = iE;
+              this->m_nodes[iE].m_parent = iA;
+            }
+            else
+            {
+              B.m_right = iE;
+              A.m_left  = iD;
+              this->m_nodes[iD].m_parent = iA;
+            }
+
+            this->refit( iA );
+            this->refit( iB );
+
+            return iB;
+          }
+
+          return iA;
+        }
+
+        /**
+         * Walk from a node to the root, re-balancing and refitting all nodes on the way.
+         */
+        void fix_upwards(size_t idx)
+        {
+          while( idx != UNDEFINED() )
+          {
+            idx = this->balance( idx );
+            this->refit( idx );
+            idx = this->m_nodes[idx].m_parent;
+          }
+        }
+
+        void insert_leaf(size_t const & leaf)
+        {
+          if( this->m_root == UNDEFINED() )
+          {
+            this->m_root = leaf;
+            this->m_nodes[leaf].m_parent = UNDEFINED();
+            return;
+          }
+
+          T const * leaf_box = this->m_nodes[leaf].m_box;
+
+          // Find the best sibling using the surface area heuristic
+          size_t idx = this->m_root;
+
+          while( ! this->m_nodes[idx].is_leaf() )
+          {
+            node_type const & node  = this->m_nodes[idx];
+            node_type const & left  = this->m_nodes[node.m_left];
+            node_type const & right = this->m_nodes[node.m_right];
+
+            T combined[6];
+            merge( node.m_box, leaf_box, combined );
+
+            T const node_area     = area( node.m_box );
+            T const combined_area = area( combined );
+
+            T const cost          = 2*combined_area;             // Cost of creating a new parent for this node and the leaf
+            T const inheritance   = 2*(combined_area - node_area); // Minimum cost of pushing the leaf further down
+
+            T tmp[6];
+
+            merge( left.m_box, leaf_box, tmp );
+            T const cost_left  = left.is_leaf()  ? area(tmp) + inheritance : area(tmp) - area(left.m_box)  + inheritance;
+
+            merge( right.m_box, leaf_box, tmp );
+            T const cost_right = right.is_leaf() ? area(tmp) + inheritance : area(tmp) - area(right.m_box) + inheritance;
+
+            if( cost < cost_left && cost < cost_right )
+              break;
+
+            idx = cost_left < cost_right ? node.m_left : node.m_right;
+          }
+
+          size_t const sibling    = idx;
+          size_t const old_parent = this->m_nodes[sibling].m_parent;
+          size_t const new_parent = this->allocate_node();
+
+          node_type & parent = this->m_nodes[new_parent];
+
+          parent.m_parent = old_parent;
+          parent.m_left   = sibling;
+          parent.m_right  = leaf;
+
+          this->replace_child( old_parent, sibling, new_parent );
+
+          this->m_nodes[sibling].m_parent = new_parent;
+          this->m_nodes[leaf].m_parent    = new_parent;
+
+          this->fix_upwards( new_parent );
+        }
+
+        void remove_leaf(size_t const & leaf)
+        {
+          if( leaf == this->m_root )
+          {
+            this->m_root = UNDEFINED();
+            return;
+          }
+
+          size_t const parent  = this->m_nodes[leaf].m_parent;
+          size_t const grand   = this->m_nodes[parent].m_parent;
+          size_t const sibling = this->m_nodes[parent].m_left == leaf ? this->m_nodes[parent].m_right : this->m_nodes[parent].m_left;
+
+          this->replace_child( grand, parent, sibling );
+          this->m_nodes[sibling].m_parent = grand;
+          this->free_node( parent );
+
+          this->fix_upwards( grand );
+        }
+
+      public:
+
+        /**
+         * Insert object into tree.
+         *
+         * @param obj   The object.
+         * @param box   The tight box of the object.
+         *
+         * @return      The index of the leaf node created for the object.
+         */
+        size_t insert(object_type * obj, T const * box)
+        {
+          using std::max;
+
+          assert( obj || !"insert(): object was null");
+
+          size_t const leaf = this->allocate_node();
+
+          node_type & node = this->m_nodes[leaf];
+
+          node.m_obj    = obj;
+          node.m_height = 0;
+
+          T const margin = this->m_fat_ratio * max( box[3] - box[0], max( box[4] - box[1], box[5] - box[2] ) );
+
+          node.m_box[0] = box[0] - margin;
+          node.m_box[1] = box[1] - margin;
+          node.m_box[2] = box[2] - margin;
+          node.m_box[3] = box[3] + margin;
+          node.m_box[4] = box[4] + margin;
+          node.m_box[5] = box[5] + margin;
+
+          this->insert_leaf( leaf );
+
+          return leaf;
+        }
+
+        void remove(size_t const & leaf)
+        {
+          assert( leaf < this->m_nodes.size()     || !"remove(): invalid leaf");
+          assert( this->m_nodes[leaf].is_leaf()   || !"remove(): not a leaf");
+
+          this->remove_leaf( leaf );
+          this->free_node( leaf );
+        }
+
+        /**
+         * Test if the fat box of a leaf still contains the given box.
+         */
+        bool contains(size_t const & leaf, T const * box) const
+        {
+          T const * fat = this->m_nodes[leaf].m_box;
+
+          return fat[0] <= box[0] && fat[1] <= box[1] && fat[2] <= box[2]
+              && box[3] <= fat[3] && box[4] <= fat[4] && box[5] <= fat[5];
+        }
+
+        /**
+         * Find all objects whose fat boxes overlap the given box.
+         *
+         * @param box       The query box.
+         * @param result    Upon return this container holds the found objects.
+         */
+        void query(T const * box, object_ptr_container & result)
+        {
+          result.clear();
+
+          if( this->m_root == UNDEFINED() )
+            return;
+
+          this->m_stack.clear();
+          this->m_stack.push_back( this->m_root );
+
+          while( ! this->m_stack.empty() )
+          {
+            size_t const idx = this->m_stack.back();
+            this->m_stack.pop_back();
+
+            node_type const & node = this->m_nodes[idx];
+
+            if( ! overlap( node.m_box, box ) )
+              continue;
+
+            if( node.is_leaf() )
+            {
+              result.push_back( node.m_obj );
+              continue;
+            }
+
+            this->m_stack.push_back( node.m_left  );
+            this->m_stack.push_back( node.m_right );
+          }
+        }
+
+        /**
+         * Find all objects whose fat boxes are hit by a semi-infinite ray.
+         *
+         * @param p         The origin of the ray.
+         * @param r         The direction of the ray.
+         * @param result    Upon return this container holds the found objects.
+         */
+        void raycast(T const * p, T const * r, object_ptr_container & result)
+        {
+          result.clear();
+
+          if( this->m_root == UNDEFINED() )
+            return;
+
+          this->m_stack.clear();
+          this->m_stack.push_back( this->m_root );
+
+          while( ! this->m_stack.empty() )
+          {
+            size_t const idx = this->m_stack.back();
+            this->m_stack.pop_back();
+
+            node_type const & node = this->m_nodes[idx];
+
+            if( ! ray_hit( p, r, node.m_box ) )
+              continue;
+
+            if( node.is_leaf() )
+            {
+              result.push_back( node.m_obj );
+              continue;
+            }
+
+            this->m_stack.push_back( node.m_left  );
+            this->m_stack.push_back( node.m_right );
+          }
+        }
+
+        /**
+         * Get height of tree, an empty tree has negative height.
+         */
+        int height() const
+        {
+          return this->m_root == UNDEFINED() ? -1 : this->m_nodes[this->m_root].m_height;
+        }
+
+        void clear()
+        {
+          this->m_nodes.clear();
+          this->m_root = UNDEFINED();
+          this->m_free = UNDEFINED();
+          this->m_synchronized = false;
+        }
+
+      };
+
+  } // namespace detail
+} // namespace broad
+
+// BROAD_DYNAMIC_TREE_H
+#endif
@@ -5,6 +5,8 @@
 #include "broad_object.h"
 #include "broad_accessor.h"
 #include "broad_grid.h"
+#include "broad_sap.h"
+#include "broad_dynamic_tree.h"
 
 #include <util_log.h>
 
@@ -21,6 +23,9 @@ namespace broad
    */
   struct grid_algorithm {};
   struct all_pair_algorithm {};
+  struct persistent_grid_algorithm {};
+  struct sap_algorithm {};
+  struct dynamic_tree_algorithm {};
     
   namespace detail
   {
@@ -36,6 +41,192 @@ namespace broad
       return std::make_pair( obj1, obj2 );
     }
     
+    /**
+     * Re-map a moved object in the persistent grid.
+     * All old overlap pairs of the object are dropped, the object is moved
+     * from the cells spanned by its old box into the cells spanned by its
+     * new box and new overlap pairs are found among the objects already
+     * stored in the new cells. Boxes are taken from the proxies, so
+     * objects that have not moved are never asked for their boxes.
+     */
+    template<typename T>
+    inline void remap_proxy(
+                              System<T> & sys
+                            , Object<T> * A
+                            , size_t & cnt_tests
+                            , size_t & cnt_skipped_tests
+                            , size_t & cnt_hash_collisions
+                            )
+    {
+      typedef detail::Accessor<T>                                accessor;
+      typedef Object<T>                                          object_type;
+      typedef detail::Proxy<T>                                   proxy_type;
+      typedef detail::Grid<T>                                    grid_type;
+      typedef detail::Cell<T>                                    cell_type;
+      
+      grid_type & grid  = accessor::get_grid( sys );
+      size_t    & stamp = accessor::get_query_stamp( sys );
+      
+      proxy_type & PA = accessor::get_proxy( sys, A );
+      
+      // Drop all pairs we reported last time, they will be re-discovered below if they still overlap
+      for( size_t p = 0u; p < PA.m_partners.size(); ++p)
+        accessor::get_proxy( sys, PA.m_partners[p] ).remove_partner( A );
+      PA.m_partners.clear();
+      
+      int min_i;
+      int min_j;
+      int min_k;
+      int max_i;
+      int max_j;
+      int max_k;
+      grid.get_cell_indices( PA.m_min_x, PA.m_min_y, PA.m_min_z, min_i, min_j, min_k );
+      grid.get_cell_indices( PA.m_max_x, PA.m_max_y, PA.m_max_z, max_i, max_j, max_k );
+      
+      bool const same_cells =
+           PA.m_in_grid
+        && min_i == PA.m_min_i && min_j == PA.m_min_j && min_k == PA.m_min_k
+        && max_i == PA.m_max_i && max_j == PA.m_max_j && max_k == PA.m_max_k;
+      
+      // Remove object A from the cells it no longer is stored in
+      if( PA.m_in_grid && !same_cells )
+      {
+        ++stamp;
+        
+        for ( int i = PA.m_min_i; i <= PA.m_max_i; ++i)
+          for ( int j = PA.m_min_j; j <= PA.m_max_j; ++j)
+            for ( int k = PA.m_min_k; k <= PA.m_max_k; ++k)
+            {
+              cell_type & cell = grid.get_cell(i,j,k);
+              
+              if(cell.touched() == stamp)
+                continue;
+              
+              cell.touched() = stamp;
+              cell.remove( A, grid.get_time() );
+            }
+      }
+      
+      ++stamp;
+      
+      PA.m_seen_stamp = stamp;   // Make sure we never test A against itself
+      
+      // Iterate over all grid cells spanned by the new bounding box of object A
+      for ( int i = min_i; i <= max_i; ++i)
+        for ( int j = min_j; j <= max_j; ++j)
+          for ( int k = min_k; k <= max_k; ++k)
+          {
+            cell_type & cell = grid.get_cell(i,j,k);
+            
+            // guard against hash collisions
+            if(cell.touched() == stamp)
+            {
+              ++cnt_hash_collisions;
+              continue;
+            }
+            
+            size_t const number_of_objs = cell.size( grid.get_time() );
+            
+            for( size_t idx=0u; idx < number_of_objs; ++idx)
+            {
+              object_type * B  = cell.get_object_ptr( idx );
+              proxy_type  & PB = accessor::get_proxy( sys, B );
+              
+              // Test if we have already seen B versus A in this query
+              if( PB.m_seen_stamp == stamp )
+              {
+                ++cnt_skipped_tests;
+                continue;
+              }
+              
+              PB.m_seen_stamp = stamp;
+              
+              ++cnt_tests;
+              
+              if( ! PA.overlaps( PB ) )
+                continue;
+              
+              PA.m_partners.push_back( B );
+              PB.m_partners.push_back( A );
+            }
+            
+            cell.touched() = stamp;
+            
+            if( !same_cells )
+              cell.add( A, grid.get_time() );
+          }
+      
+      PA.m_in_grid = true;
+      PA.m_min_i   = min_i;
+      PA.m_min_j   = min_j;
+      PA.m_min_k   = min_k;
+      PA.m_max_i   = max_i;
+      PA.m_max_j   = max_j;
+      PA.m_max_k   = max_k;
+      PA.m_moved   = false;
+    }
+    
+    /**
+     * Bring the dynamic tree up to date with the current boxes of all
+     * objects in the system. If the tree is not synchronized with the
+     * system it is built from scratch. Otherwise only objects whose
+     * boxes have left their fat leaf boxes are re-inserted.
+     *
+     * @return   The number of objects that were (re-)inserted into the tree.
+     */
+    template<typename T>
+    inline size_t update_dynamic_tree( System<T> & sys )
+    {
+      typedef detail::Accessor<T>                                accessor;
+      typedef typename System<T>::object_ptr_container           object_ptr_container;
+      typedef detail::DynamicTree<T>                             tree_type;
+      
+      object_ptr_container & objects = accessor::get_objects( sys );
+      tree_type            & tree    = accessor::get_tree( sys );
+      
+      size_t const N = objects.size();
+      
+      bool const rebuild = !tree.m_synchronized;
+      
+      if( rebuild )
+        tree.clear();
+      
+      tree.m_boxes.resize( 6u*N );
+      
+      size_t cnt_inserts = 0u;
+      
+      for(size_t i = 0u; i < N; ++i)
+      {
+        T * box = &(tree.m_boxes[6u*i]);
+        
+        objects[i]->get_box( box[0], box[1], box[2], box[3], box[4], box[5] );
+        
+        for(size_t a = 0u; a < 6u; ++a)
+        {
+          assert(is_number(box[a]) || !"broad::update_dynamic_tree(): Nan");
+          assert(is_finite(box[a]) || !"broad::update_dynamic_tree(): Inf");
+        }
+        
+        size_t & leaf = accessor::get_proxy( sys, objects[i] ).m_leaf;
+        
+        if( !rebuild )
+        {
+          if( tree.contains( leaf, box ) )
+            continue;
+          
+          tree.remove( leaf );
+        }
+        
+        leaf = tree.insert( objects[i], box );
+        
+        ++cnt_inserts;
+      }
+      
+      tree.m_synchronized = true;
+      
+      return cnt_inserts;
+    }
+    
   }// namespace detail
   
   /**
@@ -119,7 +310,7 @@ namespace broad
       size_t cnt_obj     = objects.size();
       size_t upper_bound = (cnt_obj*(cnt_obj - 1u))/ 2;
 
-      util::Log logging;
+      util::LogDebug logging;
       logging << "broad::find_overlaps(..., all_pair_algorithm): efficiency       = " << efficiency          << util::Log::newline();
       logging << "broad::find_overlaps(..., all_pair_algorithm): #objects         = " << objects.size()      << util::Log::newline();
       logging << "broad::find_overlaps(..., all_pair_algorithm): #bound           = " << upper_bound         << util::Log::newline();
@@ -163,6 +354,9 @@ namespace broad
     grid_type & grid = accessor::get_grid( sys );
     grid.clear();
     
+    // Grid contents are about to be overwritten, so any persistent state is lost
+    accessor::get_synchronized( sys ) = false;
+    
     // Reset touched time stamp on all grid cells so we can guard against hash
     // collisions in the grid
     {
@@ -229,7 +423,7 @@ namespace broad
 
       if(number_of_cells_to_touch > grid.size())
       {
-        util::Log logging;
+        util::LogWarning logging;
 
         logging << "broad::find_overlaps(grid_algorithm): WARNING object spans more cells than grid size" << util::Log::newline();
         logging << "broad::find_overlaps(grid_algorithm): WARNING this suggests bad ratio of object sizes" << util::Log::newline();
@@ -334,7 +528,7 @@ namespace broad
       size_t cnt_obj     = objects.size();
       size_t upper_bound = (cnt_obj*(cnt_obj - 1u))/ 2;
 
-      util::Log logging;
+      util::LogDebug logging;
 
       logging << "broad::find_overlaps(..., grid_algorithm): efficiency       = " << efficiency          << util::Log::newline();
       logging << "broad::find_overlaps(..., grid_algorithm): #objects         = " << objects.size()      << util::Log::newline();
@@ -357,6 +551,435 @@ namespace broad
     return (overlaps.size()>0);
   }
     
+  /**
+   * This function implements a persistent grid based algorithm for broad phase collision detection.
+   *
+   * Grid cell contents and overlap pairs are kept between queries. Only
+   * objects that have been marked as moved by System::update (or that have
+   * been connected since the last query) are re-mapped into the grid and
+   * re-tested. All other pairs are reported from the previous query. The
+   * first query, or any query after the grid spacing or size has changed,
+   * rebuilds everything from scratch.
+   *
+   * Observe that objects that are not updated through System::update will
+   * keep reporting their old box.
+   *
+   * @param efficiency    Upon return this argument gives the ratio of number of found
+   *                      overlaps among the moved objects divided by the actual overlap
+   *                      tests done. A ratio of close to 1 is optimal whereas a ratio
+   *                      close to zero is very bad.
+   */
+  template<typename T, typename overlap_container>
+  inline bool find_overlaps( 
+                            System<T> & sys
+                            , overlap_container & overlaps
+                            , float & efficiency
+                            , persistent_grid_algorithm const & /*tag*/
+                            )
+  {
+    typedef detail::Accessor<T>                                accessor;
+    typedef Object<T>                                          object_type;
+    typedef typename System<T>::object_ptr_container           object_ptr_container;
+    typedef typename object_ptr_container::iterator            object_ptr_iterator;
+    typedef typename System<T>::proxy_container                proxy_container;
+    typedef typename proxy_container::iterator                 proxy_iterator;
+    
+    typedef detail::Grid<T>                    grid_type;
+    typedef typename grid_type::cell_iterator  cell_iterator;
+    
+    // Clean up any potential old left over information
+    overlaps.clear();
+    
+    grid_type            & grid         = accessor::get_grid( sys );
+    object_ptr_container & objects      = accessor::get_objects( sys );
+    proxy_container      & proxies      = accessor::get_proxies( sys );
+    object_ptr_container & moved        = accessor::get_moved( sys );
+    bool                 & synchronized = accessor::get_synchronized( sys );
+    
+    bool const rebuild = !synchronized;
+    
+    if( rebuild )
+    {
+      grid.clear();
+      
+      accessor::get_query_stamp( sys ) = 0u;
+      
+      {
+        cell_iterator cell       = grid.begin();
+        cell_iterator cell_end   = grid.end();
+        for( ; cell != cell_end; ++cell)
+          cell->touched() = 0u;
+      }
+      
+      for(proxy_iterator proxy = proxies.begin(); proxy != proxies.end(); ++proxy)
+      {
+        proxy->m_in_grid    = false;
+        proxy->m_moved      = true;
+        proxy->m_seen_stamp = 0u;
+        proxy->m_partners.clear();
+      }
+      
+      moved = objects;
+      
+      synchronized = true;
+    }
+    
+    size_t const cnt_moved     = moved.size();
+    size_t cnt_tests           = 0u;   // Total number of pair wise object tests done
+    size_t cnt_hash_collisions = 0u;   // Total number of times we encountered a cell hash collision
+    size_t cnt_skipped_tests   = 0u;   // Total number of times we skipped a redundant pair-wise test
+    size_t cnt_found           = 0u;   // Total number of overlaps involving a moved object
+    
+    for(object_ptr_iterator iter = moved.begin(); iter != moved.end(); ++iter)
+    {
+      detail::remap_proxy( sys, *iter, cnt_tests, cnt_skipped_tests, cnt_hash_collisions );
+      
+      cnt_found += accessor::get_proxy( sys, *iter ).m_partners.size();
+    }
+    
+    moved.clear();
+    
+    // Report all current pairs, each pair is stored at both partners so we only report it from the lowest address
+    for(proxy_iterator proxy = proxies.begin(); proxy != proxies.end(); ++proxy)
+    {
+      object_type * A = proxy->m_obj;
+      
+      for( size_t p = 0u; p < proxy->m_partners.size(); ++p)
+      {
+        object_type * B = proxy->m_partners[p];
+        
+        if( A < B )
+          overlaps.push_back( detail::make_overlap(A, B) );
+      }
+    }
+    
+    // Lexiographic storting of overlaps, this is to ensure deterministic behaviour
+    std::sort( overlaps.begin(), overlaps.end() );
+    
+    efficiency = cnt_tests > 0u ? 1.0f*cnt_found / cnt_tests : 1.0f;
+    
+    {
+      util::LogDebug logging;
+      
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): rebuild          = " << rebuild             << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): efficiency       = " << efficiency          << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): #objects         = " << objects.size()      << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): #moved           = " << cnt_moved           << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): #overlaps        = " << overlaps.size()     << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): #tests           = " << cnt_tests           << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): #skipped tests   = " << cnt_skipped_tests   << util::Log::newline();
+      logging << "broad::find_overlaps(..., persistent_grid_algorithm): #hash collisions = " << cnt_hash_collisions << util::Log::newline();
+    }
+    
+    // Return a status flag indicating whether we have seen an overlap or not
+    return (overlaps.size()>0);
+  }
+  
+  /**
+   * This function implements a sweep and prune algorithm for broad phase collision detection.
+   *
+   * End-points of all object boxes are kept sorted along all three
+   * coordinate axes between queries. When the objects in the system have
+   * not changed since the last query the end-point arrays are re-sorted
+   * using insertion sort, which runs in close to linear time when objects
+   * move coherently. Overlaps are found by sweeping along the axis where
+   * the object centers are most spread out. Unlike the grid algorithm the
+   * performance does not depend on the ratio of object sizes, and no cell
+   * spacing has to be computed.
+   *
+   * @param efficiency    Upon return this argument gives the ratio of number of found
+   *                      overlaps divided by the actual overlap tests done. A ratio of
+   *                      close to 1 is optimal whereas a ratio close to zero is very bad.
+   */
+  template<typename T, typename overlap_container>
+  inline bool find_overlaps( 
+                            System<T> & sys
+                            , overlap_container & overlaps
+                            , float & efficiency
+                            , sap_algorithm const & /*tag*/
+                            )
+  {
+    typedef detail::Accessor<T>                                accessor;
+    typedef typename System<T>::object_ptr_container           object_ptr_container;
+    typedef detail::SweepAndPrune<T>                           sap_type;
+    typedef typename sap_type::end_point_type                  end_point_type;
+    typedef typename sap_type::end_point_container             end_point_container;
+    typedef typename end_point_container::iterator             end_point_iterator;
+    
+    // Clean up any potential old left over information
+    overlaps.clear();
+    
+    object_ptr_container & objects = accessor::get_objects( sys );
+    sap_type             & sap     = accessor::get_sap( sys );
+    
+    size_t const N = objects.size();
+    
+    // Get the current boxes of all objects and collect statistics about
+    // the spread of the box centers along each axis.
+    sap.m_boxes.resize( 6u*N );
+    
+    T sum[3]    = {0, 0, 0};
+    T sum_sq[3] = {0, 0, 0};
+    
+    for(size_t i = 0u; i < N; ++i)
+    {
+      T * box = &(sap.m_boxes[6u*i]);
+      
+      objects[i]->get_box( box[0], box[1], box[2], box[3], box[4], box[5] );
+      
+      for(size_t a = 0u; a < 3u; ++a)
+      {
+        assert(is_number(box[a])    || !"broad::find_overlaps(): Nan");
+        assert(is_number(box[a+3u]) || !"broad::find_overlaps(): Nan");
+        assert(is_finite(box[a])    || !"broad::find_overlaps(): Inf");
+        assert(is_finite(box[a+3u]) || !"broad::find_overlaps(): Inf");
+        
+        T const center = (box[a] + box[a+3u]) / 2;
+        
+        sum[a]    += center;
+        sum_sq[a] += center*center;
+      }
+    }
+    
+    // Bring end-point arrays up to date
+    bool const rebuild = !sap.m_synchronized;
+    
+    size_t cnt_swaps = 0u;   // Total number of end-point swaps done by insertion sort
+    
+    for(size_t a = 0u; a < 3u; ++a)
+    {
+      end_point_container & end_points = sap.m_axis[a];
+      
+      if( rebuild )
+      {
+        end_points.resize( 2u*N );
+        
+        for(size_t i = 0u; i < N; ++i)
+        {
+          end_points[2u*i]    = end_point_type( sap.m_boxes[6u*i + a],      i, false );
+          end_points[2u*i+1u] = end_point_type( sap.m_boxes[6u*i + a + 3u], i, true  );
+        }
+        
+        std::sort( end_points.begin(), end_points.end() );
+      }
+      else
+      {
+        for(end_point_iterator e = end_points.begin(); e != end_points.end(); ++e)
+          e->m_value = sap.get_value( a, *e );
+        
+        for(size_t k = 1u; k < end_points.size(); ++k)
+        {
+          end_point_type const tmp = end_points[k];
+          
+          size_t j = k;
+          
+          for(; j > 0u && tmp < end_points[j-1u]; --j, ++cnt_swaps)
+            end_points[j] = end_points[j-1u];
+          
+          end_points[j] = tmp;
+        }
+      }
+    }
+    
+    sap.m_synchronized = true;
+    
+    // Pick the axis with the largest variance of box centers as the sweep axis
+    size_t axis = 0u;
+    
+    if( N > 0u )
+    {
+      T max_variance = -1;
+      
+      for(size_t a = 0u; a < 3u; ++a)
+      {
+        T const mean     = sum[a] / N;
+        T const variance = sum_sq[a] / N - mean*mean;
+        
+        if( variance > max_variance )
+        {
+          max_variance = variance;
+          axis         = a;
+        }
+      }
+    }
+    
+    // Sweep along the chosen axis, keeping a list of all boxes that are
+    // currently intersected by the sweep line.
+    sap.m_active.clear();
+    sap.m_active_pos.resize( N );
+    
+    size_t cnt_tests = 0u;
+    
+    end_point_container & end_points = sap.m_axis[axis];
+    
+    for(end_point_iterator e = end_points.begin(); e != end_points.end(); ++e)
+    {
+      size_t const A = e->m_idx;
+      
+      if( e->m_is_max )
+      {
+        size_t const pos  = sap.m_active_pos[A];
+        size_t const last = sap.m_active.back();
+        
+        sap.m_active[pos]       = last;
+        sap.m_active_pos[last]  = pos;
+        sap.m_active.pop_back();
+        
+        continue;
+      }
+      
+      T const * box_A = &(sap.m_boxes[6u*A]);
+      
+      for(size_t p = 0u; p < sap.m_active.size(); ++p)
+      {
+        size_t const B = sap.m_active[p];
+        
+        T const * box_B = &(sap.m_boxes[6u*B]);
+        
+        ++cnt_tests;
+        
+        // Test if bounding boxes of A and B are overlapping
+        if(box_B[3]  < box_A[0]) continue;
+        if(box_A[3]  < box_B[0]) continue;
+        if(box_B[4]  < box_A[1]) continue;
+        if(box_A[4]  < box_B[1]) continue;
+        if(box_B[5]  < box_A[2]) continue;
+        if(box_A[5]  < box_B[2]) continue;
+        
+        // Report that we have found an overlap between the bounding boxes of object A and B.
+        overlaps.push_back( detail::make_overlap( objects[A], objects[B] ) );
+      }
+      
+      sap.m_active_pos[A] = sap.m_active.size();
+      sap.m_active.push_back( A );
+    }
+    
+    // Lexiographic storting of overlaps, this is to ensure deterministic behaviour
+    std::sort( overlaps.begin(), overlaps.end() );
+    
+    efficiency = cnt_tests > 0u ? 1.0f*overlaps.size() / cnt_tests : 1.0f;
+    
+    {
+      size_t cnt_obj     = objects.size();
+      size_t upper_bound = (cnt_obj*(cnt_obj - 1u))/ 2;
+      
+      util::LogDebug logging;
+      
+      logging << "broad::find_overlaps(..., sap_algorithm): rebuild          = " << rebuild             << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): sweep axis       = " << axis                << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): efficiency       = " << efficiency          << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): #objects         = " << objects.size()      << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): #bound           = " << upper_bound         << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): #overlaps        = " << overlaps.size()     << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): #tests           = " << cnt_tests           << util::Log::newline();
+      logging << "broad::find_overlaps(..., sap_algorithm): #swaps           = " << cnt_swaps           << util::Log::newline();
+    }
+    
+    // Return a status flag indicating whether we have seen an overlap or not
+    return (overlaps.size()>0);
+  }
+  
+  /**
+   * This function implements a dynamic bounding volume tree algorithm for broad phase collision detection.
+   *
+   * The tree is kept between queries. Leaves store fat boxes so objects
+   * that move only slightly are not re-inserted, and objects that leave
+   * their fat box are removed and re-inserted in logarithmic time. Each
+   * object box is then queried against the tree. As the tree adapts to
+   * the objects, the cost does not depend on the ratio of object sizes,
+   * which makes this algorithm suited for scenes with a few huge objects
+   * among many small ones.
+   *
+   * @param efficiency    Upon return this argument gives the ratio of number of found
+   *                      overlaps divided by the actual overlap tests done. A ratio of
+   *                      close to 1 is optimal whereas a ratio close to zero is very bad.
+   */
+  template<typename T, typename overlap_container>
+  inline bool find_overlaps( 
+                            System<T> & sys
+                            , overlap_container & overlaps
+                            , float & efficiency
+                            , dynamic_tree_algorithm const & /*tag*/
+                            )
+  {
+    typedef detail::Accessor<T>                                accessor;
+    typedef Object<T>                                          object_type;
+    typedef typename System<T>::object_ptr_container           object_ptr_container;
+    typedef detail::DynamicTree<T>                             tree_type;
+    
+    // Clean up any potential old left over information
+    overlaps.clear();
+    
+    object_ptr_container & objects = accessor::get_objects( sys );
+    tree_type            & tree    = accessor::get_tree( sys );
+    
+    bool   const rebuild     = !tree.m_synchronized;
+    size_t const cnt_inserts = detail::update_dynamic_tree( sys );
+    
+    size_t cnt_tests = 0u;
+    
+    object_ptr_container candidates;
+    
+    for(size_t i = 0u; i < objects.size(); ++i)
+    {
+      object_type * A = objects[i];
+      
+      T const * box_A = &(tree.m_boxes[6u*i]);
+      
+      tree.query( box_A, candidates );
+      
+      for(size_t c = 0u; c < candidates.size(); ++c)
+      {
+        object_type * B = candidates[c];
+        
+        size_t const j = accessor::get_proxy_idx( B );
+        
+        // Each pair is seen from both objects, only test it from the object with lowest index
+        if( j <= i )
+          continue;
+        
+        T const * box_B = &(tree.m_boxes[6u*j]);
+        
+        ++cnt_tests;
+        
+        // Test if bounding boxes of A and B are overlapping
+        if(box_B[3]  < box_A[0]) continue;
+        if(box_A[3]  < box_B[0]) continue;
+        if(box_B[4]  < box_A[1]) continue;
+        if(box_A[4]  < box_B[1]) continue;
+        if(box_B[5]  < box_A[2]) continue;
+        if(box_A[5]  < box_B[2]) continue;
+        
+        // Report that we have found an overlap between the bounding boxes of object A and B.
+        overlaps.push_back( detail::make_overlap( A, B ) );
+      }
+    }
+    
+    // Lexiographic storting of overlaps, this is to ensure deterministic behaviour
+    std::sort( overlaps.begin(), overlaps.end() );
+    
+    efficiency = cnt_tests > 0u ? 1.0f*overlaps.size() / cnt_tests : 1.0f;
+    
+    {
+      size_t cnt_obj     = objects.size();
+      size_t upper_bound = (cnt_obj*(cnt_obj - 1u))/ 2;
+      
+      util::LogDebug logging;
+      
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): rebuild          = " << rebuild             << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): tree height      = " << tree.height()       << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): efficiency       = " << efficiency          << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): #objects         = " << objects.size()      << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): #bound           = " << upper_bound         << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): #overlaps        = " << overlaps.size()     << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): #tests           = " << cnt_tests           << util::Log::newline();
+      logging << "broad::find_overlaps(..., dynamic_tree_algorithm): #inserts         = " << cnt_inserts         << util::Log::newline();
+    }
+    
+    // Return a status flag indicating whether we have seen an overlap or not
+    return (overlaps.size()>0);
+  }
+  
   /**
    * Default version of the find-overlaps function.
    *
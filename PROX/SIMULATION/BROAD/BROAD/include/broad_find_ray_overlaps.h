@@ -0,0 +1,93 @@
+#ifndef BROAD_FIND_RAY_OVERLAPS_H
+#define BROAD_FIND_RAY_OVERLAPS_H
+
+#include "broad_system.h"
+#include "broad_object.h"
+#include "broad_accessor.h"
+#include "broad_find_overlaps.h"
+
+#include <cassert>    // needed for assert
+
+namespace broad
+{
+
+  /**
+   * Refit the dynamic tree used by ray queries to the current boxes of the
+   * objects. This visits all objects, so it should be done once after the
+   * objects have moved, such as at the end of a time step, rather than for
+   * every ray. A tree that has not been built yet is left alone, the first
+   * ray query builds it.
+   */
+  template<typename T>
+  inline void refit_ray_tree( System<T> & sys )
+  {
+    if( detail::Accessor<T>::get_tree( sys ).m_synchronized )
+      detail::update_dynamic_tree( sys );
+  }
+
+  /**
+   * Find all objects whose bounding boxes are hit by a ray.
+   *
+   * The query is done using the dynamic tree of the system, so the cost
+   * is logarithmic in the number of objects rather than linear. If the
+   * tree is not in use by the broad phase it is built on the first ray
+   * query. Later queries use the boxes the tree was last fitted to, so
+   * call refit_ray_tree after objects have moved.
+   *
+   * @param p_x      The x-coordinate of the ray origin.
+   * @param p_y      The y-coordinate of the ray origin.
+   * @param p_z      The z-coordinate of the ray origin.
+   * @param r_x      The x-coordinate of the ray direction.
+   * @param r_y      The y-coordinate of the ray direction.
+   * @param r_z      The z-coordinate of the ray direction.
+   * @param hits     Upon return this container holds pointers to all objects whose
+   *                 bounding boxes are hit by the ray. The order is unspecified.
+   *
+   * @return         If any object box was hit then the return value is true otherwise it is false.
+   */
+  template<typename T, typename object_ptr_container>
+  inline bool find_ray_overlaps(
+                                System<T> & sys
+                                , T const & p_x
+                                , T const & p_y
+                                , T const & p_z
+                                , T const & r_x
+                                , T const & r_y
+                                , T const & r_z
+                                , object_ptr_container & hits
+                                )
+  {
+    typedef detail::Accessor<T>                                accessor;
+    typedef detail::DynamicTree<T>                             tree_type;
+    typedef typename System<T>::object_ptr_container           candidate_container;
+
+    hits.clear();
+
+    tree_type & tree = accessor::get_tree( sys );
+
+    if( !tree.m_synchronized )
+      detail::update_dynamic_tree( sys );
+
+    T const p[3] = { p_x, p_y, p_z };
+    T const r[3] = { r_x, r_y, r_z };
+
+    candidate_container candidates;
+
+    tree.raycast( p, r, candidates );
+
+    // The tree stores fat boxes so we test the tight boxes of all candidates
+    for(size_t c = 0u; c < candidates.size(); ++c)
+    {
+      T const * box = &(tree.m_boxes[ 6u*accessor::get_proxy_idx( candidates[c] ) ]);
+
+      if( tree_type::ray_hit( p, r, box ) )
+        hits.push_back( candidates[c] );
+    }
+
+    return (hits.size()>0);
+  }
+
+} //namespace broad
+
+// BROAD_FIND_RAY_OVERLAPS_H
+#endif
@@ -115,6 +115,30 @@ namespace broad
           this->m_data[this->m_size++] = obj;
         }
         
+        /**
+         * Remove Object from Cell.
+         * The order of objects in the cell is not preserved, the last object
+         * is swapped into the position of the removed object.
+         *
+         * @param time    The current grid time. This is basically just an unique number identifying the current query that is in progress.
+         */
+        void remove( object_type * obj, size_t const & time )
+        {
+          assert( obj  || !"remove(): object was null");
+          assert( this->m_time_stamp == time || !"remove(): cell data is out of date");
+
+          for(size_t idx = 0u; idx < this->m_size; ++idx)
+          {
+            if( this->m_data[idx] == obj )
+            {
+              this->m_data[idx] = this->m_data[--(this->m_size)];
+              return;
+            }
+          }
+
+          assert( false || !"remove(): object was not in cell");
+        }
+
         object_type * get_object_ptr( size_t const & idx )
         {
           assert( idx >= 0u          || !"get_object_ptr(): invalid index");
@@ -1,8 +1,16 @@
 #ifndef BROAD_OBJECT_H
 #define BROAD_OBJECT_H
 
+#include <cstddef>  // needed for size_t
+
 namespace broad
 {
+  template< typename T> class System;           ///< Forward declaration of System class
+  
+  namespace detail
+  {
+    template< typename T> class Accessor;       ///< Forward declaration of Accessor class
+  }
   
   /**
    * Broad Phase Object Interface.
@@ -16,8 +24,12 @@ namespace broad
     {
     public:
       
+      friend class System<T>;
+      friend class detail::Accessor<T>;
+      
       Object()
       : m_seen_by(0)
+      , m_proxy_idx(0u)
       {}
       
       virtual ~Object(){}
@@ -46,6 +58,11 @@ namespace broad
                                ///< increases the object memory footprint and the technique
                                ///< itself is inherently sequential (thus not parallizable).
                                
+    protected:
+      
+      size_t m_proxy_idx;      ///< Index of the proxy record of this object in the
+                               ///< broad phase system it is connected to. This allows
+                               ///< connect, disconnect and update to run in constant time.
        
     };
   
@@ -0,0 +1,148 @@
+#ifndef BROAD_PROXY_H
+#define BROAD_PROXY_H
+
+#include <broad_object.h>
+
+#include <vector>      // needed for std::vector
+#include <algorithm>   // needed for std::find
+#include <cassert>     // needed for assert
+
+namespace broad
+{
+
+  namespace detail
+  {
+
+    /**
+     * Broad Phase Proxy.
+     * A proxy is the record a broad phase system keeps about each connected
+     * object. It caches the last known bounding box of the object and the
+     * state that the persistent grid algorithm carries between queries, ie.
+     * which grid cells the object is stored in and the objects it currently
+     * overlaps with.
+     *
+     * @tparam T    The precision of the broad phase collision detection system, often either float or double.
+     */
+    template<typename T>
+    class Proxy
+      {
+      public:
+
+        typedef Object<T>                               object_type;
+        typedef std::vector<object_type*>               object_ptr_container;
+
+      public:
+
+        object_type *           m_obj;            ///< The object this proxy is representing.
+
+        T                       m_min_x;          ///< Cached world-space bounding box of the object.
+        T                       m_min_y;
+        T                       m_min_z;
+        T                       m_max_x;
+        T                       m_max_y;
+        T                       m_max_z;
+
+        bool                    m_in_grid;        ///< Boolean flag indicating whether the object is currently stored in the grid cells given by the cell span below.
+        int                     m_min_i;          ///< Span of grid cells the object is currently stored in.
+        int                     m_min_j;
+        int                     m_min_k;
+        int                     m_max_i;
+        int                     m_max_j;
+        int                     m_max_k;
+
+        bool                    m_moved;          ///< Boolean flag indicating whether the box has changed since the last query.
+        size_t                  m_seen_stamp;     ///< Query stamp, used to guard against multiple tests of the same pair during a query.
+        object_ptr_container    m_partners;       ///< All objects whose boxes overlapped this box at the last query.
+
+        size_t                  m_leaf;           ///< Index of the leaf node of the object in the dynamic tree.
+
+      public:
+
+        Proxy()
+        : m_obj(0)
+        , m_min_x(0)
+        , m_min_y(0)
+        , m_min_z(0)
+        , m_max_x(0)
+        , m_max_y(0)
+        , m_max_z(0)
+        , m_in_grid(false)
+        , m_min_i(0)
+        , m_min_j(0)
+        , m_min_k(0)
+        , m_max_i(0)
+        , m_max_j(0)
+        , m_max_k(0)
+        , m_moved(false)
+        , m_seen_stamp(0u)
+        , m_partners()
+        , m_leaf(0u)
+        {}
+
+        Proxy( Proxy const & proxy ) { *this = proxy; }
+
+        Proxy & operator=(Proxy const & proxy )
+        {
+          if( this != &proxy)
+          {
+            this->m_obj        = proxy.m_obj;
+            this->m_min_x      = proxy.m_min_x;
+            this->m_min_y      = proxy.m_min_y;
+            this->m_min_z      = proxy.m_min_z;
+            this->m_max_x      = proxy.m_max_x;
+            this->m_max_y      = proxy.m_max_y;
+            this->m_max_z      = proxy.m_max_z;
+            this->m_in_grid    = proxy.m_in_grid;
+            this->m_min_i      = proxy.m_min_i;
+            this->m_min_j      = proxy.m_min_j;
+            this->m_min_k      = proxy.m_min_k;
+            this->m_max_i      = proxy.m_max_i;
+            this->m_max_j      = proxy.m_max_j;
+            this->m_max_k      = proxy.m_max_k;
+            this->m_moved      = proxy.m_moved;
+            this->m_seen_stamp = proxy.m_seen_stamp;
+            this->m_partners   = proxy.m_partners;
+            this->m_leaf       = proxy.m_leaf;
+          }
+          return *this;
+        }
+
+      public:
+
+        /**
+         * Test if cached box overlaps with the cached box of another proxy.
+         * Touching boxes are considered to be overlapping.
+         */
+        bool overlaps( Proxy const & proxy ) const
+        {
+          if(proxy.m_max_x  < this->m_min_x) return false;
+          if(this->m_max_x  < proxy.m_min_x) return false;
+          if(proxy.m_max_y  < this->m_min_y) return false;
+          if(this->m_max_y  < proxy.m_min_y) return false;
+          if(proxy.m_max_z  < this->m_min_z) return false;
+          if(this->m_max_z  < proxy.m_min_z) return false;
+          return true;
+        }
+
+        /**
+         * Remove partner object.
+         * Partner order is irrelevant so the entry is swapped with the last
+         * entry and popped.
+         */
+        void remove_partner( object_type * obj )
+        {
+          typename object_ptr_container::iterator iter = std::find( this->m_partners.begin(), this->m_partners.end(), obj);
+
+          assert( iter != this->m_partners.end() || !"remove_partner(): obj was not a partner");
+
+          *iter = this->m_partners.back();
+          this->m_partners.pop_back();
+        }
+
+      };
+
+  } // namespace detail
+} // namespace broad
+
+// BROAD_PROXY_H
+#endif
@@ -0,0 +1,120 @@
+#ifndef BROAD_SAP_H
+#define BROAD_SAP_H
+
+#include <vector>      // needed for std::vector
+#include <cassert>     // needed for assert
+
+namespace broad
+{
+
+  namespace detail
+  {
+
+    /**
+     * Sweep and Prune End-point.
+     * An end-point is either the minimum or maximum coordinate of an
+     * object box along one coordinate axis.
+     */
+    template<typename T>
+    class EndPoint
+      {
+      public:
+
+        T       m_value;    ///< The coordinate value of the end-point.
+        size_t  m_idx;      ///< The index of the object (in the object container of the system) that the end-point belongs to.
+        bool    m_is_max;   ///< Boolean flag indicating whether this is a maximum end-point or a minimum end-point.
+
+      public:
+
+        EndPoint()
+        : m_value(0)
+        , m_idx(0u)
+        , m_is_max(false)
+        {}
+
+        EndPoint(T const & value, size_t const & idx, bool const & is_max)
+        : m_value(value)
+        , m_idx(idx)
+        , m_is_max(is_max)
+        {}
+
+      public:
+
+        /**
+         * End-point ordering. At equal coordinate values minimum end-points
+         * are ordered before maximum end-points such that touching boxes are
+         * reported as overlapping.
+         */
+        bool operator<(EndPoint const & e) const
+        {
+          if( this->m_value < e.m_value )
+            return true;
+          if( e.m_value < this->m_value )
+            return false;
+          return !this->m_is_max && e.m_is_max;
+        }
+
+      };
+
+    /**
+     * Sweep and Prune Data.
+     * This class holds the state of the sweep and prune algorithm that is
+     * kept between queries. That is the sorted end-point arrays along all
+     * three coordinate axes and the box of each object from the last query.
+     * Keeping the arrays sorted between queries allows the next query to
+     * use insertion sort, which is close to linear when objects only move
+     * a little.
+     */
+    template<typename T>
+    class SweepAndPrune
+      {
+      public:
+
+        typedef EndPoint<T>                       end_point_type;
+        typedef std::vector<end_point_type>       end_point_container;
+
+      public:
+
+        bool                    m_synchronized;   ///< Boolean flag indicating whether the end-point arrays match the objects in the system.
+        end_point_container     m_axis[3];        ///< Sorted end-points along x, y and z axis.
+        std::vector<T>          m_boxes;          ///< Boxes of all objects, stored as 6 consecutive values (min x, min y, min z, max x, max y, max z) per object.
+        std::vector<size_t>     m_active;         ///< Indices of objects that are currently intersected by the sweep line.
+        std::vector<size_t>     m_active_pos;     ///< Position of each object in the active list.
+
+      public:
+
+        SweepAndPrune()
+        : m_synchronized(false)
+        , m_boxes()
+        , m_active()
+        , m_active_pos()
+        {}
+
+      public:
+
+        /**
+         * Get end-point coordinate value.
+         * Looks up the coordinate of an end-point in the box array.
+         */
+        T const & get_value( size_t const & axis, end_point_type const & e ) const
+        {
+          assert( axis < 3u || !"get_value(): invalid axis");
+
+          return this->m_boxes[ 6u*e.m_idx + (e.m_is_max ? 3u : 0u) + axis ];
+        }
+
+        void clear()
+        {
+          this->m_synchronized = false;
+          this->m_axis[0].clear();
+          this->m_axis[1].clear();
+          this->m_axis[2].clear();
+        }
+
+      };
+
+  } // namespace detail
+} // namespace broad
+
+// BROAD_SAP_H
+#endif
@@ -4,6 +4,9 @@
 #include "broad_object.h"
 #include "broad_accessor.h"
 #include "broad_grid.h"
+#include "broad_proxy.h"
+#include "broad_sap.h"
+#include "broad_dynamic_tree.h"
 
 #include <util_log.h>
 
@@ -25,16 +28,28 @@ namespace broad
       typedef Object<T>                             object_type;
       typedef std::vector<object_type*>             object_ptr_container;
       typedef std::pair<object_type*,object_type*>  overlap_type;
+      typedef detail::Proxy<T>                      proxy_type;
+      typedef std::vector<proxy_type>               proxy_container;
       
     protected:
       
       typedef detail::Grid<T>                       grid_type;
+      typedef detail::SweepAndPrune<T>              sap_type;
+      typedef detail::DynamicTree<T>                tree_type;
       
     protected:
       
       object_ptr_container      m_object_ptrs;
       grid_type                 m_grid;
       
+      proxy_container           m_proxies;          ///< Proxy records of connected objects, m_proxies[i] is the proxy of m_object_ptrs[i].
+      object_ptr_container      m_moved;            ///< Objects whose boxes have changed since the last persistent query.
+      bool                      m_synchronized;     ///< Boolean flag indicating whether grid cells and proxy partners are up to date with the persistent grid algorithm.
+      size_t                    m_query_stamp;      ///< Running stamp used by the persistent grid algorithm to guard against hash collisions and redundant tests.
+      
+      sap_type                  m_sap;              ///< Sorted end-point arrays kept between queries by the sweep and prune algorithm.
+      tree_type                 m_tree;             ///< Dynamic bounding volume tree used by the dynamic tree algorithm and ray queries.
+      
       T m_min_span_x;        ///< Minimum span of object bounding boxes
       T m_min_span_y;
       T m_min_span_z;
@@ -48,6 +63,13 @@ namespace broad
       
       System()
       : m_object_ptrs()
+      , m_grid()
+      , m_proxies()
+      , m_moved()
+      , m_synchronized(false)
+      , m_query_stamp(0u)
+      , m_sap()
+      , m_tree()
       , m_min_span_x( std::numeric_limits<T>::max()  )
       , m_min_span_y( std::numeric_limits<T>::max()  )
       , m_min_span_z( std::numeric_limits<T>::max()  )
@@ -57,6 +79,21 @@ namespace broad
       {
         this->clear();
       }
+      
+      /**
+       * Get the number of objects currently connected to the system.
+       */
+      size_t size() const { return this->m_object_ptrs.size(); }
+      
+      /**
+       * Test if an object is connected to the system.
+       */
+      bool is_connected( object_type const * obj ) const
+      {
+        assert(obj || !"is_connected() obj was null");
+        
+        return obj->m_proxy_idx < this->m_proxies.size() && this->m_proxies[obj->m_proxy_idx].m_obj == obj;
+      }
 
     protected:
 
@@ -98,7 +135,7 @@ namespace broad
 
         if(N==0)
         {
-          util::Log logging;
+          util::LogWarning logging;
 
           logging << "broad::System::compute_optimal_cell_spacing(): No data in system,"
                   << "can not determine spacing, using default value of 1.0"
@@ -145,11 +182,12 @@ namespace broad
         T const optimal_spacing = max(median_x,max(median_y,median_z))*2;
 
         {
-          util::Log logging;
+          util::LogDebug logging;
           logging << "broad::System::compute_optimal_cell_spacing(): optimal spacing found to be = " << optimal_spacing << util::Log::newline();
         }
 
         this->m_grid.set_spacing( optimal_spacing );
+        this->m_synchronized = false;
 
         //--- Now make sure to allocate sufficiently many cells to cover the
         //--- whole scene
@@ -172,24 +210,23 @@ namespace broad
         using std::max;
         
         assert(obj || !"connect() obj was null");
-        assert( std::find( this->m_object_ptrs.begin(), this->m_object_ptrs.end(), obj) == this->m_object_ptrs.end() || !"connect() obj already connected");
+        assert( !this->is_connected(obj) || !"connect() obj already connected");
+        
+        proxy_type proxy;
+        
+        proxy.m_obj   = obj;
+        proxy.m_moved = true;  // Make sure the persistent grid algorithm will pick up the new object
+        
+        // Get bounding box of object
+        obj->get_box( proxy.m_min_x, proxy.m_min_y, proxy.m_min_z, proxy.m_max_x, proxy.m_max_y, proxy.m_max_z);
         
         // Compute some statistics in order to pick a "good" cell spacing of the grid
         // Here we just do something simple, we pick two times the average box size as the cell size!
         {
-          // Get bounding box of object
-          T min_x;
-          T min_y;
-          T min_z;
-          T max_x;
-          T max_y;
-          T max_z;
-          obj->get_box( min_x, min_y, min_z, max_x, max_y, max_z);
-          
           // Compute span of bounding box
-          T const span_x  = max_x - min_x;
-          T const span_y  = max_y - min_y;
-          T const span_z  = max_z - min_z;
+          T const span_x  = proxy.m_max_x - proxy.m_min_x;
+          T const span_y  = proxy.m_max_y - proxy.m_min_y;
+          T const span_z  = proxy.m_max_z - proxy.m_min_z;
           
           // Find minimum spans. Determine simple first order statistics about all boxes that have been added to the system so far.
           this->m_min_span_x = min( this->m_min_span_x, span_x );
@@ -199,24 +236,152 @@ namespace broad
           // Now we use the statistics to set a cell size of the grid.
           T const new_spacing = max( this->m_min_span_x, max( this->m_min_span_y, this->m_min_span_z ) ) * 2;
           
-          this->m_grid.set_spacing( new_spacing );
+          if( new_spacing != this->m_grid.get_spacing() )
+          {
+            this->m_grid.set_spacing( new_spacing );
+            this->m_synchronized = false;
+          }
         }
         
+        obj->m_proxy_idx = this->m_object_ptrs.size();
+        
         this->m_object_ptrs.push_back( obj );
+        this->m_proxies.push_back( proxy );
+        this->m_moved.push_back( obj );
+        this->m_sap.clear();
+        
+        // If the dynamic tree is in use then insert the object right away
+        if( this->m_tree.m_synchronized )
+        {
+          T const box[6] = { proxy.m_min_x, proxy.m_min_y, proxy.m_min_z, proxy.m_max_x, proxy.m_max_y, proxy.m_max_z };
+          
+          this->m_tree.m_boxes.insert( this->m_tree.m_boxes.end(), box, box + 6 );
+          this->m_proxies.back().m_leaf = this->m_tree.insert( obj, box );
+        }
+        
+        size_t const old_grid_size = this->m_grid.size();
+        
         this->m_grid.resize ( this->m_object_ptrs.size() );  // Remember to resize grid so it got space for the objects.
+        
+        if( this->m_grid.size() != old_grid_size )
+          this->m_synchronized = false;   // Hash keys have changed so the cell contents are no longer valid
       }
       
       void disconnect( object_type * obj )
       {
         assert(obj || !"disconnect() obj was null");        
-        assert( std::find( this->m_object_ptrs.begin(), this->m_object_ptrs.end(), obj) != this->m_object_ptrs.end() || !"disconnect() obj was not connected");
+        assert( this->is_connected(obj) || !"disconnect() obj was not connected");
+        
+        size_t const idx  = obj->m_proxy_idx;
+        proxy_type & proxy = this->m_proxies[idx];
+        
+        // Remove any knowledge about obj from the persistent grid state
+        if( this->m_synchronized )
+        {
+          for( size_t p = 0u; p < proxy.m_partners.size(); ++p)
+            this->m_proxies[ proxy.m_partners[p]->m_proxy_idx ].remove_partner( obj );
+          
+          if( proxy.m_in_grid )
+          {
+            ++(this->m_query_stamp);
+            
+            for ( int i = proxy.m_min_i; i <= proxy.m_max_i; ++i)
+              for ( int j = proxy.m_min_j; j <= proxy.m_max_j; ++j)
+                for ( int k = proxy.m_min_k; k <= proxy.m_max_k; ++k)
+                {
+                  typename grid_type::cell_type & cell = this->m_grid.get_cell(i,j,k);
+                  
+                  if(cell.touched() == this->m_query_stamp)
+                    continue;
+                  
+                  cell.touched() = this->m_query_stamp;
+                  cell.remove( obj, this->m_grid.get_time() );
+                }
+          }
+        }
+        
+        if( proxy.m_moved )
+          this->m_moved.erase( std::find( this->m_moved.begin(), this->m_moved.end(), obj) );
+        
+        // Swap last object into the free slot so all other proxy indices stay valid
+        size_t const last = this->m_object_ptrs.size() - 1u;
+        
+        if( this->m_tree.m_synchronized )
+        {
+          this->m_tree.remove( proxy.m_leaf );
+          
+          std::copy( this->m_tree.m_boxes.begin() + 6u*last, this->m_tree.m_boxes.end(), this->m_tree.m_boxes.begin() + 6u*idx );
+          this->m_tree.m_boxes.resize( 6u*last );
+        }
+        
+        if( idx != last )
+        {
+          this->m_object_ptrs[idx] = this->m_object_ptrs[last];
+          this->m_proxies[idx]     = this->m_proxies[last];
+          this->m_object_ptrs[idx]->m_proxy_idx = idx;
+        }
+        
+        this->m_object_ptrs.pop_back();
+        this->m_proxies.pop_back();
+        this->m_sap.clear();
+      }
+      
+      /**
+       * Update object.
+       * This method queries the object for its current bounding box and
+       * compares it to the box stored at the last update. If the box has
+       * changed then the object is marked as moved, and the persistent grid
+       * algorithm will re-map the object at the next query. Objects that
+       * have not moved cost nothing at query time.
+       *
+       * @param obj    A pointer to a connected object.
+       *
+       * @return       If the bounding box of the object has changed then the return value is true otherwise it is false.
+       */
+      bool update( object_type * obj )
+      {
+        assert(obj || !"update() obj was null");
+        assert( this->is_connected(obj) || !"update() obj was not connected");
+        
+        proxy_type & proxy = this->m_proxies[obj->m_proxy_idx];
+        
+        T min_x;
+        T min_y;
+        T min_z;
+        T max_x;
+        T max_y;
+        T max_z;
+        obj->get_box( min_x, min_y, min_z, max_x, max_y, max_z);
+        
+        if(   min_x == proxy.m_min_x && min_y == proxy.m_min_y && min_z == proxy.m_min_z
+           && max_x == proxy.m_max_x && max_y == proxy.m_max_y && max_z == proxy.m_max_z
+           )
+          return false;
+        
+        proxy.m_min_x = min_x;
+        proxy.m_min_y = min_y;
+        proxy.m_min_z = min_z;
+        proxy.m_max_x = max_x;
+        proxy.m_max_y = max_y;
+        proxy.m_max_z = max_z;
+        
+        if( !proxy.m_moved )
+        {
+          proxy.m_moved = true;
+          this->m_moved.push_back( obj );
+        }
         
-        this->m_object_ptrs.remove( obj );
+        return true;
       }
       
       void clear()
       {
         this->m_object_ptrs.clear();
+        this->m_proxies.clear();
+        this->m_moved.clear();
+        this->m_synchronized = false;
+        this->m_sap.clear();
+        this->m_tree.clear();
       }
       
     };
@@ -5,11 +5,13 @@
 #include <kdop_make_tree.h>
 #include <kdop_mesh_reorder.h>
 #include <kdop_refit_tree.h>
+#include <kdop_rigid_transform.h>
 #include <kdop_single_traversal.h>
 #include <kdop_tandem_traversal.h>
 #include <kdop_raycast.h>
 #include <kdop_test_pair.h>
 #include <kdop_tree.h>
+#include <kdop_wide_tree.h>
 #include <kdop_select_contact_point_algorithm.h>
 
 // KDOP_H
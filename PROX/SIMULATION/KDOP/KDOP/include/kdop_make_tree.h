@@ -1,17 +1,22 @@
 #ifndef KDOP_MAKE_TREE_H
 #define KDOP_MAKE_TREE_H
 
+#include <kdop_mesh_reorder.h>
 #include <kdop_refit_tree.h>
 #include <kdop_tree.h>
+#include <kdop_wide_tree.h>
 
 #include <mesh_array_t4mesh.h>
 #include <mesh_array_vertex_attribute.h>
 
 #include <tiny_power2.h>
 
+#include <util_thread_pool.h>
+
 #include <algorithm>   // Needed for std::min
 #include <cassert>     // Needed for assert
 #include <cmath>       // Needed for std::ceil and std::floor
+#include <vector>
 
 namespace kdop
 {
@@ -184,105 +189,216 @@ namespace kdop
       }
     }
     
+    /**
+     * Build the nodes of all chunk levels of a tree, the volumes are left
+     * for a refit. Every branch and every super chunk is an independent
+     * sub tree over a contiguous range of leaves, so they are built
+     * concurrently. A tree that is built again reuses the memory of its
+     * sub trees.
+     *
+     * @param order   If empty then leaf i covers tetrahedron i, this is what
+     *                we want for a mesh that has been reordered. Otherwise
+     *                leaf i covers tetrahedron order[i].
+     */
+    template< typename V, size_t K, typename T>
+    inline void make_tree_nodes( size_t const & mem_bytes
+                               , mesh_array::T4Mesh const & mesh
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                               , std::vector<size_t> const & order
+                               , Tree<T,K> & tree
+                               , util::ThreadPool & pool
+                               )
+    {
+      typedef typename V::value_traits VT;
+
+      using std::ceil;
+      using std::floor;
+      using std::min;
+      using std::max;
+
+      size_t const M          = mesh.tetrahedron_size();                        // Total number of tetrahedra
+
+      assert( M > 0u                          || !"make_tree(): mesh has no tetrahedra");
+      assert( 2u*M - 1u < size_t(UNDEFINED()) || !"make_tree(): mesh is too large for 32 bit node indices");
+      assert( order.empty() || order.size() == M || !"make_tree(): order must cover all tetrahedra");
+
+      //--- Assuming we have reordered a T4Mesh then we may now create subsets for
+      //--- leaf nodes simply by chopping up the tetrahedra array into chunks. In
+      //--- order to do so we much determine how big chunks we need. A memory
+      //--- budget of zero bytes means no limit, the whole mesh then goes into a
+      //--- single contiguous sub tree.
+
+      size_t const node_bytes = sizeof(Node<T,K> );
+      size_t const N_max      = floor( (mem_bytes / node_bytes)* VT::half() );  // Total number of nodes that fit into memory, divided by two because we want two trees simultaneously in memory.
+
+      // However, the maximum number of possible nodes may not be a power of 2,
+      // which is needed to create a perfect balanced binary tree.
+      // There is no need to have more than is needed for one full BVH.
+      size_t const N_perfect  =
+              min(tiny::lower_power2(N_max),
+                  tiny::upper_power2(M * 2)
+              ) - 1;
+      size_t const L          = mem_bytes > 0u ? max( (N_perfect + 1u)/2u, size_t(2u) ) : M; // So if we have a single tree of N nodes (assuming binary balanced tree) then how many leaves will such a tree have? The total number of nodes in a perfect binary tree is N = 2 L  - 1 where L is number of leaf nodes
+      size_t       C          = ceil( VT::one()*M / L);                         // Total number of chunks to divide the mesh into
+      size_t const H          = C > 1u ? max(ceil(log(C) / log(L)), 1.0) : 1u; // Total number of chunk levels (C could be 1)
+
+      tree.m_wide_branches.clear();
+
+      //--- Create enough branches to hold all subtrees correspodining to --------
+      //--- the chuncks of the mesh. ---------------------------------------------
+      tree.m_chunk_levels.resize(H);
+      tree.branches().resize(C);
+
+      //--- Build subtrees for all chuncks of the mesh ---------------------------
+      pool.parallel_for(
+                        C
+                        , [&] (size_t const & c, size_t const & /*thread_idx*/)
+                        {
+                          SubTree<T,K> & branch = tree.branches()[c];
+
+                          size_t const first  =  c*L;                             // Index of first tetrahedron in chunk
+                          size_t const last   =  min( first+L-1u, M - 1u);        // Index of last tetrahedron in chunk
+
+                          MeshChunkInfo<T> geometry( first, last, mesh, X, Y, Z); // Create a wrapper of all mesh information
+
+                          branch.m_nodes.assign( 2u*(last - first + 1u) - 1u, Node<T,K>() ); // A binary tree over n leaves has exactly 2 n - 1 nodes
+
+                          size_t const root_idx = 0u;
+                          size_t       free_idx = 1u;
+
+                          make_subtree<V,K,T>( root_idx, free_idx, geometry, branch, branch.m_height );  // Now build the sucker!
+
+                          if( order.empty() )
+                            return;
+
+                          for(size_t n = 0u; n < branch.m_nodes.size(); ++n)
+                          {
+                            Node<T,K> & node = branch.m_nodes[n];
+
+                            if( node.is_leaf() )
+                            {
+                              node.m_start = order[ node.m_start ];
+                              node.m_end   = node.m_start;
+                            }
+                          }
+                        }
+                        );
+
+      //--- Do the same for all higher levels covering the next lower one bottom up
+      for(size_t h = H - 1; h >= 1; --h)
+      {
+        C = ceil(VT::one()*C / L);
+
+        tree.super_chunks(h - 1).resize(C);
+
+        pool.parallel_for(
+                          C
+                          , [&] (size_t const & c, size_t const & /*thread_idx*/)
+                          {
+                            SubTree<T,K> & super_chunck = tree.super_chunks(h - 1)[c];
+
+                            size_t const first = c * L;
+                            size_t const last = min(first + L - 1, tree.super_chunks(h).size() - 1);
+
+                            super_chunck.m_nodes.assign( 2u*(last - first + 1u) - 1u, Node<T,K>() );
+
+                            size_t const root_idx = 0u;
+                            size_t free_idx = 1u;
+
+                            make_subtree<V,K,T>(
+                                                  root_idx
+                                                , free_idx
+                                                , first
+                                                , last
+                                                , super_chunck
+                                                , super_chunck.m_height
+                                                );
+                          }
+                          );
+      }
+    }
+
   } // end of namespace details
   
+  /**
+   * Build a kDOP tree of a mesh that has been reordered by mesh_reorder.
+   * Branches are built and refitted concurrently by the threads of the
+   * pool, the result does not depend on the number of threads.
+   *
+   * @param mem_bytes   Memory budget of a single sub tree, zero means no limit.
+   */
   template< typename V, size_t K, typename T>
   inline Tree<T,K> make_tree( size_t const & mem_bytes
                              , mesh_array::T4Mesh const & mesh
                              , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
                              , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
                              , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                             , util::ThreadPool & pool
                              )
   {
-    typedef typename V::value_traits VT;
-    
-    assert( mem_bytes > 0u || !"make_tree(): must have some memory");
-    
-    using std::ceil;
-    using std::floor;
-    using std::min;
-    using std::max;
-    
-    using namespace details;
-    
     Tree<T,K> tree;
+
+    details::make_tree_nodes<V,K,T>( mem_bytes, mesh, X, Y, Z, std::vector<size_t>(), tree, pool );
+
+    refit_tree<V,K,T>(tree, mesh, X, Y, Z, pool );
     
-    //--- Assuming we have reordered a T4Mesh then we may now create subsets for
-    //--- leaf nodes simply by chopping up the tetrahedra array into chunks. In
-    //--- order to do so we much determine how big chunks we need.
-    
-    size_t const node_bytes = sizeof(Node<T,K> );    
-    size_t const N_max      = floor( (mem_bytes / node_bytes)* VT::half() );  // Total number of nodes that fit into memory, divided by two because we want two trees simultaneously in memory.
-    
-    // However, the maximum number of possible nodes may not be a power of 2,
-    // which is needed to create a perfect balanced binary tree.
-    // There is no need to have more than is needed for one full BVH.
-    size_t const N_perfect  = 
-            min(tiny::lower_power2(N_max),
-                tiny::upper_power2(mesh.tetrahedron_size() * 2)
-            ) - 1;
-    size_t const L          = (N_perfect + 1)*VT::half();                     // So if we have a single tree of N nodes (assuming binary balanced tree) then how many leaves will such a tree have? The total number of nodes in a perfect binary tree is N = 2 L  - 1 where L is number of leaf nodes
-    size_t const M          = mesh.tetrahedron_size();                        // Total number of tetrahedra
-    size_t       C          = ceil( VT::one()*M / L);                         // Total number of chunks to divide the mesh into
-    size_t const H          = max(ceil(log(C) / log(L)), 1.0);                // Total number of chunk levels (C could be 1)
-    
-    
-    //--- Create enough branches to hold all subtrees correspodining to --------
-    //--- the chuncks of the mesh. ---------------------------------------------
-    tree.m_chunk_levels.resize(H);
-    tree.branches().resize(C);
-    
-    //--- Loop over the chunks of the mesh and build subtrees for each chunck --
-    for( size_t c = 0u; c < C;++c) 
-    {
-      SubTree<T,K> & branch = tree.branches()[c];
-      
-      size_t const first  =  c*L;                             // Index of first tetrahedron in chunk
-      size_t const last   =  min( first+L-1u, M - 1u);        // Index of last tetrahedron in chunk
-      
-      MeshChunkInfo<T> geometry( first, last, mesh, X, Y, Z); // Create a wrapper of all mesh information
-      
-      branch.m_nodes.resize(N_perfect); // Pre-allocate storge for a full perfect balanced tree
+    return tree;
+  }
+
+  template< typename V, size_t K, typename T>
+  inline Tree<T,K> make_tree( size_t const & mem_bytes
+                             , mesh_array::T4Mesh const & mesh
+                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                             )
+  {
+    util::ThreadPool serial(1u);
 
-      size_t const root_idx = 0u;
-      size_t       free_idx = 1u;
+    return make_tree<V,K,T>( mem_bytes, mesh, X, Y, Z, serial );
+  }
 
-      make_subtree<V,K,T>( root_idx, free_idx, geometry, branch, branch.m_height );  // Now build the sucker!
-    }
+  /**
+   * Rebuild a kDOP tree of a deformed mesh. A refit keeps the hierarchy
+   * that was made for the rest shape, and its volumes grow loose once
+   * tetrahedra have moved far from their original neighbours. A rebuild
+   * sorts the tetrahedra by the Morton codes of their current centroids
+   * and builds a new hierarchy over that order. The mesh itself is not
+   * reordered, so any per vertex or per tetrahedron data stays valid.
+   * A wide layout is rebuilt too if the tree had one.
+   *
+   * @param mem_bytes   Memory budget of a single sub tree, zero means no limit.
+   */
+  template< typename V, size_t K, typename T>
+  inline void rebuild_tree( size_t const & mem_bytes
+                          , mesh_array::T4Mesh const & mesh
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                          , Tree<T,K> & tree
+                          , util::ThreadPool & pool
+                          )
+  {
+    bool const wide = tree.has_wide_branches();
 
-    //--- Do the same for all higher levels covering the next lower one bottom up
-    for(size_t h = H - 1; h >= 1; --h)
-    {
-      C = ceil(VT::one()*C / L);
+    std::vector<details::MortonCode> codes;
 
-      tree.super_chunks(h - 1).resize(C);
-      
-      for(size_t c = 0; c < C; ++c)
-      {
-        SubTree<T,K> & super_chunck = tree.super_chunks(h - 1)[c];
+    details::make_morton_codes( mesh, X, Y, Z, codes, pool );
+    details::sort_morton_codes( codes, pool );
 
-        size_t const first = c * L;
-        size_t const last = min(first + L - 1, tree.super_chunks(h).size() - 1);
+    std::vector<size_t> order( codes.size() );
 
-        super_chunck.m_nodes.resize(N_perfect);
+    for(size_t i = 0u; i < codes.size(); ++i)
+      order[i] = codes[i].m_tet;
 
-        size_t const root_idx = 0u;
-        size_t free_idx = 1u;
+    details::make_tree_nodes<V,K,T>( mem_bytes, mesh, X, Y, Z, order, tree, pool );
 
-        make_subtree<V,K,T>(
-                              root_idx
-                            , free_idx
-                            , first
-                            , last
-                            , super_chunck
-                            , super_chunck.m_height
-                            );
-      }
-    }
+    refit_tree<V,K,T>(tree, mesh, X, Y, Z, pool );
 
-    refit_tree<V,K,T>(tree, mesh, X, Y, Z );
-    
-    return tree;
+    if( wide )
+      make_wide_tree( tree );
   }
   
 }// namespace kdop
@@ -8,10 +8,13 @@
 #include <mesh_array_tetrahedron_attribute_t4mesh.h>
 #include <mesh_array_vertex_attribute.h>
 
+#include <util_thread_pool.h>
+
 #include <algorithm>
 #include <cmath>
 #include <limits>
 #include <queue>
+#include <vector>
 
 namespace kdop
 {
@@ -21,13 +24,267 @@ namespace kdop
     struct mesh_reorder_breadth_first {};
 
     struct mesh_reorder_morton {};
-    
-    inline bool compare_morton_codes( std::pair<mesh_array::Tetrahedron, unsigned long long> a
-                                    , std::pair<mesh_array::Tetrahedron, unsigned long long> b
-                                    )
+
+    size_t const morton_bits       = 21u;      ///< Number of bits per coordinate in a Morton code, three of them fit into 64 bits.
+    size_t const morton_block_size = 16384u;   ///< Number of tetrahedra processed by a single task when computing and sorting Morton codes.
+
+    /**
+     * The Morton code of a tetrahedron.
+     */
+    class MortonCode
+    {
+    public:
+
+      unsigned long long m_code;   ///< The interleaved bits of the quantized centroid.
+      size_t             m_tet;    ///< The index of the tetrahedron.
+
+    };
+
+    /**
+     * Spread the lower 21 bits of a value such that there are two zero bits
+     * between every bit, bit k is moved to bit 3 k.
+     */
+    inline unsigned long long spread_morton_bits(unsigned long long x)
+    {
+      x &= 0x00000000001fffffull;
+      x = (x | (x << 32)) & 0x001f00000000ffffull;
+      x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+      x = (x | (x <<  8)) & 0x100f00f00f00f00full;
+      x = (x | (x <<  4)) & 0x10c30c30c30c30c3ull;
+      x = (x | (x <<  2)) & 0x1249249249249249ull;
+      return x;
+    }
+
+    /**
+     * Compute the Morton codes of the centroids of all tetrahedra. The
+     * centroids are quantized into a 2^21 x 2^21 x 2^21 grid spanning
+     * their bounding box, using the same scale along all axes.
+     *
+     * @param mesh    The tetrahedral mesh.
+     * @param X       The x-coordinates of the vertices.
+     * @param Y       The y-coordinates of the vertices.
+     * @param Z       The z-coordinates of the vertices.
+     * @param codes   Upon return the Morton codes in tetrahedron order.
+     * @param pool    The thread pool to use.
+     */
+    template<typename T>
+    inline void make_morton_codes(
+                                  mesh_array::T4Mesh const & mesh
+                                  , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                                  , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                                  , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                                  , std::vector<MortonCode> & codes
+                                  , util::ThreadPool & pool
+                                  )
+    {
+      using std::min;
+      using std::max;
+      using namespace mesh_array;
+
+      size_t const M = mesh.tetrahedron_size();
+      size_t const B = (M + morton_block_size - 1u) / morton_block_size;
+
+      codes.resize(M);
+
+      if( M == 0u )
+        return;
+
+      //--- Copy coordinates into plain arrays, so each vertex is only read ---
+      //--- once through its attribute rather than once per tetrahedron ------
+      size_t const N  = mesh.vertex_size();
+      size_t const BV = (N + morton_block_size - 1u) / morton_block_size;
+
+      std::vector<T> coords( 3u*N );
+
+      pool.parallel_for(
+                        BV
+                        , [&] (size_t const & b, size_t const & /*thread_idx*/)
+                        {
+                          size_t const end = min( (b + 1u)*morton_block_size, N );
+
+                          for(size_t v = b*morton_block_size; v < end; ++v)
+                          {
+                            coords[3u*v]      = X[v];
+                            coords[3u*v + 1u] = Y[v];
+                            coords[3u*v + 2u] = Z[v];
+                          }
+                        }
+                        );
+
+      //--- Compute centroids and the bounds of each block of tetrahedra -------
+      std::vector<T> centroids( 3u*M );
+      std::vector<T> bounds( 6u*B );
+
+      pool.parallel_for(
+                        B
+                        , [&] (size_t const & b, size_t const & /*thread_idx*/)
+                        {
+                          T lower[3] = { std::numeric_limits<T>::max(),    std::numeric_limits<T>::max(),    std::numeric_limits<T>::max()    };
+                          T upper[3] = { std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest() };
+
+                          size_t const end = min( (b + 1u)*morton_block_size, M );
+
+                          for(size_t i = b*morton_block_size; i < end; ++i)
+                          {
+                            Tetrahedron const tet = mesh.tetrahedron(i);
+
+                            T const * const pi = &coords[3u*tet.i()];
+                            T const * const pj = &coords[3u*tet.j()];
+                            T const * const pk = &coords[3u*tet.k()];
+                            T const * const pm = &coords[3u*tet.m()];
+
+                            for(size_t d = 0u; d < 3u; ++d)
+                            {
+                              T const c = T(0.25) * ( pi[d] + pj[d] + pk[d] + pm[d] );
+
+                              centroids[3u*i + d] = c;
+                              lower[d] = min( lower[d], c );
+                              upper[d] = max( upper[d], c );
+                            }
+                          }
+
+                          for(size_t d = 0u; d < 3u; ++d)
+                          {
+                            bounds[6u*b + d]      = lower[d];
+                            bounds[6u*b + 3u + d] = upper[d];
+                          }
+                        }
+                        );
+
+      T lower[3] = { bounds[0], bounds[1], bounds[2] };
+      T upper[3] = { bounds[3], bounds[4], bounds[5] };
+
+      for(size_t b = 1u; b < B; ++b)
+      {
+        for(size_t d = 0u; d < 3u; ++d)
+        {
+          lower[d] = min( lower[d], bounds[6u*b + d]      );
+          upper[d] = max( upper[d], bounds[6u*b + 3u + d] );
+        }
+      }
+
+      //--- Use the same scale along all axes so the grid cells are cubes ------
+      T const cells = static_cast<T>( (1ull << morton_bits) - 1ull );
+      T       scale = std::numeric_limits<T>::max();
+
+      for(size_t d = 0u; d < 3u; ++d)
+      {
+        if( upper[d] > lower[d] )
+          scale = min( scale, cells / (upper[d] - lower[d]) );
+      }
+
+      if( scale == std::numeric_limits<T>::max() )  // All centroids are the same point
+        scale = T(0);
+
+      //--- Quantize and interleave --------------------------------------------
+      pool.parallel_for(
+                        B
+                        , [&] (size_t const & b, size_t const & /*thread_idx*/)
+                        {
+                          size_t const end = min( (b + 1u)*morton_block_size, M );
+
+                          for(size_t i = b*morton_block_size; i < end; ++i)
+                          {
+                            unsigned long long code = 0ull;
+
+                            for(size_t d = 0u; d < 3u; ++d)
+                            {
+                              T const q = min( (centroids[3u*i + d] - lower[d]) * scale, cells );
+
+                              code |= spread_morton_bits( static_cast<unsigned long long>( q ) ) << d;
+                            }
+
+                            codes[i].m_code = code;
+                            codes[i].m_tet  = i;
+                          }
+                        }
+                        );
+    }
+
+    /**
+     * Sort Morton codes using a least significant digit radix sort with
+     * 11 bit digits, so the 63 bits of a code take six passes. Every pass counts digits per block of codes and then
+     * scatters the blocks in parallel. The sort is stable, so tetrahedra
+     * with the same code keep their input order and the result does not
+     * depend on the number of threads. Passes where all codes share the
+     * same digit are skipped, which is typical for the upper bits.
+     *
+     * @param codes   The codes to sort.
+     * @param pool    The thread pool to use.
+     */
+    inline void sort_morton_codes(std::vector<MortonCode> & codes, util::ThreadPool & pool)
     {
-      return a.second < b.second;
+      using std::min;
+
+      size_t const D = 11u;
+      size_t const R = 1u << D;
+      size_t const M = codes.size();
+      size_t const B = (M + morton_block_size - 1u) / morton_block_size;
+
+      if( M < 2u )
+        return;
+
+      std::vector<MortonCode> buffer( M );
+      std::vector<size_t>     counts( B*R );
+
+      for(size_t shift = 0u; shift < 3u*morton_bits; shift += D)
+      {
+        std::fill( counts.begin(), counts.end(), 0u );
+
+        pool.parallel_for(
+                          B
+                          , [&] (size_t const & b, size_t const & /*thread_idx*/)
+                          {
+                            size_t       * count = &counts[b*R];
+                            size_t const   end   = min( (b + 1u)*morton_block_size, M );
+
+                            for(size_t i = b*morton_block_size; i < end; ++i)
+                              ++count[ (codes[i].m_code >> shift) & (R - 1u) ];
+                          }
+                          );
+
+        //--- Turn counts into scatter offsets, digit major and block minor ----
+        size_t offset = 0u;
+        bool   skip   = false;
+
+        for(size_t r = 0u; r < R; ++r)
+        {
+          size_t const before = offset;
+
+          for(size_t b = 0u; b < B; ++b)
+          {
+            size_t const count = counts[b*R + r];
+
+            counts[b*R + r] = offset;
+            offset         += count;
+          }
+
+          if( offset - before == M )
+          {
+            skip = true;
+            break;
+          }
+        }
+
+        if( skip )
+          continue;
+
+        pool.parallel_for(
+                          B
+                          , [&] (size_t const & b, size_t const & /*thread_idx*/)
+                          {
+                            size_t       * offsets = &counts[b*R];
+                            size_t const   end     = min( (b + 1u)*morton_block_size, M );
+
+                            for(size_t i = b*morton_block_size; i < end; ++i)
+                              buffer[ offsets[ (codes[i].m_code >> shift) & (R - 1u) ]++ ] = codes[i];
+                          }
+                          );
+
+        codes.swap( buffer );
+      }
     }
+
   }
   
   template<typename T>
@@ -169,6 +426,14 @@ namespace kdop
     }
   }
   
+  /**
+   * Morton Reordering.
+   * Tetrahedra are sorted by the Morton codes of their centroids, so
+   * tetrahedra that are close in space are also close in memory. Vertices
+   * are numbered in the order they are first used by the sorted
+   * tetrahedra. Codes are computed and sorted in parallel, only the final
+   * copy into the output mesh is serial.
+   */
   template<typename T>
   inline void mesh_reorder( mesh_array::T4Mesh const & M_in
                           , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_in
@@ -179,117 +444,15 @@ namespace kdop
                           , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Y_out
                           , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Z_out
                           , details::mesh_reorder_morton const & /* tag */
+                          , util::ThreadPool & pool
                           )
   {
-    using std::min;
-    using std::max;
     using namespace mesh_array;
     
-    //--- Collect centroids for all tetrahedra ---------------------------------
-    //--- and remember min and max centroid coordinates ------------------------
-    TetrahedronAttribute<T, T4Mesh> centroids_X(M_in);
-    TetrahedronAttribute<T, T4Mesh> centroids_Y(M_in);
-    TetrahedronAttribute<T, T4Mesh> centroids_Z(M_in);
-
-    T min_X = std::numeric_limits<T>::max();
-    T min_Y = std::numeric_limits<T>::max();
-    T min_Z = std::numeric_limits<T>::max();
-    T max_X = std::numeric_limits<T>::min();
-    T max_Y = std::numeric_limits<T>::min();
-    T max_Z = std::numeric_limits<T>::min();
-    
-    for(size_t i = 0; i < M_in.tetrahedron_size(); ++i)
-    {
-      Tetrahedron const tet = M_in.tetrahedron(i);
-
-      centroids_X[ tet ] = 0.25 * (
-              X_in[ tet.i() ] +
-              X_in[ tet.j() ] +
-              X_in[ tet.k() ] +
-              X_in[ tet.m() ]
-      );
-
-      centroids_Y[ tet ] = 0.25 * (
-              Y_in[ tet.i() ] +
-              Y_in[ tet.j() ] +
-              Y_in[ tet.k() ] +
-              Y_in[ tet.m() ]
-      );
-
-      centroids_Z[ tet ] = 0.25 * (
-              Z_in[ tet.i() ] +
-              Z_in[ tet.j() ] +
-              Z_in[ tet.k() ] +
-              Z_in[ tet.m() ]
-      );
-
-      min_X = min(min_X, centroids_X[ tet ]);
-      min_Y = min(min_Y, centroids_Y[ tet ]);
-      min_Z = min(min_Z, centroids_Z[ tet ]);
-      max_X = max(max_X, centroids_X[ tet ]);
-      max_Y = max(max_Y, centroids_Y[ tet ]);
-      max_Z = max(max_Z, centroids_Z[ tet ]);
-    }
-
-    //--- Discretize the centroids' coordinates into K-bit integers ------------
-    //--- because we need to combine them into one 3K bit integer to sort on ---
-    int const K = (sizeof(unsigned long long) * 8) / 3;
+    std::vector<details::MortonCode> morton_codes;
 
-    int scale = ((1 << K) - 1) / (max_X - min_X);
-
-    scale = min(scale, static_cast<int>(
-                                        (((1 << K) - 1) / (max_Y - min_Y))
-                                        )
-                );
-
-    scale = min(scale, static_cast<int>(
-                                        (((1 << K) - 1) / (max_Z - min_Z))
-                                        )
-                );
-
-    for(size_t i = 0; i < M_in.tetrahedron_size(); ++i)
-    {
-      Tetrahedron const tet = M_in.tetrahedron(i);
-
-      centroids_X[ tet ] = static_cast<int>( ((centroids_X[ tet ] - min_X) * scale) );
-      centroids_Y[ tet ] = static_cast<int>( ((centroids_Y[ tet ] - min_Y) * scale) );
-      centroids_Z[ tet ] = static_cast<int>( ((centroids_Z[ tet ] - min_Z) * scale) );
-    }
-
-
-    //--- Now all centroids' coordinates are integers between 0 and 2^K
-    //--- i.e. they're spread out in a 2^K x 2^K x 2^K cube
-    //---
-    //--- let's interleave them into a long integer per tetrahedron, so we
-    //--- can use it to create the Morton ordering
-    std::vector< std::pair<Tetrahedron, unsigned long long> > morton_codes(M_in.tetrahedron_size());
-
-    for(size_t i = 0; i < M_in.tetrahedron_size(); ++i)
-    {
-      Tetrahedron const tet = M_in.tetrahedron(i);
-      
-      unsigned long long x = (unsigned long long) centroids_X[ tet ];
-      unsigned long long y = (unsigned long long) centroids_Y[ tet ];
-      unsigned long long z = (unsigned long long) centroids_Z[ tet ];
-      unsigned long long morton_code = 0;
-
-      for(unsigned long k = 0; k < K; ++k)
-      {
-        // interleave the k'th bits: x, y, z
-        morton_code |= ((x >> k) & 1) << (3 * k);
-        morton_code |= ((y >> k) & 1) << (3 * k + 1);
-        morton_code |= ((z >> k) & 1) << (3 * k + 2);
-      }
-
-      morton_codes[ i ] = std::make_pair(tet, morton_code);
-    }
-            
-    //--- Sort according to Morton codes ---------------------------------------
-    std::sort(
-              morton_codes.begin()
-              , morton_codes.end()
-              , details::compare_morton_codes
-              );
+    details::make_morton_codes( M_in, X_in, Y_in, Z_in, morton_codes, pool );
+    details::sort_morton_codes( morton_codes, pool );
     
     //--- Now simply push out tetrahedra and vertices in that order ------------
     M_out.clear();
@@ -302,7 +465,7 @@ namespace kdop
 
     for(size_t i = 0; i < morton_codes.size(); ++i)
     {
-      Tetrahedron const tet = morton_codes[i].first;
+      Tetrahedron const tet = M_in.tetrahedron( morton_codes[i].m_tet );
 
       Vertex vi = lookup[ tet.i() ];
 
@@ -352,6 +515,23 @@ namespace kdop
     }
   }
   
+  template<typename T>
+  inline void mesh_reorder( mesh_array::T4Mesh const & M_in
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_in
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y_in
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z_in
+                          , mesh_array::T4Mesh & M_out
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & X_out
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Y_out
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Z_out
+                          , details::mesh_reorder_morton const & tag
+                          )
+  {
+    util::ThreadPool serial(1u);
+
+    mesh_reorder<T>( M_in, X_in, Y_in, Z_in, M_out, X_out, Y_out, Z_out, tag, serial );
+  }
+  
   /**
    *
    * A subset of tetrahedra does not necessarily form a contigous chunk  of memory.... this
@@ -385,6 +565,32 @@ namespace kdop
                     , details::mesh_reorder_morton()
                     );
   }
+
+  template<typename T>
+  inline void mesh_reorder( mesh_array::T4Mesh const & M_in
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_in
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y_in
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z_in
+                          , mesh_array::T4Mesh & M_out
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & X_out
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Y_out
+                          , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Z_out
+                          , util::ThreadPool & pool
+                          )
+  {
+    mesh_reorder<T>(
+                    M_in
+                    , X_in
+                    , Y_in
+                    , Z_in
+                    , M_out
+                    , X_out
+                    , Y_out
+                    , Z_out
+                    , details::mesh_reorder_morton()
+                    , pool
+                    );
+  }
   
 }// namespace kdop
 
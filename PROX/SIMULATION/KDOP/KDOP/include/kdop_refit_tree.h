@@ -2,6 +2,7 @@
 #define KDOP_REFIT_TREE_H
 
 #include <kdop_tree.h>
+#include <kdop_wide_tree.h>
 
 #include <types/geometry_direction_table.h>
 #include <types/geometry_dop.h>
@@ -10,6 +11,8 @@
 #include <mesh_array_t4mesh.h>
 #include <mesh_array_vertex_attribute.h>
 
+#include <util_thread_pool.h>
+
 #include <cstddef>
 #include <vector>
 
@@ -45,8 +48,7 @@ namespace kdop
           size_t      const tet_idx = node.m_start;
           Tetrahedron const Tet     = mesh.tetrahedron(tet_idx);
           
-          std::vector<V> points;
-          points.resize(4);
+          V points[4];
           
           points[0](0) = X(Tet.i());
           points[0](1) = Y(Tet.i());
@@ -64,7 +66,7 @@ namespace kdop
           points[3](1) = Y(Tet.m());
           points[3](2) = Z(Tet.m());
           
-          node.m_volume = make_dop(points.begin(), points.end(), DT);
+          node.m_volume = make_dop(&points[0], &points[0] + 4, DT);
           
         }else{
           
@@ -97,7 +99,7 @@ namespace kdop
         
         if(node.is_leaf())
         {
-          SubTree<T, K> const subtree = chunk_children[node.m_start];
+          SubTree<T, K> const & subtree = chunk_children[node.m_start];
 
           node.m_volume = subtree.m_nodes[0].m_volume;
         }
@@ -115,25 +117,40 @@ namespace kdop
     
   } // end of namespace details
   
+  /**
+   * Refit a single branch of a tree.
+   * Branches are independent of each other, so different branches of the
+   * same tree may be refitted concurrently. The wide layout of the branch
+   * is updated too if the tree has one. Once all branches are refitted
+   * the remaining levels must be updated by calling refit_super_chunks.
+   */
   template< typename V, size_t K, typename T>
-  inline void refit_tree(
-                              Tree<T,K> & tree
-                             , mesh_array::T4Mesh const & mesh
-                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
-                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
-                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
-                             )
-  {        
-    geometry::DirectionTable<V,(K/2)> const DT = geometry::DirectionTableHelper<V,(K/2)>::make();
+  inline void refit_branch(
+                           Tree<T,K> & tree
+                           , size_t const & branch_idx
+                           , mesh_array::T4Mesh const & mesh
+                           , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                           , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                           , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                           , geometry::DirectionTable<V,(K/2)> const & DT
+                           )
+  {
+    SubTree<T,K> & branch = tree.branches()[branch_idx];
 
-    size_t C = tree.branches().size();
-    
-    for( size_t c = 0u; c < C;++c) 
-    {
-      SubTree<T,K> & branch = tree.branches()[c];
-            
-      details::refit_subtree<V,K,T>(branch, mesh, X, Y, Z, DT);
-    }
+    details::refit_subtree<V,K,T>(branch, mesh, X, Y, Z, DT);
+
+    if( tree.has_wide_branches() )
+      details::refit_wide_subtree( branch, tree.m_wide_branches[branch_idx] );
+  }
+
+  /**
+   * Refit all levels above the branches and the root volume of a tree.
+   * Assumes that all branches have already been refitted.
+   */
+  template< typename V, size_t K, typename T>
+  inline void refit_super_chunks( Tree<T,K> & tree )
+  {
+    size_t C = 0u;
 
     for(size_t h = tree.number_of_levels() - 1; h >= 1; --h)
     {
@@ -158,6 +175,54 @@ namespace kdop
       tree.m_root = geometry::make_union( tree.m_root, tree.super_chunks(0)[c].m_nodes[0].m_volume );
     }    
   }
+
+  template< typename V, size_t K, typename T>
+  inline void refit_tree(
+                              Tree<T,K> & tree
+                             , mesh_array::T4Mesh const & mesh
+                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                             , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                             )
+  {        
+    geometry::DirectionTable<V,(K/2)> const DT = geometry::DirectionTableHelper<V,(K/2)>::make();
+
+    size_t const C = tree.branches().size();
+    
+    for( size_t c = 0u; c < C;++c) 
+    {
+      refit_branch<V,K,T>(tree, c, mesh, X, Y, Z, DT);
+    }
+
+    refit_super_chunks<V,K,T>(tree);
+  }
+
+  /**
+   * Parallel refit of a tree, branches are refitted concurrently by the
+   * threads of the pool.
+   */
+  template< typename V, size_t K, typename T>
+  inline void refit_tree(
+                         Tree<T,K> & tree
+                         , mesh_array::T4Mesh const & mesh
+                         , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
+                         , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y
+                         , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z
+                         , util::ThreadPool & pool
+                         )
+  {
+    geometry::DirectionTable<V,(K/2)> const DT = geometry::DirectionTableHelper<V,(K/2)>::make();
+
+    pool.parallel_for(
+                      tree.branches().size()
+                      , [&] (size_t const & c, size_t const & /*thread_idx*/)
+                      {
+                        refit_branch<V,K,T>(tree, c, mesh, X, Y, Z, DT);
+                      }
+                      );
+
+    refit_super_chunks<V,K,T>(tree);
+  }
   
 }// namespace kdop
 
@@ -0,0 +1,216 @@
+#ifndef KDOP_RIGID_TRANSFORM_H
+#define KDOP_RIGID_TRANSFORM_H
+
+#include <types/geometry_direction_table.h>
+#include <types/geometry_dop.h>
+
+#include <tiny_vector_functions.h>
+
+#include <cassert>
+#include <cmath>   // needed for std::fabs
+
+namespace kdop
+{
+
+  /**
+   * Rigid Transform.
+   * Maps material (body frame) coordinates into world coordinates,
+   *
+   *    x = R x0 + t
+   *
+   * The rotation matrix is stored as its three rows.
+   */
+  template<typename V>
+  class RigidTransform
+  {
+  public:
+
+    typedef typename V::value_traits VT;
+
+  public:
+
+    V m_row0;   ///< First row of rotation matrix.
+    V m_row1;   ///< Second row of rotation matrix.
+    V m_row2;   ///< Third row of rotation matrix.
+    V m_t;      ///< Translation.
+
+  public:
+
+    RigidTransform()
+    : m_row0( V::make( VT::one(),  VT::zero(), VT::zero() ) )
+    , m_row1( V::make( VT::zero(), VT::one(),  VT::zero() ) )
+    , m_row2( V::make( VT::zero(), VT::zero(), VT::one()  ) )
+    , m_t( V::zero() )
+    {}
+
+    /**
+     * Create a transform from the columns of the rotation matrix, ie. the
+     * world space images of the three coordinate axes of the body frame.
+     */
+    RigidTransform(V const & col0, V const & col1, V const & col2, V const & t)
+    : m_row0( V::make( col0(0), col1(0), col2(0) ) )
+    , m_row1( V::make( col0(1), col1(1), col2(1) ) )
+    , m_row2( V::make( col0(2), col1(2), col2(2) ) )
+    , m_t( t )
+    {}
+
+  public:
+
+    V rotate( V const & x0 ) const
+    {
+      return V::make(
+                     tiny::inner_prod( this->m_row0, x0 )
+                     , tiny::inner_prod( this->m_row1, x0 )
+                     , tiny::inner_prod( this->m_row2, x0 )
+                     );
+    }
+
+    V rotate_transposed( V const & x ) const
+    {
+      return this->m_row0*x(0) + this->m_row1*x(1) + this->m_row2*x(2);
+    }
+
+    V operator()( V const & x0 ) const
+    {
+      return this->rotate(x0) + this->m_t;
+    }
+
+  };
+
+  namespace details
+  {
+
+    /**
+     * DOP Frame Map.
+     * Maps DOPs given in the body frame of an object B into conservative
+     * DOPs in the body frame of an object A.
+     *
+     * A DOP is the intersection of slabs along fixed directions d_k. Let u
+     * be a direction and write u = sum_k lambda_k d_k, then the support of a
+     * DOP in direction u is bounded by sum_k lambda_k times the lower or
+     * upper slab value of d_k depending on the sign of lambda_k. Lambda is
+     * taken to be the least norm solution, lambda_k = d_k^T G^{-1} u where
+     * G = sum_k d_k d_k^T. The map is exact for the slabs along u = d_k
+     * only when directions are orthogonal, otherwise it is conservative.
+     */
+    template<typename V, size_t K, typename T>
+    class DOPFrameMap
+    {
+    public:
+
+      typedef typename V::value_traits VT;
+
+    protected:
+
+      T m_lambda[K/2][K/2];   ///< Mapping coefficients, row j gives slab j of A in terms of slabs of B.
+      T m_offset[K/2];        ///< Projection of the translation onto the slab directions.
+
+    public:
+
+      DOPFrameMap(
+                  RigidTransform<V> const & A
+                  , RigidTransform<V> const & B
+                  , geometry::DirectionTable<V,(K/2)> const & DT
+                  )
+      {
+        using std::fabs;
+
+        size_t const N = K/2;
+
+        //--- Compute inverse of G = sum_k d_k d_k^T -----------------------------
+        T G[3][3];
+        for(size_t r = 0u; r < 3u; ++r)
+          for(size_t c = 0u; c < 3u; ++c)
+            G[r][c] = VT::zero();
+
+        for(size_t k = 0u; k < N; ++k)
+          for(size_t r = 0u; r < 3u; ++r)
+            for(size_t c = 0u; c < 3u; ++c)
+              G[r][c] += DT(k)(r) * DT(k)(c);
+
+        T const det =   G[0][0]*(G[1][1]*G[2][2] - G[1][2]*G[2][1])
+                      - G[0][1]*(G[1][0]*G[2][2] - G[1][2]*G[2][0])
+                      + G[0][2]*(G[1][0]*G[2][1] - G[1][1]*G[2][0]);
+
+        assert( fabs(det) > VT::zero() || !"DOPFrameMap(): direction table does not span space");
+
+        T invG[3][3];
+        invG[0][0] =  (G[1][1]*G[2][2] - G[1][2]*G[2][1]) / det;
+        invG[0][1] = -(G[0][1]*G[2][2] - G[0][2]*G[2][1]) / det;
+        invG[0][2] =  (G[0][1]*G[1][2] - G[0][2]*G[1][1]) / det;
+        invG[1][0] = -(G[1][0]*G[2][2] - G[1][2]*G[2][0]) / det;
+        invG[1][1] =  (G[0][0]*G[2][2] - G[0][2]*G[2][0]) / det;
+        invG[1][2] = -(G[0][0]*G[1][2] - G[0][2]*G[1][0]) / det;
+        invG[2][0] =  (G[1][0]*G[2][1] - G[1][1]*G[2][0]) / det;
+        invG[2][1] = -(G[0][0]*G[2][1] - G[0][1]*G[2][0]) / det;
+        invG[2][2] =  (G[0][0]*G[1][1] - G[0][1]*G[1][0]) / det;
+
+        //--- Relative transform from B frame into A frame, x_A = R x_B + t ---
+        // R = R_A^T R_B and t = R_A^T (t_B - t_A).
+        V const t = A.rotate_transposed( B.m_t - A.m_t );
+
+        for(size_t j = 0u; j < N; ++j)
+        {
+          // u = R^T m_j = R_B^T R_A m_j expressed in the B frame
+          V const u = B.rotate_transposed( A.rotate( DT(j) ) );
+
+          V const w = V::make(
+                                invG[0][0]*u(0) + invG[0][1]*u(1) + invG[0][2]*u(2)
+                              , invG[1][0]*u(0) + invG[1][1]*u(1) + invG[1][2]*u(2)
+                              , invG[2][0]*u(0) + invG[2][1]*u(1) + invG[2][2]*u(2)
+                              );
+
+          for(size_t k = 0u; k < N; ++k)
+            this->m_lambda[j][k] = tiny::inner_prod( DT(k), w );
+
+          this->m_offset[j] = tiny::inner_prod( DT(j), t );
+        }
+      }
+
+    public:
+
+      /**
+       * Map a DOP of B into a conservative DOP in the frame of A.
+       */
+      geometry::DOP<T,K> operator()( geometry::DOP<T,K> const & dop_B ) const
+      {
+        size_t const N = K/2;
+
+        geometry::DOP<T,K> dop_A;
+
+        for(size_t j = 0u; j < N; ++j)
+        {
+          T lower = this->m_offset[j];
+          T upper = this->m_offset[j];
+
+          for(size_t k = 0u; k < N; ++k)
+          {
+            T const & lambda = this->m_lambda[j][k];
+
+            if(lambda >= VT::zero())
+            {
+              lower += lambda*dop_B(k).lower();
+              upper += lambda*dop_B(k).upper();
+            }
+            else
+            {
+              lower += lambda*dop_B(k).upper();
+              upper += lambda*dop_B(k).lower();
+            }
+          }
+
+          dop_A(j).lower() = lower;
+          dop_A(j).upper() = upper;
+        }
+
+        return dop_A;
+      }
+
+    };
+
+  }// namespace details
+
+}// namespace kdop
+
+// KDOP_RIGID_TRANSFORM_H
+#endif
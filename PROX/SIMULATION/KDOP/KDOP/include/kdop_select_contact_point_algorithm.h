@@ -59,10 +59,10 @@ namespace kdop
                       geometry::Tetrahedron<V> const & A
                     , geometry::Tetrahedron<V> const & B
                     , geometry::ContactsCallback<V> & callback
-                    , std::vector<bool> const & surface_A
-                    , std::vector<bool> const & surface_B
-                    , std::vector<V> const & structure_map_A
-                    , std::vector<V> const & structure_map_B
+                    , bool const surface_A[4]
+                    , bool const surface_B[4]
+                    , V const structure_map_A[4]
+                    , V const structure_map_B[4]
                     )
     {
       switch ( get_algorithm_choice() )
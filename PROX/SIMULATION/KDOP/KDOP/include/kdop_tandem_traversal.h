@@ -3,17 +3,188 @@
 
 #include <kdop_test_pair.h>
 #include <kdop_tree.h>
+#include <kdop_wide_tree.h>
+#include <kdop_rigid_transform.h>
 #include <kdop_select_contact_point_algorithm.h>
 
 #include <mesh_array.h>
 
 #include <util_profiling.h>
+#include <util_thread_pool.h>
 
 namespace kdop
 {
   namespace details
   {
-    
+
+    /**
+     * Rigid Traversal Context.
+     * Holds what is needed to traverse two trees given in the body frames
+     * of their objects. Node volumes of B are mapped into the frame of A
+     * and tetrahedron vertices are only transformed into world space once
+     * a leaf-leaf overlap is found.
+     */
+    template< typename V, size_t K, typename T>
+    class RigidContext
+    {
+    public:
+
+      RigidTransform<V>                   const & m_transform_A;
+      RigidTransform<V>                   const & m_transform_B;
+      geometry::DirectionTable<V,(K/2)>   const   m_DT;
+      DOPFrameMap<V,K,T>                  const   m_map;           ///< Maps volumes of B into the frame of A.
+      DOPFrameMap<V,K,T>                  const   m_inverse_map;   ///< Maps volumes of A into the frame of B, used by wide traversal.
+
+    public:
+
+      RigidContext( RigidTransform<V> const & A, RigidTransform<V> const & B)
+      : m_transform_A(A)
+      , m_transform_B(B)
+      , m_DT( geometry::DirectionTableHelper<V,(K/2)>::make() )
+      , m_map( A, B, m_DT )
+      , m_inverse_map( B, A, m_DT )
+      {}
+
+    };
+
+    /**
+     * Generate contacts between two tetrahedra whose leaf volumes overlap.
+     */
+    template< typename V, size_t K, typename T>
+    inline void leaf_leaf_test(
+                               size_t const & tet_idx_A
+                               , mesh_array::T4Mesh const & mesh_A
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_A
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y_A
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z_A
+                               , mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> const & surface_map_A
+                               , mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & Sa
+                               , size_t const & tet_idx_B
+                               , mesh_array::T4Mesh const & mesh_B
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_B
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y_B
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z_B
+                               , mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> const & surface_map_B
+                               , mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & Sb
+                               , geometry::ContactsCallback<V> & callback
+                               , RigidContext<V,K,T> const * rigid
+                               , bool const & profile
+                               )
+    {
+      using namespace mesh_array;
+
+      if(profile)
+      {
+        PAUSE_TIMER("kdop_tandem_traversal_time");
+        RESUME_TIMER("contact_point_generation_time");
+      }
+
+      Tetrahedron const & tet_A = mesh_A.tetrahedron( tet_idx_A );
+      Tetrahedron const & tet_B = mesh_B.tetrahedron( tet_idx_B );
+      
+      bool const & surface_Ai = surface_map_A( tet_A ).m_i;
+      bool const & surface_Aj = surface_map_A( tet_A ).m_j;
+      bool const & surface_Ak = surface_map_A( tet_A ).m_k;
+      bool const & surface_Am = surface_map_A( tet_A ).m_m;
+
+      if (
+          !surface_Ai &&
+          !surface_Aj &&
+          !surface_Ak &&
+          !surface_Am
+          )
+      {
+        if(profile)
+        {
+          PAUSE_TIMER("contact_point_generation_time");
+          RESUME_TIMER("kdop_tandem_traversal_time");
+        }
+        return;
+      }
+
+      bool const & surface_Bi = surface_map_B( tet_B ).m_i;
+      bool const & surface_Bj = surface_map_B( tet_B ).m_j;
+      bool const & surface_Bk = surface_map_B( tet_B ).m_k;
+      bool const & surface_Bm = surface_map_B( tet_B ).m_m;
+
+      if (
+          !surface_Bi &&
+          !surface_Bj &&
+          !surface_Bk &&
+          !surface_Bm
+          )
+      {
+        if(profile)
+        {
+          PAUSE_TIMER("contact_point_generation_time");
+          RESUME_TIMER("kdop_tandem_traversal_time");
+        }
+        return; // all faces of B are internal
+      }
+
+      V a0 = V::make( X_A( tet_A.i() ), Y_A( tet_A.i() ), Z_A( tet_A.i() ) );
+      V a1 = V::make( X_A( tet_A.j() ), Y_A( tet_A.j() ), Z_A( tet_A.j() ) );
+      V a2 = V::make( X_A( tet_A.k() ), Y_A( tet_A.k() ), Z_A( tet_A.k() ) );
+      V a3 = V::make( X_A( tet_A.m() ), Y_A( tet_A.m() ), Z_A( tet_A.m() ) );
+      
+      V b0 = V::make( X_B( tet_B.i() ), Y_B( tet_B.i() ), Z_B( tet_B.i() ) );
+      V b1 = V::make( X_B( tet_B.j() ), Y_B( tet_B.j() ), Z_B( tet_B.j() ) );
+      V b2 = V::make( X_B( tet_B.k() ), Y_B( tet_B.k() ), Z_B( tet_B.k() ) );
+      V b3 = V::make( X_B( tet_B.m() ), Y_B( tet_B.m() ), Z_B( tet_B.m() ) );
+
+      if(rigid)
+      {
+        // Vertices are in body frames, bring them into world space and
+        // test the world space leaf volumes just as a refitted tree would.
+        a0 = rigid->m_transform_A(a0);
+        a1 = rigid->m_transform_A(a1);
+        a2 = rigid->m_transform_A(a2);
+        a3 = rigid->m_transform_A(a3);
+
+        b0 = rigid->m_transform_B(b0);
+        b1 = rigid->m_transform_B(b1);
+        b2 = rigid->m_transform_B(b2);
+        b3 = rigid->m_transform_B(b3);
+
+        V const points_A[4] = { a0, a1, a2, a3 };
+        V const points_B[4] = { b0, b1, b2, b3 };
+
+        if(!geometry::overlap_dop_dop(
+                                      geometry::make_dop( &points_A[0], &points_A[0] + 4, rigid->m_DT )
+                                      , geometry::make_dop( &points_B[0], &points_B[0] + 4, rigid->m_DT )
+                                      ))
+        {
+          if(profile)
+          {
+            PAUSE_TIMER("contact_point_generation_time");
+            RESUME_TIMER("kdop_tandem_traversal_time");
+          }
+          return;
+        }
+      }
+
+      // Surface and structure maps live on the stack, this is done for
+      // every overlapping pair of leaves so it must not touch the heap.
+      bool const surface_A[4] = { surface_Ai, surface_Aj, surface_Ak, surface_Am };
+      bool const surface_B[4] = { surface_Bi, surface_Bj, surface_Bk, surface_Bm };
+
+      V const structure_A[4] = { Sa( tet_A.i() ), Sa( tet_A.j() ), Sa( tet_A.k() ), Sa( tet_A.m() ) };
+      V const structure_B[4] = { Sb( tet_B.i() ), Sb( tet_B.j() ), Sb( tet_B.k() ), Sb( tet_B.m() ) };
+
+      geometry::Tetrahedron<V> const gtet_A = geometry::make_tetrahedron(a0,a1,a2,a3);
+      geometry::Tetrahedron<V> const gtet_B = geometry::make_tetrahedron(b0,b1,b2,b3);
+
+      callback.set_features( tet_A.idx(), tet_B.idx() );
+
+      SelectContactPointAlgorithm::call_algorithm(gtet_A, gtet_B, callback, surface_A, surface_B, structure_A, structure_B );
+
+      if(profile)
+      {
+        PAUSE_TIMER("contact_point_generation_time");
+        RESUME_TIMER("kdop_tandem_traversal_time");
+      }
+    }
+
     template< typename V, size_t K, typename T>
     inline void traversal(
                           size_t const & node_idx_A
@@ -33,6 +204,8 @@ namespace kdop
                           , mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> const & surface_map_B
                           , mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & Sb
                           , geometry::ContactsCallback<V> & callback
+                          , RigidContext<V,K,T> const * rigid
+                          , bool const & profile
                           )
     {
       using namespace mesh_array;
@@ -40,7 +213,12 @@ namespace kdop
       Node<T,K> const & node_A = branch_A.m_nodes[node_idx_A];
       Node<T,K> const & node_B = branch_B.m_nodes[node_idx_B];
       
-      if(!geometry::overlap_dop_dop(node_A.m_volume, node_B.m_volume))
+      if(rigid)
+      {
+        if(!geometry::overlap_dop_dop(node_A.m_volume, rigid->m_map(node_B.m_volume)))
+          return;
+      }
+      else if(!geometry::overlap_dop_dop(node_A.m_volume, node_B.m_volume))
         return;
       
       bool const A_is_leaf = node_A.is_leaf();
@@ -48,90 +226,12 @@ namespace kdop
       
       if(A_is_leaf && B_is_leaf)
       {
-        PAUSE_TIMER("kdop_tandem_traversal_time");
-        RESUME_TIMER("contact_point_generation_time");
-
-        Tetrahedron const & tet_A = mesh_A.tetrahedron( node_A.m_start );
-        Tetrahedron const & tet_B = mesh_B.tetrahedron( node_B.m_start );
-        
-        bool const & surface_Ai = surface_map_A( tet_A ).m_i;
-        bool const & surface_Aj = surface_map_A( tet_A ).m_j;
-        bool const & surface_Ak = surface_map_A( tet_A ).m_k;
-        bool const & surface_Am = surface_map_A( tet_A ).m_m;
-
-        if (
-            !surface_Ai &&
-            !surface_Aj &&
-            !surface_Ak &&
-            !surface_Am
-            )
-        {
-          PAUSE_TIMER("contact_point_generation_time");
-          RESUME_TIMER("kdop_tandem_traversal_time");
-          return;
-        }
-
-        bool const & surface_Bi = surface_map_B( tet_B ).m_i;
-        bool const & surface_Bj = surface_map_B( tet_B ).m_j;
-        bool const & surface_Bk = surface_map_B( tet_B ).m_k;
-        bool const & surface_Bm = surface_map_B( tet_B ).m_m;
-
-        if (
-            !surface_Bi &&
-            !surface_Bj &&
-            !surface_Bk &&
-            !surface_Bm
-            )
-        {
-          PAUSE_TIMER("contact_point_generation_time");
-          RESUME_TIMER("kdop_tandem_traversal_time");
-          return; // all faces of B are internal
-        }
-
-        V const a0 = V::make( X_A( tet_A.i() ), Y_A( tet_A.i() ), Z_A( tet_A.i() ) );
-        V const a1 = V::make( X_A( tet_A.j() ), Y_A( tet_A.j() ), Z_A( tet_A.j() ) );
-        V const a2 = V::make( X_A( tet_A.k() ), Y_A( tet_A.k() ), Z_A( tet_A.k() ) );
-        V const a3 = V::make( X_A( tet_A.m() ), Y_A( tet_A.m() ), Z_A( tet_A.m() ) );
-        
-        V const b0 = V::make( X_B( tet_B.i() ), Y_B( tet_B.i() ), Z_B( tet_B.i() ) );
-        V const b1 = V::make( X_B( tet_B.j() ), Y_B( tet_B.j() ), Z_B( tet_B.j() ) );
-        V const b2 = V::make( X_B( tet_B.k() ), Y_B( tet_B.k() ), Z_B( tet_B.k() ) );
-        V const b3 = V::make( X_B( tet_B.m() ), Y_B( tet_B.m() ), Z_B( tet_B.m() ) );
-
-        std::vector<bool> surface_A( 4u, false );
-        std::vector<bool> surface_B( 4u, false );
-        std::vector<V> structure_A( 4u, V::zero() );
-        std::vector<V> structure_B( 4u, V::zero() );
-
-
-        geometry::Tetrahedron<V> const gtet_A = geometry::make_tetrahedron(a0,a1,a2,a3);
-        geometry::Tetrahedron<V> const gtet_B = geometry::make_tetrahedron(b0,b1,b2,b3);
-
-        surface_A[0] = surface_Ai;
-        surface_A[1] = surface_Aj;
-        surface_A[2] = surface_Ak;
-        surface_A[3] = surface_Am;
-        
-        surface_B[0] = surface_Bi;
-        surface_B[1] = surface_Bj;
-        surface_B[2] = surface_Bk;
-        surface_B[3] = surface_Bm;
-
-        structure_A[0] = Sa( tet_A.i() );
-        structure_A[1] = Sa( tet_A.j() );
-        structure_A[2] = Sa( tet_A.k() );
-        structure_A[3] = Sa( tet_A.m() );
-
-        structure_B[0] = Sb( tet_B.i() );
-        structure_B[1] = Sb( tet_B.j() );
-        structure_B[2] = Sb( tet_B.k() );
-        structure_B[3] = Sb( tet_B.m() );
-
-        SelectContactPointAlgorithm::call_algorithm(gtet_A, gtet_B, callback, surface_A, surface_B, structure_A, structure_B );
-
-        PAUSE_TIMER("contact_point_generation_time");
-        RESUME_TIMER("kdop_tandem_traversal_time");
-
+        leaf_leaf_test<V,K,T>(  node_A.m_start, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
+                              , node_B.m_start, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
+                              , callback
+                              , rigid
+                              , profile
+                              );
       }
       else if(!A_is_leaf && !B_is_leaf)
       {
@@ -142,6 +242,8 @@ namespace kdop
             traversal<V,K,T>(  a, branch_A, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
                              , b, branch_B, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
                              , callback
+                             , rigid
+                             , profile
                              );
           }
         }
@@ -153,6 +255,8 @@ namespace kdop
           traversal<V,K,T>(           a, branch_A, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
                            , node_idx_B, branch_B, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
                            , callback
+                           , rigid
+                           , profile
                            );
         }
       }
@@ -163,51 +267,348 @@ namespace kdop
           traversal<V,K,T>(  node_idx_A, branch_A, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
                            ,          b, branch_B, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
                            , callback
+                           , rigid
+                           , profile
                            );
         }
       }
       
     }
+
+    /**
+     * Wide traversal.
+     * Traverses the wide layouts of two branches. The volumes of the two
+     * nodes are known to overlap. One of the nodes is expanded by testing
+     * the volume of the other node against all its children in a single
+     * batched test, nodes are expanded in turns so both trees are descended
+     * at the same pace. A node is identified by a flag telling whether it
+     * is a leaf and an index that is the tetrahedron index for leaves and
+     * the wide node index otherwise.
+     */
+    template< typename V, size_t K, typename T, size_t W>
+    inline void wide_traversal(
+                               bool const & leaf_A
+                               , size_t const & idx_A
+                               , geometry::DOP<T,K> const & volume_A
+                               , WideSubTree<T,K,W> const & wide_A
+                               , mesh_array::T4Mesh const & mesh_A
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_A
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y_A
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z_A
+                               , mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> const & surface_map_A
+                               , mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & Sa
+                               , bool const & leaf_B
+                               , size_t const & idx_B
+                               , geometry::DOP<T,K> const & volume_B
+                               , WideSubTree<T,K,W> const & wide_B
+                               , mesh_array::T4Mesh const & mesh_B
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X_B
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Y_B
+                               , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & Z_B
+                               , mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> const & surface_map_B
+                               , mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & Sb
+                               , geometry::ContactsCallback<V> & callback
+                               , RigidContext<V,K,T> const * rigid
+                               , bool const & profile
+                               , bool const & expand_B
+                               )
+    {
+      if(leaf_A && leaf_B)
+      {
+        leaf_leaf_test<V,K,T>(  idx_A, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
+                              , idx_B, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
+                              , callback
+                              , rigid
+                              , profile
+                              );
+        return;
+      }
+
+      if( leaf_A || (!leaf_B && expand_B) )
+      {
+        WideNode<T,K,W> const & node_B = wide_B.m_nodes[idx_B];
+
+        // In body frames the children of B are tested in the frame of B
+        unsigned int const mask = rigid ? overlap_children( rigid->m_inverse_map(volume_A), node_B ) : overlap_children( volume_A, node_B );
+
+        for(size_t c = 0u; c < node_B.m_count; ++c)
+        {
+          if( !(mask & (1u << c)) )
+            continue;
+
+          wide_traversal<V,K,T,W>(  leaf_A,              idx_A,           volume_A,                     wide_A, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
+                                  , node_B.m_leaf[c], node_B.m_child[c], get_child_volume( node_B, c ), wide_B, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
+                                  , callback
+                                  , rigid
+                                  , profile
+                                  , false
+                                  );
+        }
+      }
+      else
+      {
+        WideNode<T,K,W> const & node_A = wide_A.m_nodes[idx_A];
+
+        unsigned int const mask = rigid ? overlap_children( rigid->m_map(volume_B), node_A ) : overlap_children( volume_B, node_A );
+
+        for(size_t c = 0u; c < node_A.m_count; ++c)
+        {
+          if( !(mask & (1u << c)) )
+            continue;
+
+          wide_traversal<V,K,T,W>(  node_A.m_leaf[c], node_A.m_child[c], get_child_volume( node_A, c ), wide_A, mesh_A, X_A, Y_A, Z_A, surface_map_A, Sa
+                                  , leaf_B,            idx_B,            volume_B,                     wide_B, mesh_B, X_B, Y_B, Z_B, surface_map_B, Sb
+                                  , callback
+                                  , rigid
+                                  , profile
+                                  , true
+                                  );
+        }
+      }
+    }
+
+    /**
+     * Traverse a pair of branches, using their wide layouts if both trees
+     * have one.
+     */
+    template< typename V, size_t K, typename T>
+    inline void branch_traversal(
+                                 TestPair<V,K,T> & work_item
+                                 , size_t const & a
+                                 , size_t const & b
+                                 , RigidContext<V,K,T> const * rigid
+                                 , bool const & profile
+                                 )
+    {
+      SubTree<T,K> const & branch_A = work_item.m_tree_a->branches()[a];
+      SubTree<T,K> const & branch_B = work_item.m_tree_b->branches()[b];
+
+      if( work_item.m_tree_a->has_wide_branches() && work_item.m_tree_b->has_wide_branches() )
+      {
+        Node<T,K> const & root_A = branch_A.m_nodes[0];
+        Node<T,K> const & root_B = branch_B.m_nodes[0];
+
+        if(rigid)
+        {
+          if(!geometry::overlap_dop_dop(root_A.m_volume, rigid->m_map(root_B.m_volume)))
+            return;
+        }
+        else if(!geometry::overlap_dop_dop(root_A.m_volume, root_B.m_volume))
+          return;
+
+        // The wide layout leaves out the branch roots, a root that is a
+        // leaf is referred to by its tetrahedron instead.
+        wide_traversal<V,K,T>(  root_A.is_leaf()
+                              , root_A.is_leaf() ? root_A.m_start : 0u
+                              , root_A.m_volume
+                              , work_item.m_tree_a->m_wide_branches[a]
+                              , *(work_item.m_mesh_a)
+                              , *(work_item.m_x_a)
+                              , *(work_item.m_y_a)
+                              , *(work_item.m_z_a)
+                              , *(work_item.m_surface_map_a)
+                              , *(work_item.m_Sa)
+                              , root_B.is_leaf()
+                              , root_B.is_leaf() ? root_B.m_start : 0u
+                              , root_B.m_volume
+                              , work_item.m_tree_b->m_wide_branches[b]
+                              , *(work_item.m_mesh_b)
+                              , *(work_item.m_x_b)
+                              , *(work_item.m_y_b)
+                              , *(work_item.m_z_b)
+                              , *(work_item.m_surface_map_b)
+                              , *(work_item.m_Sb)
+                              , *(work_item.m_callback)
+                              , rigid
+                              , profile
+                              , true
+                              );
+        return;
+      }
+
+      traversal<V,K,T>(  0
+                       , branch_A
+                       , *(work_item.m_mesh_a)
+                       , *(work_item.m_x_a)
+                       , *(work_item.m_y_a)
+                       , *(work_item.m_z_a)
+                       , *(work_item.m_surface_map_a)
+                       , *(work_item.m_Sa)
+                       , 0
+                       , branch_B
+                       , *(work_item.m_mesh_b)
+                       , *(work_item.m_x_b)
+                       , *(work_item.m_y_b)
+                       , *(work_item.m_z_b)
+                       , *(work_item.m_surface_map_b)
+                       , *(work_item.m_Sb)
+                       , *(work_item.m_callback)
+                       , rigid
+                       , profile
+                       );
+    }
+
+    /**
+     * Get the volume of a node in a chunk level of a tree. On the lowest
+     * level, the branches, a chunk is represented by the volume of its
+     * root as branches are traversed by branch_traversal.
+     */
+    template< typename T, size_t K>
+    inline geometry::DOP<T,K> const & get_chunk_volume(
+                                                       Tree<T,K> const & tree
+                                                       , size_t const & level
+                                                       , size_t const & chunk_idx
+                                                       , size_t const & node_idx
+                                                       )
+    {
+      if( level + 1u == tree.number_of_levels() )
+        return tree.branches()[chunk_idx].m_nodes[0].m_volume;
+
+      return tree.super_chunks(level)[chunk_idx].m_nodes[node_idx].m_volume;
+    }
+
+    /**
+     * Chunk Traversal.
+     * Tandem traverses the super chunk levels of two trees. A leaf of a
+     * super chunk refers to a chunk on the next level, so culling on the
+     * super chunks prunes whole groups of branches at a time. Once both
+     * sides are down to single branches these are handed to
+     * branch_traversal. The two trees may have a different number of
+     * levels.
+     */
+    template< typename V, size_t K, typename T>
+    inline void chunk_traversal(
+                                TestPair<V,K,T> & work_item
+                                , size_t const & level_A
+                                , size_t const & chunk_A
+                                , size_t const & node_A
+                                , size_t const & level_B
+                                , size_t const & chunk_B
+                                , size_t const & node_B
+                                , RigidContext<V,K,T> const * rigid
+                                , bool const & profile
+                                )
+    {
+      Tree<T,K> const & tree_A = *(work_item.m_tree_a);
+      Tree<T,K> const & tree_B = *(work_item.m_tree_b);
+
+      geometry::DOP<T,K> const & volume_A = get_chunk_volume( tree_A, level_A, chunk_A, node_A );
+      geometry::DOP<T,K> const & volume_B = get_chunk_volume( tree_B, level_B, chunk_B, node_B );
+
+      if(rigid)
+      {
+        if(!geometry::overlap_dop_dop(volume_A, rigid->m_map(volume_B)))
+          return;
+      }
+      else if(!geometry::overlap_dop_dop(volume_A, volume_B))
+        return;
+
+      bool const A_is_branch = (level_A + 1u == tree_A.number_of_levels());
+      bool const B_is_branch = (level_B + 1u == tree_B.number_of_levels());
+
+      if(A_is_branch && B_is_branch)
+      {
+        branch_traversal<V,K,T>( work_item, chunk_A, chunk_B, rigid, profile );
+        return;
+      }
+
+      if(!A_is_branch)
+      {
+        Node<T,K> const & node = tree_A.super_chunks(level_A)[chunk_A].m_nodes[node_A];
+
+        if(node.is_leaf())
+        {
+          chunk_traversal<V,K,T>( work_item, level_A + 1u, node.m_start, 0u, level_B, chunk_B, node_B, rigid, profile );
+          return;
+        }
+      }
+
+      if(!B_is_branch)
+      {
+        Node<T,K> const & node = tree_B.super_chunks(level_B)[chunk_B].m_nodes[node_B];
+
+        if(node.is_leaf())
+        {
+          chunk_traversal<V,K,T>( work_item, level_A, chunk_A, node_A, level_B + 1u, node.m_start, 0u, rigid, profile );
+          return;
+        }
+      }
+
+      if(!A_is_branch && !B_is_branch)
+      {
+        Node<T,K> const & parent_A = tree_A.super_chunks(level_A)[chunk_A].m_nodes[node_A];
+        Node<T,K> const & parent_B = tree_B.super_chunks(level_B)[chunk_B].m_nodes[node_B];
+
+        for(size_t a = parent_A.m_start; a <= parent_A.m_end; ++a)
+          for(size_t b = parent_B.m_start; b <= parent_B.m_end; ++b)
+            chunk_traversal<V,K,T>( work_item, level_A, chunk_A, a, level_B, chunk_B, b, rigid, profile );
+      }
+      else if(!A_is_branch)
+      {
+        Node<T,K> const & parent_A = tree_A.super_chunks(level_A)[chunk_A].m_nodes[node_A];
+
+        for(size_t a = parent_A.m_start; a <= parent_A.m_end; ++a)
+          chunk_traversal<V,K,T>( work_item, level_A, chunk_A, a, level_B, chunk_B, node_B, rigid, profile );
+      }
+      else
+      {
+        Node<T,K> const & parent_B = tree_B.super_chunks(level_B)[chunk_B].m_nodes[node_B];
+
+        for(size_t b = parent_B.m_start; b <= parent_B.m_end; ++b)
+          chunk_traversal<V,K,T>( work_item, level_A, chunk_A, node_A, level_B, chunk_B, b, rigid, profile );
+      }
+    }
+
+    template< typename V, size_t K, typename T>
+    inline void tandem_traversal_branches(
+                                          TestPair<V,K,T> & work_item
+                                          , RigidContext<V,K,T> const * rigid
+                                          , bool const & profile
+                                          )
+    {
+      // Looping over all pairs of branches makes the cost grow with the
+      // square of the number of chunks, even when only a small part of the
+      // meshes overlap. Start from the top level chunks and cull our way down
+      // instead.
+      size_t const C_A = work_item.m_tree_a->super_chunks(0).size();
+      size_t const C_B = work_item.m_tree_b->super_chunks(0).size();
+
+      for( size_t a = 0u; a < C_A; ++a)
+        for( size_t b = 0u; b < C_B; ++b)
+          chunk_traversal<V,K,T>( work_item, 0u, a, 0u, 0u, b, 0u, rigid, profile );
+    }
     
   }// namespace details
 
+  /**
+   * Tandem traverse a single test pair. If both trees have a wide layout
+   * (see make_wide_tree) then the wide layouts are traversed instead of
+   * the binary branches.
+   *
+   * @param work_item   The test pair to traverse.
+   * @param profile     Boolean flag indicating whether the leaf-leaf tests
+   *                    should pause and resume the profiling timers. Must
+   *                    be false when called from a worker thread as the
+   *                    profiling timers are not thread safe.
+   */
   template< typename V, size_t K, typename T>
-  inline void tandem_traversal( TestPair<V,K,T> & work_item  )
+  inline void tandem_traversal( TestPair<V,K,T> & work_item, bool const & profile = true )
   {
+    if(work_item.m_rigid)
+    {
+      details::RigidContext<V,K,T> const rigid( work_item.m_transform_a, work_item.m_transform_b );
 
-    if(!geometry::overlap_dop_dop(work_item.m_tree_a->m_root, work_item.m_tree_b->m_root))
-      return;
-
-    size_t const C_A = work_item.m_tree_a->branches().size();
-    size_t const C_B = work_item.m_tree_b->branches().size();
+      if(!geometry::overlap_dop_dop(work_item.m_tree_a->m_root, rigid.m_map(work_item.m_tree_b->m_root)))
+        return;
 
-    for( size_t a = 0u; a < C_A; ++a)
+      details::tandem_traversal_branches<V,K,T>( work_item, &rigid, profile );
+    }
+    else
     {
-      SubTree<T,K> const & branch_A = work_item.m_tree_a->branches()[a];
+      if(!geometry::overlap_dop_dop(work_item.m_tree_a->m_root, work_item.m_tree_b->m_root))
+        return;
 
-      for( size_t b = 0u; b < C_B; ++b)
-      {
-        SubTree<T,K> const & branch_B = work_item.m_tree_b->branches()[b];
-
-        details::traversal<V,K,T>(  0
-                                  , branch_A
-                                  , *(work_item.m_mesh_a)
-                                  , *(work_item.m_x_a)
-                                  , *(work_item.m_y_a)
-                                  , *(work_item.m_z_a)
-                                  , *(work_item.m_surface_map_a)
-                                  , *(work_item.m_Sa)
-                                  , 0
-                                  , branch_B
-                                  , *(work_item.m_mesh_b)
-                                  , *(work_item.m_x_b)
-                                  , *(work_item.m_y_b)
-                                  , *(work_item.m_z_b)
-                                  , *(work_item.m_surface_map_b)
-                                  , *(work_item.m_Sb)
-                                  , *(work_item.m_callback)
-                                  );
-      }
+      details::tandem_traversal_branches<V,K,T>( work_item, 0, profile );
     }
   }
 
@@ -240,6 +641,46 @@ namespace kdop
     STOP_TIMER("kdop_tandem_traversal_time");
   }
 
+  /**
+   * Parallel tandem traversal of all test pairs in a work pool.
+   * The test pairs are distributed over the threads of the pool. Each test
+   * pair is processed by exactly one thread, so callbacks are never shared
+   * between threads as long as no two test pairs share the same callback.
+   *
+   * Only the total traversal time is measured, contact point generation
+   * time can not be separated from traversal time when running in parallel.
+   *
+   * @param work_pool   The test pairs to traverse.
+   * @param pool        The thread pool to use.
+   */
+  template< typename V, size_t K, typename T>
+  inline void tandem_traversal(
+                               std::vector< TestPair<V,K,T> > & work_pool
+                               , util::ThreadPool & pool
+                               )
+  {
+    if( work_pool.empty() )
+      return;
+
+    if( pool.size() == 1u )
+    {
+      tandem_traversal<V, K, T>( work_pool );
+      return;
+    }
+
+    START_TIMER("kdop_tandem_traversal_time");
+
+    pool.parallel_for(
+                      work_pool.size()
+                      , [&work_pool] (size_t const & i, size_t const & /*thread_idx*/)
+                      {
+                        tandem_traversal<V, K, T>( work_pool[i], false );
+                      }
+                      );
+
+    STOP_TIMER("kdop_tandem_traversal_time");
+  }
+
 }// namespace kdop
 
 // KDOP_TANDEM_TRAVERSAL_H
@@ -2,6 +2,7 @@
 #define	KDOP_TEST_PAIR_H
 
 #include <kdop_tree.h>
+#include <kdop_rigid_transform.h>
 
 #include <contacts/geometry_contacts_callback.h>
 
@@ -39,6 +40,10 @@ namespace kdop
 
     geometry::ContactsCallback<V> * m_callback;
 
+    bool              m_rigid;         ///< If true then trees and coordinates are given in body frames and the transforms below map them into world space.
+    RigidTransform<V> m_transform_a;   ///< Body frame to world transform of A.
+    RigidTransform<V> m_transform_b;   ///< Body frame to world transform of B.
+
   public:
 
     TestPair()
@@ -57,6 +62,9 @@ namespace kdop
     , m_Sa(0)
     , m_Sb(0)
     , m_callback(0)
+    , m_rigid(false)
+    , m_transform_a()
+    , m_transform_b()
     {}
 
     TestPair(
@@ -91,8 +99,23 @@ namespace kdop
     , m_Sa(&Sa)
     , m_Sb(&Sb)
     , m_callback(&callback)
+    , m_rigid(false)
+    , m_transform_a()
+    , m_transform_b()
     {}
 
+    /**
+     * Make the test pair traverse the trees in the body frames of A and B.
+     * The trees and the vertex coordinates of the test pair must then be
+     * given in the body frames too.
+     */
+    void set_rigid_transforms( RigidTransform<V> const & A, RigidTransform<V> const & B )
+    {
+      this->m_rigid       = true;
+      this->m_transform_a = A;
+      this->m_transform_b = B;
+    }
+
   };
 
 } // namespace kdop
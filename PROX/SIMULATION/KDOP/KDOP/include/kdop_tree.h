@@ -5,11 +5,19 @@
 
 #include <vector>
 #include <cassert>
+#include <cstdint>   // Needed for std::uint32_t
 
 namespace kdop
 {
 
-  inline size_t UNDEFINED() { return 0xFFFF; }
+  /**
+   * Node indices are stored as 32 bit integers. This keeps nodes compact
+   * while still allowing a single sub tree to cover meshes with billions
+   * of tetrahedra.
+   */
+  typedef std::uint32_t index_type;
+
+  inline index_type UNDEFINED() { return 0xFFFFFFFFu; }
 
   template<typename T, size_t K>
   class Node
@@ -21,9 +29,9 @@ namespace kdop
   public:
 
     volume_type m_volume;
-    size_t      m_parent;   // Index of parent node, undefined for root node
-    size_t      m_start;    // Index of first child node
-    size_t      m_end;      // Index of last child node, if node is a leaf then start==end and start has the index value of the geometry entity (tetrahedron) covered by the node.
+    index_type  m_parent;   // Index of parent node, undefined for root node
+    index_type  m_start;    // Index of first child node
+    index_type  m_end;      // Index of last child node, if node is a leaf then start==end and start has the index value of the geometry entity (tetrahedron) covered by the node.
 
   public:
 
@@ -112,6 +120,58 @@ namespace kdop
     }
   };
 
+  /**
+   * Wide Node.
+   * A node of a wide BVH with up to W children. The slabs of the child
+   * volumes are stored in structure of arrays form, slab k of child c is
+   * the interval [m_lower[k][c] , m_upper[k][c]]. This way a single volume
+   * of another tree can be tested against all children in one pass.
+   */
+  template<typename T, size_t K, size_t W>
+  class WideNode
+  {
+  public:
+
+    T          m_lower[K/2][W];   ///< Lower slab values of the children.
+    T          m_upper[K/2][W];   ///< Upper slab values of the children, unused slots hold empty slabs that never overlap anything.
+    index_type m_child[W];        ///< Index of the wide node of a child, if the child is a leaf then this is the index of the tetrahedron.
+    index_type m_source[W];       ///< Index of the binary node that a child volume is copied from.
+    bool       m_leaf[W];         ///< True if the child is a leaf.
+    size_t     m_count;           ///< Number of children in use.
+
+  public:
+
+    WideNode()
+    : m_count(0u)
+    {}
+
+  };
+
+  /**
+   * Wide Sub Tree.
+   * A wide layout of a binary sub tree. Every wide node collapses the top
+   * levels of a binary sub tree into a single node. The root of the binary
+   * sub tree is not stored, the first wide node holds its children.
+   */
+  template<typename T, size_t K, size_t W>
+  class WideSubTree
+  {
+  public:
+
+    typedef WideNode<T,K,W> node_type;
+
+  public:
+
+    std::vector<node_type> m_nodes;
+
+  public:
+
+    WideSubTree()
+    : m_nodes()
+    {}
+
+  };
+
   template<typename T, size_t K>
   class Tree
   {
@@ -119,6 +179,7 @@ namespace kdop
 
     typedef geometry::DOP<T,K>     volume_type;
     typedef SubTree<T,K>           subtree_type;
+    typedef WideSubTree<T,K,4>     wide_subtree_type;
 
   public:
 
@@ -132,11 +193,15 @@ namespace kdop
                                                                 ///< the intermediate levels are called super
                                                                 ///< chuncks (they are chunks of chunks).
 
+    std::vector< wide_subtree_type >         m_wide_branches;   ///< Optional wide layout of the branches, one for each
+                                                                ///< branch. Empty unless make_wide_tree has been called.
+
   public:
 
     Tree()
     : m_root()
     , m_chunk_levels()
+    , m_wide_branches()
     {}
 
     ~Tree(){}
@@ -152,6 +217,7 @@ namespace kdop
       {
         this->m_root         = tree.m_root;
         this->m_chunk_levels = tree.m_chunk_levels;
+        this->m_wide_branches = tree.m_wide_branches;
       }
       return *this;
     }
@@ -162,6 +228,7 @@ namespace kdop
     {
       this->m_root = volume_type();
       this->m_chunk_levels.clear();
+      this->m_wide_branches.clear();
     }
 
     typename std::vector< std::vector<subtree_type> >::reference branches()
@@ -192,6 +259,11 @@ namespace kdop
       return m_chunk_levels[level];
     }
 
+    bool has_wide_branches() const
+    {
+      return ! this->m_wide_branches.empty();
+    }
+
     size_t number_of_levels() const
     {
       return m_chunk_levels.size();
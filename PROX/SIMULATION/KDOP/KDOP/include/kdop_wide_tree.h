@@ -0,0 +1,264 @@
+#ifndef KDOP_WIDE_TREE_H
+#define KDOP_WIDE_TREE_H
+
+#include <kdop_tree.h>
+
+#include <types/geometry_dop.h>
+#include <types/geometry_interval.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include <cassert>
+#include <vector>
+
+namespace kdop
+{
+
+  namespace details
+  {
+
+    /**
+     * Collapse the binary sub tree below a node into a wide node. The
+     * children of the binary node are expanded breadth first until there
+     * are W of them or only leaves are left. Wide nodes are then made for
+     * the children that are not leaves.
+     *
+     * @return   The index of the new wide node.
+     */
+    template<typename T, size_t K, size_t W>
+    inline size_t make_wide_node(
+                                 SubTree<T,K> const & branch
+                                 , size_t const & node_idx
+                                 , WideSubTree<T,K,W> & wide
+                                 )
+    {
+      Node<T,K> const & node = branch.m_nodes[node_idx];
+
+      assert( !node.is_leaf() || !"make_wide_node(): leaves can not be collapsed");
+
+      size_t frontier[W];
+      size_t count = 0u;
+
+      frontier[count++] = node.m_start;
+      frontier[count++] = node.m_end;
+
+      bool expanded = true;
+
+      while( expanded && count < W )
+      {
+        expanded = false;
+
+        for(size_t i = 0u; i < count && count < W; ++i)
+        {
+          Node<T,K> const & child = branch.m_nodes[ frontier[i] ];
+
+          if( child.is_leaf() )
+            continue;
+
+          frontier[i]       = child.m_start;
+          frontier[count++] = child.m_end;
+          expanded          = true;
+        }
+      }
+
+      size_t const wide_idx = wide.m_nodes.size();
+
+      wide.m_nodes.push_back( WideNode<T,K,W>() );
+
+      // Recursion may grow the node vector, so the new node is only
+      // accessed through its index from here on
+      for(size_t c = 0u; c < count; ++c)
+      {
+        Node<T,K> const & child = branch.m_nodes[ frontier[c] ];
+
+        size_t const child_idx = child.is_leaf() ? child.m_start : make_wide_node( branch, frontier[c], wide );
+
+        WideNode<T,K,W> & wide_node = wide.m_nodes[wide_idx];
+
+        wide_node.m_child[c]  = child_idx;
+        wide_node.m_source[c] = frontier[c];
+        wide_node.m_leaf[c]   = child.is_leaf();
+      }
+
+      WideNode<T,K,W> & wide_node = wide.m_nodes[wide_idx];
+
+      wide_node.m_count = count;
+
+      geometry::Interval<T> const empty;
+
+      for(size_t c = count; c < W; ++c)
+      {
+        wide_node.m_child[c]  = UNDEFINED();
+        wide_node.m_source[c] = UNDEFINED();
+        wide_node.m_leaf[c]   = false;
+
+        for(size_t k = 0u; k < K/2; ++k)
+        {
+          wide_node.m_lower[k][c] = empty.lower();
+          wide_node.m_upper[k][c] = empty.upper();
+        }
+      }
+
+      return wide_idx;
+    }
+
+    /**
+     * Copy the child volumes of the binary sub tree into the wide layout.
+     * Must be called whenever the binary sub tree has been refitted.
+     */
+    template<typename T, size_t K, size_t W>
+    inline void refit_wide_subtree(
+                                   SubTree<T,K> const & branch
+                                   , WideSubTree<T,K,W> & wide
+                                   )
+    {
+      size_t const N = wide.m_nodes.size();
+
+      for(size_t i = 0u; i < N; ++i)
+      {
+        WideNode<T,K,W> & wide_node = wide.m_nodes[i];
+
+        for(size_t c = 0u; c < wide_node.m_count; ++c)
+        {
+          geometry::DOP<T,K> const & volume = branch.m_nodes[ wide_node.m_source[c] ].m_volume;
+
+          for(size_t k = 0u; k < K/2; ++k)
+          {
+            wide_node.m_lower[k][c] = volume(k).lower();
+            wide_node.m_upper[k][c] = volume(k).upper();
+          }
+        }
+      }
+    }
+
+    /**
+     * Test a volume against all children of a wide node.
+     *
+     * @return   Bit c is set if the volume overlaps child c.
+     */
+    template<typename T, size_t K, size_t W>
+    inline unsigned int overlap_children( geometry::DOP<T,K> const & A, WideNode<T,K,W> const & node )
+    {
+      bool hit[W];
+
+      for(size_t c = 0u; c < W; ++c)
+        hit[c] = true;
+
+      for(size_t k = 0u; k < K/2; ++k)
+      {
+        T const lower = A(k).lower();
+        T const upper = A(k).upper();
+
+        for(size_t c = 0u; c < W; ++c)
+          hit[c] = hit[c] & (lower <= node.m_upper[k][c]) & (node.m_lower[k][c] <= upper);
+      }
+
+      unsigned int mask = 0u;
+
+      for(size_t c = 0u; c < W; ++c)
+        mask |= (hit[c] ? 1u : 0u) << c;
+
+      return mask;
+    }
+
+#if defined(__SSE__)
+    template<size_t K>
+    inline unsigned int overlap_children( geometry::DOP<float,K> const & A, WideNode<float,K,4> const & node )
+    {
+      __m128 hit = _mm_cmpeq_ps( _mm_setzero_ps(), _mm_setzero_ps() );
+
+      for(size_t k = 0u; k < K/2; ++k)
+      {
+        __m128 const lower = _mm_set1_ps( A(k).lower() );
+        __m128 const upper = _mm_set1_ps( A(k).upper() );
+
+        __m128 const below = _mm_cmple_ps( lower, _mm_loadu_ps( node.m_upper[k] ) );
+        __m128 const above = _mm_cmple_ps( _mm_loadu_ps( node.m_lower[k] ), upper );
+
+        hit = _mm_and_ps( hit, _mm_and_ps( below, above ) );
+      }
+
+      return static_cast<unsigned int>( _mm_movemask_ps( hit ) );
+    }
+#endif
+
+#if defined(__AVX__)
+    template<size_t K>
+    inline unsigned int overlap_children( geometry::DOP<float,K> const & A, WideNode<float,K,8> const & node )
+    {
+      __m256 hit = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+
+      for(size_t k = 0u; k < K/2; ++k)
+      {
+        __m256 const lower = _mm256_set1_ps( A(k).lower() );
+        __m256 const upper = _mm256_set1_ps( A(k).upper() );
+
+        __m256 const below = _mm256_cmp_ps( lower, _mm256_loadu_ps( node.m_upper[k] ), _CMP_LE_OQ );
+        __m256 const above = _mm256_cmp_ps( _mm256_loadu_ps( node.m_lower[k] ), upper, _CMP_LE_OQ );
+
+        hit = _mm256_and_ps( hit, _mm256_and_ps( below, above ) );
+      }
+
+      return static_cast<unsigned int>( _mm256_movemask_ps( hit ) );
+    }
+#endif
+
+    /**
+     * Get the volume of a child of a wide node.
+     */
+    template<typename T, size_t K, size_t W>
+    inline geometry::DOP<T,K> get_child_volume( WideNode<T,K,W> const & node, size_t const & c )
+    {
+      geometry::DOP<T,K> volume;
+
+      for(size_t k = 0u; k < K/2; ++k)
+      {
+        volume(k).lower() = node.m_lower[k][c];
+        volume(k).upper() = node.m_upper[k][c];
+      }
+
+      return volume;
+    }
+
+    template<typename T, size_t K, size_t W>
+    inline void make_wide_subtree(
+                                  SubTree<T,K> const & branch
+                                  , WideSubTree<T,K,W> & wide
+                                  )
+    {
+      wide.m_nodes.clear();
+
+      if( branch.m_nodes.empty() || branch.m_nodes[0].is_leaf() )
+        return;
+
+      make_wide_node( branch, 0u, wide );
+      refit_wide_subtree( branch, wide );
+    }
+
+  }// namespace details
+
+  /**
+   * Build the wide layout of all branches of a tree. Once built, refitting
+   * the tree also refits the wide layout and tandem traversal of two trees
+   * that both have a wide layout uses it.
+   */
+  template<typename T, size_t K>
+  inline void make_wide_tree( Tree<T,K> & tree )
+  {
+    size_t const C = tree.branches().size();
+
+    tree.m_wide_branches.resize( C );
+
+    for(size_t c = 0u; c < C; ++c)
+      details::make_wide_subtree( tree.branches()[c], tree.m_wide_branches[c] );
+  }
+
+}// namespace kdop
+
+// KDOP_WIDE_TREE_H
+#endif
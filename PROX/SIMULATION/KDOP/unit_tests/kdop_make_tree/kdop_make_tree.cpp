@@ -11,15 +11,82 @@
 
 #include <vector>
 
+typedef tiny::MathTypes<float> MT;
+typedef MT::vector3_type       V;
+typedef MT::real_type          T;
+
+namespace
+{
+
+  void make_mesh(
+                 mesh_array::T4Mesh & mesh
+                 , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & X
+                 , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Y
+                 , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> & Z
+                 )
+  {
+    mesh_array::T3Mesh surface;
+    mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+    mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+    mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+    mesh_array::make_sphere<MT>(1.0f, 16u, 16u, surface, sX, sY, sZ);
+
+    mesh_array::T4Mesh mesh_in;
+    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X_in;
+    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y_in;
+    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z_in;
+
+    mesh_array::tetgen(surface, sX, sY, sZ, mesh_in, X_in, Y_in, Z_in);
+
+    kdop::mesh_reorder( mesh_in, X_in, Y_in, Z_in, mesh, X, Y, Z );
+  }
+
+  void check_equal( kdop::Tree<T,8> const & A, kdop::Tree<T,8> const & B )
+  {
+    BOOST_REQUIRE_EQUAL( A.number_of_levels(), B.number_of_levels() );
+
+    for(size_t d = 0u; d < 4u; ++d)
+    {
+      BOOST_CHECK_EQUAL( A.m_root(d).lower(), B.m_root(d).lower() );
+      BOOST_CHECK_EQUAL( A.m_root(d).upper(), B.m_root(d).upper() );
+    }
+
+    for(size_t h = 0u; h < A.number_of_levels(); ++h)
+    {
+      BOOST_REQUIRE_EQUAL( A.super_chunks(h).size(), B.super_chunks(h).size() );
+
+      for(size_t c = 0u; c < A.super_chunks(h).size(); ++c)
+      {
+        kdop::SubTree<T,8> const & a = A.super_chunks(h)[c];
+        kdop::SubTree<T,8> const & b = B.super_chunks(h)[c];
+
+        BOOST_CHECK_EQUAL( a.m_height, b.m_height );
+        BOOST_REQUIRE_EQUAL( a.m_nodes.size(), b.m_nodes.size() );
+
+        for(size_t n = 0u; n < a.m_nodes.size(); ++n)
+        {
+          BOOST_CHECK_EQUAL( a.m_nodes[n].m_parent, b.m_nodes[n].m_parent );
+          BOOST_CHECK_EQUAL( a.m_nodes[n].m_start,  b.m_nodes[n].m_start  );
+          BOOST_CHECK_EQUAL( a.m_nodes[n].m_end,    b.m_nodes[n].m_end    );
+
+          for(size_t d = 0u; d < 4u; ++d)
+          {
+            BOOST_CHECK_EQUAL( a.m_nodes[n].m_volume(d).lower(), b.m_nodes[n].m_volume(d).lower() );
+            BOOST_CHECK_EQUAL( a.m_nodes[n].m_volume(d).upper(), b.m_nodes[n].m_volume(d).upper() );
+          }
+        }
+      }
+    }
+  }
+
+}
+
 
 BOOST_AUTO_TEST_SUITE(kdop);
 
 BOOST_AUTO_TEST_CASE(kdop_make_tree)
 {
-  typedef tiny::MathTypes<float> MT;
-  typedef MT::vector3_type       V;
-  typedef MT::real_type          T;
-
   mesh_array::T3Mesh surface;
   mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
   mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
@@ -45,6 +112,141 @@ BOOST_AUTO_TEST_CASE(kdop_make_tree)
   
   
   kdop::Tree<T,8> tree = kdop::make_tree<V,8,T>( 8000, mesh_out, X_out, Y_out, Z_out );
+
+  // Without a memory budget the whole mesh goes into one sub tree that has
+  // exactly one node per tetrahedron plus one per internal node
+  kdop::Tree<T,8> single = kdop::make_tree<V,8,T>( 0, mesh_out, X_out, Y_out, Z_out );
+
+  size_t const M = mesh_out.tetrahedron_size();
+
+  BOOST_CHECK_EQUAL( single.number_of_levels(), 1u );
+  BOOST_CHECK_EQUAL( single.branches().size(), 1u );
+  BOOST_CHECK_EQUAL( single.branches()[0].m_nodes.size(), 2u*M - 1u );
+
+  std::vector<size_t> counts( M, 0u );
+
+  for(size_t n = 0u; n < single.branches()[0].m_nodes.size(); ++n)
+  {
+    kdop::Node<T,8> const & node = single.branches()[0].m_nodes[n];
+
+    BOOST_CHECK( !node.is_undefined() );
+
+    if( node.is_leaf() )
+      ++counts[ node.m_start ];
+  }
+
+  for(size_t t = 0u; t < M; ++t)
+    BOOST_CHECK_EQUAL( counts[t], 1u );
+
+  // A tiny budget gives a hierarchy of super chunks
+  kdop::Tree<T,8> chunked = kdop::make_tree<V,8,T>( 200, mesh_out, X_out, Y_out, Z_out );
+
+  BOOST_CHECK( chunked.number_of_levels() > 1u );
+  BOOST_CHECK_EQUAL( chunked.branches().size(), (M + 1u) / 2u );
+}
+
+BOOST_AUTO_TEST_CASE(kdop_make_tree_parallel)
+{
+  mesh_array::T4Mesh mesh;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z;
+
+  make_mesh(mesh, X, Y, Z);
+
+  util::ThreadPool pool(4u);
+
+  size_t const budgets[3] = { 0u, 200u, 8000u };
+
+  for(size_t b = 0u; b < 3u; ++b)
+  {
+    kdop::Tree<T,8> const serial   = kdop::make_tree<V,8,T>( budgets[b], mesh, X, Y, Z );
+    kdop::Tree<T,8> const parallel = kdop::make_tree<V,8,T>( budgets[b], mesh, X, Y, Z, pool );
+
+    check_equal( serial, parallel );
+
+    // The mesh is already in Morton order, so a rebuild must give the very
+    // same tree, also when it reuses the memory of a tree with another budget
+    kdop::Tree<T,8> rebuilt = kdop::make_tree<V,8,T>( budgets[(b + 1u) % 3u], mesh, X, Y, Z );
+
+    kdop::rebuild_tree<V,8,T>( budgets[b], mesh, X, Y, Z, rebuilt, pool );
+
+    check_equal( serial, rebuilt );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(kdop_rebuild_tree)
+{
+  mesh_array::T4Mesh mesh;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z;
+
+  make_mesh(mesh, X, Y, Z);
+
+  kdop::Tree<T,8> tree = kdop::make_tree<V,8,T>( 8000u, mesh, X, Y, Z );
+
+  kdop::make_wide_tree( tree );
+
+  // Swap the two halves of the mesh so the old hierarchy no longer matches
+  for(size_t v = 0u; v < mesh.vertex_size(); ++v)
+  {
+    mesh_array::Vertex const & vertex = mesh.vertex(v);
+
+    X(vertex) += X(vertex) > 0.0f ? -2.0f : 2.0f;
+  }
+
+  util::ThreadPool pool(4u);
+
+  kdop::rebuild_tree<V,8,T>( 8000u, mesh, X, Y, Z, tree, pool );
+
+  BOOST_CHECK( tree.has_wide_branches() );
+  BOOST_CHECK_EQUAL( tree.m_wide_branches.size(), tree.branches().size() );
+
+  // Every tetrahedron is covered by exactly one leaf, and every leaf volume
+  // contains the tetrahedron
+  size_t const M = mesh.tetrahedron_size();
+
+  std::vector<size_t> counts( M, 0u );
+
+  geometry::DirectionTable<V,4> const DT = geometry::DirectionTableHelper<V,4>::make();
+
+  for(size_t c = 0u; c < tree.branches().size(); ++c)
+  {
+    kdop::SubTree<T,8> const & branch = tree.branches()[c];
+
+    for(size_t n = 0u; n < branch.m_nodes.size(); ++n)
+    {
+      kdop::Node<T,8> const & node = branch.m_nodes[n];
+
+      if( !node.is_leaf() )
+        continue;
+
+      BOOST_REQUIRE( node.m_start < M );
+
+      ++counts[ node.m_start ];
+
+      mesh_array::Tetrahedron const tet = mesh.tetrahedron( node.m_start );
+
+      size_t const corners[4] = { tet.i(), tet.j(), tet.k(), tet.m() };
+
+      for(size_t corner = 0u; corner < 4u; ++corner)
+      {
+        V const p = V::make( X[corners[corner]], Y[corners[corner]], Z[corners[corner]] );
+
+        for(size_t d = 0u; d < 4u; ++d)
+        {
+          T const projection = tiny::inner_prod( DT(d), p );
+
+          BOOST_CHECK( node.m_volume(d).lower() <= projection );
+          BOOST_CHECK( node.m_volume(d).upper() >= projection );
+        }
+      }
+    }
+  }
+
+  for(size_t t = 0u; t < M; ++t)
+    BOOST_CHECK_EQUAL( counts[t], 1u );
 }
 
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,8 @@
 #include <boost/test/floating_point_comparison.hpp>
 #include <boost/test/test_tools.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 BOOST_AUTO_TEST_SUITE(kdop);
@@ -136,5 +138,108 @@ BOOST_AUTO_TEST_CASE(kdop_mesh_reorder_capsule)
   
 }
 
+BOOST_AUTO_TEST_CASE(kdop_mesh_reorder_morton_codes)
+{
+  // Spreading bits must match interleaving them one at a time
+  for(unsigned long long x = 0ull; x < (1ull << 21); x += 4099ull)
+  {
+    unsigned long long expected = 0ull;
+
+    for(size_t k = 0u; k < 21u; ++k)
+      expected |= ((x >> k) & 1ull) << (3u * k);
+
+    BOOST_CHECK_EQUAL( kdop::details::spread_morton_bits(x), expected );
+  }
+
+  // The radix sort must give the same order as a stable comparison sort,
+  // also when codes span several blocks and there are many duplicates
+  size_t const M = 3u*kdop::details::morton_block_size + 17u;
+
+  std::vector<kdop::details::MortonCode> codes(M);
+
+  std::srand(42u);
+
+  for(size_t i = 0u; i < M; ++i)
+  {
+    unsigned long long const high = static_cast<unsigned long long>( std::rand() % 1000 );
+    unsigned long long const low  = static_cast<unsigned long long>( std::rand() );
+
+    codes[i].m_code = ( (high << 40) | low ) & 0x7fffffffffffffffull;
+    codes[i].m_tet  = i;
+  }
+
+  std::vector<kdop::details::MortonCode> expected = codes;
+
+  std::stable_sort(
+                   expected.begin()
+                   , expected.end()
+                   , [] (kdop::details::MortonCode const & a, kdop::details::MortonCode const & b) { return a.m_code < b.m_code; }
+                   );
+
+  util::ThreadPool pool(4u);
+
+  kdop::details::sort_morton_codes(codes, pool);
+
+  for(size_t i = 0u; i < M; ++i)
+  {
+    BOOST_CHECK_EQUAL( codes[i].m_code, expected[i].m_code );
+    BOOST_CHECK_EQUAL( codes[i].m_tet,  expected[i].m_tet  );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(kdop_mesh_reorder_parallel)
+{
+  typedef tiny::MathTypes<float> MT;
+  typedef MT::real_type          T;
+
+  mesh_array::T3Mesh surf;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_sphere<MT>(1.0f, 12u, 12u, surf, sX, sY, sZ);
+
+  mesh_array::T4Mesh mesh_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Xin;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Yin;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Zin;
+  mesh_array::tetgen(surf, sX, sY, sZ, mesh_in, Xin, Yin, Zin);
+
+  mesh_array::T4Mesh serial;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Xs;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Ys;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Zs;
+
+  kdop::mesh_reorder( mesh_in, Xin, Yin, Zin, serial, Xs, Ys, Zs );
+
+  mesh_array::T4Mesh parallel;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Xp;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Yp;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Zp;
+
+  util::ThreadPool pool(4u);
+
+  kdop::mesh_reorder( mesh_in, Xin, Yin, Zin, parallel, Xp, Yp, Zp, pool );
+
+  BOOST_REQUIRE_EQUAL( serial.vertex_size(),      mesh_in.vertex_size()      );
+  BOOST_REQUIRE_EQUAL( serial.tetrahedron_size(), mesh_in.tetrahedron_size() );
+  BOOST_REQUIRE_EQUAL( parallel.vertex_size(),      serial.vertex_size()      );
+  BOOST_REQUIRE_EQUAL( parallel.tetrahedron_size(), serial.tetrahedron_size() );
+
+  for(size_t t = 0u; t < serial.tetrahedron_size(); ++t)
+  {
+    BOOST_CHECK_EQUAL( serial.tetrahedron(t).i(), parallel.tetrahedron(t).i() );
+    BOOST_CHECK_EQUAL( serial.tetrahedron(t).j(), parallel.tetrahedron(t).j() );
+    BOOST_CHECK_EQUAL( serial.tetrahedron(t).k(), parallel.tetrahedron(t).k() );
+    BOOST_CHECK_EQUAL( serial.tetrahedron(t).m(), parallel.tetrahedron(t).m() );
+  }
+
+  for(size_t v = 0u; v < serial.vertex_size(); ++v)
+  {
+    BOOST_CHECK_EQUAL( Xs[v], Xp[v] );
+    BOOST_CHECK_EQUAL( Ys[v], Yp[v] );
+    BOOST_CHECK_EQUAL( Zs[v], Zp[v] );
+  }
+}
 
 BOOST_AUTO_TEST_SUITE_END();
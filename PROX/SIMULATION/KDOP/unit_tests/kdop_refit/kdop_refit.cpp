@@ -4,6 +4,8 @@
 #include <mesh_array.h>
 #include <tiny.h>
 
+#include <util_thread_pool.h>
+
 #define BOOST_AUTO_TEST_MAIN
 #include <boost/test/auto_unit_test.hpp>
 #include <boost/test/unit_test_suite.hpp>
@@ -48,4 +50,87 @@ BOOST_AUTO_TEST_CASE(kdop_refit)
   kdop::refit_tree<V,8,T>(tree, mesh_out, X_out, Y_out, Z_out );
 }
 
+BOOST_AUTO_TEST_CASE(kdop_refit_branches)
+{
+  typedef tiny::MathTypes<float> MT;
+  typedef MT::vector3_type       V;
+  typedef MT::real_type          T;
+
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<MT>( 1.0f, 1.0f, 2.0f, surface, sX, sY, sZ);
+
+  mesh_array::T4Mesh mesh_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z_in;
+  mesh_array::tetgen(surface, sX, sY, sZ, mesh_in, X_in, Y_in, Z_in);
+
+  mesh_array::T4Mesh mesh;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z;
+  kdop::mesh_reorder( mesh_in, X_in, Y_in, Z_in, mesh, X, Y, Z );
+
+  // Use a small chunk size to get several branches and levels
+  kdop::Tree<T,8> serial = kdop::make_tree<V,8,T>( 512, mesh, X, Y, Z );
+
+  BOOST_CHECK( serial.branches().size() > 1u );
+
+  for(size_t v = 0u; v < mesh.vertex_size(); ++v)
+  {
+    mesh_array::Vertex const & vertex = mesh.vertex(v);
+
+    X(vertex) += 1.0f;
+    Y(vertex) *= 2.0f;
+  }
+
+  kdop::Tree<T,8> parallel = serial;
+
+  kdop::refit_tree<V,8,T>(serial, mesh, X, Y, Z );
+
+  geometry::DirectionTable<V,4> const DT = geometry::DirectionTableHelper<V,4>::make();
+
+  util::ThreadPool pool(4u);
+
+  pool.parallel_for(
+                    parallel.branches().size()
+                    , [&] (size_t const & c, size_t const & /*thread_idx*/)
+                    {
+                      kdop::refit_branch<V,8,T>(parallel, c, mesh, X, Y, Z, DT);
+                    }
+                    );
+
+  kdop::refit_super_chunks<V,8,T>(parallel);
+
+  for(size_t d = 0u; d < 4u; ++d)
+  {
+    BOOST_CHECK_EQUAL( serial.m_root(d).lower(), parallel.m_root(d).lower() );
+    BOOST_CHECK_EQUAL( serial.m_root(d).upper(), parallel.m_root(d).upper() );
+  }
+
+  for(size_t c = 0u; c < serial.branches().size(); ++c)
+  {
+    kdop::SubTree<T,8> const & A = serial.branches()[c];
+    kdop::SubTree<T,8> const & B = parallel.branches()[c];
+
+    BOOST_CHECK_EQUAL( A.m_nodes.size(), B.m_nodes.size() );
+
+    for(size_t n = 0u; n < A.m_nodes.size() && n < B.m_nodes.size(); ++n)
+    {
+      if( A.m_nodes[n].is_undefined() )
+        continue;
+
+      for(size_t d = 0u; d < 4u; ++d)
+      {
+        BOOST_CHECK_EQUAL( A.m_nodes[n].m_volume(d).lower(), B.m_nodes[n].m_volume(d).lower() );
+        BOOST_CHECK_EQUAL( A.m_nodes[n].m_volume(d).upper(), B.m_nodes[n].m_volume(d).upper() );
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,333 @@
+#include <kdop.h>
+#include <mesh_array.h>
+#include <geometry.h>
+#include <tiny.h>
+
+#include <util_thread_pool.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+typedef tiny::MathTypes<float> MT;
+typedef MT::vector3_type       V;
+typedef MT::real_type          T;
+typedef MT::value_traits       VT;
+
+
+class GeometryInfo
+{
+public:
+
+  kdop::Tree<T,8>                                   m_tree;
+  mesh_array::T4Mesh                                m_mesh;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_X;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Y;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Z;
+  mesh_array::VertexAttribute<V,mesh_array::T4Mesh> m_S;
+
+  mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> m_surface_map;
+
+};
+
+
+class Contact
+{
+public:
+
+  V m_p;
+  V m_n;
+  T m_d;
+
+public:
+
+  bool operator<(Contact const & c) const
+  {
+    if( this->m_p(0) != c.m_p(0) ) return this->m_p(0) < c.m_p(0);
+    if( this->m_p(1) != c.m_p(1) ) return this->m_p(1) < c.m_p(1);
+    if( this->m_p(2) != c.m_p(2) ) return this->m_p(2) < c.m_p(2);
+    return this->m_d < c.m_d;
+  }
+
+};
+
+
+class Callback
+: public geometry::ContactsCallback<V>
+{
+public:
+
+  std::vector<Contact> m_contacts;
+
+  void operator()( V const & p, V const & n, T const & d, V const & /*Sa*/, V const & /*Sb*/)
+  {
+    Contact c;
+    c.m_p = p;
+    c.m_n = n;
+    c.m_d = d;
+    this->m_contacts.push_back(c);
+  }
+
+};
+
+
+void make_geometry( T const & offset, GeometryInfo & info, size_t const & mem_bytes = 32000 )
+{
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<MT>( 2.0f, 2.0f, 2.0f, surface, sX, sY, sZ);
+
+  mesh_array::T4Mesh mesh_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z_in;
+
+  mesh_array::tetgen(surface, sX, sY, sZ, mesh_in, X_in, Y_in, Z_in);
+
+  kdop::mesh_reorder( mesh_in, X_in, Y_in, Z_in, info.m_mesh, info.m_X, info.m_Y, info.m_Z );
+
+  info.m_S.bind(info.m_mesh);
+
+  for(size_t v = 0u; v < info.m_mesh.vertex_size(); ++v)
+  {
+    mesh_array::Vertex const & vertex = info.m_mesh.vertex(v);
+
+    info.m_X(vertex) += offset;
+    info.m_S(vertex)  = V::zero();
+  }
+
+  mesh_array::compute_surface_map( info.m_mesh, info.m_X, info.m_Y, info.m_Z, info.m_surface_map );
+
+  info.m_tree = kdop::make_tree<V,8,T>( mem_bytes, info.m_mesh, info.m_X, info.m_Y, info.m_Z );
+}
+
+
+kdop::TestPair<V,8,T> make_pair(GeometryInfo const & A, GeometryInfo const & B, Callback & callback)
+{
+  return kdop::TestPair<V,8,T>(
+                               A.m_tree
+                               , B.m_tree
+                               , A.m_mesh
+                               , B.m_mesh
+                               , A.m_X
+                               , B.m_X
+                               , A.m_Y
+                               , B.m_Y
+                               , A.m_Z
+                               , B.m_Z
+                               , A.m_surface_map
+                               , B.m_surface_map
+                               , A.m_S
+                               , B.m_S
+                               , callback
+                               );
+}
+
+
+BOOST_AUTO_TEST_SUITE(kdop);
+
+BOOST_AUTO_TEST_CASE(thread_pool_test)
+{
+  util::ThreadPool pool(4u);
+
+  BOOST_CHECK_EQUAL( pool.size(), 4u );
+
+  size_t const N = 1000u;
+
+  std::vector<size_t> counts(N, 0u);
+
+  pool.parallel_for( N, [&counts] (size_t const & i, size_t const & /*thread_idx*/) { ++counts[i]; } );
+
+  for(size_t i = 0u; i < N; ++i)
+    BOOST_CHECK_EQUAL( counts[i], 1u );
+
+  pool.resize(2u);
+
+  BOOST_CHECK_EQUAL( pool.size(), 2u );
+
+  pool.parallel_for( N, [&counts] (size_t const & i, size_t const & /*thread_idx*/) { ++counts[i]; } );
+
+  for(size_t i = 0u; i < N; ++i)
+    BOOST_CHECK_EQUAL( counts[i], 2u );
+}
+
+BOOST_AUTO_TEST_CASE(parallel_tandem_traversal_test)
+{
+  // A row of boxes where each box slightly overlaps its neighbours
+  size_t const N = 6u;
+
+  std::vector<GeometryInfo> objects(N);
+
+  for(size_t i = 0u; i < N; ++i)
+    make_geometry( 1.9f*i, objects[i] );
+
+  std::vector<Callback> serial_callbacks(N-1u);
+  std::vector<Callback> parallel_callbacks(N-1u);
+
+  std::vector< kdop::TestPair<V,8,T> > serial_pairs;
+  std::vector< kdop::TestPair<V,8,T> > parallel_pairs;
+
+  for(size_t i = 0u; i < (N-1u); ++i)
+  {
+    serial_pairs.push_back(   make_pair( objects[i], objects[i+1u], serial_callbacks[i]   ) );
+    parallel_pairs.push_back( make_pair( objects[i], objects[i+1u], parallel_callbacks[i] ) );
+  }
+
+  kdop::tandem_traversal<V,8,T>( serial_pairs );
+
+  util::ThreadPool pool(4u);
+
+  kdop::tandem_traversal<V,8,T>( parallel_pairs, pool );
+
+  for(size_t i = 0u; i < (N-1u); ++i)
+  {
+    std::vector<Contact> const & serial   = serial_callbacks[i].m_contacts;
+    std::vector<Contact> const & parallel = parallel_callbacks[i].m_contacts;
+
+    BOOST_CHECK( !serial.empty() );
+    BOOST_CHECK_EQUAL( serial.size(), parallel.size() );
+
+    for(size_t k = 0u; k < serial.size() && k < parallel.size(); ++k)
+    {
+      BOOST_CHECK_EQUAL( serial[k].m_p(0), parallel[k].m_p(0) );
+      BOOST_CHECK_EQUAL( serial[k].m_p(1), parallel[k].m_p(1) );
+      BOOST_CHECK_EQUAL( serial[k].m_p(2), parallel[k].m_p(2) );
+      BOOST_CHECK_EQUAL( serial[k].m_n(0), parallel[k].m_n(0) );
+      BOOST_CHECK_EQUAL( serial[k].m_n(1), parallel[k].m_n(1) );
+      BOOST_CHECK_EQUAL( serial[k].m_n(2), parallel[k].m_n(2) );
+      BOOST_CHECK_EQUAL( serial[k].m_d,    parallel[k].m_d    );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(rigid_tandem_traversal_test)
+{
+  // Two boxes in their body frames
+  GeometryInfo body_A;
+  GeometryInfo body_B;
+
+  make_geometry( 0.0f, body_A );
+  make_geometry( 0.0f, body_B );
+
+  // Place B slightly rotated and penetrating the top of A
+  T const c = std::cos(0.3f);
+  T const s = std::sin(0.3f);
+
+  kdop::RigidTransform<V> const transform_A(
+                                            V::make( 1.0f, 0.0f, 0.0f )
+                                            , V::make( 0.0f, 1.0f, 0.0f )
+                                            , V::make( 0.0f, 0.0f, 1.0f )
+                                            , V::make( 0.5f, 0.0f, 0.0f )
+                                            );
+  kdop::RigidTransform<V> const transform_B(
+                                            V::make(  c,   s,    0.0f )
+                                            , V::make( -s,   c,    0.0f )
+                                            , V::make( 0.0f, 0.0f, 1.0f )
+                                            , V::make( 0.6f, 2.1f, 0.2f )
+                                            );
+
+  // World space copies with refitted trees
+  GeometryInfo world_A = body_A;
+  GeometryInfo world_B = body_B;
+
+  for(size_t v = 0u; v < body_A.m_mesh.vertex_size(); ++v)
+  {
+    mesh_array::Vertex const & vertex = body_A.m_mesh.vertex(v);
+
+    V const a = transform_A( V::make( body_A.m_X(vertex), body_A.m_Y(vertex), body_A.m_Z(vertex) ) );
+    V const b = transform_B( V::make( body_B.m_X(vertex), body_B.m_Y(vertex), body_B.m_Z(vertex) ) );
+
+    world_A.m_X(vertex) = a(0);
+    world_A.m_Y(vertex) = a(1);
+    world_A.m_Z(vertex) = a(2);
+
+    world_B.m_X(vertex) = b(0);
+    world_B.m_Y(vertex) = b(1);
+    world_B.m_Z(vertex) = b(2);
+  }
+
+  kdop::refit_tree<V,8,T>( world_A.m_tree, world_A.m_mesh, world_A.m_X, world_A.m_Y, world_A.m_Z );
+  kdop::refit_tree<V,8,T>( world_B.m_tree, world_B.m_mesh, world_B.m_X, world_B.m_Y, world_B.m_Z );
+
+  Callback world_callback;
+  Callback rigid_callback;
+
+  kdop::TestPair<V,8,T> world_pair = make_pair( world_A, world_B, world_callback );
+  kdop::TestPair<V,8,T> rigid_pair = make_pair( body_A,  body_B,  rigid_callback );
+
+  rigid_pair.set_rigid_transforms( transform_A, transform_B );
+
+  kdop::tandem_traversal<V,8,T>( world_pair, false );
+  kdop::tandem_traversal<V,8,T>( rigid_pair, false );
+
+  std::vector<Contact> const & world = world_callback.m_contacts;
+  std::vector<Contact> const & rigid = rigid_callback.m_contacts;
+
+  BOOST_CHECK( !world.empty() );
+  BOOST_CHECK_EQUAL( world.size(), rigid.size() );
+
+  for(size_t k = 0u; k < world.size() && k < rigid.size(); ++k)
+  {
+    BOOST_CHECK_EQUAL( world[k].m_p(0), rigid[k].m_p(0) );
+    BOOST_CHECK_EQUAL( world[k].m_p(1), rigid[k].m_p(1) );
+    BOOST_CHECK_EQUAL( world[k].m_p(2), rigid[k].m_p(2) );
+    BOOST_CHECK_EQUAL( world[k].m_d,    rigid[k].m_d    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(chunked_tandem_traversal_test)
+{
+  // Deep super chunk hierarchies must find the same contacts as a single
+  // contiguous tree, only the order of the leaf pairs may differ
+  GeometryInfo single_A;
+  GeometryInfo single_B;
+  GeometryInfo chunked_A;
+  GeometryInfo chunked_B;
+
+  make_geometry( 0.0f, single_A,  0u   );
+  make_geometry( 1.9f, single_B,  0u   );
+  make_geometry( 0.0f, chunked_A, 200u );
+  make_geometry( 1.9f, chunked_B, 800u );
+
+  BOOST_CHECK_EQUAL( single_A.m_tree.number_of_levels(), 1u );
+  BOOST_CHECK( chunked_A.m_tree.number_of_levels() > 1u );
+  BOOST_CHECK( chunked_B.m_tree.branches().size() > 1u );
+  BOOST_CHECK( chunked_A.m_tree.number_of_levels() != chunked_B.m_tree.number_of_levels() );
+
+  Callback single_callback;
+  Callback chunked_callback;
+
+  kdop::TestPair<V,8,T> single_pair  = make_pair( single_A,  single_B,  single_callback  );
+  kdop::TestPair<V,8,T> chunked_pair = make_pair( chunked_A, chunked_B, chunked_callback );
+
+  kdop::tandem_traversal<V,8,T>( single_pair,  false );
+  kdop::tandem_traversal<V,8,T>( chunked_pair, false );
+
+  std::vector<Contact> single  = single_callback.m_contacts;
+  std::vector<Contact> chunked = chunked_callback.m_contacts;
+
+  BOOST_CHECK( !single.empty() );
+  BOOST_CHECK_EQUAL( single.size(), chunked.size() );
+
+  std::sort( single.begin(),  single.end()  );
+  std::sort( chunked.begin(), chunked.end() );
+
+  for(size_t k = 0u; k < single.size() && k < chunked.size(); ++k)
+  {
+    BOOST_CHECK_EQUAL( single[k].m_p(0), chunked[k].m_p(0) );
+    BOOST_CHECK_EQUAL( single[k].m_p(1), chunked[k].m_p(1) );
+    BOOST_CHECK_EQUAL( single[k].m_p(2), chunked[k].m_p(2) );
+    BOOST_CHECK_EQUAL( single[k].m_d,    chunked[k].m_d    );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
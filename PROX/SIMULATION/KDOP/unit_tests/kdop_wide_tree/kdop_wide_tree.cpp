@@ -0,0 +1,348 @@
+#include <kdop.h>
+#include <mesh_array.h>
+#include <geometry.h>
+#include <tiny.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+typedef tiny::MathTypes<float> MT;
+typedef MT::vector3_type       V;
+typedef MT::real_type          T;
+typedef MT::value_traits       VT;
+
+
+class GeometryInfo
+{
+public:
+
+  kdop::Tree<T,8>                                   m_tree;
+  mesh_array::T4Mesh                                m_mesh;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_X;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Y;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Z;
+  mesh_array::VertexAttribute<V,mesh_array::T4Mesh> m_S;
+
+  mesh_array::TetrahedronAttribute<mesh_array::TetrahedronSurfaceInfo,mesh_array::T4Mesh> m_surface_map;
+
+};
+
+
+class Contact
+{
+public:
+
+  V m_p;
+  V m_n;
+  T m_d;
+
+public:
+
+  bool operator<(Contact const & c) const
+  {
+    if( this->m_p(0) != c.m_p(0) ) return this->m_p(0) < c.m_p(0);
+    if( this->m_p(1) != c.m_p(1) ) return this->m_p(1) < c.m_p(1);
+    if( this->m_p(2) != c.m_p(2) ) return this->m_p(2) < c.m_p(2);
+    return this->m_d < c.m_d;
+  }
+
+};
+
+
+class Callback
+: public geometry::ContactsCallback<V>
+{
+public:
+
+  std::vector<Contact> m_contacts;
+
+  void operator()( V const & p, V const & n, T const & d, V const & /*Sa*/, V const & /*Sb*/)
+  {
+    Contact c;
+    c.m_p = p;
+    c.m_n = n;
+    c.m_d = d;
+    this->m_contacts.push_back(c);
+  }
+
+};
+
+
+void make_geometry( T const & offset, GeometryInfo & info )
+{
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<T,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<MT>( 2.0f, 2.0f, 2.0f, surface, sX, sY, sZ);
+
+  mesh_array::T4Mesh mesh_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> X_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Y_in;
+  mesh_array::VertexAttribute<T,mesh_array::T4Mesh> Z_in;
+
+  mesh_array::tetgen(surface, sX, sY, sZ, mesh_in, X_in, Y_in, Z_in);
+
+  kdop::mesh_reorder( mesh_in, X_in, Y_in, Z_in, info.m_mesh, info.m_X, info.m_Y, info.m_Z );
+
+  info.m_S.bind(info.m_mesh);
+
+  for(size_t v = 0u; v < info.m_mesh.vertex_size(); ++v)
+  {
+    mesh_array::Vertex const & vertex = info.m_mesh.vertex(v);
+
+    info.m_X(vertex) += offset;
+    info.m_S(vertex)  = V::zero();
+  }
+
+  mesh_array::compute_surface_map( info.m_mesh, info.m_X, info.m_Y, info.m_Z, info.m_surface_map );
+
+  info.m_tree = kdop::make_tree<V,8,T>( 2000, info.m_mesh, info.m_X, info.m_Y, info.m_Z );
+}
+
+
+kdop::TestPair<V,8,T> make_pair(GeometryInfo const & A, GeometryInfo const & B, Callback & callback)
+{
+  return kdop::TestPair<V,8,T>(
+                               A.m_tree
+                               , B.m_tree
+                               , A.m_mesh
+                               , B.m_mesh
+                               , A.m_X
+                               , B.m_X
+                               , A.m_Y
+                               , B.m_Y
+                               , A.m_Z
+                               , B.m_Z
+                               , A.m_surface_map
+                               , B.m_surface_map
+                               , A.m_S
+                               , B.m_S
+                               , callback
+                               );
+}
+
+
+// Wide and binary traversals find the leaf pairs in different orders, so
+// the contacts are compared as sets
+void check_same_contacts( std::vector<Contact> binary, std::vector<Contact> wide )
+{
+  BOOST_CHECK( !binary.empty() );
+  BOOST_CHECK_EQUAL( binary.size(), wide.size() );
+
+  std::sort( binary.begin(), binary.end() );
+  std::sort( wide.begin(), wide.end() );
+
+  for(size_t k = 0u; k < binary.size() && k < wide.size(); ++k)
+  {
+    BOOST_CHECK_EQUAL( binary[k].m_p(0), wide[k].m_p(0) );
+    BOOST_CHECK_EQUAL( binary[k].m_p(1), wide[k].m_p(1) );
+    BOOST_CHECK_EQUAL( binary[k].m_p(2), wide[k].m_p(2) );
+    BOOST_CHECK_EQUAL( binary[k].m_d,    wide[k].m_d    );
+  }
+}
+
+
+template<size_t W>
+void check_overlap_children()
+{
+  T const lower[4] = { -1.0f, 0.5f, 2.0f, -3.0f };
+
+  kdop::WideNode<T,8,W> node;
+
+  std::vector< geometry::DOP<T,8> > children(W);
+
+  for(size_t c = 0u; c < W; ++c)
+  {
+    for(size_t k = 0u; k < 4u; ++k)
+    {
+      children[c](k).lower() = lower[k] + 0.75f*c;
+      children[c](k).upper() = lower[k] + 0.75f*c + 1.0f;
+
+      node.m_lower[k][c] = children[c](k).lower();
+      node.m_upper[k][c] = children[c](k).upper();
+    }
+  }
+
+  for(size_t trial = 0u; trial < 100u; ++trial)
+  {
+    geometry::DOP<T,8> A;
+
+    for(size_t k = 0u; k < 4u; ++k)
+    {
+      T const center = lower[k] + ( 8.0f*std::rand() ) / RAND_MAX - 2.0f;
+
+      A(k).lower() = center - 0.5f;
+      A(k).upper() = center + 0.5f;
+    }
+
+    unsigned int const mask = kdop::details::overlap_children( A, node );
+
+    for(size_t c = 0u; c < W; ++c)
+      BOOST_CHECK_EQUAL( (mask >> c) & 1u, geometry::overlap_dop_dop( A, children[c] ) ? 1u : 0u );
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE(kdop);
+
+BOOST_AUTO_TEST_CASE(overlap_children_test)
+{
+  check_overlap_children<4>();
+  check_overlap_children<8>();
+}
+
+BOOST_AUTO_TEST_CASE(make_wide_tree_test)
+{
+  GeometryInfo info;
+
+  make_geometry( 0.0f, info );
+
+  kdop::make_wide_tree( info.m_tree );
+
+  BOOST_CHECK( info.m_tree.has_wide_branches() );
+  BOOST_CHECK_EQUAL( info.m_tree.m_wide_branches.size(), info.m_tree.branches().size() );
+
+  // Every tetrahedron must be a leaf of exactly one wide node and every
+  // child volume must be the volume of its binary node
+  std::vector<size_t> counts( info.m_mesh.tetrahedron_size(), 0u );
+
+  for(size_t b = 0u; b < info.m_tree.branches().size(); ++b)
+  {
+    kdop::SubTree<T,8>         const & branch = info.m_tree.branches()[b];
+    kdop::WideSubTree<T,8,4>   const & wide   = info.m_tree.m_wide_branches[b];
+
+    if( branch.m_nodes[0].is_leaf() )
+    {
+      ++counts[ branch.m_nodes[0].m_start ];
+      continue;
+    }
+
+    for(size_t i = 0u; i < wide.m_nodes.size(); ++i)
+    {
+      kdop::WideNode<T,8,4> const & node = wide.m_nodes[i];
+
+      BOOST_CHECK( node.m_count >= 2u );
+      BOOST_CHECK( node.m_count <= 4u );
+
+      for(size_t c = 0u; c < node.m_count; ++c)
+      {
+        if( node.m_leaf[c] )
+          ++counts[ node.m_child[c] ];
+        else
+          BOOST_CHECK( node.m_child[c] < wide.m_nodes.size() );
+
+        for(size_t k = 0u; k < 4u; ++k)
+        {
+          BOOST_CHECK_EQUAL( node.m_lower[k][c], branch.m_nodes[ node.m_source[c] ].m_volume(k).lower() );
+          BOOST_CHECK_EQUAL( node.m_upper[k][c], branch.m_nodes[ node.m_source[c] ].m_volume(k).upper() );
+        }
+      }
+    }
+  }
+
+  for(size_t t = 0u; t < counts.size(); ++t)
+    BOOST_CHECK_EQUAL( counts[t], 1u );
+}
+
+BOOST_AUTO_TEST_CASE(wide_tandem_traversal_test)
+{
+  GeometryInfo binary_A;
+  GeometryInfo binary_B;
+
+  make_geometry( 0.0f, binary_A );
+  make_geometry( 1.9f, binary_B );
+
+  GeometryInfo wide_A = binary_A;
+  GeometryInfo wide_B = binary_B;
+
+  kdop::make_wide_tree( wide_A.m_tree );
+  kdop::make_wide_tree( wide_B.m_tree );
+
+  Callback binary_callback;
+  Callback wide_callback;
+
+  kdop::TestPair<V,8,T> binary_pair = make_pair( binary_A, binary_B, binary_callback );
+  kdop::TestPair<V,8,T> wide_pair   = make_pair( wide_A,   wide_B,   wide_callback   );
+
+  kdop::tandem_traversal<V,8,T>( binary_pair, false );
+  kdop::tandem_traversal<V,8,T>( wide_pair,   false );
+
+  check_same_contacts( binary_callback.m_contacts, wide_callback.m_contacts );
+
+  // Refitting the binary tree must also refit the wide layout
+  for(size_t v = 0u; v < wide_B.m_mesh.vertex_size(); ++v)
+  {
+    mesh_array::Vertex const & vertex = wide_B.m_mesh.vertex(v);
+
+    binary_B.m_Y(vertex) += 0.3f;
+    wide_B.m_Y(vertex)   += 0.3f;
+  }
+
+  kdop::refit_tree<V,8,T>( binary_B.m_tree, binary_B.m_mesh, binary_B.m_X, binary_B.m_Y, binary_B.m_Z );
+  kdop::refit_tree<V,8,T>( wide_B.m_tree,   wide_B.m_mesh,   wide_B.m_X,   wide_B.m_Y,   wide_B.m_Z   );
+
+  binary_callback.m_contacts.clear();
+  wide_callback.m_contacts.clear();
+
+  kdop::tandem_traversal<V,8,T>( binary_pair, false );
+  kdop::tandem_traversal<V,8,T>( wide_pair,   false );
+
+  check_same_contacts( binary_callback.m_contacts, wide_callback.m_contacts );
+}
+
+BOOST_AUTO_TEST_CASE(rigid_wide_tandem_traversal_test)
+{
+  GeometryInfo body_A;
+  GeometryInfo body_B;
+
+  make_geometry( 0.0f, body_A );
+  make_geometry( 0.0f, body_B );
+
+  T const c = std::cos(0.3f);
+  T const s = std::sin(0.3f);
+
+  kdop::RigidTransform<V> const transform_A(
+                                            V::make( 1.0f, 0.0f, 0.0f )
+                                            , V::make( 0.0f, 1.0f, 0.0f )
+                                            , V::make( 0.0f, 0.0f, 1.0f )
+                                            , V::make( 0.5f, 0.0f, 0.0f )
+                                            );
+  kdop::RigidTransform<V> const transform_B(
+                                            V::make(  c,   s,    0.0f )
+                                            , V::make( -s,   c,    0.0f )
+                                            , V::make( 0.0f, 0.0f, 1.0f )
+                                            , V::make( 0.6f, 2.1f, 0.2f )
+                                            );
+
+  GeometryInfo wide_A = body_A;
+  GeometryInfo wide_B = body_B;
+
+  kdop::make_wide_tree( wide_A.m_tree );
+  kdop::make_wide_tree( wide_B.m_tree );
+
+  Callback binary_callback;
+  Callback wide_callback;
+
+  kdop::TestPair<V,8,T> binary_pair = make_pair( body_A, body_B, binary_callback );
+  kdop::TestPair<V,8,T> wide_pair   = make_pair( wide_A, wide_B, wide_callback   );
+
+  binary_pair.set_rigid_transforms( transform_A, transform_B );
+  wide_pair.set_rigid_transforms( transform_A, transform_B );
+
+  kdop::tandem_traversal<V,8,T>( binary_pair, false );
+  kdop::tandem_traversal<V,8,T>( wide_pair,   false );
+
+  check_same_contacts( binary_callback.m_contacts, wide_callback.m_contacts );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
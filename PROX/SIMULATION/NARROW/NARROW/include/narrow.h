@@ -2,6 +2,7 @@
 #define NARROW_H
 
 #include <narrow_test_pair.h>
+#include <narrow_analytic_contacts.h>
 #include <narrow_dispatch.h>
 #include <narrow_geometry.h>
 #include <narrow_object.h>
@@ -0,0 +1,218 @@
+#ifndef NARROW_ANALYTIC_CONTACTS_H
+#define NARROW_ANALYTIC_CONTACTS_H
+
+#include "narrow_geometry.h"
+#include "narrow_object.h"
+#include "narrow_system.h"
+#include "narrow_test_pair.h"
+
+#include <geometry.h>
+
+#include <tiny_quaternion_functions.h>
+#include <tiny_vector_functions.h>
+
+#include <cassert>
+#include <vector>
+
+namespace narrow
+{
+
+  namespace detail
+  {
+
+    /**
+     * Contact callback adapter for the closed form contact routines. The
+     * closed form routines know nothing about structure directions, so the
+     * structure directions of the two objects are added here before the
+     * contact is passed on. If the routine was invoked with the shapes of A
+     * and B swapped then the normal is flipped to point from A towards B
+     * again.
+     */
+    template< typename M>
+    class AnalyticCallback
+    : public geometry::ContactsCallback<typename M::vector3_type>
+    {
+    public:
+
+      typedef typename M::real_type       T;
+      typedef typename M::vector3_type    V;
+
+    protected:
+
+      TestPair<M>       & m_pair;
+      V                   m_Sa;     ///< Structure direction of A.
+      V                   m_Sb;     ///< Structure direction of B.
+      bool                m_flip;
+
+    public:
+
+      AnalyticCallback(
+                       TestPair<M> & pair
+                       , Geometry<M> const & geo_a
+                       , Geometry<M> const & geo_b
+                       , bool const & flip
+                       )
+      : m_pair(pair)
+      , m_Sa( geo_a.get_structure_direction( pair.obj_a().get_structure_map_idx() ) )
+      , m_Sb( geo_b.get_structure_direction( pair.obj_b().get_structure_map_idx() ) )
+      , m_flip(flip)
+      {}
+
+      void operator()( V const & p, V const & n, T const & d, V const & /*Sa*/, V const & /*Sb*/)
+      {
+        this->m_pair.callback()( p, this->m_flip ? V( -n ) : n, d, this->m_Sa, this->m_Sb );
+      }
+    };
+
+    template< typename M>
+    inline geometry::Sphere<typename M::vector3_type> make_analytic_sphere(
+                                                                           Geometry<M> const & geometry
+                                                                           , typename M::vector3_type const & t
+                                                                           , typename M::quaternion_type const & /*q*/
+                                                                           )
+    {
+      return geometry::make_sphere( t, geometry.get_analytic_size()(0) );
+    }
+
+    template< typename M>
+    inline geometry::OBB<M> make_analytic_box(
+                                              Geometry<M> const & geometry
+                                              , typename M::vector3_type const & t
+                                              , typename M::quaternion_type const & q
+                                              )
+    {
+      return geometry::make_obb<M>( t, q, geometry.get_analytic_size() );
+    }
+
+    template< typename M>
+    inline geometry::Capsule<typename M::vector3_type> make_analytic_capsule(
+                                                                             Geometry<M> const & geometry
+                                                                             , typename M::vector3_type const & t
+                                                                             , typename M::quaternion_type const & q
+                                                                             )
+    {
+      typedef typename M::vector3_type  V;
+      typedef typename M::value_traits  VT;
+
+      V const & size = geometry.get_analytic_size();
+      V const   axis = tiny::rotate( q, V::make( VT::zero(), size(1), VT::zero() ) );
+
+      return geometry::make_capsule( size(0), V( t - axis ), V( t + axis ) );
+    }
+
+    /**
+     * Test if a pair of geometries can be handled by the closed form
+     * contact routines. Every combination of spheres, boxes and capsules
+     * is supported.
+     */
+    template< typename M>
+    inline bool is_analytic_pair( Geometry<M> const & geo_a, Geometry<M> const & geo_b )
+    {
+      return geo_a.has_analytic_shape() && geo_b.has_analytic_shape();
+    }
+
+    /**
+     * Generate contacts for a pair of geometries with closed form shape
+     * descriptions. The pairs are ordered so that the closed form routine
+     * exists, i.e. sphere before capsule before box, and the normals are
+     * flipped back when the order had to be swapped.
+     */
+    template< typename M>
+    inline void analytic_contacts( System<M> const & system, TestPair<M> & pair )
+    {
+      typedef typename M::vector3_type     V;
+      typedef typename M::quaternion_type  Q;
+      typedef typename M::real_type        T;
+
+      Geometry<M> const & geo_a = system.get_geometry( pair.obj_a().get_geometry_idx() );
+      Geometry<M> const & geo_b = system.get_geometry( pair.obj_b().get_geometry_idx() );
+
+      assert( is_analytic_pair( geo_a, geo_b ) || !"analytic_contacts(): geometries have no closed form description");
+
+      bool const flip = geo_b.get_analytic_type() < geo_a.get_analytic_type();
+
+      Geometry<M> const & first  = flip ? geo_b : geo_a;
+      Geometry<M> const & second = flip ? geo_a : geo_b;
+      V           const & t1     = flip ? pair.t_b() : pair.t_a();
+      Q           const & q1     = flip ? pair.Q_b() : pair.Q_a();
+      V           const & t2     = flip ? pair.t_a() : pair.t_b();
+      Q           const & q2     = flip ? pair.Q_a() : pair.Q_b();
+
+      T const & envelope = system.params().get_envelope();
+
+      AnalyticCallback<M> callback( pair, geo_a, geo_b, flip );
+
+      // The closed form routines generate a few contacts from the shapes
+      // as a whole, so they share a single pair of features.
+      pair.callback().set_features( 0u, 0u );
+
+      switch( first.get_analytic_type() )
+      {
+        case analytic_sphere:
+        {
+          geometry::Sphere<V> const A = make_analytic_sphere( first, t1, q1 );
+
+          if( second.get_analytic_type() == analytic_sphere )
+            geometry::contacts_sphere_sphere( A, make_analytic_sphere( second, t2, q2 ), envelope, callback );
+          else if( second.get_analytic_type() == analytic_box )
+            geometry::contacts_sphere_obb( A, make_analytic_box( second, t2, q2 ), envelope, callback );
+          else
+            geometry::contacts_sphere_capsule( A, make_analytic_capsule( second, t2, q2 ), envelope, callback );
+          break;
+        }
+        case analytic_box:
+        {
+          // A box can only come first if the other shape is a box too
+          geometry::contacts_obb_obb( make_analytic_box( first, t1, q1 ), make_analytic_box( second, t2, q2 ), envelope, callback );
+          break;
+        }
+        case analytic_capsule:
+        {
+          geometry::Capsule<V> const A = make_analytic_capsule( first, t1, q1 );
+
+          if( second.get_analytic_type() == analytic_capsule )
+            geometry::contacts_capsule_capsule( A, make_analytic_capsule( second, t2, q2 ), envelope, callback );
+          else
+            geometry::contacts_capsule_obb( A, make_analytic_box( second, t2, q2 ), envelope, callback );
+          break;
+        }
+        default:
+          assert( false || !"analytic_contacts(): unknown shape type");
+      }
+    }
+
+    /**
+     * Split the test pairs into those that are handled by closed form
+     * contact generation and those that must traverse the volume meshes.
+     */
+    template< typename M>
+    inline void split_analytic_pairs(
+                                     System<M> const & system
+                                     , std::vector< TestPair<M> > & test_pairs
+                                     , std::vector< TestPair<M> > & analytic_pairs
+                                     , std::vector< TestPair<M> > & mesh_pairs
+                                     )
+    {
+      typedef typename std::vector<TestPair<M> >::iterator pair_iterator;
+
+      analytic_pairs.clear();
+      mesh_pairs.clear();
+
+      for(pair_iterator current = test_pairs.begin(); current != test_pairs.end(); ++current)
+      {
+        Geometry<M> const & geo_a = system.get_geometry( current->obj_a().get_geometry_idx() );
+        Geometry<M> const & geo_b = system.get_geometry( current->obj_b().get_geometry_idx() );
+
+        if( is_analytic_pair( geo_a, geo_b ) )
+          analytic_pairs.push_back( *current );
+        else
+          mesh_pairs.push_back( *current );
+      }
+    }
+
+  }// namespace detail
+
+} //namespace narrow
+
+// NARROW_ANALYTIC_CONTACTS_H
+#endif
@@ -1,14 +1,126 @@
 #ifndef NARROW_DISPATCH_H
 #define NARROW_DISPATCH_H
 
+#include "narrow_analytic_contacts.h"
 #include "narrow_object.h"
 #include "narrow_geometry.h"
 
 #include <kdop_tandem_traversal.h>
+#include <kdop_rigid_transform.h>
+
+#include <tiny_quaternion_functions.h>
+
+#include <util_thread_pool.h>
+#include <util_profiling.h>
+
+#include <cassert>
 
 namespace narrow
 {
 
+  namespace detail
+  {
+
+    /**
+     * Convert a body position and orientation into the body frame to
+     * world transform used by the kDOP traversal.
+     */
+    template< typename M>
+    inline kdop::RigidTransform<typename M::vector3_type> make_rigid_transform(
+                                                                                typename M::vector3_type const & t
+                                                                                , typename M::quaternion_type const & q
+                                                                                )
+    {
+      typedef typename M::vector3_type  V;
+      typedef typename M::value_traits  VT;
+
+      V const col0 = tiny::rotate( q, V::make( VT::one(),  VT::zero(), VT::zero() ) );
+      V const col1 = tiny::rotate( q, V::make( VT::zero(), VT::one(),  VT::zero() ) );
+      V const col2 = tiny::rotate( q, V::make( VT::zero(), VT::zero(), VT::one()  ) );
+
+      return kdop::RigidTransform<V>( col0, col1, col2, t );
+    }
+
+    template< typename M>
+    inline void make_kdop_test_pairs(
+                                     System<M> const & system
+                                     , std::vector< TestPair<M> > & test_pairs
+                                     , std::vector< kdop::TestPair<typename M::vector3_type, 8, typename M::real_type> > & kdop_test_pairs
+                                     )
+    {
+      typedef typename M::vector3_type                     V;
+      typedef typename M::real_type                        T;
+      typedef typename std::vector<TestPair<M> >::iterator pair_iterator;
+      typedef typename kdop::TestPair<V, 8, T>             kdop_pair_type;
+      typedef mesh_array::VertexAttribute<T,mesh_array::T4Mesh> coordinate_type;
+
+      pair_iterator current = test_pairs.begin();
+      pair_iterator end     = test_pairs.end();
+
+      kdop_test_pairs.clear();
+      kdop_test_pairs.reserve( test_pairs.size() );
+
+      bool const rigid = system.params().get_rigid_traversal();
+
+      for(;current!=end;++current)
+      {
+        Object<M> const & objA = current->obj_a();
+        Object<M> const & objB = current->obj_b();
+
+        Geometry<M> const & geoA = system.get_geometry( objA.get_geometry_idx() );
+        Geometry<M> const & geoB = system.get_geometry( objB.get_geometry_idx() );
+
+        // When traversing in body frames the undeformed (material)
+        // coordinates are used, otherwise the deformed (spatial) ones.
+        coordinate_type const & XA = rigid ? geoA.m_X0 : objA.m_X;
+        coordinate_type const & YA = rigid ? geoA.m_Y0 : objA.m_Y;
+        coordinate_type const & ZA = rigid ? geoA.m_Z0 : objA.m_Z;
+        coordinate_type const & XB = rigid ? geoB.m_X0 : objB.m_X;
+        coordinate_type const & YB = rigid ? geoB.m_Y0 : objB.m_Y;
+        coordinate_type const & ZB = rigid ? geoB.m_Z0 : objB.m_Z;
+
+        kdop_pair_type test_pair = kdop_pair_type(
+                                                  get_kdop_bvh( objA, geoA )
+                                                  , get_kdop_bvh( objB, geoB )
+                                                  , geoA.m_mesh
+                                                  , geoB.m_mesh
+                                                  , XA
+                                                  , XB
+                                                  , YA
+                                                  , YB
+                                                  , ZA
+                                                  , ZB
+                                                  , geoA.m_surface_map
+                                                  , geoB.m_surface_map
+                                                  , get_structure_map( objA, geoA )
+                                                  , get_structure_map( objB, geoB )
+                                                  , current->callback()
+                                                  );
+
+        if(rigid)
+        {
+          assert( objA.m_body_frame_tree || !"make_kdop_test_pairs(): tree of A is not in body frame");
+          assert( objB.m_body_frame_tree || !"make_kdop_test_pairs(): tree of B is not in body frame");
+
+          test_pair.set_rigid_transforms(
+                                         make_rigid_transform<M>( current->t_a(), current->Q_a() )
+                                         , make_rigid_transform<M>( current->t_b(), current->Q_b() )
+                                         );
+        }
+
+        kdop_test_pairs.push_back( test_pair );
+      }
+    }
+
+  }// namespace detail
+
+  /**
+   * Dispatch of test pairs.
+   * Callbacks write their contacts as they are invoked, so the test pairs
+   * are processed one by one in the given order, also when analytic and
+   * mesh pairs are mixed. The contacts then come out in the same order as
+   * when the per test pair buffers of the parallel dispatch are appended.
+   */
   template< typename M>
   inline void dispatch( System<M> const & system, std::vector< TestPair<M> > & test_pairs )
   {
@@ -17,44 +129,110 @@ namespace narrow
 
     typedef typename M::vector3_type                     V;
     typedef typename M::real_type                        T;
-    typedef typename std::vector<TestPair<M> >::iterator pair_iterator;
     typedef typename kdop::TestPair<V, 8, T>             kdop_pair_type;
 
-    pair_iterator current = test_pairs.begin();
-    pair_iterator end     = test_pairs.end();
+    std::vector< kdop_pair_type > kdop_test_pairs;
+
+    if( ! system.params().get_analytic_shapes() )
+    {
+      detail::make_kdop_test_pairs( system, test_pairs, kdop_test_pairs );
+
+      kdop::tandem_traversal<V, 8, T>( kdop_test_pairs );
+
+      return;
+    }
+
+    std::vector< TestPair<M> > analytic_pairs;
+    std::vector< TestPair<M> > mesh_pairs;
+
+    detail::split_analytic_pairs( system, test_pairs, analytic_pairs, mesh_pairs );
+
+    detail::make_kdop_test_pairs( system, mesh_pairs, kdop_test_pairs );
+
+    START_TIMER("analytic_contacts_time");
+    PAUSE_TIMER("analytic_contacts_time");
+    START_TIMER("kdop_tandem_traversal_time");
+    START_TIMER("contact_point_generation_time");
+    PAUSE_TIMER("contact_point_generation_time");
+    PAUSE_TIMER("kdop_tandem_traversal_time");
+
+    size_t m = 0u;
+
+    for(size_t i = 0u; i < test_pairs.size(); ++i)
+    {
+      Geometry<M> const & geo_a = system.get_geometry( test_pairs[i].obj_a().get_geometry_idx() );
+      Geometry<M> const & geo_b = system.get_geometry( test_pairs[i].obj_b().get_geometry_idx() );
+
+      if( detail::is_analytic_pair( geo_a, geo_b ) )
+      {
+        RESUME_TIMER("analytic_contacts_time");
+        detail::analytic_contacts( system, test_pairs[i] );
+        PAUSE_TIMER("analytic_contacts_time");
+      }
+      else
+      {
+        RESUME_TIMER("kdop_tandem_traversal_time");
+        kdop::tandem_traversal<V, 8, T>( kdop_test_pairs[m++] );
+        PAUSE_TIMER("kdop_tandem_traversal_time");
+      }
+    }
+
+    assert( m == kdop_test_pairs.size() || !"dispatch(): not all mesh pairs were traversed");
+
+    RESUME_TIMER("kdop_tandem_traversal_time");
+    RESUME_TIMER("contact_point_generation_time");
+    STOP_TIMER("contact_point_generation_time");
+    STOP_TIMER("kdop_tandem_traversal_time");
+    RESUME_TIMER("analytic_contacts_time");
+    STOP_TIMER("analytic_contacts_time");
+  }
+
+  /**
+   * Parallel dispatch of test pairs.
+   * The test pairs are processed concurrently by the threads in the given
+   * pool. The callback of each test pair is only ever invoked from the
+   * thread processing that test pair, hence callbacks must not be shared
+   * between test pairs. Giving each test pair its own contact buffer and
+   * appending the buffers in test pair order afterwards yields the same
+   * contacts in the same order as the serial dispatch.
+   */
+  template< typename M>
+  inline void dispatch( System<M> const & system, std::vector< TestPair<M> > & test_pairs, util::ThreadPool & pool )
+  {
+    if (test_pairs.empty())
+      return;
+
+    typedef typename M::vector3_type                     V;
+    typedef typename M::real_type                        T;
+    typedef typename kdop::TestPair<V, 8, T>             kdop_pair_type;
 
     std::vector< kdop_pair_type > kdop_test_pairs;
 
-    for(;current!=end;++current)
+    if( system.params().get_analytic_shapes() )
+    {
+      std::vector< TestPair<M> > analytic_pairs;
+      std::vector< TestPair<M> > mesh_pairs;
+
+      detail::split_analytic_pairs( system, test_pairs, analytic_pairs, mesh_pairs );
+
+      START_TIMER("analytic_contacts_time");
+      pool.parallel_for(
+                        analytic_pairs.size()
+                        , [&] (size_t const & i, size_t const & /*thread_idx*/)
+                        {
+                          detail::analytic_contacts( system, analytic_pairs[i] );
+                        }
+                        );
+      STOP_TIMER("analytic_contacts_time");
+
+      detail::make_kdop_test_pairs( system, mesh_pairs, kdop_test_pairs );
+    }
+    else
     {
-      Object<M> const & objA = current->obj_a();
-      Object<M> const & objB = current->obj_b();
-
-      Geometry<M> const & geoA = system.get_geometry( objA.get_geometry_idx() );
-      Geometry<M> const & geoB = system.get_geometry( objB.get_geometry_idx() );
-
-      kdop_pair_type const test_pair = kdop_pair_type(
-                                                      objA.m_tree
-                                                      , objB.m_tree
-                                                      , geoA.m_mesh
-                                                      , geoB.m_mesh
-                                                      , objA.m_X
-                                                      , objB.m_X
-                                                      , objA.m_Y
-                                                      , objB.m_Y
-                                                      , objA.m_Z
-                                                      , objB.m_Z
-                                                      , geoA.m_surface_map
-                                                      , geoB.m_surface_map
-                                                      , objA.m_structure_map
-                                                      , objB.m_structure_map
-                                                      , current->callback()
-                                                      );
-
-      kdop_test_pairs.push_back( test_pair );
+      detail::make_kdop_test_pairs( system, test_pairs, kdop_test_pairs );
     }
 
-    kdop::tandem_traversal<V, 8, T>( kdop_test_pairs );
+    kdop::tandem_traversal<V, 8, T>( kdop_test_pairs, pool );
   }
 
 } //namespace narrow
@@ -8,11 +8,28 @@
 #include <tiny_quaternion_functions.h>
 #include <tiny_coordsys_functions.h>
 
+#include <util_thread_pool.h>
+
 #include <vector>
 #include <algorithm>
+#include <cassert>
 
 namespace narrow
 {
+
+  /**
+   * Analytic Shape Types.
+   * Geometries made from primitives remember their closed form description,
+   * so the narrow phase can generate contacts with closed form routines
+   * instead of traversing the volume meshes. Pairs of shapes are ordered
+   * by this type when picking a closed form routine.
+   */
+  typedef enum {
+      no_analytic_shape
+    , analytic_sphere      ///< Sphere centered at the origin.
+    , analytic_capsule     ///< Capsule centered at the origin with its core segment along the y-axis.
+    , analytic_box         ///< Box centered at the origin and aligned with the axes.
+  } analytic_shape_type;
   
   /**
    * Narrow Phase Geometry Type.
@@ -47,6 +64,15 @@ namespace narrow
 
     T                       m_static_radius;
 
+    analytic_shape_type     m_analytic_type;   ///< The type of closed form shape description, if any.
+    V                       m_analytic_size;   ///< Sphere: radius in first coordinate. Box: half extents. Capsule: radius and half height of the core segment.
+
+    kdop::Tree<T,8>         m_tree;            ///< kDOP BVH fitted to the undeformed (material) coordinates, shared by all objects using this geometry.
+
+    std::vector< mesh_array::VertexAttribute<V,mesh_array::T4Mesh> > m_structure_maps;        ///< The distinct structure maps of objects using this geometry.
+    std::vector< V >                                                 m_structure_directions;  ///< One structure direction per structure map, used by the closed form contact routines.
+    mesh_array::VertexAttribute<V,mesh_array::T4Mesh>                m_no_structure_map;      ///< Empty structure map used by objects without one.
+
   public:
 
     Geometry()
@@ -56,6 +82,12 @@ namespace narrow
     , m_Z0()
     , m_surface_map()
     , m_static_radius( VT::zero() )
+    , m_analytic_type( no_analytic_shape )
+    , m_analytic_size( V::zero() )
+    , m_tree()
+    , m_structure_maps()
+    , m_structure_directions()
+    , m_no_structure_map()
     {
     }
 
@@ -71,6 +103,11 @@ namespace narrow
         this->m_Z0            = geo.m_Z0;
         this->m_surface_map   = geo.m_surface_map;
         this->m_static_radius = geo.m_static_radius;
+        this->m_analytic_type = geo.m_analytic_type;
+        this->m_analytic_size = geo.m_analytic_size;
+        this->m_tree          = geo.m_tree;
+        this->m_structure_maps = geo.m_structure_maps;
+        this->m_structure_directions = geo.m_structure_directions;
       }
       return *this;
     }
@@ -82,6 +119,11 @@ namespace narrow
 
   public:
 
+    /**
+     * Set the volume mesh of the geometry. This drops the body frame tree
+     * and the structure maps, objects already using the geometry hold
+     * indices into these and must be bound again with rebind_object.
+     */
     void set_shape(
                    mesh_array::T4Mesh const & mesh
                    , mesh_array::VertexAttribute<T,mesh_array::T4Mesh> const & X
@@ -102,6 +144,7 @@ namespace narrow
                          , m_X0
                          , m_Y0
                          , m_Z0
+                         , util::ThreadPool::get_instance()
                          );
 
       mesh_array::compute_surface_map( m_mesh
@@ -113,6 +156,14 @@ namespace narrow
 
       m_static_radius = VT::zero();
 
+      // A new volume mesh invalidates any previous closed form description,
+      // tree and structure maps
+      m_analytic_type = no_analytic_shape;
+      m_analytic_size = V::zero();
+      m_tree.clear();
+      m_structure_maps.clear();
+      m_structure_directions.clear();
+
       size_t const N = m_mesh.vertex_size();
 
       V min_coord = V(VT::highest());
@@ -132,11 +183,143 @@ namespace narrow
     }
 
 
+    /**
+     * Set the closed form description of the shape. This must be called
+     * after set_shape, the volume mesh is still needed for any pairs that
+     * have no closed form contact routine.
+     */
+    void set_analytic_sphere( T const & radius )
+    {
+      assert( radius > VT::zero() || !"set_analytic_sphere(): radius must be positive");
+
+      this->m_analytic_type = analytic_sphere;
+      this->m_analytic_size = V::make( radius, VT::zero(), VT::zero() );
+    }
+
+    void set_analytic_box( V const & half_extents )
+    {
+      assert( half_extents(0) > VT::zero() || !"set_analytic_box(): half extents must be positive");
+      assert( half_extents(1) > VT::zero() || !"set_analytic_box(): half extents must be positive");
+      assert( half_extents(2) > VT::zero() || !"set_analytic_box(): half extents must be positive");
+
+      this->m_analytic_type = analytic_box;
+      this->m_analytic_size = half_extents;
+    }
+
+    void set_analytic_capsule( T const & radius, T const & half_height )
+    {
+      assert( radius > VT::zero()          || !"set_analytic_capsule(): radius must be positive");
+      assert( half_height >= VT::zero()    || !"set_analytic_capsule(): half height must be non-negative");
+
+      this->m_analytic_type = analytic_capsule;
+      this->m_analytic_size = V::make( radius, half_height, VT::zero() );
+    }
+
+    /**
+     * Add a structure map to the geometry. Objects sharing a geometry
+     * usually share their structure map as well, so an identical map that
+     * was added before is reused.
+     *
+     * @param structure_map   The structure map, must be bound to the volume mesh of this geometry.
+     *
+     * @return                The index of the structure map.
+     */
+    size_t add_structure_map( mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & structure_map )
+    {
+      size_t const N = this->m_mesh.vertex_size();
+
+      for(size_t idx = 0u; idx < this->m_structure_maps.size(); ++idx)
+      {
+        mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & other = this->m_structure_maps[idx];
+
+        bool equal = other.size() == structure_map.size();
+
+        for(size_t n = 0u; equal && n < N; ++n)
+        {
+          mesh_array::Vertex const & v = this->m_mesh.vertex(n);
+
+          V const & a = other(v);
+          V const & b = structure_map(v);
+
+          equal = a(0) == b(0) && a(1) == b(1) && a(2) == b(2);
+        }
+
+        if( equal )
+          return idx;
+      }
+
+      // The closed form contact routines have no mesh vertices to look up
+      // the map in, they use the direction of the vertex closest to the
+      // center of the shape. This is exact for the constant structure maps
+      // that primitives are given in practice.
+      T      best_distance = VT::highest();
+      V      direction     = V::zero();
+
+      for(size_t n = 0u; n < N; ++n)
+      {
+        mesh_array::Vertex const & v = this->m_mesh.vertex(n);
+
+        V const r = V::make( this->m_X0(v), this->m_Y0(v), this->m_Z0(v) );
+        T const d = tiny::inner_prod( r, r );
+
+        if( d < best_distance )
+        {
+          best_distance = d;
+          direction     = structure_map(v);
+        }
+      }
+
+      this->m_structure_maps.push_back( structure_map );
+      this->m_structure_directions.push_back( direction );
+
+      return this->m_structure_maps.size() - 1u;
+    }
+
+    /**
+     * Get a structure map of the geometry. An index that does not refer to
+     * a structure map gives an empty map.
+     */
+    mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & get_structure_map( size_t const & idx ) const
+    {
+      if( idx < this->m_structure_maps.size() )
+        return this->m_structure_maps[idx];
+
+      return this->m_no_structure_map;
+    }
+
+    /**
+     * Get the structure direction used with the closed form shape
+     * description. An index that does not refer to a structure map gives
+     * the zero vector.
+     */
+    V get_structure_direction( size_t const & idx ) const
+    {
+      if( idx < this->m_structure_directions.size() )
+        return this->m_structure_directions[idx];
+
+      return V::zero();
+    }
+
     bool has_shape() const
     {
       return ((m_mesh.vertex_size() > 0u) && (m_mesh.tetrahedron_size() > 0u));
     }
 
+    bool has_analytic_shape() const
+    {
+      return this->m_analytic_type != no_analytic_shape;
+    }
+
+    analytic_shape_type const & get_analytic_type() const
+    {
+      return this->m_analytic_type;
+    }
+
+    V const & get_analytic_size() const
+    {
+      return this->m_analytic_size;
+    }
+
     void clear()
     {
       m_X0.release();
@@ -144,8 +327,14 @@ namespace narrow
       m_Z0.release();
       m_surface_map.release();
 
+      m_tree.clear();
+      m_structure_maps.clear();
+      m_structure_directions.clear();
+
       m_mesh.clear();
       m_static_radius = VT::zero();
+      m_analytic_type = no_analytic_shape;
+      m_analytic_size = V::zero();
     }
 
     T const & get_static_radius() const
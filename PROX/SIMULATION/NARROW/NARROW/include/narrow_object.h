@@ -5,10 +5,13 @@
 #include <narrow_params.h>
 
 #include <kdop_make_tree.h>
+#include <kdop_wide_tree.h>
 #include <kdop_tree.h>
 
 #include <mesh_array.h>
 
+#include <util_thread_pool.h>
+
 #include <limits>
 
 namespace narrow
@@ -34,20 +37,25 @@ namespace narrow
   public:
 
     template<typename MP>
-    friend void make_kdop_bvh(Params<MP> const & params, Object<MP> & object, Geometry<MP> const & geometry);
+    friend void make_kdop_bvh(Params<MP> const & params, Object<MP> & object, Geometry<MP> & geometry);
 
-    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_X;      ///< Deformed (spatial) x-coordinate
-    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Y;      ///< Deformed (spatial) y-coordinate
-    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Z;      ///< Deformed (spatial) z-coordinate
-    mesh_array::VertexAttribute<V,mesh_array::T4Mesh> m_structure_map; ///< More complicated solution for friction using a mesh array
+    // The undeformed shape, its kDOP BVH and the structure maps are stored
+    // once in the geometry and shared by all objects using it. An object only
+    // keeps a world space copy of the coordinates and tree when they are
+    // refitted in world space.
+    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_X;      ///< Deformed (spatial) x-coordinate, empty unless refitted in world space
+    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Y;      ///< Deformed (spatial) y-coordinate, empty unless refitted in world space
+    mesh_array::VertexAttribute<T,mesh_array::T4Mesh> m_Z;      ///< Deformed (spatial) z-coordinate, empty unless refitted in world space
 
-    kdop::Tree<T,8> m_tree;                                     ///< kDOP BVH tree used for collision detection of deformed (spatial) mesh
+    kdop::Tree<T,8> m_tree;                                     ///< kDOP BVH tree of the deformed (spatial) mesh, empty unless refitted in world space
+    bool            m_body_frame_tree;                          ///< If true then the body frame tree of the geometry is used rather than m_tree.
 
     T m_dynamic_radius;                                         ///< The current updated radius for the current deformed shape.
 
   protected:
     
-    size_t           m_geometry_idx;  ///< A geometry index.
+    size_t           m_geometry_idx;       ///< A geometry index.
+    size_t           m_structure_map_idx;  ///< Index of the structure map in the geometry.
 
   public:
 
@@ -61,9 +69,27 @@ namespace narrow
       return this->m_geometry_idx;
     }
 
-    void set_structure_map(mesh_array::VertexAttribute<V,mesh_array::T4Mesh> & structure_map)
+    void set_structure_map_idx( size_t const & idx )
+    {
+      this->m_structure_map_idx = idx;
+    }
+
+    size_t const & get_structure_map_idx() const
+    {
+      return this->m_structure_map_idx;
+    }
+
+    bool has_world_space_tree() const
     {
-        this->m_structure_map = structure_map;
+      return this->m_X.size() > 0u;
+    }
+
+    void release_world_space_tree()
+    {
+      this->m_X.release();
+      this->m_Y.release();
+      this->m_Z.release();
+      this->m_tree.clear();
     }
 
     T const & get_dynamic_radius() const
@@ -85,8 +111,10 @@ namespace narrow
     , m_Y()
     , m_Z()
     , m_tree()
+    , m_body_frame_tree(false)
     , m_dynamic_radius( VT::zero() )
     , m_geometry_idx( 0u )
+    , m_structure_map_idx( std::numeric_limits<size_t>::max() )
     {}
 
     ~ Object(){}
@@ -104,8 +132,9 @@ namespace narrow
         this->m_Y                   = obj.m_Y;
         this->m_Z                   = obj.m_Z;
         this->m_tree                = obj.m_tree;
+        this->m_body_frame_tree     = obj.m_body_frame_tree;
         this->m_geometry_idx        = obj.m_geometry_idx;
-        this->m_structure_map       = obj.m_structure_map;
+        this->m_structure_map_idx   = obj.m_structure_map_idx;
         this->m_dynamic_radius      = obj.m_dynamic_radius;
       }
       return *this;
@@ -113,31 +142,102 @@ namespace narrow
 
   };
 
+  /**
+   * Build the body frame kDOP BVH of a geometry. The tree is only built
+   * once and is then shared by all objects using the geometry.
+   */
   template<typename M>
-  inline void make_kdop_bvh(Params<M> const & params, Object<M> & object, Geometry<M> const & geometry)
+  inline void make_kdop_bvh(Params<M> const & params, Geometry<M> & geometry)
   {
     typedef typename M::real_type                         T;
     typedef typename M::vector3_type                      V;
 
-    if( geometry.has_shape() )
+    if( ! geometry.has_shape() )
+      return;
+
+    if( geometry.m_tree.number_of_levels() == 0u )
     {
       size_t mem_bytes = params.get_chunk_bytes();
 
-      object.m_tree = kdop::make_tree<V,8,T>(
-                                             mem_bytes
-                                             , geometry.m_mesh
-                                             , geometry.m_X0
-                                             , geometry.m_Y0
-                                             , geometry.m_Z0
-                                             );
+      geometry.m_tree = kdop::make_tree<V,8,T>(
+                                               mem_bytes
+                                               , geometry.m_mesh
+                                               , geometry.m_X0
+                                               , geometry.m_Y0
+                                               , geometry.m_Z0
+                                               , util::ThreadPool::get_instance()
+                                               );
+    }
+
+    if( params.get_wide_traversal() && ! geometry.m_tree.has_wide_branches() )
+      kdop::make_wide_tree( geometry.m_tree );
+  }
+
+  template<typename M>
+  inline void make_kdop_bvh(Params<M> const & params, Object<M> & object, Geometry<M> & geometry)
+  {
+    if( geometry.has_shape() )
+    {
+      make_kdop_bvh( params, geometry );
 
-      object.m_X.bind(geometry.m_mesh);
-      object.m_Y.bind(geometry.m_mesh);
-      object.m_Z.bind(geometry.m_mesh);
+      object.release_world_space_tree();
 
-      object.m_dynamic_radius = geometry.m_static_radius;
+      object.m_body_frame_tree = true;
+      object.m_dynamic_radius  = geometry.m_static_radius;
     }
   }
+
+  /**
+   * Bind an object to a geometry that was given a new shape. The world
+   * space tree and the structure map index of the object refer to the old
+   * shape, so the object is moved onto the new body frame tree and is left
+   * without a structure map.
+   */
+  template<typename M>
+  inline void rebind_object(Params<M> const & params, Object<M> & object, Geometry<M> & geometry)
+  {
+    make_kdop_bvh( params, object, geometry );
+
+    object.set_structure_map_idx( std::numeric_limits<size_t>::max() );
+  }
+
+  /**
+   * Allocate the world space coordinates and tree of an object. The tree
+   * is a copy of the body frame tree of the geometry so only a refit is
+   * needed to bring it into world space.
+   */
+  template<typename M>
+  inline void make_world_space_kdop_bvh(Object<M> & object, Geometry<M> const & geometry)
+  {
+    if( object.has_world_space_tree() )
+      return;
+
+    object.m_X.bind(geometry.m_mesh);
+    object.m_Y.bind(geometry.m_mesh);
+    object.m_Z.bind(geometry.m_mesh);
+
+    object.m_tree = geometry.m_tree;
+  }
+
+  /**
+   * Get the kDOP BVH that should be traversed for an object, this is either
+   * the shared body frame tree of the geometry or the world space tree of
+   * the object.
+   */
+  template<typename M>
+  inline kdop::Tree<typename M::real_type,8> const & get_kdop_bvh(Object<M> const & object, Geometry<M> const & geometry)
+  {
+    return object.m_body_frame_tree ? geometry.m_tree : object.m_tree;
+  }
+
+  /**
+   * Get the structure map of an object.
+   */
+  template<typename M>
+  inline mesh_array::VertexAttribute<typename M::vector3_type,mesh_array::T4Mesh> const & get_structure_map(Object<M> const & object, Geometry<M> const & geometry)
+  {
+    return geometry.get_structure_map( object.get_structure_map_idx() );
+  }
   
 } //namespace narrow
 
@@ -15,23 +15,35 @@ namespace narrow
     
     T      m_envelope;              ///< Procentage of scale of smallest object size to be used as collision envelope
     size_t m_chunk_bytes;
+    bool   m_rigid_traversal;       ///< If true then kDOP trees are kept in body frames and traversed using the body transforms, instead of being refitted in world space every step.
+    bool   m_wide_traversal;        ///< If true then kDOP trees get a wide layout that is tested one node against all children of the other tree at a time.
+    bool   m_analytic_shapes;       ///< If true then pairs of geometries with closed form shape descriptions use closed form contact generation instead of kDOP traversal.
 
   public:
     
     T      const & get_envelope()      const { return this->m_envelope;           }
     size_t const & get_chunk_bytes()   const { return this->m_chunk_bytes;        }
+    bool   const & get_rigid_traversal() const { return this->m_rigid_traversal;  }
+    bool   const & get_wide_traversal()  const { return this->m_wide_traversal;   }
+    bool   const & get_analytic_shapes() const { return this->m_analytic_shapes;  }
 
 
   public:      
     
     void set_envelope(T const & value)              { this->m_envelope       = value;   }
     void set_chunk_bytes(size_t const & value)      { this->m_chunk_bytes    = value;   }
+    void set_rigid_traversal(bool const & value)    { this->m_rigid_traversal = value;  }
+    void set_wide_traversal(bool const & value)     { this->m_wide_traversal  = value;  }
+    void set_analytic_shapes(bool const & value)    { this->m_analytic_shapes = value;  }
 
   public:
     
     Params()
     : m_envelope(VT::numeric_cast(0.01))
     , m_chunk_bytes(8000)
+    , m_rigid_traversal(false)
+    , m_wide_traversal(false)
+    , m_analytic_shapes(false)
     {}
   };
   
@@ -11,10 +11,12 @@
 #include <tiny_quaternion_functions.h>
 
 #include <util_profiling.h>
+#include <util_thread_pool.h>
 
 #include <cassert>
 #include <vector>
 #include <cmath>  // needed for std::max
+#include <algorithm>  // needed for std::min
 
 namespace narrow
 {
@@ -151,6 +153,8 @@ namespace narrow
       if( N <= 0u)
         continue;
 
+      make_world_space_kdop_bvh( object, geometry );
+
       // 2018-12-27 Kenny code review: If this was a deformable body then X, Y
       // and Z's would have been updated by the solver, and should not be
       // updated here.
@@ -177,10 +181,231 @@ namespace narrow
                               , geometry.m_mesh
                               , object.m_X, object.m_Y, object.m_Z
                               );
+
+      object.m_body_frame_tree = false;
     }
     
     STOP_TIMER("narrow_update_kdop_bvh_time");
   }
+
+  /**
+   * Rigid kDOP BVH update.
+   * When trees are traversed in body frames nothing needs to be done per
+   * vertex. All objects simply use the shared body frame tree of their
+   * geometry, and the dynamic radius is bounded by the distance of the
+   * body origin plus the static radius.
+   */
+  template<typename M>
+  inline void update_rigid_kdop_bvh(  std::vector< UpdateWorkItem< M > > & work_pool )
+  {
+    typedef typename std::vector< UpdateWorkItem< M > >::iterator work_item_iterator;
+
+    work_item_iterator current = work_pool.begin();
+    work_item_iterator end     = work_pool.end();
+
+    START_TIMER("narrow_update_kdop_bvh_time");
+
+    for (; current != end; ++current)
+    {
+      Object<M>         & object   = current->object();
+      Geometry<M> const & geometry = current->geometry();
+
+      if( geometry.m_mesh.vertex_size() <= 0u)
+        continue;
+
+      object.m_body_frame_tree = true;
+
+      object.set_dynamic_radius( tiny::norm( current->p() ) + geometry.get_static_radius() );
+    }
+
+    STOP_TIMER("narrow_update_kdop_bvh_time");
+  }
+
+  namespace detail
+  {
+
+    /**
+     * A range of vertices of a single work item that should be transformed.
+     */
+    class VertexTask
+    {
+    public:
+
+      size_t m_item;    ///< Index of the work item.
+      size_t m_begin;   ///< Index of first vertex in range.
+      size_t m_end;     ///< Index of one past the last vertex in range.
+
+      VertexTask(size_t const & item, size_t const & begin, size_t const & end)
+      : m_item(item)
+      , m_begin(begin)
+      , m_end(end)
+      {}
+
+    };
+
+    /**
+     * A single kDOP tree branch of a work item that should be refitted.
+     */
+    class BranchTask
+    {
+    public:
+
+      size_t m_item;     ///< Index of the work item.
+      size_t m_branch;   ///< Index of the branch in the tree of the work item.
+
+      BranchTask(size_t const & item, size_t const & branch)
+      : m_item(item)
+      , m_branch(branch)
+      {}
+
+    };
+
+  }// namespace detail
+
+  /**
+   * Parallel kDOP BVH update.
+   * Work items are split into tasks that are processed by the threads of
+   * the given pool. To keep a single large mesh from occupying one thread
+   * for the whole update, vertices are transformed in ranges of at most
+   * vertex_chunk vertices and tree branches are refitted one at a time.
+   * Branches are already bounded in size by the chunk size used when the
+   * tree was built, so they balance well. Only the few levels above the
+   * branches are refitted per work item.
+   *
+   * @param work_pool      The work items to update.
+   * @param pool           The thread pool to use.
+   * @param vertex_chunk   The maximum number of vertices in a single transform task.
+   */
+  template<typename M>
+  inline void update_kdop_bvh(
+                              std::vector< UpdateWorkItem< M > > & work_pool
+                              , util::ThreadPool & pool
+                              , size_t const & vertex_chunk = 4096u
+                              )
+  {
+    using std::max;
+    using std::min;
+
+    typedef typename M::real_type                                      T;
+    typedef typename M::vector3_type                                   V;
+    typedef typename M::value_traits                                   VT;
+
+    assert( vertex_chunk > 0u || !"update_kdop_bvh(): vertex chunk must be positive");
+
+    if( pool.size() == 1u )
+    {
+      update_kdop_bvh( work_pool );
+      return;
+    }
+
+    START_TIMER("narrow_update_kdop_bvh_time");
+
+    size_t const I = work_pool.size();
+
+    std::vector< detail::VertexTask > vertex_tasks;
+    std::vector< detail::BranchTask > branch_tasks;
+
+    for(size_t i = 0u; i < I; ++i)
+    {
+      size_t const N = work_pool[i].geometry().m_mesh.vertex_size();
+
+      if( N <= 0u)
+        continue;
+
+      make_world_space_kdop_bvh( work_pool[i].object(), work_pool[i].geometry() );
+
+      for(size_t begin = 0u; begin < N; begin += vertex_chunk)
+        vertex_tasks.push_back( detail::VertexTask( i, begin, min( begin + vertex_chunk, N ) ) );
+
+      size_t const C = work_pool[i].object().m_tree.branches().size();
+
+      for(size_t c = 0u; c < C; ++c)
+        branch_tasks.push_back( detail::BranchTask( i, c ) );
+    }
+
+    //--- Transform vertices, each task reports the radius of its vertices -----
+    std::vector<T> radius( vertex_tasks.size(), VT::zero() );
+
+    pool.parallel_for(
+                      vertex_tasks.size()
+                      , [&] (size_t const & t, size_t const & /*thread_idx*/)
+                      {
+                        detail::VertexTask  const & task     = vertex_tasks[t];
+                        UpdateWorkItem<M>   const & item     = work_pool[task.m_item];
+                        Object<M>                 & object   = item.object();
+                        Geometry<M>         const & geometry = item.geometry();
+
+                        T max_radius = VT::zero();
+
+                        for(size_t n = task.m_begin; n < task.m_end; ++n)
+                        {
+                          mesh_array::Vertex const & v = geometry.m_mesh.vertex(n);
+
+                          V const r0 = V::make( geometry.m_X0(v), geometry.m_Y0(v), geometry.m_Z0(v) );
+
+                          V const r = tiny::rotate(item.q(), r0) + item.p();
+
+                          object.m_X(v) = r(0);
+                          object.m_Y(v) = r(1);
+                          object.m_Z(v) = r(2);
+
+                          max_radius = max( max_radius, tiny::norm(r) );
+                        }
+
+                        radius[t] = max_radius;
+                      }
+                      );
+
+    //--- Reduce radius of each work item, tasks of an item are consecutive ----
+    for(size_t t = 0u; t < vertex_tasks.size(); )
+    {
+      size_t const i     = vertex_tasks[t].m_item;
+      T            value = VT::zero();
+
+      for(; t < vertex_tasks.size() && vertex_tasks[t].m_item == i; ++t)
+        value = max( value, radius[t] );
+
+      work_pool[i].object().set_dynamic_radius(value);
+    }
+
+    //--- Refit all branches of all trees ---------------------------------------
+    geometry::DirectionTable<V,4> const DT = geometry::DirectionTableHelper<V,4>::make();
+
+    pool.parallel_for(
+                      branch_tasks.size()
+                      , [&] (size_t const & t, size_t const & /*thread_idx*/)
+                      {
+                        detail::BranchTask  const & task     = branch_tasks[t];
+                        UpdateWorkItem<M>   const & item     = work_pool[task.m_item];
+                        Object<M>                 & object   = item.object();
+                        Geometry<M>         const & geometry = item.geometry();
+
+                        kdop::refit_branch<V,8,T>(
+                                                  object.m_tree
+                                                  , task.m_branch
+                                                  , geometry.m_mesh
+                                                  , object.m_X, object.m_Y, object.m_Z
+                                                  , DT
+                                                  );
+                      }
+                      );
+
+    //--- Refit remaining levels of all trees -----------------------------------
+    pool.parallel_for(
+                      I
+                      , [&] (size_t const & i, size_t const & /*thread_idx*/)
+                      {
+                        if( work_pool[i].geometry().m_mesh.vertex_size() <= 0u )
+                          return;
+
+                        kdop::refit_super_chunks<V,8,T>( work_pool[i].object().m_tree );
+
+                        work_pool[i].object().m_body_frame_tree = false;
+                      }
+                      );
+
+    STOP_TIMER("narrow_update_kdop_bvh_time");
+  }
   
 } // namespace narrow
 
@@ -40,6 +40,7 @@ namespace procedural
     tetset.m_maximum_volume     = util::to_value<double>( params.get_value("tetgen_maximum_volume", "0.0")      );
     tetset.m_quiet_output       = util::to_value<bool>(   params.get_value("tetgen_quiet_output", "true")       );
     tetset.m_suppress_splitting = util::to_value<bool>(   params.get_value("tetgen_suppress_splitting", "true") );
+    tetset.m_cache_path         =                         params.get_value("tetgen_cache_path", "");
     
     procedural::MaterialInfo<T> mat_info = procedural::create_material_info<MT>(engine);
     
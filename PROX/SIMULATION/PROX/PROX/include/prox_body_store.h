@@ -0,0 +1,411 @@
+#ifndef PROX_BODY_STORE_H
+#define PROX_BODY_STORE_H
+
+#include <prox_rigid_body.h>
+
+#include <tiny_is_number.h>
+
+#include <cassert>
+#include <vector>
+
+namespace prox
+{
+
+  template< typename MT >
+  class ForceCallback;           // forward declaration
+
+  /**
+   * Body Store.
+   * The rigid body state that the time steppers work on, kept in structure
+   * of arrays form. Rigid bodies are big objects that also carry their
+   * collision geometry, so walking all of them for every vector and matrix
+   * the stepper needs drags a lot of cold memory through the caches.
+   *
+   * The store lives across time steps and is the owner of the velocities of
+   * the bodies that the stepper moves. The stepper works on the position and
+   * velocity vectors of the store directly, and the mass matrix and external
+   * forces are computed from the store alone. Bodies are only written to
+   * when collision detection needs their new placement, they never get
+   * their velocities back from the stepper. Use get_body_velocity to read
+   * them.
+   *
+   * Anything that changes a body outside the time stepper must call
+   * checkout_body first, which marks the body as changed. Only new and
+   * changed bodies are read by sync_body_store at the beginning of the next
+   * time step.
+   *
+   * The store also owns the force callbacks of the bodies. Few bodies have
+   * any, so they are kept out of both the bodies and the hot arrays.
+   */
+  template<typename M>
+  class BodyStore
+  {
+  public:
+
+    typedef typename M::real_type          T;
+    typedef typename M::matrix3x3_type     M3;
+    typedef typename M::quaternion_type    Q;
+    typedef typename M::vector6_type       V6;
+    typedef typename M::vector7_type       V7;
+    typedef ForceCallback<M>               force_callback;
+
+  public:
+
+    V7                   m_q;          ///< Positions and orientations, one block per body.
+    V6                   m_u;          ///< Linear and angular velocities, one block per body. Zero for fixed and sleeping bodies.
+    std::vector<Q>       m_Q;          ///< Orientations as stored in the bodies. Bodies normalize their orientation so these may differ slightly from the ones in m_q.
+    std::vector<T>       m_mass;       ///< Masses.
+    std::vector<M3>      m_I_BF;       ///< Inertia tensors wrt CM in BF.
+    std::vector<char>    m_active;     ///< Non-zero if the body is moved by the stepper, that is it is neither fixed, scripted nor sleeping.
+    std::vector<char>    m_changed;    ///< Non-zero if the body was changed outside the stepper since the last sync_body_store.
+    std::vector<size_t>  m_changes;    ///< Indices of the changed bodies.
+
+    std::vector< std::vector< force_callback * > >  m_force_callbacks;   ///< The force callbacks of each body.
+
+  public:
+
+    BodyStore()
+    : m_q()
+    , m_u()
+    , m_Q()
+    , m_mass()
+    , m_I_BF()
+    , m_active()
+    , m_changed()
+    , m_changes()
+    , m_force_callbacks()
+    {}
+
+  public:
+
+    void clear()
+    {
+      this->m_q.clear();
+      this->m_u.clear();
+      this->m_Q.clear();
+      this->m_mass.clear();
+      this->m_I_BF.clear();
+      this->m_active.clear();
+      this->m_changed.clear();
+      this->m_changes.clear();
+      this->m_force_callbacks.clear();
+    }
+
+    /**
+     * Make room for a new body. This must be called whenever a body is
+     * created, the state of the body is picked up by sync_body_store.
+     */
+    void add_body()
+    {
+      this->m_changed.push_back( 0 );
+      this->m_force_callbacks.push_back( std::vector< force_callback * >() );
+    }
+
+    /**
+     * Mark a body as changed outside the stepper, such that its state is
+     * read again by the next sync_body_store.
+     */
+    void set_changed(size_t const & idx)
+    {
+      assert( idx < this->m_changed.size() || !"set_changed(): no such body");
+
+      if( this->m_changed[idx] )
+        return;
+
+      this->m_changed[idx] = 1;
+      this->m_changes.push_back( idx );
+    }
+
+    size_t size() const { return this->m_mass.size(); }
+
+    bool is_active(size_t const & idx) const { return this->m_active[idx] != 0; }
+
+    /**
+     * Test if the store holds the velocities of a body. This is the case
+     * for bodies the stepper moves, unless they have been changed since
+     * the last sync_body_store.
+     */
+    bool has_velocity(size_t const & idx) const
+    {
+      return idx < this->size() && this->is_active(idx) && !this->m_changed[idx];
+    }
+
+    std::vector< force_callback * > const & get_force_callbacks(size_t const & idx) const { return this->m_force_callbacks[idx]; }
+    std::vector< force_callback * >       & get_force_callbacks(size_t const & idx)       { return this->m_force_callbacks[idx]; }
+
+  };
+
+  namespace detail
+  {
+
+    /**
+     * Read the state of a single body into the store.
+     */
+    template<typename MT>
+    inline void load_body( RigidBody<MT> const & body, size_t const & k, BodyStore<MT> & store )
+    {
+      typedef typename MT::vector3_type     V;
+      typedef typename MT::quaternion_type  Q;
+      typedef typename MT::block6x1_type    B6x1;
+      typedef typename MT::block7x1_type    B7x1;
+      typedef typename MT::value_traits     VT;
+
+      V const & r = body.get_position();
+      Q const & R = body.get_orientation();
+
+      assert(is_number(r(0))        || !"load_body(): non number encountered");
+      assert(is_number(r(1))        || !"load_body(): non number encountered");
+      assert(is_number(r(2))        || !"load_body(): non number encountered");
+      assert(is_number(R.real())    || !"load_body(): non number encountered");
+      assert(is_number(R.imag()(0)) || !"load_body(): non number encountered");
+      assert(is_number(R.imag()(1)) || !"load_body(): non number encountered");
+      assert(is_number(R.imag()(2)) || !"load_body(): non number encountered");
+
+      B7x1 & q = store.m_q( k );
+
+      q(0) = r(0);
+      q(1) = r(1);
+      q(2) = r(2);
+      q(3) = R.real();
+      q(4) = R.imag()(0);
+      q(5) = R.imag()(1);
+      q(6) = R.imag()(2);
+
+      B6x1 & u = store.m_u( k );
+
+      if( body.is_fixed() || body.is_sleeping() )
+      {
+        u(0) = VT::zero();
+        u(1) = VT::zero();
+        u(2) = VT::zero();
+        u(3) = VT::zero();
+        u(4) = VT::zero();
+        u(5) = VT::zero();
+      }
+      else
+      {
+        V const & v = body.get_velocity();
+        V const & w = body.get_spin();
+
+        assert(is_number(v(0)) || !"load_body(): non number encountered");
+        assert(is_number(v(1)) || !"load_body(): non number encountered");
+        assert(is_number(v(2)) || !"load_body(): non number encountered");
+        assert(is_number(w(0)) || !"load_body(): non number encountered");
+        assert(is_number(w(1)) || !"load_body(): non number encountered");
+        assert(is_number(w(2)) || !"load_body(): non number encountered");
+
+        u(0) = v(0);
+        u(1) = v(1);
+        u(2) = v(2);
+        u(3) = w(0);
+        u(4) = w(1);
+        u(5) = w(2);
+      }
+
+      store.m_Q[k]      = R;
+      store.m_mass[k]   = body.get_mass();
+      store.m_I_BF[k]   = body.get_inertia_bf();
+      store.m_active[k] = ( body.is_fixed() || body.is_scripted() || body.is_sleeping() ) ? 0 : 1;
+    }
+
+  }// end namespace detail
+
+  /**
+   * Bring the store up to date with the bodies. Only bodies that were
+   * created or changed since the last call are read, everything else is
+   * already in the store from the previous time step. New bodies also get
+   * their body indices that are used to access the blocks of assembled
+   * matrices.
+   */
+  template<typename body_iterator, typename MT>
+  inline void sync_body_store(
+                              body_iterator begin
+                              , body_iterator end
+                              , BodyStore<MT> & store
+                              , MT const & /*tag*/
+                              )
+  {
+    size_t const N = std::distance(begin,end);
+    size_t const K = store.size();
+
+    assert( store.m_force_callbacks.size() == N || !"sync_body_store(): bodies were created without adding them to the store");
+    assert( K <= N                              || !"sync_body_store(): bodies were removed without clearing the store");
+
+    if( K < N )
+    {
+      store.m_q.resize( N, true );
+      store.m_u.resize( N, true );
+      store.m_Q.resize( N );
+      store.m_mass.resize( N );
+      store.m_I_BF.resize( N );
+      store.m_active.resize( N );
+
+      for(size_t k = K; k < N; ++k)
+      {
+        (begin + k)->set_idx( k );
+
+        detail::load_body( *(begin + k), k, store );
+      }
+    }
+
+    for(size_t i = 0u; i < store.m_changes.size(); ++i)
+    {
+      size_t const k = store.m_changes[i];
+
+      if( k < K )
+        detail::load_body( *(begin + k), k, store );
+
+      store.m_changed[k] = 0;
+    }
+
+    store.m_changes.clear();
+  }
+
+  /**
+   * Get the velocities of a body, these are held by the store for bodies
+   * moved by the stepper and by the body itself otherwise.
+   */
+  template<typename MT>
+  inline void get_body_velocity(
+                                RigidBody<MT> const & body
+                                , size_t const & idx
+                                , BodyStore<MT> const & store
+                                , typename MT::vector3_type & velocity
+                                , typename MT::vector3_type & spin
+                                )
+  {
+    typedef typename MT::block6x1_type    B6x1;
+
+    if( ! store.has_velocity( idx ) )
+    {
+      velocity = body.get_velocity();
+      spin     = body.get_spin();
+      return;
+    }
+
+    B6x1 const & u = store.m_u( idx );
+
+    velocity(0) = u(0);
+    velocity(1) = u(1);
+    velocity(2) = u(2);
+    spin(0)     = u(3);
+    spin(1)     = u(4);
+    spin(2)     = u(5);
+  }
+
+  /**
+   * Hand the velocities held by the store back to a body that is about to
+   * be changed outside the stepper, and mark the body as changed.
+   */
+  template<typename MT>
+  inline void checkout_body(
+                            RigidBody<MT> & body
+                            , size_t const & idx
+                            , BodyStore<MT> & store
+                            )
+  {
+    typedef typename MT::vector3_type     V;
+
+    if( store.has_velocity( idx ) )
+    {
+      V v;
+      V w;
+
+      get_body_velocity( body, idx, store, v, w );
+
+      body.set_velocity( v );
+      body.set_spin( w );
+    }
+
+    store.set_changed( idx );
+  }
+
+  /**
+   * Write new positions to all active bodies. The orientations that the
+   * bodies end up with are kept in the store, such that the mass matrix
+   * and the external forces can be computed without going back to the
+   * bodies.
+   */
+  template<typename body_iterator, typename MT>
+  inline void set_position_vector(
+                                  body_iterator begin
+                                  , body_iterator end
+                                  , typename MT::vector7_type const & q
+                                  , BodyStore<MT> & store
+                                  , MT const & /*tag*/
+                                  )
+  {
+    typedef typename MT::vector3_type     V;
+    typedef typename MT::quaternion_type  Q;
+    typedef typename MT::block7x1_type    B7x1;
+
+    size_t const N = std::distance(begin,end);
+
+    assert(q.size() == N            || !"set_position_vector(): q has incorrect dimension");
+    assert(store.m_active.size() == N || !"set_position_vector(): store has incorrect dimension");
+
+    size_t k = 0u;
+    for(body_iterator body = begin; body!=end; ++body, ++k)
+    {
+      if( ! store.is_active(k) )
+        continue;
+
+      V r;
+      Q R;
+
+      B7x1 const & b = q( k );
+
+      r(0) = b(0);
+      r(1) = b(1);
+      r(2) = b(2);
+      R.real()    = b(3);
+      R.imag()(0) = b(4);
+      R.imag()(1) = b(5);
+      R.imag()(2) = b(6);
+
+      assert(is_number(r(0))        || !"set_position_vector(): non number encountered");
+      assert(is_number(r(1))        || !"set_position_vector(): non number encountered");
+      assert(is_number(r(2))        || !"set_position_vector(): non number encountered");
+      assert(is_number(R.real())    || !"set_position_vector(): non number encountered");
+      assert(is_number(R.imag()(0)) || !"set_position_vector(): non number encountered");
+      assert(is_number(R.imag()(1)) || !"set_position_vector(): non number encountered");
+      assert(is_number(R.imag()(2)) || !"set_position_vector(): non number encountered");
+
+      body->set_position( r );
+      body->set_orientation( R );
+
+      store.m_Q[k] = body->get_orientation();
+    }
+  }
+
+  /**
+   * Finish a time step. Bodies normalize their orientations, so the
+   * orientations they ended up with are put back into the position vector
+   * of the store. The next time step then starts out from exactly the
+   * placement the bodies have.
+   */
+  template<typename MT>
+  inline void commit_body_store( BodyStore<MT> & store, MT const & /*tag*/ )
+  {
+    typedef typename MT::block7x1_type    B7x1;
+
+    size_t const N = store.size();
+
+    for(size_t k = 0u; k < N; ++k)
+    {
+      if( ! store.is_active(k) )
+        continue;
+
+      B7x1 & b = store.m_q( k );
+
+      b(3) = store.m_Q[k].real();
+      b(4) = store.m_Q[k].imag()(0);
+      b(5) = store.m_Q[k].imag()(1);
+      b(6) = store.m_Q[k].imag()(2);
+    }
+  }
+
+} // namespace prox
+
+// PROX_BODY_STORE_H
+#endif
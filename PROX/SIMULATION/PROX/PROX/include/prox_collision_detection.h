@@ -12,6 +12,7 @@
 #include <prox_rigid_body.h>
 
 #include <util_profiling.h>
+#include <util_thread_pool.h>
 
 #include <cassert>
 #include <vector>
@@ -45,6 +46,9 @@ namespace prox
       body_type                   * m_body_i;   ///< A pointer to body i of the contact.
       body_type                   * m_body_j;   ///< A pointer to body j of the contact.
       std::vector< contact_type > * m_results;  ///< A pointer to a contact point container where all generated contacts should be added to.
+      size_t                        m_feature_i; ///< The feature of body i that the next contacts are generated from.
+      size_t                        m_feature_j; ///< The feature of body j that the next contacts are generated from.
+      size_t                        m_feature;   ///< The number of contacts generated so far from the current pair of features.
 
     public:
 
@@ -52,12 +56,18 @@ namespace prox
       : m_body_i(0)
       , m_body_j(0)
       , m_results(0)
+      , m_feature_i(0u)
+      , m_feature_j(0u)
+      , m_feature(0u)
       {}
 
       ContactCallbackFunctor(body_type * A, body_type * B, std::vector< prox::ContactPoint<M> > & results)
       : m_body_i(A)
       , m_body_j(B)
       , m_results(&results)
+      , m_feature_i(0u)
+      , m_feature_j(0u)
+      , m_feature(0u)
       {
         assert(A || !"ContactCallbackFunctor(...) body A was null");
         assert(B || !"ContactCallbackFunctor(...) body B was null");
@@ -72,6 +82,9 @@ namespace prox
           this->m_body_i  = callback.m_body_i;
           this->m_body_j  = callback.m_body_j;
           this->m_results = callback.m_results;
+          this->m_feature_i = callback.m_feature_i;
+          this->m_feature_j = callback.m_feature_j;
+          this->m_feature   = callback.m_feature;
         }
         return *this;
       }
@@ -103,9 +116,21 @@ namespace prox
         contact.set_Sa(Sa);
         contact.set_Sb(Sb);
         contact.set_S(n);
+        contact.set_features( this->m_feature_i, this->m_feature_j, this->m_feature++ );
 
         this->m_results->push_back( contact );
       }
+
+      /*
+       * Remember the features that the following contacts are generated
+       * from, so contacts can be recognized from one time step to the next.
+       */
+      void set_features( size_t const & feature_i, size_t const & feature_j )
+      {
+        this->m_feature_i = feature_i;
+        this->m_feature_j = feature_j;
+        this->m_feature   = 0u;
+      }
     };
 
   }// namespace detail
@@ -157,6 +182,8 @@ namespace prox
 
       kdop_bvh_update_work_pool.reserve( bodies.size() ); // Make sure all space we may need is pre-allocated.
 
+      bool const rigid = narrow_system.params().get_rigid_traversal();
+
       for(body_iterator body = bodies.begin(); body != bodies.end(); ++body)
       {
         geometry_type const & geometry = narrow_system.get_geometry( body->get_geometry_idx() );
@@ -164,6 +191,19 @@ namespace prox
         if(!geometry.has_shape() )
           continue;
 
+        // Sleeping bodies do not move so their BVHs are still valid. A body
+        // that just fell asleep moved during the last half of its final time
+        // step and therefore gets one last update. A raycast refits the trees
+        // it visits in world space, so a sleeping body is also updated if its
+        // tree is not in the frame the traversal expects.
+        if( body->is_sleeping() )
+        {
+          if( ! body->needs_sleep_refit() && body->m_body_frame_tree == rigid )
+            continue;
+
+          body->set_sleep_refit( false );
+        }
+
         narrow::UpdateWorkItem<tiny_types> work_item = narrow::UpdateWorkItem<tiny_types>(
                                                                                           *body
                                                                                           , geometry
@@ -177,7 +217,12 @@ namespace prox
       START_TIMER("kdop_update_time");
       if( ! kdop_bvh_update_work_pool.empty() )
       {
-        narrow::update_kdop_bvh(  kdop_bvh_update_work_pool );
+        // Rigid bodies do not need their world coordinates and BVHs updated,
+        // their trees are traversed in body frames instead.
+        if( rigid )
+          narrow::update_rigid_kdop_bvh(  kdop_bvh_update_work_pool );
+        else
+          narrow::update_kdop_bvh(  kdop_bvh_update_work_pool, util::ThreadPool::get_instance() );
       }
       STOP_TIMER("kdop_update_time");
 
@@ -188,22 +233,47 @@ namespace prox
       //            again. Ideally only newly added bodies or geometry
       //            changed bodies should be cleared/added to the broad
       //            phase system.
-      broad_system.clear();
+      //
+      //            When the broad phase is kept between time steps we
+      //            only rebuild if bodies have been added or removed (or
+      //            moved in memory), otherwise bodies are just updated.
+      bool rebuild_broad_system = ! params.keep_broad_phase() || broad_system.size() != bodies.size();
 
-      for(body_iterator body = bodies.begin(); body != bodies.end(); ++body)
+      for(body_iterator body = bodies.begin(); !rebuild_broad_system && body != bodies.end(); ++body)
       {
-        // 2013-07-06 Kenny code review: Here we re-connect all bodies
-        //            to the broad phase collision detection system.
-        //            See my review comment above about efficiency.
-        broad_system.connect( &(*body)  );
+        rebuild_broad_system = ! broad_system.is_connected( &(*body) );
       }
 
-      // 2015-03-03 Kenny code review: This optimal spacing requires
-      // sorting of all objects, so it runs O(n lg n). However, grid
-      // algorithm is trying to run in O(n). Hence, one could argue that
-      // a sweep-line algorithm would be better as its performance do
-      // not depend on the obejct sizes.
-      broad_system.compute_optimal_cell_spacing();
+      if( rebuild_broad_system )
+      {
+        broad_system.clear();
+
+        for(body_iterator body = bodies.begin(); body != bodies.end(); ++body)
+        {
+          // 2013-07-06 Kenny code review: Here we re-connect all bodies
+          //            to the broad phase collision detection system.
+          //            See my review comment above about efficiency.
+          broad_system.connect( &(*body)  );
+        }
+
+        // 2015-03-03 Kenny code review: This optimal spacing requires
+        // sorting of all objects, so it runs O(n lg n). However, grid
+        // algorithm is trying to run in O(n). Hence, one could argue that
+        // a sweep-line algorithm would be better as its performance do
+        // not depend on the obejct sizes.
+        //
+        // The sweep and prune and dynamic tree algorithms do not use
+        // the grid so we skip the spacing computation in that case.
+        if( ! params.use_sap() && ! params.use_dynamic_tree() )
+          broad_system.compute_optimal_cell_spacing();
+      }
+      else
+      {
+        for(body_iterator body = bodies.begin(); body != bodies.end(); ++body)
+        {
+          broad_system.update( &(*body) );
+        }
+      }
 
       STOP_TIMER("preprocessing_time");
     }
@@ -221,6 +291,18 @@ namespace prox
       {
         broad::find_overlaps( broad_system, overlaps, efficiency, broad::all_pair_algorithm() );
       }
+      else if( params.use_sap() )
+      {
+        broad::find_overlaps( broad_system, overlaps, efficiency, broad::sap_algorithm() );
+      }
+      else if( params.use_dynamic_tree() )
+      {
+        broad::find_overlaps( broad_system, overlaps, efficiency, broad::dynamic_tree_algorithm() );
+      }
+      else if( params.use_persistent_broad_phase() )
+      {
+        broad::find_overlaps( broad_system, overlaps, efficiency, broad::persistent_grid_algorithm() );
+      }
       else
       {
         broad::find_overlaps( broad_system, overlaps, efficiency, broad::grid_algorithm() );
@@ -249,11 +331,26 @@ namespace prox
 
       std::vector< narrow::TestPair<tiny_types> > narrow_test_pairs;
 
+      util::ThreadPool & pool = util::ThreadPool::get_instance();
+
+      bool const use_threads = pool.size() > 1u;
+
+      // When running multithreaded each overlap gets its own contact
+      // buffer. A buffer is only written to by the thread processing the
+      // test pair it belongs to, and the buffers are appended to the contact
+      // container in overlap order afterwards. This way the resulting contact
+      // order is the same as when running single threaded.
+      std::vector< std::vector< ContactPoint<M> > > buffers;
+      if( use_threads )
+        buffers.resize( overlaps.size() );
+
       std::vector< callback_type > callbacks;  // 2014-10-19 Kenny: Argh, I hate this design choice.... really ugly
       callbacks.resize( overlaps.size() );
       typename std::vector< callback_type >::iterator callback = callbacks.begin();
 
-      for(overlap_iterator o = overlaps.begin(); o != overlaps.end(); ++o, ++callback)
+      size_t k = 0u;
+
+      for(overlap_iterator o = overlaps.begin(); o != overlaps.end(); ++o, ++callback, ++k)
       {
         body_type * bodyA = static_cast<body_type *>(o->first);    // 2009-11-25 Kenny: hmm can we not get rid of static casts?
         body_type * bodyB = static_cast<body_type *>(o->second);   // 2009-11-25 Kenny: hmm can we not get rid of static casts?
@@ -267,8 +364,12 @@ namespace prox
           continue;
         if (bodyA->is_scripted() && bodyB->is_scripted())
           continue;
+        if (bodyA->is_sleeping() && (bodyB->is_fixed() || bodyB->is_sleeping()))
+          continue;
+        if (bodyB->is_sleeping() && bodyA->is_fixed())
+          continue;
 
-        *callback = callback_type( bodyA, bodyB, contacts );
+        *callback = callback_type( bodyA, bodyB, use_threads ? buffers[k] : contacts );
 
         narrow::TestPair<tiny_types> narrow_pair = narrow::TestPair<tiny_types>(
                                                                                 *bodyA
@@ -283,7 +384,23 @@ namespace prox
         narrow_test_pairs.push_back( narrow_pair );
       }
 
-      narrow::dispatch( narrow_system, narrow_test_pairs );
+      if( use_threads )
+      {
+        narrow::dispatch( narrow_system, narrow_test_pairs, pool );
+
+        size_t total = 0u;
+        for(size_t b = 0u; b < buffers.size(); ++b)
+          total += buffers[b].size();
+
+        contacts.reserve( total );
+
+        for(size_t b = 0u; b < buffers.size(); ++b)
+          contacts.insert( contacts.end(), buffers[b].begin(), buffers[b].end() );
+      }
+      else
+      {
+        narrow::dispatch( narrow_system, narrow_test_pairs );
+      }
 
       STOP_TIMER("narrow_time");
     }
@@ -4,8 +4,10 @@
 #include <prox_rigid_body.h>
 #include <geometry.h>
 #include <narrow.h>
+#include <broad.h>
 
 #include <vector>
+#include <algorithm>  // needed for std::sort
 #include <cassert>
 
 namespace prox
@@ -15,6 +17,7 @@ namespace prox
   inline bool compute_raycast(
                               geometry::Ray<typename M::vector3_type> const & ray
                               , std::vector< RigidBody< M > > & bodies
+                              , broad::System<typename M::real_type> & broad_system
                               , narrow::System<typename M::tiny_types> & narrow_system
                               , size_t & body_index
                               , typename M::vector3_type & point
@@ -30,39 +33,93 @@ namespace prox
     typedef typename body_container::iterator                       body_iterator;
     typedef typename narrow::Geometry<tiny_types>                   geometry_type;
     //typedef typename narrow::System<tiny_types>::geometry_iterator  geometry_iterator;
+    typedef typename broad::System<T>::object_ptr_container         object_ptr_container;
 
     //--- Initialization -------------------------------------------------------
     point        = V::zero();
     distance     = VT::infinity();
     bool did_hit = false;
 
-    //--- Preprocessing geometries so they reflect current state ---------------
+    //--- Make sure broad phase knows about all bodies ------------------------
+    bool rebuild_broad_system = broad_system.size() != bodies.size();
+
+    for(body_iterator body = bodies.begin(); !rebuild_broad_system && body != bodies.end(); ++body)
+    {
+      rebuild_broad_system = ! broad_system.is_connected( &(*body) );
+    }
+
+    if( rebuild_broad_system )
+    {
+      broad_system.clear();
+
+      for(body_iterator body = bodies.begin(); body != bodies.end(); ++body)
+        broad_system.connect( &(*body) );
+
+      broad_system.compute_optimal_cell_spacing();
+    }
+
+    //--- Use broad phase to find bodies whose AABBs are hit by the ray --------
+    object_ptr_container hits;
+
+    broad::find_ray_overlaps(
+                             broad_system
+                             , ray.origin()(0)
+                             , ray.origin()(1)
+                             , ray.origin()(2)
+                             , ray.direction()(0)
+                             , ray.direction()(1)
+                             , ray.direction()(2)
+                             , hits
+                             );
+
+    // Visit candidates in body order so ties are resolved as before
+    std::vector<size_t> candidates;
+
+    candidates.reserve( hits.size() );
+
+    for(typename object_ptr_container::iterator hit = hits.begin(); hit != hits.end(); ++hit)
+    {
+      body_type const * body = static_cast<body_type const *>( *hit );
+
+      candidates.push_back( body - &bodies[0] );
+    }
+
+    std::sort( candidates.begin(), candidates.end() );
+
+    //--- Preprocessing geometries of candidates so they reflect current state -
     std::vector< narrow::UpdateWorkItem< tiny_types > > kdop_bvh_update_work_pool;
 
-    kdop_bvh_update_work_pool.reserve( bodies.size() ); // Make sure all space we may need is pre-allocated.
+    kdop_bvh_update_work_pool.reserve( candidates.size() ); // Make sure all space we may need is pre-allocated.
 
-    for(body_iterator body = bodies.begin(); body != bodies.end(); ++body)
+    for(std::vector<size_t>::const_iterator idx = candidates.begin(); idx != candidates.end(); ++idx)
     {
-      geometry_type const & geometry = narrow_system.get_geometry( body->get_geometry_idx() );
+      body_type & body = bodies[*idx];
+
+      geometry_type const & geometry = narrow_system.get_geometry( body.get_geometry_idx() );
 
       if(geometry.has_shape() )
       {
         narrow::UpdateWorkItem<tiny_types> work_item = narrow::UpdateWorkItem<tiny_types>(
-                                                                                                        *body
+                                                                                                        body
                                                                                                         , geometry
-                                                                                                        , body->get_position()
-                                                                                                        , body->get_orientation()
+                                                                                                        , body.get_position()
+                                                                                                        , body.get_orientation()
                                                                                                         );
         kdop_bvh_update_work_pool.push_back( work_item );
       }
     }
 
-    narrow::update_kdop_bvh( kdop_bvh_update_work_pool );
+    if( ! kdop_bvh_update_work_pool.empty() )
+    {
+      narrow::update_kdop_bvh( kdop_bvh_update_work_pool );
+    }
 
-    //--- Test each body for intersection and find the "closest" one -----------
-    size_t idx = 0u;
-    for(body_iterator body = bodies.begin(); body != bodies.end(); ++body,++idx)
+    //--- Test each candidate body for intersection and find the "closest" one -
+    for(std::vector<size_t>::const_iterator candidate = candidates.begin(); candidate != candidates.end(); ++candidate)
     {
+      size_t    const idx  = *candidate;
+      body_iterator   body = bodies.begin() + idx;
+
       T min_x = VT::zero();
       T min_y = VT::zero();
       T min_z = VT::zero();
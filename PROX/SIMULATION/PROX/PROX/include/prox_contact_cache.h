@@ -0,0 +1,213 @@
+#ifndef PROX_CONTACT_CACHE_H
+#define PROX_CONTACT_CACHE_H
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+
+#include <tiny_vector_functions.h>
+#include <tiny_quaternion_functions.h>
+
+#include <sparse_traits.h>  // needed for sparse::zero_block
+
+#include <algorithm>  // needed for std::sort and std::lower_bound
+#include <cassert>
+#include <vector>
+
+namespace prox
+{
+
+  namespace detail
+  {
+
+    /**
+     * Get the position of a contact in the body frame of body i, using the
+     * current pose of body i.
+     */
+    template<typename M>
+    inline typename M::vector3_type get_contact_anchor( ContactPoint<M> const & contact )
+    {
+      RigidBody<M> const * body_i = contact.get_body_i();
+
+      return tiny::rotate( tiny::conj( body_i->get_orientation() ), contact.get_position() - body_i->get_position() );
+    }
+
+  }// end namespace detail
+
+  /**
+   * Contact Cache.
+   * Remembers the contact impulses of the previous time step. Collision
+   * detection rebuilds the contacts from scratch every time step, so the
+   * index of a contact says nothing about the contact with the same index
+   * in the previous time step. Instead contacts are recognized by their
+   * bodies and the features (tetrahedra) that generated them.
+   */
+  template<typename M>
+  class ContactCache
+  {
+  public:
+
+    typedef typename M::real_type       T;
+    typedef typename M::vector3_type    V;
+    typedef typename M::vector4_type    V4;
+    typedef typename M::block4x1_type   B4x1;
+
+    class Entry
+    {
+    public:
+
+      size_t m_body_i;      ///< Index of body i.
+      size_t m_body_j;      ///< Index of body j.
+      size_t m_feature_i;   ///< Feature of body i that generated the contact.
+      size_t m_feature_j;   ///< Feature of body j that generated the contact.
+      size_t m_feature;     ///< Ordinal of the contact among the contacts of the feature pair.
+      V      m_position;    ///< Contact position in the body frame of body i.
+      B4x1   m_impulse;     ///< Contact impulse of the previous time step.
+
+    public:
+
+      bool operator<(Entry const & entry) const
+      {
+        if( this->m_body_i    != entry.m_body_i    ) return this->m_body_i    < entry.m_body_i;
+        if( this->m_body_j    != entry.m_body_j    ) return this->m_body_j    < entry.m_body_j;
+        if( this->m_feature_i != entry.m_feature_i ) return this->m_feature_i < entry.m_feature_i;
+        if( this->m_feature_j != entry.m_feature_j ) return this->m_feature_j < entry.m_feature_j;
+        return this->m_feature < entry.m_feature;
+      }
+
+      bool same_key(Entry const & entry) const
+      {
+        return this->m_body_i    == entry.m_body_i
+            && this->m_body_j    == entry.m_body_j
+            && this->m_feature_i == entry.m_feature_i
+            && this->m_feature_j == entry.m_feature_j
+            && this->m_feature   == entry.m_feature;
+      }
+
+    };
+
+  protected:
+
+    std::vector<Entry> m_entries;   ///< Cache entries sorted by key.
+
+  protected:
+
+    static Entry make_entry( ContactPoint<M> const & contact, V const & position )
+    {
+      RigidBody<M> const * body_i = contact.get_body_i();
+      RigidBody<M> const * body_j = contact.get_body_j();
+
+      Entry entry;
+
+      entry.m_body_i    = body_i->get_idx();
+      entry.m_body_j    = body_j->get_idx();
+      entry.m_feature_i = contact.get_feature_i();
+      entry.m_feature_j = contact.get_feature_j();
+      entry.m_feature   = contact.get_feature();
+      entry.m_position  = position;
+      entry.m_impulse   = contact.get_impulse();
+
+      return entry;
+    }
+
+  public:
+
+    size_t size() const { return this->m_entries.size(); }
+
+    void clear() { this->m_entries.clear(); }
+
+    /**
+     * Fill the cache with the impulses stored in the contacts of the
+     * previous time step. Body indices must be up to date. Bodies have
+     * moved since the contacts were generated, so the contact positions
+     * are taken from the anchors stored along with the impulses.
+     *
+     * @param contacts   The contacts of the previous time step.
+     */
+    void store( std::vector< ContactPoint<M> > const & contacts )
+    {
+      this->m_entries.clear();
+      this->m_entries.reserve( contacts.size() );
+
+      for(size_t k = 0u; k < contacts.size(); ++k)
+        this->m_entries.push_back( make_entry( contacts[k], contacts[k].get_anchor() ) );
+
+      std::sort( this->m_entries.begin(), this->m_entries.end() );
+    }
+
+    /**
+     * Seed the contact impulses with the impulses of matching contacts from
+     * the previous time step. Contacts without a match start from zero.
+     *
+     * @param contacts    The current contacts.
+     * @param tolerance   Matching contacts must be closer than this in the body frame of body i.
+     * @param lambda      Upon return this holds the initial contact impulses.
+     *
+     * @return            The number of contacts that were matched.
+     */
+    size_t warm_start(
+                      std::vector< ContactPoint<M> > const & contacts
+                      , T const & tolerance
+                      , V4 & lambda
+                      ) const
+    {
+      size_t const K = contacts.size();
+
+      lambda.resize( K );
+
+      size_t matches = 0u;
+
+      for(size_t k = 0u; k < K; ++k)
+      {
+        Entry const entry = make_entry( contacts[k], detail::get_contact_anchor( contacts[k] ) );
+
+        typename std::vector<Entry>::const_iterator match = std::lower_bound( this->m_entries.begin(), this->m_entries.end(), entry );
+
+        if( match != this->m_entries.end()
+           && match->same_key( entry )
+           && tiny::norm( match->m_position - entry.m_position ) < tolerance
+           )
+        {
+          lambda( k ) = match->m_impulse;
+          ++matches;
+        }
+        else
+        {
+          lambda( k ) = sparse::zero_block<B4x1>();
+        }
+      }
+
+      return matches;
+    }
+
+  };
+
+  namespace detail
+  {
+
+    /**
+     * Store the solved contact impulses in the contacts, so they can be used
+     * for warm starting the next time step. Bodies must still be at the
+     * pose the contacts were generated at, as the contact positions are
+     * anchored in the body frame of body i here.
+     */
+    template<typename M>
+    inline void set_contact_impulses(
+                                     typename M::vector4_type const & lambda
+                                     , std::vector< ContactPoint<M> > & contacts
+                                     )
+    {
+      assert( lambda.size() == contacts.size() || !"set_contact_impulses(): size mismatch");
+
+      for(size_t k = 0u; k < contacts.size(); ++k)
+      {
+        contacts[k].set_impulse( lambda( k ) );
+        contacts[k].set_anchor( get_contact_anchor( contacts[k] ) );
+      }
+    }
+
+  }// end namespace detail
+
+} //namespace prox
+
+// PROX_CONTACT_CACHE_H
+#endif
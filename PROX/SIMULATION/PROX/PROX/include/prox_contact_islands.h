@@ -0,0 +1,154 @@
+#ifndef PROX_CONTACT_ISLANDS_H
+#define PROX_CONTACT_ISLANDS_H
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+
+#include <cassert>
+#include <vector>
+
+namespace prox
+{
+
+  /**
+   * Contact Island.
+   * A group of simulated bodies that are connected through contacts. Fixed,
+   * scripted and sleeping bodies do not join islands, so no two islands
+   * share a simulated body and the contact forces of an island can be
+   * computed independently of all other islands.
+   */
+  class ContactIsland
+  {
+  public:
+
+    std::vector<size_t> m_contacts;   ///< Indices of the contacts in the island, in increasing order.
+    std::vector<size_t> m_bodies;     ///< Indices of the simulated bodies in the island, in increasing order.
+
+  };
+
+  namespace detail
+  {
+
+    /**
+     * Test if a body is simulated, ie. it is neither fixed, scripted nor sleeping.
+     */
+    template<typename M>
+    inline bool is_simulated( RigidBody<M> const & body )
+    {
+      return ! body.is_fixed() && ! body.is_scripted() && ! body.is_sleeping();
+    }
+
+    /**
+     * Find the root of an island in a union-find forest.
+     */
+    inline size_t find_island( std::vector<size_t> & parent, size_t idx )
+    {
+      while( parent[idx] != idx )
+      {
+        parent[idx] = parent[ parent[idx] ];   // Path halving
+        idx = parent[idx];
+      }
+      return idx;
+    }
+
+    /**
+     * Build a union-find forest where simulated bodies touching each other
+     * through contacts are in the same tree.
+     *
+     * @param N           The number of bodies.
+     * @param contacts    The contact points, body indices must be up to date.
+     * @param parent      Upon return this holds the parent of each body in the forest.
+     */
+    template<typename M>
+    inline void union_islands(
+                              size_t const & N
+                              , std::vector< ContactPoint<M> > const & contacts
+                              , std::vector<size_t> & parent
+                              )
+    {
+      typedef typename std::vector< ContactPoint<M> >::const_iterator contact_iterator;
+
+      parent.resize( N );
+
+      for(size_t k = 0u; k < N; ++k)
+        parent[k] = k;
+
+      for(contact_iterator contact = contacts.begin(); contact != contacts.end(); ++contact)
+      {
+        RigidBody<M> const * body_i = contact->get_body_i();
+        RigidBody<M> const * body_j = contact->get_body_j();
+
+        if( ! is_simulated( *body_i ) || ! is_simulated( *body_j ) )
+          continue;
+
+        size_t const root_i = find_island( parent, body_i->get_idx() );
+        size_t const root_j = find_island( parent, body_j->get_idx() );
+
+        if( root_i != root_j )
+          parent[ root_j ] = root_i;
+      }
+    }
+
+    /**
+     * Split contacts into independent islands. Every contact must involve
+     * at least one simulated body. Islands are ordered by their first
+     * contact, so the decomposition is deterministic.
+     *
+     * @param bodies      All rigid bodies, body indices must be up to date.
+     * @param contacts    The contact points.
+     * @param islands     Upon return this holds the contact islands.
+     */
+    template<typename M>
+    inline void compute_contact_islands(
+                                        std::vector< RigidBody<M> > const & bodies
+                                        , std::vector< ContactPoint<M> > const & contacts
+                                        , std::vector< ContactIsland > & islands
+                                        )
+    {
+      size_t const N     = bodies.size();
+      size_t const UNSET = N;
+
+      std::vector<size_t> parent;
+
+      union_islands( N, contacts, parent );
+
+      std::vector<size_t> island_of_root( N, UNSET );
+
+      islands.clear();
+
+      for(size_t k = 0u; k < contacts.size(); ++k)
+      {
+        RigidBody<M> const * body_i = contacts[k].get_body_i();
+        RigidBody<M> const * body_j = contacts[k].get_body_j();
+
+        assert( (is_simulated( *body_i ) || is_simulated( *body_j )) || !"compute_contact_islands(): contact without simulated bodies");
+
+        size_t const root = find_island( parent, is_simulated( *body_i ) ? body_i->get_idx() : body_j->get_idx() );
+
+        if( island_of_root[root] == UNSET )
+        {
+          island_of_root[root] = islands.size();
+          islands.push_back( ContactIsland() );
+        }
+
+        islands[ island_of_root[root] ].m_contacts.push_back( k );
+      }
+
+      for(size_t k = 0u; k < N; ++k)
+      {
+        if( ! is_simulated( bodies[k] ) )
+          continue;
+
+        size_t const island = island_of_root[ find_island( parent, k ) ];
+
+        if( island != UNSET )
+          islands[ island ].m_bodies.push_back( k );
+      }
+    }
+
+  }// end namespace detail
+
+} //namespace prox
+
+// PROX_CONTACT_ISLANDS_H
+#endif
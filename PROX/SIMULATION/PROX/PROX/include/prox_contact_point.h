@@ -18,6 +18,7 @@ namespace prox
     
     typedef typename M::real_type       real_type;
     typedef typename M::vector3_type    vector3_type;
+    typedef typename M::block4x1_type   block4x1_type;
     typedef          RigidBody<M>       body_type;
     
   protected:
@@ -32,6 +33,12 @@ namespace prox
     vector3_type m_Sa; ///< structure direction of object A
     vector3_type m_Sb; ///< structure direction of object B
     vector3_type m_S;  ///< structure direction of the two objects combined
+
+    size_t        m_feature_i;  ///< Index of the feature (tetrahedron) of body i that generated the contact.
+    size_t        m_feature_j;  ///< Index of the feature (tetrahedron) of body j that generated the contact.
+    size_t        m_feature;    ///< Ordinal of the contact among all contacts generated by the same pair of features.
+    block4x1_type m_impulse;    ///< The contact impulse found by the solver, used for warm starting.
+    vector3_type  m_anchor;     ///< Contact position in the body frame of body i at the pose the contact was generated at, used for warm starting.
     
   public:
 
@@ -44,6 +51,11 @@ namespace prox
     , m_Sa(vector3_type::make(real_type(1),real_type(0),real_type(0)))
     , m_Sb(vector3_type::make(real_type(1),real_type(0),real_type(0)))
     , m_S(vector3_type::make(real_type(0),real_type(0),real_type(0)))
+    , m_feature_i(0u)
+    , m_feature_j(0u)
+    , m_feature(0u)
+    , m_impulse(real_type(0))
+    , m_anchor(vector3_type::make(real_type(0),real_type(0),real_type(0)))
     {}
     
     virtual ~ContactPoint(){}
@@ -68,6 +80,11 @@ namespace prox
         this->m_Sa          = point.m_Sa;
         this->m_Sb          = point.m_Sb;
         this->m_S           = point.m_S;
+        this->m_feature_i   = point.m_feature_i;
+        this->m_feature_j   = point.m_feature_j;
+        this->m_feature     = point.m_feature;
+        this->m_impulse     = point.m_impulse;
+        this->m_anchor      = point.m_anchor;
       }
       return *this;
     }
@@ -80,6 +97,11 @@ namespace prox
     vector3_type const & get_Sa()        const {  return this->m_Sa;       }
     vector3_type const & get_Sb()        const {  return this->m_Sb;       }
     vector3_type const & get_S()         const {  return this->m_S;        }
+    size_t       const & get_feature_i() const {  return this->m_feature_i; }
+    size_t       const & get_feature_j() const {  return this->m_feature_j; }
+    size_t       const & get_feature()   const {  return this->m_feature;   }
+    block4x1_type const & get_impulse()  const {  return this->m_impulse;   }
+    vector3_type const & get_anchor()    const {  return this->m_anchor;    }
 
     
     void set_position(vector3_type const & p)  {  this->m_position = p;    }
@@ -88,6 +110,15 @@ namespace prox
     void set_Sa(vector3_type const & d)        {  this->m_Sa = d;          }
     void set_Sb(vector3_type const & d)        {  this->m_Sb = d;          }
     void set_S(vector3_type const & d)         {  this->m_S = d;           }
+    void set_impulse(block4x1_type const & l)  {  this->m_impulse = l;     }
+    void set_anchor(vector3_type const & a)    {  this->m_anchor = a;      }
+
+    void set_features(size_t const & feature_i, size_t const & feature_j, size_t const & feature)
+    {
+      this->m_feature_i = feature_i;
+      this->m_feature_j = feature_j;
+      this->m_feature   = feature;
+    }
 
       void set_body_i(body_type const * body_i)
     {
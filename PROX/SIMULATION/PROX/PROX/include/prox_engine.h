@@ -21,6 +21,7 @@ namespace prox
     static std::string const PARAM_SOLVER;
     static std::string const VALUE_JACOBI;
     static std::string const VALUE_GAUSS_SEIDEL;
+    static std::string const VALUE_COLORED_GAUSS_SEIDEL;
     static std::string const PARAM_NORMAL_SOLVER;
     static std::string const VALUE_NONNEGATIVE;
     static std::string const VALUE_ORIGIN;
@@ -50,6 +51,17 @@ namespace prox
     static std::string const PARAM_TETGEN_SUPPRESS_SPLITTING;
     static std::string const PARAM_MAX_ITERATION;
     static std::string const PARAM_NARROW_CHUNK_BYTES;
+    static std::string const PARAM_NARROW_RIGID_TRAVERSAL;
+    static std::string const PARAM_NARROW_WIDE_TRAVERSAL;
+    static std::string const PARAM_NARROW_ANALYTIC_SHAPES;
+    static std::string const PARAM_NUMBER_OF_THREADS;
+    static std::string const PARAM_SLEEPING;
+    static std::string const PARAM_SLEEP_STEPS;
+    static std::string const PARAM_SLEEP_LINEAR_VELOCITY;
+    static std::string const PARAM_SLEEP_ANGULAR_VELOCITY;
+    static std::string const PARAM_SOLVER_ISLANDS;
+    static std::string const PARAM_WARM_STARTING;
+    static std::string const PARAM_WARM_START_TOLERANCE;
     static std::string const PARAM_ABSOLUTE_TOLERANCE;
     static std::string const PARAM_RELATIVE_TOLERANCE;
     static std::string const PARAM_GAP_REDUCTION;
@@ -57,12 +69,21 @@ namespace prox
     static std::string const PARAM_MIN_GAP;
     static std::string const PARAM_TETGEN_QUALITY_RATIO;
     static std::string const PARAM_TETGEN_MAXIMUM_VOLUME;
+    static std::string const PARAM_TETGEN_CACHE_PATH;
     static std::string const PARAM_NARROW_ENVELOPE;
     static std::string const PARAM_COLLISION_ENVELOPE;
     static std::string const PARAM_TIME_STEP;
     static std::string const PARAM_BROAD_PHASE_ALGORITHM;
     static std::string const VALUE_ALL_PAIR;
     static std::string const VALUE_GRID;
+    static std::string const VALUE_SAP;
+    static std::string const VALUE_DYNAMIC_TREE;
+    static std::string const PARAM_BROAD_PHASE_PERSISTENT;
+    static std::string const PARAM_PROFILING_WINDOW;
+    static std::string const PARAM_PROFILING_FLUSH_FILE;
+    static std::string const PARAM_PROFILING_FLUSH_STEPS;
+    static std::string const PARAM_PROFILING_TRACE;
+    static std::string const PARAM_PROFILING_TRACE_STEPS;
 
     void set_parameter(std::string const & name, bool         const & value );
 
@@ -480,6 +501,7 @@ namespace prox
   public:
 
     bool write_matlab_profiling_data(std::string const & filename);
+    bool write_chrome_trace_data(std::string const & filename);
     bool write_matlab_contact_data(std::string const & filename, unsigned int const & frame_number);
 
   };
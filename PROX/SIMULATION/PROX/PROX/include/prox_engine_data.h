@@ -3,6 +3,7 @@
 
 #include <prox_math_policy.h>
 #include <prox_rigid_body.h>
+#include <prox_body_store.h>
 #include <prox_contact_point.h>
 #include <prox_matchstick_model.h>
 #include <prox_params.h>
@@ -49,6 +50,8 @@ namespace prox
     std::vector< std::string >       m_geometry_names;
     std::vector< std::string >       m_materials;
     std::vector< rigid_body_type  >  m_bodies;
+    std::vector< std::string >       m_body_names;   ///< Names of the bodies, kept out of the bodies as they are only needed by the API.
+    prox::BodyStore< MT >            m_body_store;   ///< Time stepper state of the bodies and their force callbacks.
     std::vector< contact_type >      m_contacts;
 
     broad_phase_type                 m_broad;
@@ -78,6 +81,10 @@ namespace prox
 
     mesh_array::TetGenSettings m_tetgen_settings;           ///< Tetget settings
 
+    std::string                      m_profiling_flush_file;    ///< File that raw profiling values are appended to, empty means no flushing.
+    unsigned int                     m_profiling_flush_steps;   ///< Number of steps between two flushes of the raw profiling values.
+    unsigned int                     m_profiling_steps;         ///< Number of steps taken since the last flush.
+
   public:
 
     class ScriptedMotion
@@ -19,6 +19,7 @@ namespace prox
   typedef enum {
     jacobi
     , gauss_seidel
+    , colored_gauss_seidel
   } solver_type;
 
 
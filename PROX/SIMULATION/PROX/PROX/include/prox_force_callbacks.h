@@ -36,7 +36,12 @@ namespace prox
 
   public:
 
-    virtual void compute_force_and_torque( B const & body, V & force, V & torque) const = 0;
+    /**
+     * Compute the force and torque acting on a body. The velocities of
+     * bodies moved by the time stepper are held by the body store, so
+     * they are passed along instead of being read from the body.
+     */
+    virtual void compute_force_and_torque( B const & body, V const & velocity, V const & spin, V & force, V & torque) const = 0;
 
   };
 
@@ -72,11 +77,16 @@ namespace prox
 
   public:
 
-    void compute_force_and_torque( B const & body, V & force, V & torque) const
+    void compute_force_and_torque( B const & body, V const & /*velocity*/, V const & /*spin*/, V & force, V & torque) const
+    {
+      this->compute_force_and_torque( body.get_mass(), force, torque );
+    }
+
+    void compute_force_and_torque( T const & mass, V & force, V & torque) const
     {
       assert(this->m_acceleration >= VT::zero() || !"Gravity::compute_force_and_torque(): acceleration must be non-negative");
 
-      force = - this->m_up * (body.get_mass() * this->m_acceleration);
+      force = - this->m_up * (mass * this->m_acceleration);
       torque = V::zero();
     }
 
@@ -114,14 +124,18 @@ namespace prox
 
   public:
 
-    void compute_force_and_torque( B const & body, V & force, V & torque) const
+    void compute_force_and_torque( B const & /*body*/, V const & velocity, V const & spin, V & force, V & torque) const
+    {
+      this->compute_force_and_torque( velocity, spin, force, torque );
+    }
+
+    void compute_force_and_torque( V const & velocity, V const & spin, V & force, V & torque) const
     {
       assert(this->m_linear  >= VT::zero() || !"Damping::compute_force_and_torque(): damping must be non-negative");
       assert(this->m_angular >= VT::zero() || !"Damping::compute_force_and_torque(): damping must be non-negative");
 
-
-      force = - (body.get_velocity() * m_linear);
-      torque = - (body.get_spin()     * m_angular);
+      force = - (velocity * m_linear);
+      torque = - (spin     * m_angular);
     }
     
   };
@@ -163,7 +177,7 @@ namespace prox
 
   public:
 
-    void compute_force_and_torque( B const & body, V & force, V & torque) const
+    void compute_force_and_torque( B const & body, V const & velocity, V const & /*spin*/, V & force, V & torque) const
     {
       using std::min;
       using std::max;
@@ -174,7 +188,7 @@ namespace prox
       V const D      = this->m_target -  (r + body.get_position());
       T const l      = tiny::norm( D );
       V const n      = tiny::unit( D );
-      T const v      = tiny::inner_prod(body.get_velocity(), n);
+      T const v      = tiny::inner_prod(velocity, n);
       T const m      = body.get_mass();
       T const b      = (VT::two() *m) / this->m_tau;
       T const k      = m / (this->m_tau*this->m_tau);
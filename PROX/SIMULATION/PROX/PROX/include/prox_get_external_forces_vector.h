@@ -2,6 +2,7 @@
 #define PROX_GET_EXTERNAL_FORCES_VECTOR_H
 
 #include <prox_force_callbacks.h>
+#include <prox_body_store.h>
 
 #include <tiny_is_number.h>
 #include <tiny_is_finite.h>
@@ -12,6 +13,8 @@ namespace prox
 {
 
   /**
+   * The forces are computed from the body store, the bodies are only
+   * visited by the force callbacks that have been connected to them.
    *
    * @param h      Upon return this parameter contains the total external forces
    *               and torques acting on the bodies in the system
@@ -20,6 +23,7 @@ namespace prox
   inline void get_external_forces_vector(
                            body_iterator begin
                            , body_iterator end
+                           , BodyStore< MT > const & store
                            , Gravity< MT > const & gravity
                            , Damping< MT > const & damping
                            , typename MT::vector6_type & h
@@ -32,14 +36,16 @@ namespace prox
     typedef typename MT::value_traits     VT;
 
     size_t const N = std::distance(begin,end);
+
+    assert(store.size() == N || !"get_external_forces_vector(): store has incorrect dimension");
+
     h.resize( N );
 
-    size_t k = 0u;
-    for(body_iterator body = begin;body!=end;++body, ++k)
+    for(size_t k = 0u; k < N; ++k)
     {
       B6x1 & b = h( k );
 
-      if(body->is_fixed() || body->is_scripted() )
+      if( ! store.is_active(k) )
       {
         b(0) = VT::zero();
         b(1) = VT::zero();
@@ -50,6 +56,11 @@ namespace prox
         continue;
       }
 
+      B6x1 const & u = store.m_u( k );
+
+      V const v = V::make( u(0), u(1), u(2) );
+      V const w = V::make( u(3), u(4), u(5) );
+
       V total_force  = V::zero();
       V total_torque = V::zero();
 
@@ -57,23 +68,23 @@ namespace prox
       V torque = V::zero();
 
       //--- First we add global world gravity force ----------------------------
-      gravity.compute_force_and_torque((*body), force, torque);
+      gravity.compute_force_and_torque(store.m_mass[k], force, torque);
 
       total_force  += force;
       total_torque += torque;
 
       //--- Second we add global world damping force ---------------------------
-      damping.compute_force_and_torque((*body), force, torque);
+      damping.compute_force_and_torque(v, w, force, torque);
 
       total_force  += force;
       total_torque += torque;
 
       //--- Third we add any local body forces that might be applied -----------
-      typename std::vector<ForceCallback<MT> * >::const_iterator callback      = body->get_force_callbacks().begin();
-      typename std::vector<ForceCallback<MT> * >::const_iterator callback_end  = body->get_force_callbacks().end();
+      typename std::vector<ForceCallback<MT> * >::const_iterator callback      = store.get_force_callbacks(k).begin();
+      typename std::vector<ForceCallback<MT> * >::const_iterator callback_end  = store.get_force_callbacks(k).end();
       for(;callback != callback_end;++callback)
       {
-        (*callback)->compute_force_and_torque((*body), force, torque);
+        (*callback)->compute_force_and_torque(*(begin + k), v, w, force, torque);
         total_force  += force;
         total_torque += torque;
       }
@@ -98,8 +109,7 @@ namespace prox
       b(1) = total_force(1);
       b(2) = total_force(2);
 
-      V const & w    = body->get_spin();
-      M const & I_bf = body->get_inertia_bf();
+      M const & I_bf = store.m_I_BF[k];
 
       assert(is_number(w(0))|| !"get_external_forces_vector(): Nan");
       assert(is_number(w(1))|| !"get_external_forces_vector(): Nan");
@@ -109,7 +119,7 @@ namespace prox
       assert(is_finite(w(1))|| !"get_external_forces_vector(): Inf");
       assert(is_finite(w(2))|| !"get_external_forces_vector(): Inf");
 
-      M const R = tiny::make( body->get_orientation() );
+      M const R = tiny::make( store.m_Q[k] );
 
       M I;
       detail::update_inertia_tensor<MT>( R, I_bf, I );
@@ -2,6 +2,7 @@
 #define PROX_GET_INVERSE_MASS_MATRIX_H
 
 #include <prox_update_inertia_tensor.h>
+#include <prox_body_store.h>
 
 #include <tiny_is_number.h>
 #include <tiny_is_finite.h>
@@ -40,7 +41,7 @@ namespace prox
                            , VT::zero(), VT::zero(), VT::zero()
                            );
 
-      if( !body->is_fixed() && !body->is_scripted() )
+      if( !body->is_fixed() && !body->is_scripted() && !body->is_sleeping() )
       {
         assert( fabs(body->get_mass()) > VT::zero() || !"get_inverse_mass_matrix(): Divide by zero!");
         
@@ -74,6 +75,69 @@ namespace prox
       b(5,5) = inv_I(2,2);    
     }
   }
+  /**
+   * Compute the inverse mass matrix from the body store, without
+   * touching the bodies themselves.
+   */
+  template <typename MT >
+  inline void get_inverse_mass_matrix(
+                                      BodyStore<MT> const & store,
+                                      typename MT::diagonal6x6_type & W,
+                                      MT const & /*math types tag*/
+                                      )
+  {
+    typedef typename MT::real_type                T;
+    typedef typename MT::matrix3x3_type           M;
+    typedef typename MT::block6x6_type            B6x6;
+    typedef typename MT::value_traits             VT;
+
+    size_t const N = store.size();
+
+    W.resize( N );
+
+    for(size_t index = 0u; index < N; ++index)
+    {
+      T inv_mass = VT::zero();
+      M inv_I    = M::make(
+                             VT::zero(), VT::zero(), VT::zero()
+                           , VT::zero(), VT::zero(), VT::zero()
+                           , VT::zero(), VT::zero(), VT::zero()
+                           );
+
+      if( store.is_active(index) )
+      {
+        assert( fabs(store.m_mass[index]) > VT::zero() || !"get_inverse_mass_matrix(): Divide by zero!");
+
+        inv_mass = VT::one() / store.m_mass[index];
+
+        assert(is_number(inv_mass)   || !"get_inverse_mass_matrix(): Nan");
+        assert(is_finite(inv_mass)   || !"get_inverse_mass_matrix(): Inf");
+        assert(inv_mass > VT::zero() || !"get_inverse_mass_matrix(): Negative mass");
+
+        M const R = tiny::make( store.m_Q[index] );
+
+        detail::update_inertia_tensor<MT>( R, store.m_I_BF[index], inv_I );
+
+        inv_I = tiny::inverse( inv_I );
+      }
+
+      B6x6 & b = W( index );
+
+      b(0,0) = inv_mass;
+      b(1,1) = inv_mass;
+      b(2,2) = inv_mass;
+      b(3,3) = inv_I(0,0);
+      b(3,4) = inv_I(0,1);
+      b(3,5) = inv_I(0,2);
+      b(4,3) = inv_I(1,0);
+      b(4,4) = inv_I(1,1);
+      b(4,5) = inv_I(1,2);
+      b(5,3) = inv_I(2,0);
+      b(5,4) = inv_I(2,1);
+      b(5,5) = inv_I(2,2);
+    }
+  }
+
 } // namespace prox
 // PROX_GET_INVERSE_MASS_MATRIX_H
 #endif 
@@ -41,7 +41,7 @@ namespace prox
       assert(is_finite(mass)   || !"get_mass_matrix(): Inf");
       assert(mass > VT::zero() || !"get_mass_matrix(): Non-positive mass");
 
-      if( body->is_fixed() || body->is_scripted() )
+      if( body->is_fixed() || body->is_scripted() || body->is_sleeping() )
       {
         mass = VT::infinity();
       }
@@ -37,7 +37,7 @@ namespace prox
       
       block6x1_type & b = u( k );
       
-      if( body->is_fixed() ) 
+      if( body->is_fixed() || body->is_sleeping() )
       {
         b(0) = value_traits::zero();
         b(1) = value_traits::zero();
@@ -7,6 +7,7 @@
 #include <sparse.h>
 
 #include <cmath> // for std::abs
+#include <cassert>
 
 
 namespace prox
@@ -49,6 +50,8 @@ namespace prox
         typedef sparse::DiagonalMatrix< mass_block_type >     diagonal_mass_type;
         typedef sparse::CompressedRowMatrix< block6x4_type >  compressed6x4_type;
         typedef sparse::CompressedRowMatrix< block4x6_type >  compressed4x6_type;
+        typedef sparse::TwoColumnMatrix< block4x6_type >      two_column4x6_type;
+        typedef sparse::TwoColumnMatrix< block6x4_type >      two_column6x4_type;
         
         typedef typename compressed4x6_type::const_iterator      compressed4x6_type_const_iterator;
         typedef typename compressed4x6_type::const_row_iterator  compressed4x6_type_const_row_iterator;
@@ -119,6 +122,40 @@ namespace prox
             sparse::prod(W, h, Wdth);
         }
         
+        /**
+         * Every row of J has exactly two blocks, one for each body of the
+         * contact. Copy J and the columns of W J^T into two column matrices
+         * that keep the two blocks of a contact next to each other, the kth
+         * row of WJT_columns holds the kth column of W J^T. This way
+         * compute_z_k and the update of w need no lookups of blocks.
+         */
+        static void compute_two_column(
+                                       compressed4x6_type const & J
+                                       , compressed6x4_type const & WJT
+                                       , two_column4x6_type & J_rows
+                                       , two_column6x4_type & WJT_columns
+                                       )
+        {
+            size_t const K = J.nrows();
+            size_t const N = J.ncols();
+
+            J_rows.resize( K, N, 2u*K );
+            WJT_columns.resize( K, N, 2u*K );
+
+            for(size_t k = 0u; k < K; ++k)
+            {
+                assert( J.row_idx(k+1u) - J.row_idx(k) == 2u || !"compute_two_column(): Jacobian row must have two blocks");
+
+                for(size_t idx = J.row_idx(k); idx < J.row_idx(k+1u); ++idx)
+                {
+                    size_t const j = J.col_of_idx(idx);
+
+                    J_rows( k, j )      = J[idx];
+                    WJT_columns( k, j ) = WJT( j, k );
+                }
+            }
+        }
+
         //compute z = x - R(J W J^T x  + b)  = x - R( A x  + b)
         static void compute_z(
                               vector4_type       const & x
@@ -161,6 +198,25 @@ namespace prox
             sparse::sub(x_k, temp, z_k);          // z_k = x_k - temp
         }
         
+        static void compute_z_k(
+                                block4x1_type        const & x_k
+                                , vector6_type       const & w
+                                , block4x4_type      const & R_k
+                                , two_column4x6_type const & J_rows
+                                , block4x1_type      const & b_k
+                                , block4x1_type            & z_k
+                                , size_t             const & k
+                                )
+        {
+            // z_k = x_k - R_kk ( J w + b_k )
+            z_k.clear_data();
+            block4x1_type temp(0);
+            sparse::row_prod(J_rows, w, z_k, k);  // z_k += J_k w
+            sparse::add(b_k, z_k);                // z_k += b_k
+            sparse::prod(R_k, z_k, temp);         // temp += R_kk z_k
+            sparse::sub(x_k, temp, z_k);          // z_k = x_k - temp
+        }
+        
         static void update_w(
                              compressed6x4_type    const & WJT
                              , compressed4x6_type  const & J
@@ -32,6 +32,24 @@ namespace prox
                                              ///< all-pair or grid algorithm should
                                              ///< be used for broad phase collision
                                              ///< detetection. Default is false (=off).
+
+    bool   m_use_sap;                        ///< Parameter for controlling if the
+                                             ///< sweep and prune algorithm should be
+                                             ///< used for broad phase collision
+                                             ///< detection. Default is false (=off).
+
+    bool   m_use_dynamic_tree;               ///< Parameter for controlling if the
+                                             ///< dynamic tree algorithm should be
+                                             ///< used for broad phase collision
+                                             ///< detection. Default is false (=off).
+
+    bool   m_use_persistent_broad_phase;     ///< Parameter for controlling if the
+                                             ///< grid broad phase system is kept between
+                                             ///< time steps such that only bodies that
+                                             ///< moved are re-mapped. Sweep and prune and the
+                                             ///< dynamic tree always keep their system, see
+                                             ///< keep_broad_phase().
+                                             ///< Default is false (=off).
     
   public:
 
@@ -44,12 +62,32 @@ namespace prox
     bool const & use_all_pair() const { return this->m_use_all_pair; }
     bool       & use_all_pair()       { return this->m_use_all_pair; }
 
+    bool const & use_sap() const { return this->m_use_sap; }
+    bool       & use_sap()       { return this->m_use_sap; }
+
+    bool const & use_dynamic_tree() const { return this->m_use_dynamic_tree; }
+    bool       & use_dynamic_tree()       { return this->m_use_dynamic_tree; }
+
+    bool const & use_persistent_broad_phase() const { return this->m_use_persistent_broad_phase; }
+    bool       & use_persistent_broad_phase()       { return this->m_use_persistent_broad_phase; }
+
+    /**
+     * Test if the broad phase system is kept between time steps. Sweep and
+     * prune relies on the end-point order and the dynamic tree on the fat
+     * leaf boxes of the last time step, so they always keep the system. The
+     * grid only does so when asked to.
+     */
+    bool keep_broad_phase() const { return this->m_use_persistent_broad_phase || this->m_use_sap || this->m_use_dynamic_tree; }
+
   public:
     
     Params()
     : m_solver_params()
     , m_stepper_params()
     , m_use_all_pair(false)
+    , m_use_sap(false)
+    , m_use_dynamic_tree(false)
+    , m_use_persistent_broad_phase(false)
     {}
   };
 
@@ -1,70 +1,56 @@
 #ifndef PROX_POSITION_UPDATE_H
 #define PROX_POSITION_UPDATE_H
 
+#include <prox_simd_lanes.h>
+
+#include <tiny_quaternion_functions.h>   // for tiny::prod and tiny::unit
+
 #include <cmath>
 #include <stdexcept>
 
 namespace prox
 {
-  
-  template<typename math_policy>
-  inline void position_update( 
-                              typename math_policy::vector7_type const& q,
-                              typename math_policy::vector6_type const & u,
-                              typename math_policy::real_type const & dt,
-                              typename math_policy::vector7_type & qnew,
-                              math_policy const & /*tag*/ 
-                              ) 
+
+  namespace detail
   {
-    typedef typename math_policy::vector3_type     vector3_type;
-    typedef typename math_policy::quaternion_type  quaternion_type;
-    
-    typedef typename math_policy::block6x1_type block6x1_type;
-    typedef typename math_policy::block7x1_type block7x1_type;
-    
-    typedef typename math_policy::value_traits  value_traits;
-    
-    size_t const N = u.size();
-    
-    if( q.size() != N )
-      throw std::logic_error("position_update(): s has incorrect dimension");
-    
-    // 2009-08-04 Kenny: You are right this seems pointless. In fact I think the correct behaviour should be to get the number 
-    // of blocks from q, then verify if u has the same number of blocks, and lastly if qnew is big enough to hold the results  
-    if( u.size() != N )// 2009-08-03 Sarah: is this not redundant since N = u.size()?
-      throw std::logic_error("position_update(): u has incorrect dimension");
-    
-    if(&q != &qnew)
-    {
-      qnew.resize( N );
-    }
-    
-    float const dt_half = dt / value_traits::two();
-    
-    for(size_t i = 0; i<N; ++i)
+
+    /**
+     * Integrate the position and orientation of a single body.
+     */
+    template<typename math_policy>
+    inline void position_update_block(
+                                      typename math_policy::block7x1_type const & q_b,
+                                      typename math_policy::block6x1_type const & u_b,
+                                      typename math_policy::real_type const & dt,
+                                      typename math_policy::block7x1_type & qnew_b,
+                                      math_policy const & /*tag*/
+                                      )
     {
-      block7x1_type & qnew_b = qnew( i );
-      block7x1_type const& q_b = q( i );
-      block6x1_type const& u_b = u( i );
-      
+      typedef typename math_policy::vector3_type     vector3_type;
+      typedef typename math_policy::quaternion_type  quaternion_type;
+
+      typedef typename math_policy::value_traits  value_traits;
+
+      float const dt_half = dt / value_traits::two();
+
       qnew_b(0) = q_b(0) + dt * u_b(0);
       qnew_b(1) = q_b(1) + dt * u_b(1);
       qnew_b(2) = q_b(2) + dt * u_b(2);
-      
-      
+    
+    
       quaternion_type Q;
       Q.real()    = q_b(3);   
       Q.imag()(0) = q_b(4);   
       Q.imag()(1) = q_b(5);
       Q.imag()(2) = q_b(6);
-      
+    
       vector3_type W;
       W(0) = u_b(3);
       W(1) = u_b(4);
       W(2) = u_b(5);
-      
+    
       bool const finite = true;  // Kenny: Hmm, this might have to be a user-specified paramter?
-      
+    
       if( finite)
       {
         // Do a finitedimensional update instead
@@ -96,15 +82,215 @@ namespace prox
         //--- Just do an infinitesimal rotation update (i.e. a forward Euler step)
         Q = Q + (tiny::prod(W , Q) * dt_half);
       }
-      
+    
       //--- To counter-act numerical problems
       Q = tiny::unit(Q);
-      
+    
       qnew_b(3) = Q.real();
       qnew_b(4) = Q.imag()(0);
       qnew_b(5) = Q.imag()(1);
       qnew_b(6) = Q.imag()(2);
     }
+
+#if defined(__SSE__)
+    /**
+     * Integrate width bodies at a time, each SIMD lane holds one body. The
+     * operations are the same and come in the same order as in
+     * position_update_block, so the results are bit identical. Only the
+     * sine and cosine are done lane by lane using the C library.
+     *
+     * @return   The number of bodies that were integrated, the remaining
+     *           N modulo width bodies are left for the caller.
+     */
+    template<typename L>
+    inline size_t position_update_lanes(
+                                        float const * q
+                                        , float const * u
+                                        , float const & dt
+                                        , float * qnew
+                                        , size_t const & N
+                                        )
+    {
+      using std::cos;
+      using std::sin;
+
+      typedef typename L::op_type op_type;
+
+      size_t const W = L::width;
+
+      float lanes[13][W];
+      float theta[W];
+      float ctheta[W];
+      float stheta[W];
+
+      op_type const zero = L::zero();
+      op_type const one  = L::set( 1.0f );
+      op_type const two  = L::set( 2.0f );
+      op_type const h    = L::set( dt );
+
+      size_t const blocks = N / W;
+
+      for(size_t b = 0u; b < blocks; ++b)
+      {
+        size_t const first = b*W;
+
+        for(size_t l = 0u; l < W; ++l)
+        {
+          float const * q_b = q + 7u*(first + l);
+          float const * u_b = u + 6u*(first + l);
+
+          for(size_t j = 0u; j < 7u; ++j)
+            lanes[j][l] = q_b[j];
+
+          for(size_t j = 0u; j < 6u; ++j)
+            lanes[7u + j][l] = u_b[j];
+        }
+
+        op_type const x  = L::load( lanes[0]  );
+        op_type const y  = L::load( lanes[1]  );
+        op_type const z  = L::load( lanes[2]  );
+        op_type const bs = L::load( lanes[3]  );
+        op_type const b0 = L::load( lanes[4]  );
+        op_type const b1 = L::load( lanes[5]  );
+        op_type const b2 = L::load( lanes[6]  );
+        op_type const vx = L::load( lanes[7]  );
+        op_type const vy = L::load( lanes[8]  );
+        op_type const vz = L::load( lanes[9]  );
+        op_type const wx = L::load( lanes[10] );
+        op_type const wy = L::load( lanes[11] );
+        op_type const wz = L::load( lanes[12] );
+
+        L::store( lanes[0], L::add( x, L::mul( h, vx ) ) );
+        L::store( lanes[1], L::add( y, L::mul( h, vy ) ) );
+        L::store( lanes[2], L::add( z, L::mul( h, vz ) ) );
+
+        // radian = norm(W)*dt and axis = unit(W)
+        op_type const length = L::sqrt( L::add( L::add( L::add( zero, L::mul(wx, wx) ), L::mul(wy, wy) ), L::mul(wz, wz) ) );
+
+        L::store( theta, L::div( L::mul( length, h ), two ) );
+
+        op_type const inv_length = L::div( one, length );
+        op_type const has_length = L::greater_than( length, zero );
+
+        op_type n0 = L::select( has_length, L::mul( wx, inv_length ), wx );
+        op_type n1 = L::select( has_length, L::mul( wy, inv_length ), wy );
+        op_type n2 = L::select( has_length, L::mul( wz, inv_length ), wz );
+
+        // Ru normalizes the axis once more
+        op_type const axis_length = L::sqrt( L::add( L::add( L::add( zero, L::mul(n0, n0) ), L::mul(n1, n1) ), L::mul(n2, n2) ) );
+
+        op_type const inv_axis_length = L::div( one, axis_length );
+        op_type const has_axis_length = L::greater_than( axis_length, zero );
+
+        n0 = L::select( has_axis_length, L::mul( n0, inv_axis_length ), n0 );
+        n1 = L::select( has_axis_length, L::mul( n1, inv_axis_length ), n1 );
+        n2 = L::select( has_axis_length, L::mul( n2, inv_axis_length ), n2 );
+
+        for(size_t l = 0u; l < W; ++l)
+        {
+          ctheta[l] = cos( theta[l] );
+          stheta[l] = sin( theta[l] );
+        }
+
+        op_type const a  = L::load( ctheta );
+        op_type const s  = L::load( stheta );
+        op_type const a0 = L::mul( n0, s );
+        op_type const a1 = L::mul( n1, s );
+        op_type const a2 = L::mul( n2, s );
+
+        // Q = R*Q
+        op_type const dot = L::add( L::add( L::add( zero, L::mul(a0, b0) ), L::mul(a1, b1) ), L::mul(a2, b2) );
+
+        op_type const rs = L::sub( L::mul( a, bs ), dot );
+        op_type const r0 = L::add( L::add( L::mul( a, b0 ), L::mul( a0, bs ) ), L::sub( L::mul( a1, b2 ), L::mul( a2, b1 ) ) );
+        op_type const r1 = L::add( L::add( L::mul( a, b1 ), L::mul( a1, bs ) ), L::sub( L::mul( a2, b0 ), L::mul( a0, b2 ) ) );
+        op_type const r2 = L::add( L::add( L::mul( a, b2 ), L::mul( a2, bs ) ), L::sub( L::mul( a0, b1 ), L::mul( a1, b0 ) ) );
+
+        // Q = unit(Q), quaternions keep the real part last so it is summed last
+        op_type const q_length = L::sqrt( L::add( L::add( L::add( L::add( zero, L::mul(r0, r0) ), L::mul(r1, r1) ), L::mul(r2, r2) ), L::mul(rs, rs) ) );
+        op_type const has_q_length = L::greater_than( q_length, zero );
+
+        L::store( lanes[3], L::select( has_q_length, L::div( rs, q_length ), zero ) );
+        L::store( lanes[4], L::select( has_q_length, L::div( r0, q_length ), zero ) );
+        L::store( lanes[5], L::select( has_q_length, L::div( r1, q_length ), zero ) );
+        L::store( lanes[6], L::select( has_q_length, L::div( r2, q_length ), zero ) );
+
+        for(size_t l = 0u; l < W; ++l)
+        {
+          float * qnew_b = qnew + 7u*(first + l);
+
+          for(size_t j = 0u; j < 7u; ++j)
+            qnew_b[j] = lanes[j][l];
+        }
+      }
+
+      return blocks*W;
+    }
+#endif
+
+    template<typename T>
+    inline size_t position_update_lanes( T const *, T const *, T const &, T *, size_t const & )
+    {
+      return 0u;
+    }
+
+#if defined(__SSE__)
+    inline size_t position_update_lanes( float const * q, float const * u, float const & dt, float * qnew, size_t const & N )
+    {
+      return position_update_lanes<Lanes>( q, u, dt, qnew, N );
+    }
+#endif
+
+  }// namespace detail
+
+  template<typename math_policy>
+  inline void position_update( 
+                              typename math_policy::vector7_type const& q,
+                              typename math_policy::vector6_type const & u,
+                              typename math_policy::real_type const & dt,
+                              typename math_policy::vector7_type & qnew,
+                              math_policy const & tag
+                              ) 
+  {
+    typedef typename math_policy::block6x1_type block6x1_type;
+    typedef typename math_policy::block7x1_type block7x1_type;
+    
+    size_t const N = u.size();
+    
+    if( q.size() != N )
+      throw std::logic_error("position_update(): s has incorrect dimension");
+    
+    // 2009-08-04 Kenny: You are right this seems pointless. In fact I think the correct behaviour should be to get the number 
+    // of blocks from q, then verify if u has the same number of blocks, and lastly if qnew is big enough to hold the results  
+    if( u.size() != N )// 2009-08-03 Sarah: is this not redundant since N = u.size()?
+      throw std::logic_error("position_update(): u has incorrect dimension");
+    
+    if(&q != &qnew)
+    {
+      qnew.resize( N );
+    }
+    
+    if( N == 0u )
+      return;
+
+    // Blocks are stored back to back, so the vectors can be handed to the
+    // SIMD kernel as plain arrays.
+    size_t const done = detail::position_update_lanes(
+                                                      &q(0)(0)
+                                                      , &u(0)(0)
+                                                      , dt
+                                                      , &qnew(0)(0)
+                                                      , N
+                                                      );
+
+    for(size_t i = done; i<N; ++i)
+    {
+      block7x1_type & qnew_b = qnew( i );
+      block7x1_type const& q_b = q( i );
+      block6x1_type const& u_b = u( i );
+
+      detail::position_update_block( q_b, u_b, dt, qnew_b, tag );
+    }
   }
 } // namespace prox
 
@@ -13,9 +13,6 @@
 namespace prox
 {
 
-  template< typename MT >
-  class ForceCallback;           // forward declaration
-  
   template< typename MT >
   class RigidBody
   : public narrow::Object<typename MT::tiny_types >
@@ -31,7 +28,6 @@ namespace prox
     typedef typename MT::value_traits          VT;
     typedef narrow::Object< tiny_types  >      narrow_object;
     typedef broad::Object< T >                 broad_object;
-    typedef ForceCallback<MT>                  force_callback;
     
   protected:
     
@@ -45,9 +41,10 @@ namespace prox
     T            m_mass;          ///< Mass.
     size_t       m_material_idx;  ///< The material index of the rigid body.
     size_t       m_idx;           ///< A body index.
-    std::string  m_name;          ///< A name
-
-    std::vector< force_callback  * >  m_force_callbacks;
+    bool         m_sleeping;      ///< if the body is sleeping or not.
+    bool         m_sleep_refit;   ///< if the BVH of the body must be refitted one last time after falling asleep.
+    size_t       m_sleep_counter; ///< Number of consecutive time steps the body has been at rest.
+    size_t       m_island_idx;    ///< The index of the island the body fell asleep with.
     
   private:
     
@@ -66,8 +63,10 @@ namespace prox
       this->m_mass            = body.m_mass;
       this->m_material_idx    = body.m_material_idx;
       this->m_idx             = body.m_idx;
-      this->m_name            = body.m_name;
-      this->m_force_callbacks = body.m_force_callbacks;
+      this->m_sleeping        = body.m_sleeping;
+      this->m_sleep_refit     = body.m_sleep_refit;
+      this->m_sleep_counter   = body.m_sleep_counter;
+      this->m_island_idx      = body.m_island_idx;
     }
     
   public:
@@ -107,8 +106,10 @@ namespace prox
       this->m_W.clear();
       this->m_material_idx = 0u;
       this->m_idx = 0u;
-      this->m_name = "";
-      this->m_force_callbacks.clear();
+      this->m_sleeping = false;
+      this->m_sleep_refit = false;
+      this->m_sleep_counter = 0u;
+      this->m_island_idx = 0u;
     }
     
     void set_idx( size_t const & idx ) { this->m_idx = idx; }
@@ -123,6 +124,34 @@ namespace prox
     void set_scripted(bool const & scripted) { this->m_scripted = scripted; }
     bool is_scripted() const { return this->m_scripted; }
 
+    /**
+     * Put the body to sleep or wake it up. A sleeping body is treated as
+     * if it was fixed by the time steppers until it is woken again.
+     *
+     * @param sleeping     The new sleep state.
+     * @param island_idx   The index of the island the body falls asleep with,
+     *                     all bodies of an island are woken together.
+     */
+    void set_sleeping(bool const & sleeping, size_t const & island_idx = 0u)
+    {
+      if( sleeping && ! this->m_sleeping )
+        this->m_sleep_refit = true;
+
+      if( ! sleeping )
+        this->m_sleep_counter = 0u;
+
+      this->m_sleeping   = sleeping;
+      this->m_island_idx = island_idx;
+    }
+    bool is_sleeping() const { return this->m_sleeping; }
+    size_t const & get_island_idx() const { return this->m_island_idx; }
+
+    void set_sleep_refit(bool const & refit) { this->m_sleep_refit = refit; }
+    bool needs_sleep_refit() const { return this->m_sleep_refit; }
+
+    void set_sleep_counter(size_t const & counter) { this->m_sleep_counter = counter; }
+    size_t const & get_sleep_counter() const { return this->m_sleep_counter; }
+
     void set_position(V const & r) { this->m_r = r; }
     V const & get_position() const { return this->m_r; }
     
@@ -141,9 +170,6 @@ namespace prox
     void set_inertia_bf(M const & I_BF) { this->m_I_BF = I_BF; }
     M const & get_inertia_bf() const { return this->m_I_BF; }
     
-    void set_name(std::string const & name) { this->m_name = name; }
-    std::string const & get_name() const { return this->m_name; }
-
     /**
      * Broad phase interface implementation, must get information from narrow phase object interface about the geometry. 
      */
@@ -163,9 +189,6 @@ namespace prox
       assert( mz < Mz || !"get_box(): min z must be less than max z");
     }
 
-    std::vector< force_callback  *> const & get_force_callbacks() const { return this->m_force_callbacks; }
-    std::vector< force_callback  *>       & get_force_callbacks()       { return this->m_force_callbacks; }
-
   };
   
 } // namespace prox
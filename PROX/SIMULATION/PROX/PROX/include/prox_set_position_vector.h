@@ -25,7 +25,7 @@ namespace prox
     size_t k = 0u;
     for(body_iterator body = begin; body!=end; ++body, ++k)
     {
-      if( body->is_fixed() || body->is_scripted() )
+      if( body->is_fixed() || body->is_scripted() || body->is_sleeping() )
         continue;
       
       vector3_type r;
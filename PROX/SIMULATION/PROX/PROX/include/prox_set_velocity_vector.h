@@ -26,7 +26,7 @@ namespace prox
     size_t k = 0u;
     for(body_iterator body = begin; body!=end; ++body, ++k)
     {
-      if( body->is_fixed() || body->is_scripted())
+      if( body->is_fixed() || body->is_scripted() || body->is_sleeping() )
         continue;
       
       block6x1_type const& b = u( k );
@@ -0,0 +1,95 @@
+#ifndef PROX_SIMD_LANES_H
+#define PROX_SIMD_LANES_H
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace prox
+{
+  namespace detail
+  {
+
+    /**
+     * SIMD Lanes.
+     * Thin wrappers around the single precision SIMD instructions used by
+     * the integration kernels. A kernel is written once against the
+     * interface below and processes width bodies at a time, one body per
+     * lane. Only operations that are exactly rounded are wrapped, such
+     * that the kernels give the very same results as the scalar code.
+     */
+#if defined(__SSE__)
+    class SSELanes
+    {
+    public:
+
+      typedef __m128 op_type;
+
+      enum { width = 4 };
+
+      static op_type load(float const * ptr)           { return _mm_loadu_ps(ptr);   }
+      static void    store(float * ptr, op_type const & a) { _mm_storeu_ps(ptr, a); }
+      static op_type set(float const & value)          { return _mm_set1_ps(value);  }
+      static op_type zero()                            { return _mm_setzero_ps();    }
+
+      static op_type add(op_type const & a, op_type const & b) { return _mm_add_ps(a, b); }
+      static op_type sub(op_type const & a, op_type const & b) { return _mm_sub_ps(a, b); }
+      static op_type mul(op_type const & a, op_type const & b) { return _mm_mul_ps(a, b); }
+      static op_type div(op_type const & a, op_type const & b) { return _mm_div_ps(a, b); }
+      static op_type sqrt(op_type const & a)                   { return _mm_sqrt_ps(a);   }
+
+      /// All bits set in lanes where a > b, false for NaNs.
+      static op_type greater_than(op_type const & a, op_type const & b) { return _mm_cmpgt_ps(a, b); }
+
+      /// Pick a in lanes where the mask is set and b elsewhere.
+      static op_type select(op_type const & mask, op_type const & a, op_type const & b)
+      {
+        return _mm_or_ps( _mm_and_ps(mask, a), _mm_andnot_ps(mask, b) );
+      }
+    };
+#endif
+
+#if defined(__AVX__)
+    class AVXLanes
+    {
+    public:
+
+      typedef __m256 op_type;
+
+      enum { width = 8 };
+
+      static op_type load(float const * ptr)           { return _mm256_loadu_ps(ptr);   }
+      static void    store(float * ptr, op_type const & a) { _mm256_storeu_ps(ptr, a); }
+      static op_type set(float const & value)          { return _mm256_set1_ps(value);  }
+      static op_type zero()                            { return _mm256_setzero_ps();    }
+
+      static op_type add(op_type const & a, op_type const & b) { return _mm256_add_ps(a, b); }
+      static op_type sub(op_type const & a, op_type const & b) { return _mm256_sub_ps(a, b); }
+      static op_type mul(op_type const & a, op_type const & b) { return _mm256_mul_ps(a, b); }
+      static op_type div(op_type const & a, op_type const & b) { return _mm256_div_ps(a, b); }
+      static op_type sqrt(op_type const & a)                   { return _mm256_sqrt_ps(a);   }
+
+      static op_type greater_than(op_type const & a, op_type const & b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+
+      static op_type select(op_type const & mask, op_type const & a, op_type const & b)
+      {
+        return _mm256_blendv_ps(b, a, mask);
+      }
+    };
+#endif
+
+#if defined(__AVX__)
+    typedef AVXLanes Lanes;    ///< The widest lanes supported by the target.
+#elif defined(__SSE__)
+    typedef SSELanes Lanes;
+#endif
+
+  }// namespace detail
+
+} // namespace prox
+
+// PROX_SIMD_LANES_H
+#endif
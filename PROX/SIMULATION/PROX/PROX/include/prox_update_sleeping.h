@@ -0,0 +1,252 @@
+#ifndef PROX_UPDATE_SLEEPING_H
+#define PROX_UPDATE_SLEEPING_H
+
+#include <prox_rigid_body.h>
+#include <prox_body_store.h>
+#include <prox_contact_point.h>
+#include <prox_contact_islands.h>
+
+#include <steppers/prox_stepper_params.h>
+
+#include <tiny_vector_functions.h>
+
+#include <cassert>
+#include <vector>
+
+namespace prox
+{
+
+  namespace detail
+  {
+
+    /**
+     * Test if a body is moving slowly enough to be considered at rest.
+     */
+    template<typename M>
+    inline bool is_resting( RigidBody<M> const & body, BodyStore<M> const & store, StepperParams<M> const & params )
+    {
+      typedef typename M::vector3_type V;
+
+      V v;
+      V w;
+
+      get_body_velocity( body, body.get_idx(), store, v, w );
+
+      return tiny::norm( v ) < params.sleep_linear_velocity()
+          && tiny::norm( w ) < params.sleep_angular_velocity();
+    }
+
+    /**
+     * Test if a body wakes up the sleeping bodies it touches. Fixed and
+     * sleeping bodies never wake anything while scripted bodies only do so
+     * when they are moving.
+     */
+    template<typename M>
+    inline bool is_waking( RigidBody<M> const & body, BodyStore<M> const & store, StepperParams<M> const & params )
+    {
+      if( body.is_fixed() || body.is_sleeping() )
+        return false;
+
+      if( body.is_scripted() )
+        return ! is_resting( body, store, params );
+
+      return true;
+    }
+
+    /**
+     * Wake up all sleeping bodies of an island.
+     *
+     * @param bodies        All rigid bodies.
+     * @param island_idx    The index of the island to wake up.
+     */
+    template<typename M>
+    inline void wake_island( std::vector< RigidBody<M> > & bodies, size_t const & island_idx )
+    {
+      for(size_t k = 0u; k < bodies.size(); ++k)
+      {
+        if( bodies[k].is_sleeping() && bodies[k].get_island_idx() == island_idx )
+          bodies[k].set_sleeping( false );
+      }
+    }
+
+    /**
+     * Wake up islands that are touched by awake bodies.
+     *
+     * Contacts between two sleeping bodies are never generated, so when an
+     * island is woken its bodies are missing the contacts among themselves
+     * and the caller must run collision detection again.
+     *
+     * @param bodies      All rigid bodies, body indices must be up to date.
+     * @param store       The body store, the woken bodies become active in it.
+     * @param contacts    The current contact points.
+     * @param params      The stepper parameters holding the rest thresholds.
+     *
+     * @return            True if any island was woken up.
+     */
+    template<typename M>
+    inline bool wake_islands(
+                             std::vector< RigidBody<M> > & bodies
+                             , BodyStore<M> & store
+                             , std::vector< ContactPoint<M> > const & contacts
+                             , StepperParams<M> const & params
+                             )
+    {
+      typedef typename std::vector< ContactPoint<M> >::const_iterator contact_iterator;
+
+      // Nothing falls asleep without sleeping, so there is nothing to wake up
+      if( ! params.sleeping() )
+        return false;
+
+      // Only allocated once a sleeping island is found to be woken, most
+      // time steps wake nothing
+      std::vector<bool> wake;
+
+      for(contact_iterator contact = contacts.begin(); contact != contacts.end(); ++contact)
+      {
+        RigidBody<M> const * body_i = contact->get_body_i();
+        RigidBody<M> const * body_j = contact->get_body_j();
+
+        if( body_i->is_sleeping() && is_waking( *body_j, store, params ) )
+        {
+          assert( body_i->get_island_idx() < bodies.size() || !"wake_islands(): island index out of range");
+
+          wake.resize( bodies.size(), false );
+          wake[ body_i->get_island_idx() ] = true;
+        }
+
+        if( body_j->is_sleeping() && is_waking( *body_i, store, params ) )
+        {
+          assert( body_j->get_island_idx() < bodies.size() || !"wake_islands(): island index out of range");
+
+          wake.resize( bodies.size(), false );
+          wake[ body_j->get_island_idx() ] = true;
+        }
+      }
+
+      if( wake.empty() )
+        return false;
+
+      // Sleeping bodies have zero velocities in the store already
+      for(size_t k = 0u; k < bodies.size(); ++k)
+      {
+        if( bodies[k].is_sleeping() && wake[ bodies[k].get_island_idx() ] )
+        {
+          bodies[k].set_sleeping( false );
+
+          store.m_active[k] = 1;
+        }
+      }
+
+      return true;
+    }
+
+    /**
+     * Remove contacts that do not involve any simulated bodies, such as
+     * contacts between a sleeping body and a scripted body at rest. These
+     * contacts can not produce any motion so there is no need to put them
+     * into the Jacobian.
+     */
+    template<typename M>
+    inline void remove_resting_contacts( std::vector< ContactPoint<M> > & contacts )
+    {
+      size_t kept = 0u;
+
+      for(size_t k = 0u; k < contacts.size(); ++k)
+      {
+        if( ! is_simulated( *contacts[k].get_body_i() ) && ! is_simulated( *contacts[k].get_body_j() ) )
+          continue;
+
+        if( kept != k )
+          contacts[kept] = contacts[k];
+
+        ++kept;
+      }
+
+      contacts.resize( kept );
+    }
+
+    /**
+     * Put islands of resting bodies to sleep.
+     *
+     * Simulated bodies that touch each other are grouped into islands. Fixed
+     * and scripted bodies do not join islands, otherwise everything resting on
+     * the ground would be one big island. An island falls asleep when all its
+     * bodies have been at rest for the given number of time steps.
+     *
+     * @param bodies      All rigid bodies, body indices must be up to date.
+     * @param store       The body store holding the velocities of the bodies.
+     * @param contacts    The current contact points.
+     * @param params      The stepper parameters holding the rest thresholds.
+     */
+    template<typename M>
+    inline void sleep_islands(
+                              std::vector< RigidBody<M> > & bodies
+                              , BodyStore<M> & store
+                              , std::vector< ContactPoint<M> > const & contacts
+                              , StepperParams<M> const & params
+                              )
+    {
+      typedef typename M::vector3_type   V;
+      typedef typename M::block6x1_type  B6x1;
+      typedef typename M::value_traits   VT;
+
+      size_t const N = bodies.size();
+
+      assert( store.size() == N || !"sleep_islands(): store has incorrect dimension");
+
+      //--- Count how long bodies have been at rest ----------------------------
+      for(size_t k = 0u; k < N; ++k)
+      {
+        if( ! is_simulated( bodies[k] ) )
+          continue;
+
+        bodies[k].set_sleep_counter( is_resting( bodies[k], store, params ) ? bodies[k].get_sleep_counter() + 1u : 0u );
+      }
+
+      //--- Build islands from contacts between simulated bodies ---------------
+      std::vector<size_t> parent;
+
+      union_islands( N, contacts, parent );
+
+      //--- An island may only sleep if all its bodies are ready ---------------
+      std::vector<bool> ready( N, true );
+
+      for(size_t k = 0u; k < N; ++k)
+      {
+        if( is_simulated( bodies[k] ) && bodies[k].get_sleep_counter() < params.sleep_steps() )
+          ready[ find_island( parent, k ) ] = false;
+      }
+
+      for(size_t k = 0u; k < N; ++k)
+      {
+        if( ! is_simulated( bodies[k] ) )
+          continue;
+
+        size_t const root = find_island( parent, k );
+
+        if( ! ready[ root ] )
+          continue;
+
+        bodies[k].set_sleeping( true, root );
+        bodies[k].set_velocity( V::zero() );
+        bodies[k].set_spin( V::zero() );
+
+        B6x1 & u = store.m_u( k );
+
+        u(0) = VT::zero();
+        u(1) = VT::zero();
+        u(2) = VT::zero();
+        u(3) = VT::zero();
+        u(4) = VT::zero();
+        u(5) = VT::zero();
+
+        store.m_active[k] = 0;
+      }
+    }
+
+  }// end namespace detail
+
+} //namespace prox
+
+// PROX_UPDATE_SLEEPING_H
+#endif
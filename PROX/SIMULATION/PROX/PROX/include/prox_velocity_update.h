@@ -1,42 +1,122 @@
 #ifndef PROX_VELOCITY_UPDATE_H
 #define PROX_VELOCITY_UPDATE_H
 
+#include <prox_simd_lanes.h>
+
+#include <cassert>
+
 namespace prox
 {
 
+  namespace detail
+  {
+
+    /**
+     * Compute out = a + b (+ c) over plain arrays of n values, width values
+     * at a time. The additions come in the same order as in sparse::add so
+     * the results are bit identical.
+     *
+     * @return   True if the sum was computed, false if there is no SIMD
+     *           kernel for the value type and the caller must do it.
+     */
+    template<typename T>
+    inline bool velocity_update_lanes( T const *, T const *, T const *, T *, size_t const & )
+    {
+      return false;
+    }
+
+    template<typename T>
+    inline bool velocity_update_lanes( T const *, T const *, T *, size_t const & )
+    {
+      return false;
+    }
+
+#if defined(__SSE__)
+    inline bool velocity_update_lanes( float const * a, float const * b, float const * c, float * out, size_t const & n )
+    {
+      typedef Lanes L;
+
+      size_t const W = L::width;
+      size_t const m = n - n % W;
+
+      for(size_t i = 0u; i < m; i += W)
+        L::store( out + i, L::add( L::add( L::load( a + i ), L::load( b + i ) ), L::load( c + i ) ) );
+
+      for(size_t i = m; i < n; ++i)
+        out[i] = a[i] + b[i] + c[i];
+
+      return true;
+    }
+
+    inline bool velocity_update_lanes( float const * a, float const * b, float * out, size_t const & n )
+    {
+      typedef Lanes L;
+
+      size_t const W = L::width;
+      size_t const m = n - n % W;
+
+      for(size_t i = 0u; i < m; i += W)
+        L::store( out + i, L::add( L::load( a + i ), L::load( b + i ) ) );
+
+      for(size_t i = m; i < n; ++i)
+        out[i] = a[i] + b[i];
+
+      return true;
+    }
+#endif
+
+  }// namespace detail
+
   template<typename math_policy>
-  inline void velocity_update( 
+  inline void velocity_update(
     typename math_policy::vector6_type const& u,
     typename math_policy::vector6_type const& Wdth,
     typename math_policy::vector6_type const& fc,
     typename math_policy::vector6_type & unew,
-    math_policy const & /*math_policy_tag*/ 
-    ) 
+    math_policy const & /*math_policy_tag*/
+    )
   {
-    if( &u != &unew ) 
+    if( &u != &unew )
     {
       unew.resize( u.size() );
     }
 
+    if( u.size() == 0u )
+      return;
+
+    assert( Wdth.size() == u.size() || !"velocity_update(): Wdth has incorrect dimension");
+    assert( fc.size()   == u.size() || !"velocity_update(): fc has incorrect dimension");
+
+    if( detail::velocity_update_lanes( &u(0)(0), &Wdth(0)(0), &fc(0)(0), &unew(0)(0), 6u*u.size() ) )
+      return;
+
     math_policy::compute_sum( u, Wdth, fc, unew );
   }
 
   template<typename math_policy>
-  inline void velocity_update( 
+  inline void velocity_update(
     typename math_policy::vector6_type const& u,
     typename math_policy::vector6_type const& Wdth,
     typename math_policy::vector6_type & unew,
-    math_policy const & /*math_policy_tag*/ 
-    ) 
+    math_policy const & /*math_policy_tag*/
+    )
   {
-    if( &u != &unew ) 
+    if( &u != &unew )
     {
       unew.resize( u.size( ) );
     }
 
+    if( u.size() == 0u )
+      return;
+
+    assert( Wdth.size() == u.size() || !"velocity_update(): Wdth has incorrect dimension");
+
+    if( detail::velocity_update_lanes( &u(0)(0), &Wdth(0)(0), &unew(0)(0), 6u*u.size() ) )
+      return;
+
     math_policy::compute_sum( u, Wdth, unew );
   }
-  
+
 } // namespace prox
 
 // PROX_VELOCITY_UPDATE_H
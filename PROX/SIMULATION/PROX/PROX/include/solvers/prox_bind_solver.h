@@ -7,6 +7,10 @@
 
 #include <solvers/prox_jacobi_solver.h>
 #include <solvers/prox_gauss_seidel_solver.h>
+#include <solvers/prox_colored_gauss_seidel_solver.h>
+
+#include <solvers/sub/prox_bind_normal_sub_solver.h>
+#include <solvers/sub/prox_bind_friction_sub_solver.h>
 
 #include <util_log.h>
 
@@ -31,8 +35,6 @@ namespace prox
                                   , typename M::vector4_type const &
                                   , typename M::vector4_type &
                                   , RStrategy<M> const &
-                                  , NormalSubSolver<typename M::real_type> const &
-                                  , FrictionSubSolver<typename M::real_type> const &
                                   , SolverParams<M> const &
                                   , M const & tag 
                                   );
@@ -60,45 +62,170 @@ namespace prox
                     , typename M::vector4_type const & mu
                     , typename M::vector4_type & lambda
                     , RStrategy<M> const & strategy
-                    , NormalSubSolver<typename M::real_type> const & normal_solver
-                    , FrictionSubSolver<typename M::real_type> const & friction_solver
                     , SolverParams<M> const & params
-                    , M const & tag
+                    , M const & /*tag*/
                     ) const
     {
       assert( this->m_solver || !"SolverBinder(): solver was null");
       
-      this->m_solver( J, WJT, b, mu, lambda, strategy, normal_solver, friction_solver, params, M() );
+      this->m_solver( J, WJT, b, mu, lambda, strategy, params, M() );
     }
     
   };
   
+  namespace detail
+  {
+
+    /**
+     * Solver instantiations with the sub solvers given as template
+     * arguments. These are the functions the binder points to, so the only
+     * indirect call is the one into the solver itself.
+     */
+    template<typename M, typename N, typename F>
+    inline void jacobi_kernel(
+                              typename M::compressed4x6_type const & J
+                              , typename M::compressed6x4_type const & WJT
+                              , typename M::vector4_type const & b
+                              , typename M::vector4_type const & mu
+                              , typename M::vector4_type & lambda
+                              , RStrategy<M> const & strategy
+                              , SolverParams<M> const & params
+                              , M const & tag
+                              )
+    {
+      jacobi_solver<M>( J, WJT, b, mu, lambda, strategy, N(), F(), params, tag );
+    }
+
+    template<typename M, typename N, typename F>
+    inline void gauss_seidel_kernel(
+                                    typename M::compressed4x6_type const & J
+                                    , typename M::compressed6x4_type const & WJT
+                                    , typename M::vector4_type const & b
+                                    , typename M::vector4_type const & mu
+                                    , typename M::vector4_type & lambda
+                                    , RStrategy<M> const & strategy
+                                    , SolverParams<M> const & params
+                                    , M const & tag
+                                    )
+    {
+      gauss_seidel_solver<M>( J, WJT, b, mu, lambda, strategy, N(), F(), params, tag );
+    }
+
+    template<typename M, typename N, typename F>
+    inline void colored_gauss_seidel_kernel(
+                                            typename M::compressed4x6_type const & J
+                                            , typename M::compressed6x4_type const & WJT
+                                            , typename M::vector4_type const & b
+                                            , typename M::vector4_type const & mu
+                                            , typename M::vector4_type & lambda
+                                            , RStrategy<M> const & strategy
+                                            , SolverParams<M> const & params
+                                            , M const & tag
+                                            )
+    {
+      colored_gauss_seidel_solver<M>( J, WJT, b, mu, lambda, strategy, N(), F(), params, tag );
+    }
+
+    template<typename M, typename N, typename F>
+    inline typename SolverBinder<M>::func_type * get_solver_kernel( solver_type const & type )
+    {
+      switch( type )
+      {
+        case prox::jacobi:               return &jacobi_kernel<M,N,F>;
+        case prox::gauss_seidel:         return &gauss_seidel_kernel<M,N,F>;
+        case prox::colored_gauss_seidel: return &colored_gauss_seidel_kernel<M,N,F>;
+        default:
+          assert(!"get_solver_kernel(): unknown solver type");
+          break;
+      };
+
+      return 0;
+    }
+
+    template<typename M, typename N>
+    inline typename SolverBinder<M>::func_type * get_solver_kernel(
+                                                                  solver_type const & type
+                                                                  , friction_sub_solver_type const & friction
+                                                                  )
+    {
+      typedef typename M::real_type T;
+
+      switch( friction )
+      {
+        case prox::analytical_sphere:    return get_solver_kernel< M, N, FrictionSubSolverKernel< T, &analytical_sphere<T>    > >( type );
+        case prox::analytical_ellipsoid: return get_solver_kernel< M, N, FrictionSubSolverKernel< T, &analytical_ellipsoid<T> > >( type );
+        case prox::numerical_ellipsoid:  return get_solver_kernel< M, N, FrictionSubSolverKernel< T, &numerical_ellipsoid<T>  > >( type );
+        case prox::box_model:            return get_solver_kernel< M, N, FrictionSubSolverKernel< T, &box_model<T>            > >( type );
+        case prox::friction_origin:      return get_solver_kernel< M, N, FrictionSubSolverKernel< T, &origin3D<T>             > >( type );
+        case prox::friction_infinity:    return get_solver_kernel< M, N, FrictionSubSolverKernel< T, &infinity3D<T>           > >( type );
+        default:
+          assert(!"get_solver_kernel(): unknown friction solver type");
+          break;
+      };
+
+      return 0;
+    }
+
+    template<typename M>
+    inline typename SolverBinder<M>::func_type * get_solver_kernel(
+                                                                  solver_type const & type
+                                                                  , normal_sub_solver_type const & normal
+                                                                  , friction_sub_solver_type const & friction
+                                                                  )
+    {
+      typedef typename M::real_type T;
+
+      switch( normal )
+      {
+        case prox::nonnegative:     return get_solver_kernel< M, NormalSubSolverKernel< T, &nonnegative<T> > >( type, friction );
+        case prox::normal_origin:   return get_solver_kernel< M, NormalSubSolverKernel< T, &origin1D<T>    > >( type, friction );
+        case prox::normal_infinity: return get_solver_kernel< M, NormalSubSolverKernel< T, &infinity1D<T>  > >( type, friction );
+        default:
+          assert(!"get_solver_kernel(): unknown normal solver type");
+          break;
+      };
+
+      return 0;
+    }
+
+  }// end namespace detail
+
   /**
-   *
-   */     
+   * Bind a solver together with its normal and friction sub solvers. Every
+   * combination is a separate instantiation of the solver, so the sub
+   * solvers are called directly from the loop over the contacts.
+   */
   template<typename M>
-  inline SolverBinder<M> bind_solver( solver_type const & type )
+  inline SolverBinder<M> bind_solver(
+                                     solver_type const & type
+                                     , normal_sub_solver_type const & normal
+                                     , friction_sub_solver_type const & friction
+                                     )
   {
-    util::Log logging;
+    util::LogDebug logging;
 
     switch( type )
     {
       case jacobi:
         logging << "bind_solver(): using jacobi solver"<< util::Log::newline();
-        return SolverBinder<M>( &jacobi_solver<M> );
-        
+        break;
+
       case gauss_seidel:
         logging << "bind_solver(): using gauss seidel solver"<< util::Log::newline();
-        return SolverBinder<M>( &gauss_seidel_solver<M> );
-        
+        break;
+
+      case colored_gauss_seidel:
+        logging << "bind_solver(): using colored gauss seidel solver"<< util::Log::newline();
+        break;
+
       default:
         assert(!"bind_solver(): unknown solver type");
-        break;
+        return SolverBinder<M>();
     };
-    
-    return SolverBinder<M>();
+
+    return SolverBinder<M>( detail::get_solver_kernel<M>( type, normal, friction ) );
   }
-  
+
 } //namespace prox
 
 // PROX_BIND_SOLVER_H
@@ -0,0 +1,408 @@
+#ifndef PROX_COLORED_GAUSS_SEIDEL_SOLVER_H
+#define PROX_COLORED_GAUSS_SEIDEL_SOLVER_H
+
+#include <solvers/sub/prox_normal_sub_solver.h>
+#include <solvers/sub/prox_friction_sub_solver.h>
+#include <solvers/strategies/prox_R_strategy.h>
+
+#include <solvers/prox_solver_params.h>
+
+#include <util_thread_pool.h>
+#include <util_profiling.h>
+#include <util_log.h>
+
+#include <algorithm>  // needed for std::min
+#include <cassert>
+#include <vector>
+
+namespace prox
+{
+
+  namespace detail
+  {
+
+    /**
+     * Find the columns of the Jacobian that belong to dynamic bodies. Fixed,
+     * scripted and sleeping bodies have a zero inverse mass, so their rows
+     * of W J^T are zero and their part of w never changes.
+     *
+     * @param WJT       The W J^T matrix.
+     * @param dynamic   Upon return dynamic[j] is true if column j of J belongs to a dynamic body.
+     */
+    template<typename M>
+    inline void get_dynamic_columns(
+                                    typename M::compressed6x4_type const & WJT
+                                    , std::vector<bool> & dynamic
+                                    )
+    {
+      typedef typename M::block6x4_type  B6x4;
+      typedef typename M::value_traits   VT;
+
+      dynamic.assign( WJT.nrows(), false );
+
+      for(size_t j = 0u; j < WJT.top_non_zero_row(); ++j)
+      {
+        for(size_t idx = WJT.row_idx(j); idx < WJT.row_idx(j+1u) && !dynamic[j]; ++idx)
+        {
+          B6x4 const & block = WJT[idx];
+
+          for(size_t e = 0u; e < B6x4::size(); ++e)
+          {
+            if( block[e] != VT::zero() )
+            {
+              dynamic[j] = true;
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * Locate the W J^T block that goes with each block of the Jacobian, so
+     * w can be updated without searching for the blocks.
+     *
+     * @param wjt_idx   Upon return the block J[idx] is the transpose of the block WJT[wjt_idx[idx]] up to the mass.
+     */
+    template<typename M>
+    inline void get_transposed_indices(
+                                       typename M::compressed4x6_type const & J
+                                       , typename M::compressed6x4_type const & WJT
+                                       , std::vector<size_t> & wjt_idx
+                                       )
+    {
+      wjt_idx.assign( J.size(), J.size() );
+
+      for(size_t j = 0u; j < WJT.top_non_zero_row(); ++j)
+      {
+        for(size_t idx = WJT.row_idx(j); idx < WJT.row_idx(j+1u); ++idx)
+        {
+          size_t const k = WJT.col_of_idx(idx);
+
+          for(size_t jdx = J.row_idx(k); jdx < J.row_idx(k+1u); ++jdx)
+          {
+            if( J.col_of_idx(jdx) == j )
+            {
+              wjt_idx[jdx] = idx;
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * Greedy coloring of the contacts. Two contacts that share a dynamic
+     * body never get the same color, so all contacts of one color can be
+     * solved at the same time without touching the same part of w.
+     * Contacts only sharing fixed bodies do not conflict.
+     *
+     * @param J         The Jacobian matrix.
+     * @param dynamic   Tells which columns of J belong to dynamic bodies.
+     * @param colors    Upon return colors[c] holds the indices of the contacts with color c in increasing order.
+     */
+    template<typename M>
+    inline void compute_contact_colors(
+                                       typename M::compressed4x6_type const & J
+                                       , std::vector<bool> const & dynamic
+                                       , std::vector< std::vector<size_t> > & colors
+                                       )
+    {
+      colors.clear();
+
+      std::vector< std::vector<size_t> > body_colors( J.ncols() ); // Colors already used by the contacts of a body
+      std::vector<bool>                  used;
+
+      for(size_t k = 0u; k < J.nrows(); ++k)
+      {
+        used.assign( colors.size(), false );
+
+        for(size_t idx = J.row_idx(k); idx < J.row_idx(k+1u); ++idx)
+        {
+          size_t const j = J.col_of_idx(idx);
+
+          if( !dynamic[j] )
+            continue;
+
+          for(size_t i = 0u; i < body_colors[j].size(); ++i)
+            used[ body_colors[j][i] ] = true;
+        }
+
+        size_t color = 0u;
+
+        while( color < colors.size() && used[color] )
+          ++color;
+
+        if( color == colors.size() )
+          colors.push_back( std::vector<size_t>() );
+
+        colors[color].push_back( k );
+
+        for(size_t idx = J.row_idx(k); idx < J.row_idx(k+1u); ++idx)
+        {
+          size_t const j = J.col_of_idx(idx);
+
+          if( dynamic[j] )
+            body_colors[j].push_back( color );
+        }
+      }
+    }
+
+  }// end namespace detail
+
+  /**
+   * This solver is a Gauss-Seidel solver where the contacts are visited
+   * one color at a time. Contacts of the same color do not share any
+   * dynamic bodies, so they are independent of each other and are solved
+   * in parallel on the thread pool. Contacts of later colors see the
+   * updated results of earlier colors, just like in the sequential
+   * Gauss-Seidel solver. Convergence, divergence roll-back and the
+   * R-factor strategy are handled the same way as in gauss_seidel_solver.
+   *
+   * The sub solvers are template arguments, such that solvers bound at
+   * compile time are inlined into the loop over the contacts.
+   *
+   * @tparam N   The normal sub solver functor type.
+   * @tparam F   The friction sub solver functor type.
+   */
+  template< typename M, typename N, typename F >
+  inline void colored_gauss_seidel_solver(
+                                          typename M::compressed4x6_type const& J
+                                          , typename M::compressed6x4_type const& WJT
+                                          , typename M::vector4_type const& b
+                                          , typename M::vector4_type const& mu
+                                          , typename M::vector4_type & lambda
+                                          , RStrategy<M> const & strategy
+                                          , N const & normal_solver
+                                          , F const & friction_solver
+                                          , SolverParams<M> const& params
+                                          , M const & tag
+                                          )
+  {
+    if( params.profiling() )
+    {
+      RECORD_VECTOR_NEW("convergence");
+      RECORD_VECTOR_NEW("rfactor");
+    }
+
+    typedef typename M::block4x1_type       B4x1;
+    typedef typename M::vector4_type        V4;
+    typedef typename M::vector6_type        V6;
+    typedef typename M::diagonal4x4_type    D4x4;
+    typedef typename M::real_type           T;
+    typedef typename M::value_traits        VT;
+
+    size_t const K = J.nrows( ); // Number of blocks
+
+    size_t abs_conv_in_iteration = 0u; //used for profiling, to record in what iteration we found absolute convergence
+    size_t rel_conv_in_iteration = 0u; //used for profiling, to record in what iteration we found relative convergence
+    size_t count_divergence      = 0u; //used for profiling, to record how many times we have discovered divergence
+
+    if( !params.use_warm_starting() )
+    {
+      lambda.resize( K );
+    }
+
+    if( K == 0u )
+      return;
+
+    if( params.profiling() )
+      START_TIMER("solver_time");
+
+    V4 x;           // Solution iterates, separate from lambda to be able to roll back
+
+    x.resize( K );
+
+    if( params.use_warm_starting() )
+    {
+      x = lambda;   // Only in case of warm-starting
+    }
+
+    V4 residual;
+    residual.resize( K );
+
+    T last_residual_norm = VT::infinity();    // Used to detect divergence.
+
+    D4x4 R;
+    D4x4 nu;
+
+    strategy(J, WJT, R, nu );
+
+    V6 w;
+    w.resize( J.ncols() );
+
+    if( params.use_warm_starting() )
+    {
+      sparse::prod( WJT, x, w );
+    }
+
+    T residual_norm;
+
+    std::vector<bool>                  dynamic;
+    std::vector<size_t>                wjt_idx;
+    std::vector< std::vector<size_t> > colors;
+
+    detail::get_dynamic_columns<M>( WJT, dynamic );
+    detail::get_transposed_indices<M>( J, WJT, wjt_idx );
+    detail::compute_contact_colors<M>( J, dynamic, colors );
+
+    if( params.profiling() )
+      RECORD("solver_colors", colors.size() );
+
+    util::ThreadPool & pool = util::ThreadPool::get_instance();
+
+    size_t const chunk_size = 16u;  // Contacts per task, a single contact is too little work to pay for a task
+
+    //--- Colored Gauss--Seidel loops
+    for(size_t iteration = 0u; iteration < params.max_iterations(); ++iteration )
+    {
+      if( params.profiling() )
+        RECORD_VECTOR_PUSH("rfactor", R(1)(1,1));
+
+      //--- Loop over colors
+      for(size_t c = 0u; c < colors.size(); ++c)
+      {
+        std::vector<size_t> const & contacts = colors[c];
+
+        size_t const chunks = (contacts.size() + chunk_size - 1u) / chunk_size;
+
+        auto sweep = [&] (size_t const & chunk, size_t const & /*thread_idx*/)
+        {
+          B4x1 z_k(     VT::zero() );
+          B4x1 delta_x( VT::zero() );
+
+          size_t const first = chunk*chunk_size;
+          size_t const last  = std::min( first + chunk_size, contacts.size() );
+
+          //--- Loop over contact points of the chunk
+          for(size_t i = first; i < last; ++i)
+          {
+            size_t const k = contacts[i];
+
+            B4x1 const &  mu_k    = mu(k);
+            B4x1       &  x_k     = x(k);
+            delta_x               = x(k); // save old value
+
+            M::compute_z_k( x_k, w, R(k), J, b(k), z_k, k );
+
+            size_t const n   = 0u;
+            size_t const s   = 1u;
+            size_t const t   = 2u;
+            size_t const tau = 3u;
+
+            //--- Solve lambda_n = prox_{R^+}( lambda_n - r (A lambda_n + b))
+            normal_solver( z_k(n), x_k(n) );
+
+            //--- Solve lambda_f = prox_C( lambda_f - r (A lambda_f + b))
+            friction_solver(z_k(s), z_k(t), z_k(tau), mu_k(s), mu_k(t), mu_k(tau), x_k(n), x_k(s), x_k(t), x_k(tau));
+
+            //--- delta_x = x_k_new - x_k_old (saved in delta_x)
+            sparse::sub(x_k, delta_x, delta_x);
+
+            //--- Updating w, only the parts of w that belong to dynamic bodies
+            //--- change, so other contacts of this color are not affected
+            for(size_t idx = J.row_idx(k); idx < J.row_idx(k+1u); ++idx)
+            {
+              size_t const j = J.col_of_idx(idx);
+
+              if( dynamic[j] )
+                sparse::prod( WJT[ wjt_idx[idx] ], delta_x, w(j) );
+            }
+          }
+        };
+
+        if( params.use_thread_pool() )
+        {
+          pool.parallel_for( chunks, sweep );
+        }
+        else
+        {
+          for(size_t chunk = 0u; chunk < chunks; ++chunk)
+            sweep( chunk, 0u );
+        }
+      }
+
+      //--- compute the residual, residual = lambda^k - lambda^(k+1)
+      sparse::sub(lambda, x, residual);
+      residual_norm = M::compute_norm_inf( residual );
+
+      if( params.profiling() )
+        RECORD_VECTOR_PUSH("convergence", residual_norm );
+
+      if( residual_norm < params.absolute_tolerance() )
+      {
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
+
+          logging << "colored_gauss_seidel_solver(): absolute convergence in "
+                  << iteration
+                  << " iterations |residual| = "
+                  << residual_norm
+                  << util::Log::newline();
+        }
+
+        abs_conv_in_iteration = iteration;
+
+        break;
+      }
+
+      if( fabs(residual_norm-last_residual_norm) < params.relative_tolerance()*last_residual_norm )
+      {
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
+
+          logging << "colored_gauss_seidel_solver(): relative convergence in "
+                  << iteration
+                  << " iterations"
+                  << util::Log::newline();
+        }
+
+        rel_conv_in_iteration = iteration;
+
+        break;
+      }
+
+      if( residual_norm > last_residual_norm)
+      {
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
+
+          logging << "colored_gauss_seidel_solver(): divergence in "
+                  << iteration
+                  << " iterations. |residual| = "
+                  << residual_norm
+                  << util::Log::newline();
+        }
+
+        // Reduce R-factor and roll-back solution to last known good iterate!
+        // The sweeps keep w = W J^T x up to date, so w must be rolled back too.
+        M::compute_prod( nu, R );
+        x = lambda;
+        sparse::prod( WJT, x, w, true );
+        ++count_divergence;
+      }
+      else
+      {
+        // save x to lambda.
+        last_residual_norm = residual_norm;
+        lambda = x;
+      }
+    }
+    lambda = x;
+
+    if( params.profiling() )
+    {
+      RECORD("solver_abs_conv_in",   abs_conv_in_iteration);
+      RECORD("solver_rel_conv_in",   rel_conv_in_iteration);
+      RECORD("solver_div_count",     count_divergence     );
+      STOP_TIMER("solver_time");
+    }
+  }
+
+} //namespace prox
+
+// PROX_COLORED_GAUSS_SEIDEL_SOLVER_H
+#endif
@@ -18,8 +18,14 @@ namespace prox
    * of the contact points. The system of constraints is solved using a
    * factorized Gauss-Seidel approach, where each constraint is solved in
    * turn using the updated results from previously solved constraints.
+   *
+   * The sub solvers are template arguments, such that solvers bound at
+   * compile time are inlined into the loop over the contacts.
+   *
+   * @tparam N   The normal sub solver functor type.
+   * @tparam F   The friction sub solver functor type.
    */
-  template< typename M >
+  template< typename M, typename N, typename F >
   inline void gauss_seidel_solver(
                                   typename M::compressed4x6_type const& J
                                   , typename M::compressed6x4_type const& WJT
@@ -27,23 +33,29 @@ namespace prox
                                   , typename M::vector4_type const& mu
                                   , typename M::vector4_type & lambda
                                   , RStrategy<M> const & strategy
-                                  , NormalSubSolver<typename M::real_type> const & normal_solver
-                                  , FrictionSubSolver<typename M::real_type> const & friction_solver
+                                  , N const & normal_solver
+                                  , F const & friction_solver
                                   , SolverParams<M> const& params
                                   , M const & tag
                                   )
   {
-    RECORD_VECTOR_NEW("convergence");
-    RECORD_VECTOR_NEW("rfactor");
+    if( params.profiling() )
+    {
+      RECORD_VECTOR_NEW("convergence");
+      RECORD_VECTOR_NEW("rfactor");
+    }
 
     typedef typename M::block4x1_type       B4x1;
     typedef typename M::vector4_type        V4;
     typedef typename M::vector6_type        V6;
     typedef typename M::diagonal4x4_type    D4x4;
+    typedef typename M::two_column4x6_type  TC4x6;
+    typedef typename M::two_column6x4_type  TC6x4;
     typedef typename M::real_type           T;
     typedef typename M::value_traits        VT;
     
-    START_TIMER("solver_time");
+    if( params.profiling() )
+      START_TIMER("solver_time");
     
     size_t const K = J.nrows( ); // Number of blocks
 
@@ -80,9 +92,24 @@ namespace prox
 
     strategy(J, WJT, R, nu );
 
+    // Keep the two blocks of each contact next to each other, the sweeps
+    // below then never have to search J or W J^T for a block.
+    TC4x6 J_rows;
+    TC6x4 WJT_columns;
+
+    M::compute_two_column( J, WJT, J_rows, WJT_columns );
+
     V6 w;
     w.resize( J.ncols() );// what is in w???
-    
+
+    // w = W J^T x is updated incrementally in the loop below, so it must
+    // agree with the initial iterate. It was left at zero which made warm
+    // starting diverge.
+    if( params.use_warm_starting() )
+    {
+      sparse::prod( WJT, x, w );
+    }
+
     T residual_norm;
     
     B4x1 z_k(     VT::zero() );
@@ -91,7 +118,8 @@ namespace prox
     //--- Gauss--Seidel loops
     for(size_t iteration = 0u; iteration < params.max_iterations(); ++iteration )
     {
-      RECORD_VECTOR_PUSH("rfactor", R(1)(1,1));
+      if( params.profiling() )
+        RECORD_VECTOR_PUSH("rfactor", R(1)(1,1));
 
       //--- Loop over contact points
       for(size_t k = 0u; k < K; ++k)
@@ -101,7 +129,7 @@ namespace prox
         delta_x               = x(k); // save old value
 
         
-        M::compute_z_k( x_k, w, R(k), J, b(k), z_k, k );
+        M::compute_z_k( x_k, w, R(k), J_rows, b(k), z_k, k );
         
         size_t const n   = 0u;
         size_t const s   = 1u;
@@ -117,25 +145,29 @@ namespace prox
         //--- delta_x = x_k_new - x_k_old (saved in delta_x)
         sparse::sub(x_k, delta_x, delta_x);
         
-        //--- Updating w, math_policy::update_w(WJT, J, delta_x, k, w);
-        sparse::column_prod( WJT, J, delta_x, w, k);
+        //--- Updating w, w += (W J^T)_k delta_x
+        sparse::column_prod( WJT_columns, delta_x, w, k);
       }
       
       //--- compute the residual, residual = lambda^k - lambda^(k+1)
       sparse::sub(lambda, x, residual);
       residual_norm = M::compute_norm_inf( residual );
       
-      RECORD_VECTOR_PUSH("convergence", residual_norm );
+      if( params.profiling() )
+        RECORD_VECTOR_PUSH("convergence", residual_norm );
 
       if( residual_norm < params.absolute_tolerance() )
       {
-        util::Log logging;
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
 
-        logging << "gauss_seidel_solver(): absolute convergence in "
-                << iteration
-                << " iterations |residual| = "
-                << residual_norm
-                << util::Log::newline();
+          logging << "gauss_seidel_solver(): absolute convergence in "
+                  << iteration
+                  << " iterations |residual| = "
+                  << residual_norm
+                  << util::Log::newline();
+        }
 
         abs_conv_in_iteration = iteration;
 
@@ -144,12 +176,15 @@ namespace prox
       
       if( fabs(residual_norm-last_residual_norm) < params.relative_tolerance()*last_residual_norm )
       {
-        util::Log logging;
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
 
-        logging << "gauss_seidel_solver(): relative convergence in "
-                << iteration
-                << " iterations"
-                << util::Log::newline();
+          logging << "gauss_seidel_solver(): relative convergence in "
+                  << iteration
+                  << " iterations"
+                  << util::Log::newline();
+        }
 
         rel_conv_in_iteration = iteration;
 
@@ -158,17 +193,22 @@ namespace prox
       
       if( residual_norm > last_residual_norm)
       {
-        util::Log logging;
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
 
-        logging << "gauss_seidel_solver(): divergence in "
-                << iteration
-                << " iterations. |residual| = "
-                << residual_norm
-                << util::Log::newline();
+          logging << "gauss_seidel_solver(): divergence in "
+                  << iteration
+                  << " iterations. |residual| = "
+                  << residual_norm
+                  << util::Log::newline();
+        }
 
         // Reduce R-factor and roll-back solution to last known good iterate!
+        // The sweeps keep w = W J^T x up to date, so w must be rolled back too.
         M::compute_prod( nu, R );
         x = lambda;
+        sparse::prod( WJT, x, w, true );
         ++count_divergence;
       }
       else
@@ -180,10 +220,13 @@ namespace prox
     }
     lambda = x;
  
-    RECORD("solver_abs_conv_in",   abs_conv_in_iteration);
-    RECORD("solver_rel_conv_in",   rel_conv_in_iteration);
-    RECORD("solver_div_count",     count_divergence     );
-    STOP_TIMER("solver_time");
+    if( params.profiling() )
+    {
+      RECORD("solver_abs_conv_in",   abs_conv_in_iteration);
+      RECORD("solver_rel_conv_in",   rel_conv_in_iteration);
+      RECORD("solver_div_count",     count_divergence     );
+      STOP_TIMER("solver_time");
+    }
   }
   
 } //namespace prox
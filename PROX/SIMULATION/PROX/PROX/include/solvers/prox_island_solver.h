@@ -0,0 +1,222 @@
+#ifndef PROX_ISLAND_SOLVER_H
+#define PROX_ISLAND_SOLVER_H
+
+#include <prox_contact_islands.h>
+
+#include <solvers/prox_solver.h>
+#include <solvers/prox_solver_params.h>
+
+#include <util_thread_pool.h>
+#include <util_profiling.h>
+
+#include <algorithm>  // needed for std::swap
+#include <cassert>
+#include <vector>
+
+namespace prox
+{
+
+  namespace detail
+  {
+
+    /**
+     * Extract the sub problem of a single contact island.
+     *
+     * The solver kernels expect exactly two blocks in every row of the
+     * Jacobian, so all bodies that are not in the island (fixed, scripted
+     * and sleeping bodies) share the first column of the island Jacobian.
+     * Their inverse mass is zero, so the shared column does not couple any
+     * contacts. Island bodies use the columns after it.
+     *
+     * @param island          The contact island.
+     * @param local_idx       Maps a global body index to the column of the body in its island.
+     * @param UNSET           The local index of bodies that are not in any island.
+     * @param warm_starting   If true the current contact forces are copied into lambda_i.
+     */
+    template<typename M>
+    inline void get_island_problem(
+                                   ContactIsland const & island
+                                   , std::vector<size_t> const & local_idx
+                                   , size_t const & UNSET
+                                   , typename M::compressed4x6_type const & J
+                                   , typename M::diagonal6x6_type const & W
+                                   , typename M::vector4_type const & b
+                                   , typename M::vector4_type const & mu
+                                   , typename M::vector4_type const & lambda
+                                   , bool const & warm_starting
+                                   , typename M::compressed4x6_type & J_i
+                                   , typename M::compressed6x4_type & WJT_i
+                                   , typename M::vector4_type & b_i
+                                   , typename M::vector4_type & mu_i
+                                   , typename M::vector4_type & lambda_i
+                                   )
+    {
+      typedef typename M::diagonal6x6_type D6x6;
+
+      size_t const K_i = island.m_contacts.size();
+      size_t const N_i = island.m_bodies.size() + 1u;
+
+      D6x6 W_i;
+
+      W_i.resize( N_i );   // The shared column keeps a zero block
+
+      for(size_t l = 1u; l < N_i; ++l)
+        W_i( l ) = W( island.m_bodies[l-1u] );
+
+      J_i.resize( K_i, N_i, 2u*K_i );
+      b_i.resize( K_i );
+      mu_i.resize( K_i );
+      lambda_i.resize( K_i );
+
+      for(size_t r = 0u; r < K_i; ++r)
+      {
+        size_t const k = island.m_contacts[r];
+
+        assert( J.row_idx(k+1u) - J.row_idx(k) == 2u || !"get_island_problem(): Jacobian row must have two blocks");
+
+        size_t first  = J.row_idx(k);
+        size_t second = first + 1u;
+
+        size_t col_first  = local_idx[ J.col_of_idx(first)  ];
+        size_t col_second = local_idx[ J.col_of_idx(second) ];
+
+        col_first  = (col_first  == UNSET) ? 0u : col_first  + 1u;
+        col_second = (col_second == UNSET) ? 0u : col_second + 1u;
+
+        assert( col_first != col_second || !"get_island_problem(): contact has no island body");
+
+        // Blocks must be inserted in increasing column order
+        if( col_second < col_first )
+        {
+          std::swap( first, second );
+          std::swap( col_first, col_second );
+        }
+
+        J_i( r, col_first )  = J[first];
+        J_i( r, col_second ) = J[second];
+
+        b_i( r )  = b( k );
+        mu_i( r ) = mu( k );
+
+        if( warm_starting )
+          lambda_i( r ) = lambda( k );
+      }
+
+      M::compute_WJT( W_i, J_i, WJT_i );
+    }
+
+  }// end namespace detail
+
+  /**
+   * Solve the contact problem island by island.
+   *
+   * Each island gets its own sub problem and solver run, so convergence
+   * and divergence (the R-factor back-off) are handled per island. Islands
+   * are solved concurrently on the thread pool. Without islands, or with
+   * only one, the global problem is solved just like calling the solver
+   * directly.
+   *
+   * @param islands     The contact islands, empty if islands are not used.
+   * @param W           The inverse mass matrix.
+   * @param pool        The thread pool used for solving islands.
+   */
+  template<typename M>
+  inline void island_solver(
+                            std::vector< ContactIsland > const & islands
+                            , typename M::compressed4x6_type const & J
+                            , typename M::diagonal6x6_type const & W
+                            , typename M::compressed6x4_type const & WJT
+                            , typename M::vector4_type const & b
+                            , typename M::vector4_type const & mu
+                            , typename M::vector4_type & lambda
+                            , Solver<M> const & solver
+                            , RStrategy<M> const & strategy
+                            , SolverParams<M> const & params
+                            , util::ThreadPool & pool
+                            , M const & tag
+                            )
+  {
+    typedef typename M::vector4_type       V4;
+    typedef typename M::compressed4x6_type CSR4x6;
+    typedef typename M::compressed6x4_type CSR6x4;
+
+    if( islands.size() <= 1u )
+    {
+      solver( J, WJT, b, mu, lambda, strategy, params, tag );
+      return;
+    }
+
+    if( params.profiling() )
+    {
+      START_TIMER("solver_time");
+      RECORD("solver_islands", islands.size() );
+    }
+
+    size_t const N     = W.nrows();
+    size_t const UNSET = N;
+
+    // No two islands share a body so one map serves all islands
+    std::vector<size_t> local_idx( N, UNSET );
+
+    for(size_t i = 0u; i < islands.size(); ++i)
+      for(size_t l = 0u; l < islands[i].m_bodies.size(); ++l)
+        local_idx[ islands[i].m_bodies[l] ] = l;
+
+    lambda.resize( J.nrows() );
+
+    // The profiling macros and the log are not thread safe, so the island
+    // runs must stay silent. The island runs are already tasks on the pool so
+    // they may not use the pool themselves.
+    SolverParams<M> island_params = params;
+
+    island_params.set_profiling( false );
+    island_params.set_use_thread_pool( false );
+
+    bool const warm_starting = params.use_warm_starting();
+
+    pool.parallel_for(
+                      islands.size()
+                      , [&] (size_t const & i, size_t const & /*thread_idx*/)
+    {
+      ContactIsland const & island = islands[i];
+
+      CSR4x6 J_i;
+      CSR6x4 WJT_i;
+      V4     b_i;
+      V4     mu_i;
+      V4     lambda_i;
+
+      detail::get_island_problem<M>(
+                                    island
+                                    , local_idx
+                                    , UNSET
+                                    , J
+                                    , W
+                                    , b
+                                    , mu
+                                    , lambda
+                                    , warm_starting
+                                    , J_i
+                                    , WJT_i
+                                    , b_i
+                                    , mu_i
+                                    , lambda_i
+                                    );
+
+      solver( J_i, WJT_i, b_i, mu_i, lambda_i, strategy, island_params, tag );
+
+      for(size_t r = 0u; r < island.m_contacts.size(); ++r)
+        lambda( island.m_contacts[r] ) = lambda_i( r );
+    }
+                      );
+
+    if( params.profiling() )
+    {
+      STOP_TIMER("solver_time");
+    }
+  }
+
+} //namespace prox
+
+// PROX_ISLAND_SOLVER_H
+#endif
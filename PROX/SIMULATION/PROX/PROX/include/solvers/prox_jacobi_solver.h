@@ -21,8 +21,14 @@ namespace prox
    * of the contact points. The system of constraints is solved using a
    * factorized Jacobi approach, where each constraint is solved atomically
    * in turn.
+   *
+   * The sub solvers are template arguments, such that solvers bound at
+   * compile time are inlined into the loop over the contacts.
+   *
+   * @tparam N   The normal sub solver functor type.
+   * @tparam F   The friction sub solver functor type.
    */
-  template< typename M >
+  template< typename M, typename N, typename F >
   inline void jacobi_solver( 
                             typename M::compressed4x6_type const& J
                             , typename M::compressed6x4_type const& WJT
@@ -30,14 +36,17 @@ namespace prox
                             , typename M::vector4_type const& mu 
                             , typename M::vector4_type & lambda 
                             , RStrategy<M> const & strategy
-                            , NormalSubSolver<typename M::real_type> const & normal_solver
-                            , FrictionSubSolver<typename M::real_type> const & friction_solver
+                            , N const & normal_solver
+                            , F const & friction_solver
                             , SolverParams<M> const & params
                             , M const & tag
                             ) 
   {
-    RECORD_VECTOR_NEW("convergence");
-    RECORD_VECTOR_NEW("rfactor");
+    if( params.profiling() )
+    {
+      RECORD_VECTOR_NEW("convergence");
+      RECORD_VECTOR_NEW("rfactor");
+    }
 
     typedef typename M::real_type           T;
     typedef typename M::value_traits        VT;
@@ -45,7 +54,8 @@ namespace prox
     typedef typename M::vector4_type        V4;
     typedef typename M::diagonal4x4_type    D4x4;
     
-    START_TIMER("solver_time");
+    if( params.profiling() )
+      START_TIMER("solver_time");
     
     size_t const K = J.nrows( ); // Number of blocks
 
@@ -90,7 +100,8 @@ namespace prox
     //--- Jacobi loops
     for(size_t iteration = 0u; iteration < params.max_iterations(); ++iteration )
     {
-      RECORD_VECTOR_PUSH("rfactor", R(1)(1,1));
+      if( params.profiling() )
+        RECORD_VECTOR_PUSH("rfactor", R(1)(1,1));
 
       last_iteration_diverged = false;
       
@@ -119,17 +130,21 @@ namespace prox
       
       T const residual_norm = M::compute_norm_inf( residual );
       
-      RECORD_VECTOR_PUSH( "convergence", residual_norm );
+      if( params.profiling() )
+        RECORD_VECTOR_PUSH("convergence", residual_norm );
       
       if( residual_norm < params.absolute_tolerance() ) 
       {
-        util::Log logging;
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
 
-        logging << "jacobi_solver(): absolute convergence in "
-                << iteration
-                << " iterations |residual| = "
-                << residual_norm
-                << util::Log::newline();
+          logging << "jacobi_solver(): absolute convergence in "
+                  << iteration
+                  << " iterations |residual| = "
+                  << residual_norm
+                  << util::Log::newline();
+        }
 
         abs_conv_in_iteration = iteration;
 
@@ -138,12 +153,15 @@ namespace prox
       
       if( fabs(residual_norm - last_residual_norm) < params.relative_tolerance()*last_residual_norm ) 
       {
-        util::Log logging;
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
 
-        logging << "jacobi_solver(): relative convergence in "
-                << iteration
-                << " iterations"
-                << util::Log::newline();
+          logging << "jacobi_solver(): relative convergence in "
+                  << iteration
+                  << " iterations"
+                  << util::Log::newline();
+        }
 
         rel_conv_in_iteration = iteration;
 
@@ -152,13 +170,16 @@ namespace prox
       
       if( residual_norm > last_residual_norm ) 
       {
-        util::Log logging;
+        if( params.profiling() )
+        {
+          util::LogDebug logging;
 
-        logging << "jacobi_solver(): divergence in "
-                << iteration
-                << " iterations. |residual| = "
-                << residual_norm
-                << util::Log::newline();
+          logging << "jacobi_solver(): divergence in "
+                  << iteration
+                  << " iterations. |residual| = "
+                  << residual_norm
+                  << util::Log::newline();
+        }
 
         // Reduce R-factor and roll-back solution to last known good
         // iterate! (same as not doing a flip-flop on x-vectors).
@@ -181,10 +202,13 @@ namespace prox
     else
       lambda = x[out];
     
-    RECORD("solver_abs_conv_in",   abs_conv_in_iteration);
-    RECORD("solver_rel_conv_in",   rel_conv_in_iteration);
-    RECORD("solver_div_count",     count_divergence     );
-    STOP_TIMER("solver_time");
+    if( params.profiling() )
+    {
+      RECORD("solver_abs_conv_in",   abs_conv_in_iteration);
+      RECORD("solver_rel_conv_in",   rel_conv_in_iteration);
+      RECORD("solver_div_count",     count_divergence     );
+      STOP_TIMER("solver_time");
+    }
   }
   
 } //namespace prox
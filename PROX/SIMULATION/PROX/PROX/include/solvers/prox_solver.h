@@ -2,8 +2,6 @@
 #define PROX_SOLVER_H
 
 #include <solvers/strategies/prox_R_strategy.h>
-#include <solvers/sub/prox_normal_sub_solver.h>
-#include <solvers/sub/prox_friction_sub_solver.h>
 
 #include <solvers/prox_solver_params.h>
 
@@ -12,6 +10,8 @@ namespace prox
   
   /**
    * A solver functor.
+   * The normal and friction sub solvers are part of the solver, they are
+   * chosen when the solver is bound.
    */  
   template<typename M>
   class Solver
@@ -25,8 +25,6 @@ namespace prox
                             , typename M::vector4_type const &
                             , typename M::vector4_type &
                             , RStrategy<M> const &
-                            , NormalSubSolver<typename M::real_type> const &
-                            , FrictionSubSolver<typename M::real_type> const &
                             , SolverParams<M> const &
                             , M const & 
                             ) const = 0;
@@ -30,6 +30,9 @@ namespace prox
     T                        m_absolute_tolerance;       ///< The absolute tolerance value.
     T                        m_relative_tolerance;       ///< The relative tolerance value.
     bool                     m_use_warm_starting;        ///< Boolean flag that indicates whether warmstarting is used or not.
+    bool                     m_use_islands;              ///< Boolean flag that indicates whether independent contact islands are solved separately.
+    bool                     m_profiling;                ///< Boolean flag that indicates whether the solver may record profiling data and write to the log.
+    bool                     m_use_thread_pool;          ///< Boolean flag that indicates whether the solver may run work on the shared thread pool.
     
     solver_type              m_solver;                   ///< The solver type.
     strategy_type            m_r_factor_strategy;        ///< The R-factor strategy type.
@@ -42,6 +45,9 @@ namespace prox
     T      const & absolute_tolerance() const { return this->m_absolute_tolerance;   }
     T      const & relative_tolerance() const { return this->m_relative_tolerance;   }
     bool   const & use_warm_starting()  const { return this->m_use_warm_starting;    }
+    bool   const & use_islands()        const { return this->m_use_islands;          }
+    bool   const & profiling()          const { return this->m_profiling;            }
+    bool   const & use_thread_pool()    const { return this->m_use_thread_pool;      }
     
     solver_type              const & solver()               const { return this->m_solver;              }    
     strategy_type            const & r_factor_strategy()    const { return this->m_r_factor_strategy;   }
@@ -83,6 +89,30 @@ namespace prox
       this->m_use_warm_starting = value;
     }
     
+    void set_use_islands(bool const & value)
+    {
+      this->m_use_islands = value;
+    }
+
+    /**
+     * @note   Profiling and logging are not thread safe, so this must be
+     *         turned off when running several solvers at the same time.
+     */
+    void set_profiling(bool const & value)
+    {
+      this->m_profiling = value;
+    }
+
+    /**
+     * @note   A task running on the thread pool can not use the thread pool
+     *         itself, so this must be turned off for solvers started from
+     *         such a task.
+     */
+    void set_use_thread_pool(bool const & value)
+    {
+      this->m_use_thread_pool = value;
+    }
+    
     void set_solver(solver_type const & value) 
     { 
       this->m_solver = value;
@@ -113,6 +143,9 @@ namespace prox
     , m_absolute_tolerance(VT::numeric_cast(10e-5f) )
     , m_relative_tolerance(VT::zero() )
     , m_use_warm_starting(false)
+    , m_use_islands(false)
+    , m_profiling(true)
+    , m_use_thread_pool(true)
     , m_solver(gauss_seidel) 
     , m_r_factor_strategy(local_strategy)
     , m_normal_sub_solver(nonnegative) 
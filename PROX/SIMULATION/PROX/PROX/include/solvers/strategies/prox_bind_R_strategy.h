@@ -66,7 +66,7 @@ namespace prox
   template<typename M>
   inline RStrategyBinder<M> bind_strategy( strategy_type const & type )
   {
-    util::Log logging;
+    util::LogDebug logging;
 
     switch( type )
     {
@@ -65,6 +65,33 @@ namespace prox
     
   };
     
+  /**
+   * A friction sub solver bound at compile time. Unlike the binder above the
+   * call is known to the compiler, so it can be inlined into the solvers.
+   */
+  template<typename T, void (*solver)(T const &,T const &,T const &,T const &,T const &,T const &,T const &,T &,T &,T &)>
+  class FrictionSubSolverKernel
+  {
+  public:
+    
+    void operator()(
+                    T const & z_s
+                    , T const & z_t
+                    , T const & z_tau
+                    , T const & mu_s
+                    , T const & mu_t
+                    , T const & mu_tau
+                    , T const & lambda_n
+                    , T & lambda_s
+                    , T & lambda_t
+                    , T & lambda_tau
+                    ) const
+    {
+      solver(z_s,z_t,z_tau,mu_s,mu_t,mu_tau,lambda_n,lambda_s,lambda_t,lambda_tau);
+    }
+    
+  };
+    
   /**
    *
    */     
@@ -55,6 +55,25 @@ namespace prox
     
   };
     
+  /**
+   * A normal sub solver bound at compile time. Unlike the binder above the
+   * call is known to the compiler, so it can be inlined into the solvers.
+   */
+  template<typename T, void (*solver)(T const &, T &)>
+  class NormalSubSolverKernel
+  {
+  public:
+    
+    void operator()(
+                    T const & z_n
+                    , T & lambda_n
+                    ) const
+    {
+      solver(z_n,lambda_n);
+    }
+    
+  };
+    
   /**
    *
    */     
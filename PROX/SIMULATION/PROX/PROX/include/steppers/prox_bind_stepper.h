@@ -32,6 +32,7 @@ namespace prox
     typedef void func_type(
                            typename M::real_type const & dt
                            , std::vector< RigidBody< M > > & bodies
+                           , BodyStore< M > & store
                            , std::vector< std::vector< MatchStickModel< M > > > const &  properties
                            , Gravity< M > const & gravity
                            , Damping< M > const & damping
@@ -61,6 +62,7 @@ namespace prox
     void operator()(
                       typename M::real_type const & dt
                     , std::vector< RigidBody< M > > & bodies
+                    , BodyStore< M > & store
                     , std::vector< std::vector< MatchStickModel< M > > > const & properties
                     , Gravity< M > const & gravity
                     , Damping< M > const & damping
@@ -73,7 +75,7 @@ namespace prox
     {
       assert( this->m_stepper || !"StepperBinder(): stepper was null");
       
-      this->m_stepper( dt, bodies, properties, gravity, damping, params, broad_system, narrow_system, contacts, tag );
+      this->m_stepper( dt, bodies, store, properties, gravity, damping, params, broad_system, narrow_system, contacts, tag );
     }
     
   };
@@ -84,7 +86,7 @@ namespace prox
   template< typename M  >
   inline StepperBinder<M> bind_stepper( stepper_type const & type )
   {
-    util::Log logging;
+    util::LogDebug logging;
 
     switch( type )
     {
@@ -2,6 +2,7 @@
 #define PROX_EMPTY_TIME_STEPPER_H
 
 #include <prox_rigid_body.h>
+#include <prox_body_store.h>
 #include <prox_contact_point.h>
 
 #include <prox_collision_detection.h>
@@ -25,6 +26,7 @@ namespace prox
   inline void empty_stepper(
                             typename M::real_type const & dt
                             , std::vector< RigidBody< M > > & bodies
+                            , BodyStore< M > & /*store*/
                             , std::vector< std::vector< MatchStickModel< M > > > const &  contact_models
                             , Gravity< M > const & gravity
                             , Damping< M > const & damping
@@ -35,7 +37,7 @@ namespace prox
                             , M const & tag
                             )
   {
-    util::Log logging;
+    util::LogDebug logging;
 
     START_TIMER("stepper_time");
         
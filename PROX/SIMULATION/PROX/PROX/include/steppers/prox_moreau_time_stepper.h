@@ -2,31 +2,32 @@
 #define PROX_MOREAU_TIME_STEPPER_H
 
 #include <prox_rigid_body.h>
+#include <prox_body_store.h>
 #include <prox_contact_point.h>
 
 #include <prox_get_mass_matrix.h>
 #include <prox_get_inverse_mass_matrix.h>
 #include <prox_get_jacobian_matrix.h>
 #include <prox_get_external_forces_vector.h>
-#include <prox_get_position_vector.h>
-#include <prox_get_velocity_vector.h>
 #include <prox_get_pre_stabilization_vector.h>
 #include <prox_get_post_stabilization_vector.h>
 #include <prox_get_restitution_vector.h>
 #include <prox_get_friction_coefficient_vector.h>
 
 #include <prox_set_position_vector.h>
-#include <prox_set_velocity_vector.h>
 
 #include <prox_position_update.h>
 #include <prox_velocity_update.h>
 #include <prox_collision_detection.h>
-#include <prox_update_body_indices.h>
+#include <prox_update_sleeping.h>
+#include <prox_contact_islands.h>
+#include <prox_contact_cache.h>
 
 #include <prox_params.h>
 #include <prox_math_policy.h>
 
 #include <solvers/prox_bind_solver.h>
+#include <solvers/prox_island_solver.h>
 #include <solvers/sub/prox_bind_normal_sub_solver.h>
 #include <solvers/sub/prox_bind_friction_sub_solver.h>
 #include <solvers/strategies/prox_bind_R_strategy.h>
@@ -46,6 +47,7 @@ namespace prox
   inline void moreau_time_stepper(
                                   typename M::real_type const & dt
                                   , std::vector< RigidBody< M > > & bodies
+                                  , BodyStore< M > & store
                                   , std::vector< std::vector< MatchStickModel< M > > > const &  contact_models
                                   , Gravity< M > const & gravity
                                   , Damping< M > const & damping
@@ -70,18 +72,20 @@ namespace prox
     //typedef typename M::block4x1_type       B4x1;
     //typedef typename M::block6x1_type       B6x1;
 
-    util::Log logging;
+    util::LogDebug logging;
     
     START_TIMER("stepper_time");
     
-    SolverBinder<M>            prox_solver     = bind_solver<M>( params.solver_params().solver() );
+    SolverBinder<M>            prox_solver     = bind_solver<M>(
+                                                                params.solver_params().solver()
+                                                                , params.solver_params().normal_sub_solver()
+                                                                , params.solver_params().friction_sub_solver()
+                                                                );
     RStrategyBinder<M>         strategy        = bind_strategy<M>( params.solver_params().r_factor_strategy() );
-    NormalSubSolverBinder<T>   normal_solver   = bind_normal_solver<T>( params.solver_params().normal_sub_solver() );
-    FrictionSubSolverBinder<T> friction_solver = bind_friction_solver<T>( params.solver_params().friction_sub_solver() );
 
-    V7        q;      // position vector
-    V7        qM;     // position half step update
-    V6        u;      // velocity vector
+    V7 &      q = store.m_q;   // position vector
+    V7        qM;              // position half step update
+    V6 &      u = store.m_u;   // velocity vector
     D6x6      W;      // inverse mass matrix.
                       // 2009-08-13 Kenny code review: Optimization replace diagonal6x6_type
                       // with diagonal_mass_type, maybe wait to optimize until all it working
@@ -97,19 +101,28 @@ namespace prox
     V4        b;      // right hand side vector.
     V4        w;      // Current contact velocities
 
+    std::vector< ContactIsland > islands;   // Independent contact islands, empty if islands are not used
+
     T const half_dt = dt*VT::half();
     
-    detail::update_body_indices(
-                                bodies.begin()
-                                , bodies.end()
-                                );
+    // The store already holds everything needed to get q, u, W and h from
+    // the last time step, only bodies that were created or changed since
+    // then are read. Bodies are large, so walking all of them for each of
+    // those is far more expensive than the arithmetic.
+    sync_body_store( bodies.begin(), bodies.end(), store, tag );
+
+    // Collision detection throws away the old contacts, so the impulses of
+    // the last time step must be picked up before that happens.
+    ContactCache<M> cache;
+
+    if(params.solver_params().use_warm_starting())
+    {
+      cache.store( contacts );
+    }
 
-    get_position_vector( bodies.begin(), bodies.end(), q, tag );
-    get_velocity_vector( bodies.begin(), bodies.end(), u, tag );
-    
     position_update( q, u, half_dt, qM, tag );
     
-    set_position_vector( bodies.begin(), bodies.end(), qM, tag );
+    set_position_vector( bodies.begin(), bodies.end(), qM, store, tag );
     
     collision_detection(
                         bodies
@@ -120,13 +133,35 @@ namespace prox
                         , tag
                         );
 
+    // Sleeping islands that are touched by awake bodies must be woken up. The
+    // woken bodies are missing the contacts among themselves, so we have to
+    // redo collision detection until no more islands wake up. Luckily this
+    // rarely happens.
+    while( detail::wake_islands( bodies, store, contacts, params.stepper_params() ) )
+    {
+      collision_detection(
+                          bodies
+                          , broad_system
+                          , narrow_system
+                          , contacts
+                          , params
+                          , tag
+                          );
+    }
+
+    detail::remove_resting_contacts( contacts );
+
+    if(params.solver_params().use_islands())
+    {
+      detail::compute_contact_islands( bodies, contacts, islands );
+    }
+
     unsigned int const number_of_contacts = contacts.size();
 
     logging << "moreau_time_stepper(): Number of contacts = " << number_of_contacts << util::Log::newline();
     
     get_inverse_mass_matrix(
-                            bodies.begin()
-                            , bodies.end()
+                            store
                             , W
                             , tag
                             );
@@ -134,6 +169,7 @@ namespace prox
     get_external_forces_vector(
                                bodies.begin()
                                , bodies.end()
+                               , store
                                , gravity
                                , damping
                                , h
@@ -204,18 +240,32 @@ namespace prox
 
       M::compute_b( J, Wdth, u, e, g, b );    // b   = (I+E)J u + J W (dt h)
 
-      prox_solver(
-                  J
-                  , WJT
-                  , b
-                  , mu
-                  , lambda
-                  , strategy
-                  , normal_solver
-                  , friction_solver
-                  , params.solver_params()
-                  , tag
-                  );
+      if(params.solver_params().use_warm_starting())
+      {
+        size_t const matches = cache.warm_start( contacts, params.stepper_params().warm_start_tolerance(), lambda );
+
+        RECORD("warm_start_matches", matches);
+      }
+
+      island_solver(
+                    islands
+                    , J
+                    , W
+                    , WJT
+                    , b
+                    , mu
+                    , lambda
+                    , prox_solver
+                    , strategy
+                    , params.solver_params()
+                    , util::ThreadPool::get_instance()
+                    , tag
+                    );
+
+      if(params.solver_params().use_warm_starting())
+      {
+        detail::set_contact_impulses( lambda, contacts );
+      }
 
       fc.resize( WJT.nrows() );
 
@@ -230,8 +280,7 @@ namespace prox
 
     position_update( qM, u, half_dt, q, tag );
     
-    set_position_vector( bodies.begin(), bodies.end(), q, tag );
-    set_velocity_vector( bodies.begin(), bodies.end(), u, tag );
+    set_position_vector( bodies.begin(), bodies.end(), q, store, tag );
     
     STOP_TIMER("stepper_time");
 
@@ -239,8 +288,7 @@ namespace prox
     {
       START_TIMER("post_stabilization_time");
 
-      normal_solver   = bind_normal_solver<T>( nonnegative );
-      friction_solver = bind_friction_solver<T>( friction_origin );
+      prox_solver = bind_solver<M>( params.solver_params().solver(), nonnegative, friction_origin );
 
       if( number_of_contacts > 0u )
       {
@@ -253,30 +301,46 @@ namespace prox
                                       , number_of_contacts
                                       );
 
+        // The impulses of the velocity solve are a poor initial guess for
+        // the position correction, so the cache only warm starts the former.
+        if(params.solver_params().use_warm_starting())
+        {
+          M::make_zero( lambda, number_of_contacts );
+        }
+
         PREFIX("post_");
-        prox_solver(
-                    J
-                    , WJT
-                    , g
-                    , mu
-                    , lambda
-                    , strategy
-                    , normal_solver
-                    , friction_solver
-                    , params.solver_params()
-                    , tag
-                    );
+        island_solver(
+                      islands
+                      , J
+                      , W
+                      , WJT
+                      , g
+                      , mu
+                      , lambda
+                      , prox_solver
+                      , strategy
+                      , params.solver_params()
+                      , util::ThreadPool::get_instance()
+                      , tag
+                      );
         PREFIX("");
 
         sparse::prod(WJT, lambda, fc, true);
 
         position_update( q, fc, VT::one(), q, tag );
         
-        set_position_vector( bodies.begin(), bodies.end(), q, tag );
+        set_position_vector( bodies.begin(), bodies.end(), q, store, tag );
       }
       
       STOP_TIMER("post_stabilization_time");
     }
+
+    commit_body_store( store, tag );
+
+    if(params.stepper_params().sleeping())
+    {
+      detail::sleep_islands( bodies, store, contacts, params.stepper_params() );
+    }
     
   }
   
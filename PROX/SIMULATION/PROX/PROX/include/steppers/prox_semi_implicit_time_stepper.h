@@ -2,31 +2,32 @@
 #define PROX_SEMI_IMPLICIT_TIME_STEPPER_H
 
 #include <prox_rigid_body.h> 
+#include <prox_body_store.h> 
 #include <prox_contact_point.h> 
 
 #include <prox_get_mass_matrix.h> 
 #include <prox_get_inverse_mass_matrix.h> 
 #include <prox_get_jacobian_matrix.h> 
 #include <prox_get_external_forces_vector.h>
-#include <prox_get_position_vector.h> 
-#include <prox_get_velocity_vector.h> 
 #include <prox_get_pre_stabilization_vector.h> 
 #include <prox_get_post_stabilization_vector.h>
 #include <prox_get_restitution_vector.h>
 #include <prox_get_friction_coefficient_vector.h> 
 
 #include <prox_set_position_vector.h> 
-#include <prox_set_velocity_vector.h> 
 
 #include <prox_position_update.h> 
 #include <prox_velocity_update.h> 
 #include <prox_collision_detection.h> 
-#include <prox_update_body_indices.h> 
+#include <prox_update_sleeping.h>
+#include <prox_contact_islands.h>
+#include <prox_contact_cache.h>
 
 #include <prox_params.h>
 #include <prox_math_policy.h>
 
 #include <solvers/prox_bind_solver.h>
+#include <solvers/prox_island_solver.h>
 #include <solvers/sub/prox_bind_normal_sub_solver.h>
 #include <solvers/sub/prox_bind_friction_sub_solver.h>
 #include <solvers/strategies/prox_bind_R_strategy.h>
@@ -47,6 +48,7 @@ namespace prox
   inline void semi_implicit_time_stepper( 
                                           typename M::real_type const & dt
                                          , std::vector< RigidBody< M > > & bodies
+                                         , BodyStore< M > & store
                                          , std::vector< std::vector< MatchStickModel< M > > > const &  contact_models
                                          , Gravity< M > const & gravity
                                          , Damping< M > const & damping
@@ -63,20 +65,21 @@ namespace prox
     typedef typename M::diagonal6x6_type           D6x6; 
     typedef typename M::compressed4x6_type         CSR4x6;
     typedef typename M::compressed6x4_type         CSR6x4;
-    typedef typename M::real_type                  T;
     typedef typename M::value_traits               VT;
 
-    util::Log logging;
+    util::LogDebug logging;
     
     START_TIMER("stepper_time");
 
-    SolverBinder<M>            prox_solver     = bind_solver<M>( params.solver_params().solver() );
+    SolverBinder<M>            prox_solver     = bind_solver<M>(
+                                                                params.solver_params().solver()
+                                                                , params.solver_params().normal_sub_solver()
+                                                                , params.solver_params().friction_sub_solver()
+                                                                );
     RStrategyBinder<M>         strategy        = bind_strategy<M>( params.solver_params().r_factor_strategy() );    
-    NormalSubSolverBinder<T>   normal_solver   = bind_normal_solver<T>( params.solver_params().normal_sub_solver() );
-    FrictionSubSolverBinder<T> friction_solver = bind_friction_solver<T>( params.solver_params().friction_sub_solver() );
 
-    V7        q;      // position vector
-    V6        u;      // velocity vector
+    V7 &      q = store.m_q;   // position vector
+    V6 &      u = store.m_u;   // velocity vector
     D6x6      W;      // inverse mass matrix.
                       // 2009-08-13 Kenny code review: Optimization replace diagonal6x6_type
                       // with diagonal_mass_type, maybe wait to optimize until all it working
@@ -92,24 +95,18 @@ namespace prox
     CSR6x4    WJT;    // the product of the inverse mass matrix and the transposed Jacobian
     V4        w;      // Current contact velocities
 
-    detail::update_body_indices(
-                                bodies.begin()
-                                , bodies.end()
-                                );
+    std::vector< ContactIsland > islands;   // Independent contact islands, empty if islands are not used
 
-    get_position_vector(
-                        bodies.begin()
-                        , bodies.end()
-                        , q
-                        , tag
-                        );
-    
-    get_velocity_vector(
-                        bodies.begin()
-                        , bodies.end()
-                        , u
-                        , tag
-                        );
+    sync_body_store( bodies.begin(), bodies.end(), store, tag );
+
+    // Collision detection throws away the old contacts, so the impulses of
+    // the last time step must be picked up before that happens.
+    ContactCache<M> cache;
+
+    if(params.solver_params().use_warm_starting())
+    {
+      cache.store( contacts );
+    }
         
     collision_detection(
                         bodies
@@ -119,14 +116,34 @@ namespace prox
                         , params
                         , tag
                         );
+
+    // See moreau_time_stepper for why collision detection is redone when
+    // islands wake up.
+    while( detail::wake_islands( bodies, store, contacts, params.stepper_params() ) )
+    {
+      collision_detection(
+                          bodies
+                          , broad_system
+                          , narrow_system
+                          , contacts
+                          , params
+                          , tag
+                          );
+    }
+
+    detail::remove_resting_contacts( contacts );
+
+    if(params.solver_params().use_islands())
+    {
+      detail::compute_contact_islands( bodies, contacts, islands );
+    }
     
     unsigned int const number_of_contacts = contacts.size();
 
     logging << "semi_implicit_time_stepper(): Number of contacts = " << number_of_contacts << util::Log::newline();
 
     get_inverse_mass_matrix(
-                            bodies.begin()
-                            , bodies.end()
+                            store
                             , W
                             , tag
                             );
@@ -134,6 +151,7 @@ namespace prox
     get_external_forces_vector(
                                bodies.begin()
                                , bodies.end()
+                               , store
                                , gravity
                                , damping
                                , h
@@ -203,19 +221,33 @@ namespace prox
       M::compute_WJT( W, J, WJT );            // WJT = M^{-1} J^T
 
       M::compute_b( J, Wdth, u, e, g, b );    // b   = (I+E)J u + J W (dt h)
+
+      if(params.solver_params().use_warm_starting())
+      {
+        size_t const matches = cache.warm_start( contacts, params.stepper_params().warm_start_tolerance(), lambda );
+
+        RECORD("warm_start_matches", matches);
+      }
       
-      prox_solver(
-                  J
-                  , WJT
-                  , b
-                  , mu
-                  , lambda
-                  , strategy
-                  , normal_solver
-                  , friction_solver
-                  , params.solver_params()
-                  , tag
-                  );
+      island_solver(
+                    islands
+                    , J
+                    , W
+                    , WJT
+                    , b
+                    , mu
+                    , lambda
+                    , prox_solver
+                    , strategy
+                    , params.solver_params()
+                    , util::ThreadPool::get_instance()
+                    , tag
+                    );
+
+      if(params.solver_params().use_warm_starting())
+      {
+        detail::set_contact_impulses( lambda, contacts );
+      }
       
       fc.resize( WJT.nrows() );
 
@@ -231,8 +263,7 @@ namespace prox
     
     position_update( q, u, dt, q, tag );
     
-    set_position_vector( bodies.begin(), bodies.end(), q, tag ); 
-    set_velocity_vector( bodies.begin(), bodies.end(), u, tag );  
+    set_position_vector( bodies.begin(), bodies.end(), q, store, tag ); 
     
     STOP_TIMER("stepper_time");
 
@@ -240,8 +271,7 @@ namespace prox
     {
       START_TIMER("post_stabilization_time");
 
-      normal_solver   = bind_normal_solver<T>( nonnegative );
-      friction_solver = bind_friction_solver<T>( friction_origin );
+      prox_solver = bind_solver<M>( params.solver_params().solver(), nonnegative, friction_origin );
 
       if( number_of_contacts > 0u )
       {
@@ -254,31 +284,47 @@ namespace prox
                                       , number_of_contacts
                                       );
 
+        // The impulses of the velocity solve are a poor initial guess for
+        // the position correction, so the cache only warm starts the former.
+        if(params.solver_params().use_warm_starting())
+        {
+          M::make_zero( lambda, number_of_contacts );
+        }
+
         PREFIX("post_");
-        prox_solver(
-                    J
-                    , WJT
-                    , g
-                    , mu
-                    , lambda
-                    , strategy
-                    , normal_solver
-                    , friction_solver
-                    , params.solver_params()
-                    , tag
-                    );
+        island_solver(
+                      islands
+                      , J
+                      , W
+                      , WJT
+                      , g
+                      , mu
+                      , lambda
+                      , prox_solver
+                      , strategy
+                      , params.solver_params()
+                      , util::ThreadPool::get_instance()
+                      , tag
+                      );
         PREFIX("");
 
         sparse::prod(WJT, lambda, fc, true);
 
         position_update( q, fc, VT::one(), q, tag );
 
-        set_position_vector( bodies.begin(), bodies.end(), q, tag );
+        set_position_vector( bodies.begin(), bodies.end(), q, store, tag );
       }
 
       STOP_TIMER("post_stabilization_time");
     }
 
+    commit_body_store( store, tag );
+
+    if(params.stepper_params().sleeping())
+    {
+      detail::sleep_islands( bodies, store, contacts, params.stepper_params() );
+    }
+
   } 
   
 } //namespace prox
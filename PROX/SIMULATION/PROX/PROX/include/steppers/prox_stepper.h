@@ -4,6 +4,7 @@
 #include <prox_params.h>
 #include <prox_contact_point.h>
 #include <prox_rigid_body.h>
+#include <prox_body_store.h>
 #include <prox_force_callbacks.h>
 #include <prox_matchstick_model.h>
 
@@ -26,6 +27,7 @@ namespace prox
     virtual void operator()(
                             typename M::real_type const &
                             , std::vector< RigidBody< M > > &
+                            , BodyStore< M > &
                             , std::vector< std::vector< MatchStickModel< M > > > const &
                             , Gravity< M > const &
                             , Damping< M > const &
@@ -27,6 +27,11 @@ namespace prox
     bool            m_post_stabilization;   ///< Flag to turn post stabilization on/off
     bool            m_contact_reduction;    ///< Flat to turn on contact filter reduction, post-filter that removed redundant contacts.
     bool            m_bounce_on;            ///< Flag to turn bouncing completely off, default bounce is on.
+    bool            m_sleeping;             ///< Flag to turn automatic sleeping of resting bodies on/off.
+    T               m_sleep_linear_velocity;  ///< Bodies with a linear speed below this value are considered to be at rest.
+    T               m_sleep_angular_velocity; ///< Bodies with an angular speed below this value are considered to be at rest.
+    size_t          m_sleep_steps;          ///< Number of consecutive time steps all bodies of an island must be at rest before the island falls asleep.
+    T               m_warm_start_tolerance; ///< Contacts of two consecutive time steps with the same features only share impulses if their positions are closer than this value.
 
   public:
 
@@ -40,6 +45,12 @@ namespace prox
     bool const & post_stabilization() const { return this->m_post_stabilization; }
     bool const & contact_reduction() const { return this->m_contact_reduction; }
     bool const & bounce_on() const { return this->m_bounce_on; }
+    bool const & sleeping() const { return this->m_sleeping; }
+
+    T const & sleep_linear_velocity()  const { return this->m_sleep_linear_velocity;  }
+    T const & sleep_angular_velocity() const { return this->m_sleep_angular_velocity; }
+    size_t const & sleep_steps() const { return this->m_sleep_steps; }
+    T const & warm_start_tolerance()   const { return this->m_warm_start_tolerance;   }
 
     void set_min_gap(T const & value)
     {
@@ -94,6 +105,45 @@ namespace prox
       this->m_bounce_on = value;
     }
 
+    void set_sleeping(bool const & value)
+    {
+      this->m_sleeping = value;
+    }
+
+    void set_sleep_linear_velocity(T const & value)
+    {
+      assert(value >= VT::zero() || !"set_sleep_linear_velocity(): value must be nonnegative");
+      assert(is_number(value)    || !"set_sleep_linear_velocity(): value must be a number");
+      assert(is_finite(value)    || !"set_sleep_linear_velocity(): value must be a finite value");
+
+      this->m_sleep_linear_velocity = value;
+    }
+
+    void set_sleep_angular_velocity(T const & value)
+    {
+      assert(value >= VT::zero() || !"set_sleep_angular_velocity(): value must be nonnegative");
+      assert(is_number(value)    || !"set_sleep_angular_velocity(): value must be a number");
+      assert(is_finite(value)    || !"set_sleep_angular_velocity(): value must be a finite value");
+
+      this->m_sleep_angular_velocity = value;
+    }
+
+    void set_sleep_steps(size_t const & value)
+    {
+      assert(value > 0u || !"set_sleep_steps(): value must be positive");
+
+      this->m_sleep_steps = value;
+    }
+
+    void set_warm_start_tolerance(T const & value)
+    {
+      assert(value >= VT::zero() || !"set_warm_start_tolerance(): value must be nonnegative");
+      assert(is_number(value)    || !"set_warm_start_tolerance(): value must be a number");
+      assert(is_finite(value)    || !"set_warm_start_tolerance(): value must be a finite value");
+
+      this->m_warm_start_tolerance = value;
+    }
+
   public:
     
     StepperParams()
@@ -105,6 +155,11 @@ namespace prox
     , m_post_stabilization( true )
     , m_contact_reduction( true )
     , m_bounce_on(true)
+    , m_sleeping(false)
+    , m_sleep_linear_velocity(VT::numeric_cast(0.05f) )
+    , m_sleep_angular_velocity(VT::numeric_cast(0.05f) )
+    , m_sleep_steps(50u)
+    , m_warm_start_tolerance(VT::numeric_cast(0.01f) )
     {}
     
   };
@@ -2,6 +2,7 @@
 #include <prox_engine_data.h>
 #include <prox_compute_structure_map_constant.h>
 #include <prox_compute_structure_map_from_rotational_sweep.h>
+#include <prox_update_sleeping.h>
 
 #include <util_string_helper.h>
 #include <util_config_file.h>
@@ -17,7 +18,51 @@ namespace prox
   typedef MT::quaternion_type    Q;
   typedef MT::value_traits       VT;
   typedef MT::real_type          T;
+
+  /**
+   * Any change made to a rigid body through the API wakes up the island the body is sleeping in.
+   * The body and the woken bodies are checked out of the body store, such that the next time step
+   * picks up the change.
+   */
+  inline void wake_rigid_body( EngineData * data, size_t const & body_idx )
+  {
+    EngineData::rigid_body_type & body = data->m_bodies[ body_idx ];
+
+    if( body.is_sleeping() )
+    {
+      size_t const island_idx = body.get_island_idx();
+
+      for(size_t k = 0u; k < data->m_bodies.size(); ++k)
+      {
+        if( data->m_bodies[k].is_sleeping() && data->m_bodies[k].get_island_idx() == island_idx )
+          checkout_body( data->m_bodies[k], k, data->m_body_store );
+      }
+
+      detail::wake_island( data->m_bodies, island_idx );
+    }
+
+    checkout_body( body, body_idx, data->m_body_store );
+  }
   
+  /**
+   * A new shape drops the tree and structure maps of the geometry, so the bodies using the geometry
+   * are bound to it again. Their structure maps were made for the old volume mesh and are dropped.
+   */
+  inline void rebind_geometry( EngineData * data, size_t const & geometry_index )
+  {
+    EngineData::geometry_type & geometry = data->m_narrow.get_geometry( geometry_index );
+
+    for(size_t k = 0u; k < data->m_bodies.size(); ++k)
+    {
+      if( data->m_bodies[k].get_geometry_idx() != geometry_index )
+        continue;
+
+      wake_rigid_body( data, k );
+
+      narrow::rebind_object( data->m_narrow.params(), data->m_bodies[k], geometry );
+    }
+  }
+
   Engine::Engine()
   {
     m_data = new EngineData();
@@ -79,6 +124,8 @@ namespace prox
         EngineData::ScriptedMotion * motion = m_data->m_motion_callbacks.at(body_idx);
         
         motion->update(script_time, body);
+
+        m_data->m_body_store.set_changed( body_idx );
       }
       
       m_data->step_simulation( ddt );
@@ -102,8 +149,13 @@ namespace prox
   {
     assert( m_data || !"Engine::create_rigid_body(): Internal error, null pointer");
     EngineData::rigid_body_type B = EngineData::rigid_body_type();
-    B.set_name( name );
     m_data->m_bodies.push_back(B);
+    m_data->m_body_names.push_back( name );
+    m_data->m_body_store.add_body();
+    // Growing the body container may move the bodies, so old contacts would
+    // point to freed memory. The contacts are also used for warm starting the
+    // next time step.
+    m_data->m_contacts.clear();
     return m_data->m_bodies.size()-1;
   }
   
@@ -117,6 +169,8 @@ namespace prox
     assert( body_idx < m_data->m_bodies.size()             || !"Engine::set_rigid_body_position(): No such rigid body");
     assert( (is_number(x) && is_number(y) && is_number(z)) || !"Engine::set_rigid_body_position(): NaN or inf value");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_position( EngineData::V::make( x, y, z ) );
   }
   
@@ -138,6 +192,8 @@ namespace prox
     Q.imag()(1) = Qy;
     Q.imag()(2) = Qz;
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_orientation( Q );
   }
   
@@ -152,6 +208,8 @@ namespace prox
     assert( body_idx < m_data->m_bodies.size() || !"Engine::set_rigid_body_velocity(): Internal error: no such rigid body");
     assert( (is_number(vx) && is_number(vy) && is_number(vz)) || !"Engine::set_rigid_body_velocity(): Internal error: NaN or inf value");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_velocity( EngineData::V::make( vx, vy, vz ) );
   }
   
@@ -166,6 +224,8 @@ namespace prox
     assert( body_idx < m_data->m_bodies.size() || !"Engine::set_rigid_body_spin(): Internal error: no such rigid body");
     assert( (is_number(wx) && is_number(wy) && is_number(wz)) || !"Engine::set_rigid_body_spin(): Internal error: NaN or inf value");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_spin( EngineData::V::make( wx, wy, wz ) );
   }
   
@@ -175,6 +235,8 @@ namespace prox
     assert( body_idx < m_data->m_bodies.size() || !"internal error: no such rigid body");
     assert( is_number(mass) || !"internal error: NaN or inf value");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_mass( mass );
   }
   
@@ -196,12 +258,28 @@ namespace prox
                                                                             0.0f, 0.0f, Izz
                                                                             );
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_inertia_bf( I );
   }
   
   void Engine::set_rigid_body_active( size_t const & body_idx, bool const & active )
   {
-    //not used
+    assert( m_data || !"internal error: null pointer");
+    assert( body_idx < m_data->m_bodies.size() || !"internal error: no such rigid body");
+
+    EngineData::rigid_body_type & body = m_data->m_bodies[ body_idx ];
+
+    if( active )
+    {
+      wake_rigid_body( m_data, body_idx );
+    }
+    else if( ! body.is_sleeping() )
+    {
+      checkout_body( body, body_idx, m_data->m_body_store );
+
+      body.set_sleeping( true, body_idx );
+    }
   }
   
   void Engine::set_rigid_body_fixed( size_t const & body_idx, bool const & fixed )
@@ -209,6 +287,8 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_idx < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_fixed( fixed );
   }
   
@@ -217,6 +297,8 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_idx < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_material_idx( material_idx );
   }
   
@@ -228,6 +310,8 @@ namespace prox
     EngineData::rigid_body_type & body     = m_data->m_bodies[ body_idx ];
     EngineData::geometry_type   & geometry = m_data->m_narrow.get_geometry(geometry_index);
     
+    wake_rigid_body( m_data, body_idx );
+
     body.set_geometry_idx( geometry_index );
     
     if( geometry.has_shape())
@@ -347,7 +431,7 @@ namespace prox
                                                     , structure_map
                                                     );
 
-    body.set_structure_map(structure_map);
+    body.set_structure_map_idx( geometry.add_structure_map(structure_map) );
   }
 
   void Engine::set_material_structure_map(
@@ -378,7 +462,7 @@ namespace prox
                                        , s
                                        , structure_map
                                        );
-    body.set_structure_map(structure_map);
+    body.set_structure_map_idx( geometry.add_structure_map(structure_map) );
   }
 
   void Engine::get_material_structure_map_size(size_t const & body_idx, size_t & N)
@@ -387,7 +471,9 @@ namespace prox
     assert( body_idx  < m_data->m_bodies.size() || !"internal error: index excedes allocated space for in material table");
 
     EngineData::rigid_body_type       & body     = m_data->m_bodies[ body_idx ];
-    mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & structure_map = body.m_structure_map;
+    size_t                      const & geo_idx  = body.get_geometry_idx();
+    EngineData::geometry_type         & geometry = m_data->m_narrow.get_geometry(geo_idx);
+    mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & structure_map = narrow::get_structure_map( body, geometry );
     N = structure_map.size();
   }
 
@@ -401,7 +487,7 @@ namespace prox
     EngineData::geometry_type         & geometry = m_data->m_narrow.get_geometry(geo_idx);
     mesh_array::T4Mesh          const & mesh     = geometry.m_mesh;
 
-    mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & structure_map = body.m_structure_map;
+    mesh_array::VertexAttribute<V,mesh_array::T4Mesh> const & structure_map = narrow::get_structure_map( body, geometry );
     for ( size_t idx = 0u; idx < mesh.vertex_size(); ++idx)
     {
       mesh_array::Vertex const vertex = mesh.vertex( idx );
@@ -500,6 +586,9 @@ namespace prox
                                               , surface_Z
                                               );
 
+    geometry.set_analytic_box( V::make( width, height, depth )*VT::half() );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_capsule_shape(  size_t const & geometry_index
@@ -538,7 +627,10 @@ namespace prox
                                               , surface_Y
                                               , surface_Z
                                               );
-    
+
+    geometry.set_analytic_capsule( radius, height*VT::half() );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_cone_shape(  size_t const & geometry_index
@@ -575,6 +667,8 @@ namespace prox
                                               , surface_Y
                                               , surface_Z
                                               );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_convex_shape(  size_t const & geometry_index
@@ -617,6 +711,8 @@ namespace prox
                                               , surface_Y
                                               , surface_Z
                                               );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_cylinder_shape(  size_t const & geometry_index
@@ -653,6 +749,8 @@ namespace prox
                                               , surface_Y
                                               , surface_Z
                                               );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_ellipsoid_shape(  size_t const & geometry_index
@@ -694,6 +792,8 @@ namespace prox
                                               , surface_Y
                                               , surface_Z
                                               );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_sphere_shape(  size_t const & geometry_index
@@ -735,6 +835,10 @@ namespace prox
                                               , surface_Y
                                               , surface_Z
                                               );
+
+    geometry.set_analytic_sphere( radius );
+
+    rebind_geometry( m_data, geometry_index );
   }
 
   void Engine::set_tetramesh_shape(  size_t const & geometry_index
@@ -777,6 +881,8 @@ namespace prox
                        , Y
                        , Z
                        );
+
+    rebind_geometry( m_data, geometry_index );
   }
   
   float Engine::get_collision_envelope()
@@ -983,7 +1089,7 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_index < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
-    return m_data->m_bodies[ body_index ].get_name();
+    return m_data->m_body_names[ body_index ];
   }
   
   void Engine::get_rigid_body_position( size_t const & body_index
@@ -1033,7 +1139,10 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_index < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
-    EngineData::V vel = m_data->m_bodies[ body_index ].get_velocity();
+    EngineData::V vel;
+    EngineData::V spin;
+
+    get_body_velocity( m_data->m_bodies[ body_index ], body_index, m_data->m_body_store, vel, spin );
     
     assert( (is_number(vel[0]) && is_number(vel[1]) && is_number(vel[2])) || !"internal error: NaN or inf value");
     
@@ -1051,7 +1160,10 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_index < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
-    EngineData::V spin = m_data->m_bodies[ body_index ].get_spin();
+    EngineData::V vel;
+    EngineData::V spin;
+
+    get_body_velocity( m_data->m_bodies[ body_index ], body_index, m_data->m_body_store, vel, spin );
     
     assert( (is_number(spin[0]) && is_number(spin[1]) && is_number(spin[2])) || !"internal error: NaN or inf value");
     
@@ -1096,7 +1208,7 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_index < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
-    return true;
+    return ! m_data->m_bodies[ body_index ].is_sleeping();
   }
   
   bool Engine::get_rigid_body_fixed( size_t const & body_index )
@@ -1286,7 +1398,7 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_index < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
-    return m_data->m_bodies[body_index].get_force_callbacks().size();
+    return m_data->m_body_store.get_force_callbacks(body_index).size();
   }
   
   void Engine::get_connected_force_indices(  size_t const & body_index, size_t * index_array )
@@ -1294,11 +1406,11 @@ namespace prox
     assert( m_data || !"internal error: null pointer");
     assert( body_index < m_data->m_bodies.size() || !"internal error: no such rigid body");
     
-    size_t const N = m_data->m_bodies[body_index].get_force_callbacks().size();
+    size_t const N = m_data->m_body_store.get_force_callbacks(body_index).size();
     
     for(size_t i =0u; i< N; ++i)
     {
-      index_array[i] = m_data->m_bodies[body_index].get_force_callbacks()[i]->get_idx();
+      index_array[i] = m_data->m_body_store.get_force_callbacks(body_index)[i]->get_idx();
     }
   }
   
@@ -1308,7 +1420,9 @@ namespace prox
     assert( body_idx < m_data->m_bodies.size()           || !"internal error: no such rigid body");
     assert( force_idx < m_data->m_force_callbacks.size() || !"internal error: no such force callback");
     
-    m_data->m_bodies[body_idx].get_force_callbacks().push_back( m_data->m_force_callbacks[force_idx]  );
+    wake_rigid_body( m_data, body_idx );
+
+    m_data->m_body_store.get_force_callbacks(body_idx).push_back( m_data->m_force_callbacks[force_idx]  );
   }
   
   void Engine::connect_scripted_motion( size_t const & body_idx, size_t const & motion_idx )
@@ -1318,6 +1432,8 @@ namespace prox
     assert( !(m_data->m_bodies[ body_idx ].is_scripted()) || !"connect_scripted_motion(): Rigid body is already scripted");
     assert( m_data->find_motion(motion_idx)!=0            || !"connect_scripted_motion(): No such motion exist");
     
+    wake_rigid_body( m_data, body_idx );
+
     m_data->m_bodies[ body_idx ].set_scripted( true );
     
     m_data->m_all_scripted_bodies.push_back(body_idx);
@@ -8,6 +8,7 @@
 
 #include <steppers/prox_bind_stepper.h>
 
+#include <fstream>
 #include <cassert>
 
 namespace prox
@@ -17,6 +18,8 @@ namespace prox
   : m_geometry_names()
   , m_materials()
   , m_bodies()
+  , m_body_names()
+  , m_body_store()
   , m_contacts()
   , m_broad()
   , m_narrow()
@@ -25,6 +28,9 @@ namespace prox
   , m_time(0.0f)
   , m_params()
   , m_tetgen_settings(mesh_array::tetgen_quality_settings())
+  , m_profiling_flush_file("")
+  , m_profiling_flush_steps(100u)
+  , m_profiling_steps(0u)
   , m_all_scripted_bodies()
   {
     clear();
@@ -38,6 +44,8 @@ namespace prox
   void EngineData::clear()
   {
     m_bodies.clear();
+    m_body_names.clear();
+    m_body_store.clear();
     m_contacts.clear();
     m_broad.clear();
     m_narrow.clear();
@@ -72,6 +80,8 @@ namespace prox
     m_oscillation_motions.clear();
 
     util::Profiling::reset();
+
+    m_profiling_steps = 0u;
   }
 
   void EngineData::step_simulation(float const & dt)
@@ -81,9 +91,15 @@ namespace prox
     assert( dt>0.0f         || !"step_simulation(): invalid step size");
     assert( dt<=m_time_step || !"step_simulation(): invalid step size");
     
+    util::Profiling::next_step();
+
     stepper_binder_type stepper = prox::bind_stepper< MT >( m_params.stepper_params().stepper() );
     
-    stepper( dt, m_bodies, m_contact_models, m_gravity, m_damping, m_params, m_broad, m_narrow, m_contacts, MT() );
+    stepper( dt, m_bodies, m_body_store, m_contact_models, m_gravity, m_damping, m_params, m_broad, m_narrow, m_contacts, MT() );
+
+    // Ray queries use the dynamic tree of the broad phase, it is refitted
+    // once here rather than for every ray.
+    broad::refit_ray_tree( m_broad );
 
     T E_kinetic;
     T E_potential;
@@ -92,6 +108,15 @@ namespace prox
     RECORD("dt",   dt          );
     RECORD("Ekin", E_kinetic   );
     RECORD("Epot", E_potential );
+
+    if( !m_profiling_flush_file.empty() && ++m_profiling_steps >= m_profiling_flush_steps )
+    {
+      std::ofstream output( m_profiling_flush_file.c_str(), std::ios::out | std::ios::app );
+
+      util::Profiling::flush( output );
+
+      m_profiling_steps = 0u;
+    }
   }
 
   bool EngineData::compute_raycast(
@@ -121,6 +146,7 @@ namespace prox
     bool const did_hit = prox::compute_raycast<EngineData::MT>(
                                                                ray
                                                                , m_bodies
+                                                               , m_broad
                                                                , m_narrow
                                                                , body_index
                                                                , point
@@ -210,11 +236,15 @@ namespace prox
       if(body.is_scripted())
         continue;
 
+      V velocity;
+      V w;
+
+      prox::get_body_velocity( body, i, m_body_store, velocity, w );
+
       float const m  = body.get_mass();
       float const h  = tiny::inner_prod( m_gravity.up(), body.get_position());
-      float const v  = tiny::norm( body.get_velocity());
+      float const v  = tiny::norm( velocity );
 
-      V const & w    = body.get_spin();
       M const & I_bf = body.get_inertia_bf();
       M const R      = tiny::make( body.get_orientation() );
 
@@ -4,6 +4,10 @@
 #include <util_string_helper.h>
 #include <util_config_file.h>
 #include <util_log.h>
+#include <util_thread_pool.h>
+#include <util_profiling.h>
+
+#include <fstream>
 
 namespace prox
 {
@@ -11,6 +15,7 @@ namespace prox
   std::string const Engine::PARAM_SOLVER                     = "solver";
   std::string const Engine::VALUE_JACOBI                     = "jacobi";
   std::string const Engine::VALUE_GAUSS_SEIDEL               = "gauss_seidel";
+  std::string const Engine::VALUE_COLORED_GAUSS_SEIDEL       = "colored_gauss_seidel";
 
   std::string const Engine::PARAM_NORMAL_SOLVER              = "normal_sub_solver";
   std::string const Engine::VALUE_NONNEGATIVE                = "nonnegative";
@@ -46,6 +51,17 @@ namespace prox
   std::string const Engine::PARAM_TETGEN_SUPPRESS_SPLITTING  = "tetgen_suppress_splitting";
   std::string const Engine::PARAM_MAX_ITERATION              = "max_iteration";
   std::string const Engine::PARAM_NARROW_CHUNK_BYTES         = "narrow_chunk_bytes";
+  std::string const Engine::PARAM_NARROW_RIGID_TRAVERSAL     = "narrow_rigid_traversal";
+  std::string const Engine::PARAM_NARROW_WIDE_TRAVERSAL      = "narrow_wide_traversal";
+  std::string const Engine::PARAM_NARROW_ANALYTIC_SHAPES     = "narrow_analytic_shapes";
+  std::string const Engine::PARAM_NUMBER_OF_THREADS          = "number_of_threads";
+  std::string const Engine::PARAM_SLEEPING                   = "sleeping";
+  std::string const Engine::PARAM_SLEEP_STEPS                = "sleep_steps";
+  std::string const Engine::PARAM_SLEEP_LINEAR_VELOCITY      = "sleep_linear_velocity";
+  std::string const Engine::PARAM_SLEEP_ANGULAR_VELOCITY     = "sleep_angular_velocity";
+  std::string const Engine::PARAM_SOLVER_ISLANDS             = "solver_islands";
+  std::string const Engine::PARAM_WARM_STARTING              = "warm_starting";
+  std::string const Engine::PARAM_WARM_START_TOLERANCE       = "warm_start_tolerance";
   std::string const Engine::PARAM_ABSOLUTE_TOLERANCE         = "absolute_tolerance";
   std::string const Engine::PARAM_RELATIVE_TOLERANCE         = "relative_tolerance";
   std::string const Engine::PARAM_GAP_REDUCTION              = "gap_reduction";
@@ -53,6 +69,7 @@ namespace prox
   std::string const Engine::PARAM_MIN_GAP                    = "min_gap";
   std::string const Engine::PARAM_TETGEN_QUALITY_RATIO       = "tetgen_quality_ratio";
   std::string const Engine::PARAM_TETGEN_MAXIMUM_VOLUME      = "tetgen_maximum_volume";
+  std::string const Engine::PARAM_TETGEN_CACHE_PATH          = "tetgen_cache_path";
   std::string const Engine::PARAM_NARROW_ENVELOPE            = "narrow_envelope";
   std::string const Engine::PARAM_COLLISION_ENVELOPE         = "collision_envelope";
   std::string const Engine::PARAM_TIME_STEP                  = "time_step";
@@ -60,6 +77,15 @@ namespace prox
   std::string const Engine::PARAM_BROAD_PHASE_ALGORITHM      = "broad_phase_algorithm";
   std::string const Engine::VALUE_ALL_PAIR                   = "all_pair";
   std::string const Engine::VALUE_GRID                       = "grid";
+  std::string const Engine::VALUE_SAP                        = "sap";
+  std::string const Engine::VALUE_DYNAMIC_TREE               = "dynamic_tree";
+  std::string const Engine::PARAM_BROAD_PHASE_PERSISTENT     = "broad_phase_persistent";
+
+  std::string const Engine::PARAM_PROFILING_WINDOW           = "profiling_window";
+  std::string const Engine::PARAM_PROFILING_FLUSH_FILE       = "profiling_flush_file";
+  std::string const Engine::PARAM_PROFILING_FLUSH_STEPS      = "profiling_flush_steps";
+  std::string const Engine::PARAM_PROFILING_TRACE            = "profiling_trace";
+  std::string const Engine::PARAM_PROFILING_TRACE_STEPS      = "profiling_trace_steps";
 
 
   void Engine::set_parameter(std::string const & name, std::string const & value )
@@ -76,6 +102,10 @@ namespace prox
       {
         m_data->m_params.solver_params().set_solver(prox::gauss_seidel);
       }
+      else if (value == VALUE_COLORED_GAUSS_SEIDEL)
+      {
+        m_data->m_params.solver_params().set_solver(prox::colored_gauss_seidel);
+      }
       else
       {
         util::Log logging;
@@ -199,11 +229,27 @@ namespace prox
     {
       if (value == VALUE_ALL_PAIR)
       {
-        m_data->m_params.use_all_pair() = true;
+        m_data->m_params.use_all_pair()     = true;
+        m_data->m_params.use_sap()          = false;
+        m_data->m_params.use_dynamic_tree() = false;
       }
       else if (value == VALUE_GRID)
       {
-        m_data->m_params.use_all_pair() = false;
+        m_data->m_params.use_all_pair()     = false;
+        m_data->m_params.use_sap()          = false;
+        m_data->m_params.use_dynamic_tree() = false;
+      }
+      else if (value == VALUE_SAP)
+      {
+        m_data->m_params.use_all_pair()     = false;
+        m_data->m_params.use_sap()          = true;
+        m_data->m_params.use_dynamic_tree() = false;
+      }
+      else if (value == VALUE_DYNAMIC_TREE)
+      {
+        m_data->m_params.use_all_pair()     = false;
+        m_data->m_params.use_sap()          = false;
+        m_data->m_params.use_dynamic_tree() = true;
       }
       else
       {
@@ -212,6 +258,29 @@ namespace prox
         logging << "Engine::set_parameter(): unknown broad phase algorithm = " << value << util::Log::newline();
       }
     }
+    else if (name == PARAM_TETGEN_CACHE_PATH)
+    {
+      m_data->m_tetgen_settings.m_cache_path = value;
+    }
+    else if (name == PARAM_PROFILING_FLUSH_FILE)
+    {
+      m_data->m_profiling_flush_file = value;
+
+      if( !value.empty() )
+      {
+        // Start from an empty file, flushes append to it
+        std::ofstream output( value.c_str(), std::ios::out | std::ios::trunc );
+
+        if( !output.is_open() )
+        {
+          util::Log logging;
+
+          logging << "Engine::set_parameter(): could not open profiling flush file = " << value << util::Log::newline();
+
+          m_data->m_profiling_flush_file = "";
+        }
+      }
+    }
     else
     {
       util::Log logging;
@@ -248,6 +317,53 @@ namespace prox
     {
       m_data->m_tetgen_settings.m_suppress_splitting = value;
     }
+    else if (name == PARAM_BROAD_PHASE_PERSISTENT)
+    {
+      m_data->m_params.use_persistent_broad_phase() = value;
+    }
+    else if (name == PARAM_NARROW_RIGID_TRAVERSAL)
+    {
+      m_data->m_narrow.params().set_rigid_traversal( value );
+    }
+    else if (name == PARAM_NARROW_WIDE_TRAVERSAL)
+    {
+      m_data->m_narrow.params().set_wide_traversal( value );
+    }
+    else if (name == PARAM_NARROW_ANALYTIC_SHAPES)
+    {
+      m_data->m_narrow.params().set_analytic_shapes( value );
+    }
+    else if (name == PARAM_SLEEPING)
+    {
+      m_data->m_params.stepper_params().set_sleeping( value );
+
+      // Without sleeping the steppers no longer wake up islands, so bodies
+      // that are asleep must be woken up here or they stay asleep for good
+      if( ! value )
+      {
+        for(size_t k = 0u; k < m_data->m_bodies.size(); ++k)
+        {
+          if( ! m_data->m_bodies[k].is_sleeping() )
+            continue;
+
+          checkout_body( m_data->m_bodies[k], k, m_data->m_body_store );
+
+          m_data->m_bodies[k].set_sleeping( false );
+        }
+      }
+    }
+    else if (name == PARAM_SOLVER_ISLANDS)
+    {
+      m_data->m_params.solver_params().set_use_islands( value );
+    }
+    else if (name == PARAM_WARM_STARTING)
+    {
+      m_data->m_params.solver_params().set_use_warm_starting( value );
+    }
+    else if (name == PARAM_PROFILING_TRACE)
+    {
+      util::Profiling::set_tracing( value );
+    }
     else
     {
       util::Log logging;
@@ -268,6 +384,31 @@ namespace prox
     {
       m_data->m_narrow.params().set_chunk_bytes( value );
     }
+    else if (name == PARAM_NUMBER_OF_THREADS)
+    {
+      // Zero means use as many threads as the hardware supports
+      util::ThreadPool::get_instance().resize( value );
+    }
+    else if (name == PARAM_SLEEP_STEPS)
+    {
+      m_data->m_params.stepper_params().set_sleep_steps( value );
+    }
+    else if (name == PARAM_PROFILING_WINDOW)
+    {
+      // Zero means keep every recorded value
+      util::Profiling::set_window( value );
+    }
+    else if (name == PARAM_PROFILING_TRACE_STEPS)
+    {
+      // Zero means keep the trace events of all steps
+      util::Profiling::set_trace_steps( value );
+    }
+    else if (name == PARAM_PROFILING_FLUSH_STEPS)
+    {
+      assert( value > 0u || !"set_parameter(): profiling flush steps must be positive");
+
+      m_data->m_profiling_flush_steps = value;
+    }
     else
     {
       util::Log logging;
@@ -312,6 +453,18 @@ namespace prox
     {
       m_data->m_narrow.params().set_envelope( value );
     }
+    else if (name == PARAM_SLEEP_LINEAR_VELOCITY)
+    {
+      m_data->m_params.stepper_params().set_sleep_linear_velocity( value );
+    }
+    else if (name == PARAM_SLEEP_ANGULAR_VELOCITY)
+    {
+      m_data->m_params.stepper_params().set_sleep_angular_velocity( value );
+    }
+    else if (name == PARAM_WARM_START_TOLERANCE)
+    {
+      m_data->m_params.stepper_params().set_warm_start_tolerance( value );
+    }
     else if (name == PARAM_TIME_STEP)
     {
       assert( value > 0.0f || !"set_parameter(): internal error, null pointer");
@@ -338,6 +491,14 @@ namespace prox
     bool         const tetgen_quiet_output         = util::to_value<bool>(         settings.get_value(PARAM_TETGEN_QUIET,              "true"   ) );
     bool         const tetgen_suppress_splitting   = util::to_value<bool>(         settings.get_value(PARAM_TETGEN_SUPPRESS_SPLITTING, "true"   ) );
     bool         const bounce_on_value             = util::to_value<bool>(         settings.get_value(PARAM_BOUNCE_ON,                 "true"  ) );
+    bool         const broad_phase_persistent      = util::to_value<bool>(         settings.get_value(PARAM_BROAD_PHASE_PERSISTENT,    "false"  ) );
+    bool         const narrow_rigid_traversal      = util::to_value<bool>(         settings.get_value(PARAM_NARROW_RIGID_TRAVERSAL,    "false"  ) );
+    bool         const narrow_wide_traversal       = util::to_value<bool>(         settings.get_value(PARAM_NARROW_WIDE_TRAVERSAL,     "false"  ) );
+    bool         const narrow_analytic_shapes      = util::to_value<bool>(         settings.get_value(PARAM_NARROW_ANALYTIC_SHAPES,    "false"  ) );
+    bool         const sleeping                    = util::to_value<bool>(         settings.get_value(PARAM_SLEEPING,                  "false"  ) );
+    bool         const solver_islands              = util::to_value<bool>(         settings.get_value(PARAM_SOLVER_ISLANDS,            "false"  ) );
+    bool         const warm_starting               = util::to_value<bool>(         settings.get_value(PARAM_WARM_STARTING,             "false"  ) );
+    bool         const profiling_trace             = util::to_value<bool>(         settings.get_value(PARAM_PROFILING_TRACE,           "false"  ) );
 
     set_parameter(PARAM_PRE_STABILIZATION,           pre_stabilization_value   );
     set_parameter(PARAM_POST_STABILIZATION,          post_stabilization_value  );
@@ -345,12 +506,30 @@ namespace prox
     set_parameter(PARAM_TETGEN_QUIET,         tetgen_quiet_output       );
     set_parameter(PARAM_TETGEN_SUPPRESS_SPLITTING,   tetgen_suppress_splitting );
     set_parameter(PARAM_BOUNCE_ON,                   bounce_on_value           );
+    set_parameter(PARAM_BROAD_PHASE_PERSISTENT,      broad_phase_persistent    );
+    set_parameter(PARAM_NARROW_RIGID_TRAVERSAL,      narrow_rigid_traversal    );
+    set_parameter(PARAM_NARROW_WIDE_TRAVERSAL,       narrow_wide_traversal     );
+    set_parameter(PARAM_NARROW_ANALYTIC_SHAPES,      narrow_analytic_shapes    );
+    set_parameter(PARAM_SLEEPING,                    sleeping                  );
+    set_parameter(PARAM_SOLVER_ISLANDS,              solver_islands            );
+    set_parameter(PARAM_WARM_STARTING,               warm_starting             );
+    set_parameter(PARAM_PROFILING_TRACE,             profiling_trace           );
 
     unsigned int const max_iteration_value         = util::to_value<unsigned int>( settings.get_value(PARAM_MAX_ITERATION,             "1000"   ) );
     unsigned int const narrow_chunk_bytes          = util::to_value<unsigned int>( settings.get_value(PARAM_NARROW_CHUNK_BYTES,        "8000"   ) );
+    unsigned int const number_of_threads           = util::to_value<unsigned int>( settings.get_value(PARAM_NUMBER_OF_THREADS,         "1"      ) );
+    unsigned int const sleep_steps                 = util::to_value<unsigned int>( settings.get_value(PARAM_SLEEP_STEPS,               "50"     ) );
+    unsigned int const profiling_window            = util::to_value<unsigned int>( settings.get_value(PARAM_PROFILING_WINDOW,          util::to_string( util::Profiling::default_window() ) ) );
+    unsigned int const profiling_flush_steps       = util::to_value<unsigned int>( settings.get_value(PARAM_PROFILING_FLUSH_STEPS,     "100"    ) );
+    unsigned int const profiling_trace_steps       = util::to_value<unsigned int>( settings.get_value(PARAM_PROFILING_TRACE_STEPS,     "0"      ) );
 
     set_parameter(PARAM_MAX_ITERATION,               max_iteration_value       );
     set_parameter(PARAM_NARROW_CHUNK_BYTES,          narrow_chunk_bytes        );
+    set_parameter(PARAM_NUMBER_OF_THREADS,           number_of_threads         );
+    set_parameter(PARAM_SLEEP_STEPS,                 sleep_steps               );
+    set_parameter(PARAM_PROFILING_WINDOW,            profiling_window          );
+    set_parameter(PARAM_PROFILING_FLUSH_STEPS,       profiling_flush_steps     );
+    set_parameter(PARAM_PROFILING_TRACE_STEPS,       profiling_trace_steps     );
 
     float        const absolute_tolerance_value    = util::to_value<float>(        settings.get_value(PARAM_ABSOLUTE_TOLERANCE,        "0.0"    ) );
     float        const relative_tolerance_value    = util::to_value<float>(        settings.get_value(PARAM_RELATIVE_TOLERANCE,        "0.0"    ) );
@@ -361,6 +540,9 @@ namespace prox
     float        const tetgen_maximum_volume       = util::to_value<float>(        settings.get_value(PARAM_TETGEN_MAXIMUM_VOLUME,     "0.1"    ) );
     float        const narrow_envelope             = util::to_value<float>(        settings.get_value(PARAM_NARROW_ENVELOPE,           "0.01"   ) );
     float        const time_step                   = util::to_value<float>(        settings.get_value(PARAM_TIME_STEP,                 "0.01"   ) );
+    float        const sleep_linear_velocity       = util::to_value<float>(        settings.get_value(PARAM_SLEEP_LINEAR_VELOCITY,     "0.05"   ) );
+    float        const sleep_angular_velocity      = util::to_value<float>(        settings.get_value(PARAM_SLEEP_ANGULAR_VELOCITY,    "0.05"   ) );
+    float        const warm_start_tolerance        = util::to_value<float>(        settings.get_value(PARAM_WARM_START_TOLERANCE,      "0.01"   ) );
 
     set_parameter(PARAM_ABSOLUTE_TOLERANCE,          absolute_tolerance_value  );
     set_parameter(PARAM_RELATIVE_TOLERANCE,          relative_tolerance_value  );
@@ -371,6 +553,9 @@ namespace prox
     set_parameter(PARAM_TETGEN_MAXIMUM_VOLUME,       tetgen_maximum_volume     );
     set_parameter(PARAM_NARROW_ENVELOPE,             narrow_envelope           );
     set_parameter(PARAM_TIME_STEP,                   time_step                 );
+    set_parameter(PARAM_SLEEP_LINEAR_VELOCITY,       sleep_linear_velocity     );
+    set_parameter(PARAM_SLEEP_ANGULAR_VELOCITY,      sleep_angular_velocity    );
+    set_parameter(PARAM_WARM_START_TOLERANCE,        warm_start_tolerance      );
 
     float        const gravity_x_value             = util::to_value<float>(        settings.get_value("gravity_x",                 "0.0"    ) );
     float        const gravity_y_value             = util::to_value<float>(        settings.get_value("gravity_y",                 "1.0"    ) );
@@ -390,6 +575,8 @@ namespace prox
     std::string  const time_stepper                = settings.get_value(PARAM_TIME_STEPPER,        VALUE_MOREAU            );
     std::string  const contact_algorithm           = settings.get_value(PARAM_CONTACT_ALGORITHM,   VALUE_OPPOSING          );
     std::string  const broad_phase_algorithm       = settings.get_value(PARAM_BROAD_PHASE_ALGORITHM,   VALUE_GRID          );
+    std::string  const tetgen_cache_path           = settings.get_value(PARAM_TETGEN_CACHE_PATH,   ""                      );
+    std::string  const profiling_flush_file        = settings.get_value(PARAM_PROFILING_FLUSH_FILE, ""                     );
 
     set_parameter(PARAM_FRICTION_SOLVER,         friction_sub_solver       );
     set_parameter(PARAM_NORMAL_SOLVER,           normal_sub_solver         );
@@ -398,6 +585,8 @@ namespace prox
     set_parameter(PARAM_TIME_STEPPER,            time_stepper              );
     set_parameter(PARAM_CONTACT_ALGORITHM,       contact_algorithm         );
     set_parameter(PARAM_BROAD_PHASE_ALGORITHM,   broad_phase_algorithm     );
+    set_parameter(PARAM_TETGEN_CACHE_PATH,       tetgen_cache_path         );
+    set_parameter(PARAM_PROFILING_FLUSH_FILE,    profiling_flush_file      );
   }
 
 }// namespace prox
@@ -3,6 +3,7 @@
 
 #include <util_profiling.h>
 #include <util_write_matlab_profiling_data.h>
+#include <util_write_chrome_trace_data.h>
 #include <util_log.h>
 
 #include <boost/algorithm/string.hpp>
@@ -264,5 +265,32 @@ namespace prox
     return true;
   }
 
+  bool Engine::write_chrome_trace_data(std::string const & filename)
+  {
+    util::Log        logging;
+
+    std::string const newline = util::Log::newline();
+
+    std::ofstream trace;
+
+    trace.open(filename.c_str(),std::ios::out);
+
+    if(! trace.is_open())
+    {
+      logging << "Engine::write_chrome_trace_data(): error could not open file = " << filename.c_str() << newline;
+
+      return false;
+    }
+
+    trace << util::write_chrome_trace_data();
+
+    trace.flush();
+    trace.close();
+
+    logging << "Engine::write_chrome_trace_data(): Done writing trace data..." << newline;
+
+    return true;
+  }
+
 
 } // namespace prox
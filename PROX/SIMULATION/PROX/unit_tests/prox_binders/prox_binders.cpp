@@ -34,8 +34,9 @@ BOOST_AUTO_TEST_CASE(compile_testing)
   prox::FrictionSubSolverBinder<T> friction_solver6 = prox::bind_friction_solver<T>( prox::friction_origin );
   prox::FrictionSubSolverBinder<T> friction_solver7 = prox::bind_friction_solver<T>( prox::friction_infinity );
   
-  prox::SolverBinder<M>            prox_solver1     = prox::bind_solver<M>( prox::jacobi );
-  prox::SolverBinder<M>            prox_solver2     = prox::bind_solver<M>( prox::gauss_seidel );
+  prox::SolverBinder<M>            prox_solver1     = prox::bind_solver<M>( prox::jacobi, prox::nonnegative, prox::analytical_sphere );
+  prox::SolverBinder<M>            prox_solver2     = prox::bind_solver<M>( prox::gauss_seidel, prox::nonnegative, prox::analytical_sphere );
+  prox::SolverBinder<M>            prox_solver3     = prox::bind_solver<M>( prox::colored_gauss_seidel, prox::nonnegative, prox::analytical_sphere );
 
   prox::StepperBinder<M>            prox_stepper1     = prox::bind_stepper<M>( prox::moreau );
   prox::StepperBinder<M>            prox_stepper2     = prox::bind_stepper<M>( prox::semi_implicit );
@@ -58,9 +59,39 @@ BOOST_AUTO_TEST_CASE(compile_testing)
 
   SHUT_UP_COMPILER_WARNING( prox_solver1 );
   SHUT_UP_COMPILER_WARNING( prox_solver2 );
+  SHUT_UP_COMPILER_WARNING( prox_solver3 );
 
   SHUT_UP_COMPILER_WARNING( prox_stepper1 );
   SHUT_UP_COMPILER_WARNING( prox_stepper2 );
 }
 
+BOOST_AUTO_TEST_CASE(solver_kernels)
+{
+  typedef float T;
+  typedef prox::MathPolicy<T> M;
+
+  prox::solver_type const solvers[] = { prox::jacobi, prox::gauss_seidel, prox::colored_gauss_seidel };
+
+  prox::normal_sub_solver_type const normal_solvers[] = { prox::nonnegative, prox::normal_origin, prox::normal_infinity };
+
+  prox::friction_sub_solver_type const friction_solvers[] = {
+    prox::analytical_sphere
+    , prox::analytical_ellipsoid
+    , prox::numerical_ellipsoid
+    , prox::box_model
+    , prox::friction_origin
+    , prox::friction_infinity
+  };
+
+  // Every combination of solver and sub solvers must be bound
+  for(size_t s = 0u; s < 3u; ++s)
+    for(size_t n = 0u; n < 3u; ++n)
+      for(size_t f = 0u; f < 6u; ++f)
+      {
+        prox::SolverBinder<M> solver = prox::bind_solver<M>( solvers[s], normal_solvers[n], friction_solvers[f] );
+
+        BOOST_CHECK( solver.m_solver != 0 );
+      }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,284 @@
+#include <sparse.h>
+
+#include <narrow.h>
+
+#include <prox_rigid_body.h>
+#include <prox_body_store.h>
+#include <prox_force_callbacks.h>
+#include <prox_get_position_vector.h>
+#include <prox_get_velocity_vector.h>
+#include <prox_get_inverse_mass_matrix.h>
+#include <prox_get_external_forces_vector.h>
+
+#include <prox_math_policy.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::tiny_types      tiny_types;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector3_type    vector3_type;
+typedef math_policy::vector6_type    vector6_type;
+typedef math_policy::vector7_type    vector7_type;
+typedef math_policy::matrix3x3_type  matrix3x3_type;
+typedef math_policy::quaternion_type quaternion_type;
+typedef math_policy::diagonal6x6_type diagonal6x6_type;
+
+namespace
+{
+
+  void make_bodies( std::vector< prox::RigidBody< math_policy > > & bodies, size_t const & gid )
+  {
+    bodies.resize( 4u );
+
+    for(size_t i = 0u; i < bodies.size(); ++i)
+    {
+      bodies[i].set_geometry_idx( gid );
+      bodies[i].set_position( vector3_type::make( 1.0f*i, 2.0f, 3.0f ) );
+      bodies[i].set_orientation( quaternion_type( 1.0f, 0.1f*i, 0.2f, 0.3f ) );
+      bodies[i].set_velocity( vector3_type::make( 1.0f, 2.0f*i, 3.0f ) );
+      bodies[i].set_spin( vector3_type::make( 0.5f*i, 1.0f, 1.5f ) );
+      bodies[i].set_mass( 1.0f + i );
+      bodies[i].set_inertia_bf( matrix3x3_type::make_diag( 2.0f + i ) );
+    }
+
+    bodies[1].set_fixed( true );
+    bodies[2].set_sleeping( true );
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE(body_store);
+
+BOOST_AUTO_TEST_CASE(sync_body_store_test)
+{
+  narrow::System<tiny_types> narrow;
+
+  size_t gid = narrow.create_geometry();
+
+  std::vector< prox::RigidBody< math_policy > > bodies;
+
+  make_bodies( bodies, gid );
+
+  prox::BodyStore< math_policy > store;
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+    store.add_body();
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  BOOST_CHECK_EQUAL( store.size(), 4u );
+
+  BOOST_CHECK(  store.is_active(0) );
+  BOOST_CHECK( !store.is_active(1) );
+  BOOST_CHECK( !store.is_active(2) );
+  BOOST_CHECK(  store.is_active(3) );
+
+  vector7_type q;
+  vector6_type u;
+
+  prox::get_position_vector( bodies.begin(), bodies.end(), q, math_policy() );
+  prox::get_velocity_vector( bodies.begin(), bodies.end(), u, math_policy() );
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL( bodies[i].get_idx(), i );
+
+    for(size_t j = 0u; j < 7u; ++j)
+      BOOST_CHECK_EQUAL( store.m_q(i)(j), q(i)(j) );
+
+    for(size_t j = 0u; j < 6u; ++j)
+      BOOST_CHECK_EQUAL( store.m_u(i)(j), u(i)(j) );
+  }
+
+  diagonal6x6_type A;
+  diagonal6x6_type B;
+
+  prox::get_inverse_mass_matrix( bodies.begin(), bodies.end(), A, math_policy() );
+  prox::get_inverse_mass_matrix( store, B, math_policy() );
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+    for(size_t r = 0u; r < 6u; ++r)
+      for(size_t c = 0u; c < 6u; ++c)
+        BOOST_CHECK_EQUAL( A(i)(r,c), B(i)(r,c) );
+
+  // The store owns the velocities of active bodies, a body that is not
+  // marked as changed is not read again
+  bodies[0].set_velocity( vector3_type::make( 7.0f, 8.0f, 9.0f ) );
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  BOOST_CHECK_EQUAL( store.m_u(0)(0), 1.0f );
+
+  vector3_type v;
+  vector3_type w;
+
+  prox::get_body_velocity( bodies[0], 0u, store, v, w );
+
+  BOOST_CHECK_EQUAL( v(0), 1.0f );
+
+  // Fixed bodies keep their own velocities
+  prox::get_body_velocity( bodies[1], 1u, store, v, w );
+
+  BOOST_CHECK_EQUAL( v(1), 2.0f );
+  BOOST_CHECK_EQUAL( store.m_u(1)(1), 0.0f );
+
+  // Checking out a body hands the velocities of the store back to it, and
+  // the changes made afterwards are picked up by the next sync
+  store.m_u(3)(0) = 4.0f;
+
+  prox::checkout_body( bodies[3], 3u, store );
+
+  BOOST_CHECK_EQUAL( bodies[3].get_velocity()(0), 4.0f );
+
+  bodies[3].set_mass( 10.0f );
+  bodies[2].set_sleeping( false );
+
+  store.set_changed( 2u );
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  BOOST_CHECK_EQUAL( store.m_mass[3], 10.0f );
+  BOOST_CHECK_EQUAL( store.m_u(3)(0), 4.0f );
+  BOOST_CHECK( store.is_active(2) );
+  BOOST_CHECK_EQUAL( store.m_u(2)(1), 4.0f );
+  BOOST_CHECK( store.m_changes.empty() );
+
+  // New bodies are read without being marked as changed
+  bodies.resize( 5u );
+  store.add_body();
+
+  bodies[4].set_velocity( vector3_type::make( 1.0f, 1.0f, 1.0f ) );
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  BOOST_CHECK_EQUAL( store.size(), 5u );
+  BOOST_CHECK_EQUAL( bodies[4].get_idx(), 4u );
+  BOOST_CHECK_EQUAL( store.m_u(4)(2), 1.0f );
+  BOOST_CHECK_EQUAL( store.m_u(0)(0), 1.0f );
+}
+
+BOOST_AUTO_TEST_CASE(set_position_vector_test)
+{
+  narrow::System<tiny_types> narrow;
+
+  size_t gid = narrow.create_geometry();
+
+  std::vector< prox::RigidBody< math_policy > > bodies;
+
+  make_bodies( bodies, gid );
+
+  prox::BodyStore< math_policy > store;
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+    store.add_body();
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  vector7_type q = store.m_q;
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+  {
+    q(i)(0) = 10.0f;
+    q(i)(3) = 2.0f;
+  }
+
+  prox::set_position_vector( bodies.begin(), bodies.end(), q, store, math_policy() );
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+  {
+    // Orientations in the store must always be the ones the bodies hold
+    BOOST_CHECK_EQUAL( store.m_Q[i].real(),    bodies[i].get_orientation().real()    );
+    BOOST_CHECK_EQUAL( store.m_Q[i].imag()(0), bodies[i].get_orientation().imag()(0) );
+    BOOST_CHECK_EQUAL( store.m_Q[i].imag()(1), bodies[i].get_orientation().imag()(1) );
+    BOOST_CHECK_EQUAL( store.m_Q[i].imag()(2), bodies[i].get_orientation().imag()(2) );
+  }
+
+  BOOST_CHECK_EQUAL( bodies[0].get_position()(0), 10.0f );
+  BOOST_CHECK_EQUAL( bodies[1].get_position()(0),  1.0f );
+  BOOST_CHECK_EQUAL( bodies[2].get_position()(0),  2.0f );
+  BOOST_CHECK_EQUAL( bodies[3].get_position()(0), 10.0f );
+
+  // At the end of a time step the store must hold the orientations of the
+  // bodies, as if they were read from the bodies again
+  prox::set_position_vector( bodies.begin(), bodies.end(), q, store, math_policy() );
+  prox::commit_body_store( store, math_policy() );
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL( store.m_q(i)(3), bodies[i].get_orientation().real()    );
+    BOOST_CHECK_EQUAL( store.m_q(i)(4), bodies[i].get_orientation().imag()(0) );
+    BOOST_CHECK_EQUAL( store.m_q(i)(5), bodies[i].get_orientation().imag()(1) );
+    BOOST_CHECK_EQUAL( store.m_q(i)(6), bodies[i].get_orientation().imag()(2) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(get_external_forces_vector_test)
+{
+  narrow::System<tiny_types> narrow;
+
+  size_t gid = narrow.create_geometry();
+
+  std::vector< prox::RigidBody< math_policy > > bodies;
+
+  make_bodies( bodies, gid );
+
+  prox::BodyStore< math_policy > store;
+
+  for(size_t i = 0u; i < bodies.size(); ++i)
+    store.add_body();
+
+  prox::Gravity< math_policy > gravity;
+  prox::Damping< math_policy > damping;
+  prox::Pin< math_policy >     pin;
+
+  pin.target() = vector3_type::make( 0.0f, 5.0f, 3.0f );
+
+  store.get_force_callbacks(3).push_back( &pin );
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  vector6_type h;
+
+  prox::get_external_forces_vector( bodies.begin(), bodies.end(), store, gravity, damping, h, math_policy() );
+
+  BOOST_CHECK_EQUAL( h.size(), 4u );
+
+  for(size_t j = 0u; j < 6u; ++j)
+  {
+    BOOST_CHECK_EQUAL( h(1)(j), 0.0f );
+    BOOST_CHECK_EQUAL( h(2)(j), 0.0f );
+  }
+
+  vector3_type force;
+  vector3_type torque;
+
+  vector3_type expected = vector3_type::zero();
+
+  gravity.compute_force_and_torque( bodies[0], bodies[0].get_velocity(), bodies[0].get_spin(), force, torque );
+  expected += force;
+  damping.compute_force_and_torque( bodies[0], bodies[0].get_velocity(), bodies[0].get_spin(), force, torque );
+  expected += force;
+
+  BOOST_CHECK_EQUAL( h(0)(0), expected(0) );
+  BOOST_CHECK_EQUAL( h(0)(1), expected(1) );
+  BOOST_CHECK_EQUAL( h(0)(2), expected(2) );
+
+  expected = vector3_type::zero();
+
+  gravity.compute_force_and_torque( bodies[3], bodies[3].get_velocity(), bodies[3].get_spin(), force, torque );
+  expected += force;
+  damping.compute_force_and_torque( bodies[3], bodies[3].get_velocity(), bodies[3].get_spin(), force, torque );
+  expected += force;
+  pin.compute_force_and_torque( bodies[3], bodies[3].get_velocity(), bodies[3].get_spin(), force, torque );
+  expected += force;
+
+  BOOST_CHECK_EQUAL( h(3)(0), expected(0) );
+  BOOST_CHECK_EQUAL( h(3)(1), expected(1) );
+  BOOST_CHECK_EQUAL( h(3)(2), expected(2) );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
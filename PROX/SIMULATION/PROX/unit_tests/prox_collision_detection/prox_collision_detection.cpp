@@ -0,0 +1,152 @@
+#include <sparse.h>
+
+#include <narrow.h>
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+#include <prox_update_body_indices.h>
+#include <prox_collision_detection.h>
+#include <prox_compute_structure_map_constant.h>
+
+#include <prox_math_policy.h>
+
+#include <util_thread_pool.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::tiny_types      tiny_types;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector3_type    vector3_type;
+
+typedef prox::RigidBody< math_policy >    body_type;
+typedef prox::ContactPoint< math_policy > contact_type;
+typedef narrow::Geometry< tiny_types >    geometry_type;
+
+
+size_t make_box_geometry( narrow::System< tiny_types > & narrow_system, bool const & analytic )
+{
+  size_t const gid = narrow_system.create_geometry();
+
+  geometry_type & geometry = narrow_system.get_geometry( gid );
+
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<real_type,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<real_type,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<real_type,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<tiny_types>( 2.0f, 2.0f, 2.0f, surface, sX, sY, sZ);
+
+  mesh_array::T4Mesh mesh;
+  mesh_array::VertexAttribute<real_type,mesh_array::T4Mesh> X;
+  mesh_array::VertexAttribute<real_type,mesh_array::T4Mesh> Y;
+  mesh_array::VertexAttribute<real_type,mesh_array::T4Mesh> Z;
+
+  mesh_array::tetgen(surface, sX, sY, sZ, mesh, X, Y, Z);
+
+  geometry.set_shape( mesh, X, Y, Z );
+
+  if( analytic )
+    geometry.set_analytic_box( vector3_type::make( 1.0, 1.0, 1.0) );
+
+  mesh_array::VertexAttribute<vector3_type,mesh_array::T4Mesh> structure_map;
+
+  prox::compute_structure_map_constant<tiny_types>(
+                                                   geometry.m_mesh
+                                                   , geometry.m_X0
+                                                   , geometry.m_Y0
+                                                   , geometry.m_Z0
+                                                   , vector3_type::make( 1.0, 0.0, 0.0)
+                                                   , structure_map
+                                                   );
+
+  geometry.add_structure_map( structure_map );
+
+  return gid;
+}
+
+
+void collide(
+             narrow::System< tiny_types > & narrow_system
+             , std::vector< body_type > & bodies
+             , size_t const & threads
+             , std::vector< contact_type > & contacts
+             )
+{
+  broad::System< real_type >   broad_system;
+  prox::Params< math_policy >  params;
+
+  util::ThreadPool::get_instance().resize( threads );
+
+  prox::collision_detection( bodies, broad_system, narrow_system, contacts, params, math_policy() );
+
+  util::ThreadPool::get_instance().resize( 1u );
+}
+
+
+BOOST_AUTO_TEST_SUITE(collision_detection);
+
+BOOST_AUTO_TEST_CASE(serial_parallel_order_test)
+{
+  narrow::System< tiny_types > narrow_system;
+
+  narrow_system.params().set_rigid_traversal( true );
+  narrow_system.params().set_analytic_shapes( true );
+
+  size_t const mesh_gid     = make_box_geometry( narrow_system, false );
+  size_t const analytic_gid = make_box_geometry( narrow_system, true  );
+
+  // A slightly overlapping row of boxes on a fixed floor. The pattern of
+  // geometries mixes analytic pairs with mesh pairs all along the row.
+  size_t const N = 12u;
+
+  std::vector< body_type > bodies;
+  bodies.resize( N + 1u );
+
+  for(size_t k = 0u; k <= N; ++k)
+  {
+    size_t const gid = ( k % 3u == 0u ) ? mesh_gid : analytic_gid;
+
+    bodies[k].set_geometry_idx( gid );
+    bodies[k].set_structure_map_idx( 0u );
+
+    if( k < N )
+      bodies[k].set_position( vector3_type::make( 1.9f*k, 1.9f, 0.0f) );
+    else
+      bodies[k].set_fixed( true );
+
+    narrow::make_kdop_bvh( narrow_system.params(), bodies[k], narrow_system.get_geometry( gid ) );
+  }
+
+  prox::detail::update_body_indices( bodies.begin(), bodies.end() );
+
+  std::vector< contact_type > serial;
+  std::vector< contact_type > parallel;
+
+  collide( narrow_system, bodies, 1u, serial );
+  collide( narrow_system, bodies, 4u, parallel );
+
+  BOOST_CHECK( serial.size() > 0u );
+  BOOST_REQUIRE_EQUAL( serial.size(), parallel.size() );
+
+  for(size_t k = 0u; k < serial.size(); ++k)
+  {
+    BOOST_CHECK( serial[k].get_body_i() == parallel[k].get_body_i() );
+    BOOST_CHECK( serial[k].get_body_j() == parallel[k].get_body_j() );
+    BOOST_CHECK_EQUAL( serial[k].get_feature_i(), parallel[k].get_feature_i() );
+    BOOST_CHECK_EQUAL( serial[k].get_feature_j(), parallel[k].get_feature_j() );
+    BOOST_CHECK_EQUAL( serial[k].get_feature(),   parallel[k].get_feature()   );
+    BOOST_CHECK_EQUAL( serial[k].get_depth(),     parallel[k].get_depth()     );
+
+    for(size_t i = 0u; i < 3u; ++i)
+    {
+      BOOST_CHECK_EQUAL( serial[k].get_position()(i), parallel[k].get_position()(i) );
+      BOOST_CHECK_EQUAL( serial[k].get_normal()(i),   parallel[k].get_normal()(i)   );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
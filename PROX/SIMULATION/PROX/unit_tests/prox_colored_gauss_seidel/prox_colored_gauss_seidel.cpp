@@ -0,0 +1,265 @@
+#include <sparse.h>
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+#include <prox_get_velocity_vector.h>
+#include <prox_get_inverse_mass_matrix.h>
+#include <prox_get_jacobian_matrix.h>
+#include <prox_get_friction_coefficient_vector.h>
+#include <prox_update_body_indices.h>
+
+#include <solvers/prox_bind_solver.h>
+#include <solvers/prox_colored_gauss_seidel_solver.h>
+#include <solvers/sub/prox_bind_normal_sub_solver.h>
+#include <solvers/sub/prox_bind_friction_sub_solver.h>
+#include <solvers/strategies/prox_bind_R_strategy.h>
+
+#include <prox_math_policy.h>
+
+#include <prox_test_scene.h>
+
+#include <util_thread_pool.h>
+
+#include <algorithm>  // needed for std::max
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector3_type    vector3_type;
+typedef math_policy::vector4_type    vector4_type;
+typedef math_policy::vector6_type    vector6_type;
+typedef math_policy::diagonal6x6_type     diagonal6x6_type;
+typedef math_policy::compressed4x6_type   compressed4x6_type;
+typedef math_policy::compressed6x4_type   compressed6x4_type;
+
+typedef prox::RigidBody< math_policy >       body_type;
+typedef prox::ContactPoint< math_policy >    contact_type;
+typedef prox::MatchStickModel< math_policy > model_type;
+
+
+size_t const N = 20u;   // Number of boxes in the row
+
+// Body 0 is the fixed ground and bodies 1 to N form a row of boxes resting
+// on the ground. Each box has two ground contacts and touches its right
+// neighbour. The row is long enough that a color holds more contacts than
+// the colored solver puts in a single task.
+void make_scene( std::vector< body_type > & bodies, std::vector< contact_type > & contacts )
+{
+  bodies.resize( N + 1u );
+
+  bodies[0].set_fixed( true );
+
+  for(size_t k = 1u; k <= N; ++k)
+    bodies[k].set_velocity( vector3_type::make( 0.1f*(k % 3u), -1.0f - 0.1f*k, 0.05f*(k % 2u) ) );
+
+  prox::detail::update_body_indices( bodies.begin(), bodies.end() );
+
+  contacts.clear();
+
+  for(size_t k = 1u; k <= N; ++k)
+  {
+    real_type const x = 2.0f*k;
+
+    contacts.push_back( prox_test::make_contact( bodies[0], bodies[k], vector3_type::make( x - 0.5f, 0.0, 0.0) ) );
+    contacts.push_back( prox_test::make_contact( bodies[0], bodies[k], vector3_type::make( x + 0.5f, 0.0, 0.0) ) );
+
+    if( k < N )
+      contacts.push_back( prox_test::make_contact( bodies[k], bodies[k+1u], vector3_type::make( x + 1.0f, 0.5, 0.0) ) );
+  }
+}
+
+void make_jacobian(
+                   std::vector< body_type > & bodies
+                   , std::vector< contact_type > & contacts
+                   , compressed4x6_type & J
+                   , compressed6x4_type & WJT
+                   , vector4_type & b
+                   , vector4_type & mu
+                   )
+{
+  size_t const K = contacts.size();
+
+  std::vector< std::vector< model_type > > models( 1u, std::vector< model_type >( 1u ) );
+
+  vector6_type       u;
+  diagonal6x6_type   W;
+
+  prox::get_velocity_vector( bodies.begin(), bodies.end(), u, math_policy() );
+  prox::get_inverse_mass_matrix( bodies.begin(), bodies.end(), W, math_policy() );
+  prox::get_jacobian_matrix< body_type >( contacts.begin(), contacts.end(), bodies, models, J, math_policy(), K );
+  prox::get_friction_coefficient_vector( contacts.begin(), contacts.end(), models, mu, math_policy(), K );
+
+  math_policy::compute_WJT( W, J, WJT );
+
+  sparse::prod( J, u, b );
+}
+
+void make_problem(
+                  std::vector< body_type > & bodies
+                  , std::vector< contact_type > & contacts
+                  , compressed4x6_type & J
+                  , compressed6x4_type & WJT
+                  , vector4_type & b
+                  , vector4_type & mu
+                  )
+{
+  make_scene( bodies, contacts );
+  make_jacobian( bodies, contacts, J, WJT, b, mu );
+}
+
+
+BOOST_AUTO_TEST_SUITE(colored_gauss_seidel);
+
+BOOST_AUTO_TEST_CASE(compute_contact_colors_test)
+{
+  std::vector< body_type >    bodies;
+  std::vector< contact_type > contacts;
+  compressed4x6_type          J;
+  compressed6x4_type          WJT;
+  vector4_type                b;
+  vector4_type                mu;
+
+  make_problem( bodies, contacts, J, WJT, b, mu );
+
+  std::vector<bool> dynamic;
+
+  prox::detail::get_dynamic_columns<math_policy>( WJT, dynamic );
+
+  BOOST_CHECK_EQUAL( dynamic.size(), N + 1u );
+  BOOST_CHECK( !dynamic[0] );
+  for(size_t j = 1u; j <= N; ++j)
+    BOOST_CHECK( dynamic[j] );
+
+  std::vector< std::vector<size_t> > colors;
+
+  prox::detail::compute_contact_colors<math_policy>( J, dynamic, colors );
+
+  // The two ground contacts of a box and the contacts with its neighbours
+  // conflict, the fixed ground does not make contacts conflict
+  BOOST_CHECK( colors.size() >= 3u );
+
+  size_t largest = 0u;
+  std::vector<size_t> hits( contacts.size(), 0u );
+
+  for(size_t c = 0u; c < colors.size(); ++c)
+  {
+    largest = std::max( largest, colors[c].size() );
+
+    for(size_t i = 0u; i < colors[c].size(); ++i)
+      ++hits[ colors[c][i] ];
+  }
+
+  // At least one color is split over several tasks
+  BOOST_CHECK( largest > 16u );
+
+  // Every contact has exactly one color
+  for(size_t k = 0u; k < contacts.size(); ++k)
+    BOOST_CHECK_EQUAL( hits[k], 1u );
+
+  // No two contacts of a color may share a dynamic body
+  for(size_t c = 0u; c < colors.size(); ++c)
+  {
+    std::vector<bool> seen( N + 1u, false );
+
+    for(size_t i = 0u; i < colors[c].size(); ++i)
+    {
+      size_t const k = colors[c][i];
+
+      for(size_t idx = J.row_idx(k); idx < J.row_idx(k+1u); ++idx)
+      {
+        size_t const j = J.col_of_idx(idx);
+
+        if( !dynamic[j] )
+          continue;
+
+        BOOST_CHECK( !seen[j] );
+        seen[j] = true;
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(colored_gauss_seidel_solver_test)
+{
+  typedef real_type T;
+
+  std::vector< body_type >    bodies;
+  std::vector< contact_type > contacts;
+  compressed4x6_type          J;
+  compressed6x4_type          WJT;
+  vector4_type                b;
+  vector4_type                mu;
+
+  make_problem( bodies, contacts, J, WJT, b, mu );
+
+  size_t const K = contacts.size();
+
+  // The colored solver must visit the contacts exactly like the sequential
+  // solver does when the contacts are sorted by color
+  std::vector<bool>                  dynamic;
+  std::vector< std::vector<size_t> > colors;
+  std::vector<size_t>                order;
+
+  prox::detail::get_dynamic_columns<math_policy>( WJT, dynamic );
+  prox::detail::compute_contact_colors<math_policy>( J, dynamic, colors );
+
+  for(size_t c = 0u; c < colors.size(); ++c)
+    order.insert( order.end(), colors[c].begin(), colors[c].end() );
+
+  BOOST_REQUIRE_EQUAL( order.size(), K );
+
+  std::vector< contact_type > sorted_contacts;
+  compressed4x6_type          sorted_J;
+  compressed6x4_type          sorted_WJT;
+  vector4_type                sorted_b;
+  vector4_type                sorted_mu;
+
+  for(size_t i = 0u; i < K; ++i)
+    sorted_contacts.push_back( contacts[ order[i] ] );
+
+  make_jacobian( bodies, sorted_contacts, sorted_J, sorted_WJT, sorted_b, sorted_mu );
+
+  prox::SolverParams< math_policy > params;
+
+  params.set_profiling( false );
+  params.set_absolute_tolerance( 1e-6f );
+
+  prox::SolverBinder< math_policy >              solver          = prox::bind_solver< math_policy >( prox::gauss_seidel, prox::nonnegative, prox::analytical_sphere );
+  prox::SolverBinder< math_policy >              colored_solver  = prox::bind_solver< math_policy >( prox::colored_gauss_seidel, prox::nonnegative, prox::analytical_sphere );
+  prox::RStrategyBinder< math_policy >           strategy        = prox::bind_strategy< math_policy >( prox::local_strategy );
+
+  util::ThreadPool::get_instance().resize( 2u );
+
+  vector4_type sorted_lambda;
+  vector4_type colored_lambda;
+  vector4_type serial_lambda;
+
+  solver( sorted_J, sorted_WJT, sorted_b, sorted_mu, sorted_lambda, strategy, params, math_policy() );
+
+  colored_solver( J, WJT, b, mu, colored_lambda, strategy, params, math_policy() );
+
+  params.set_use_thread_pool( false );
+
+  colored_solver( J, WJT, b, mu, serial_lambda, strategy, params, math_policy() );
+
+  util::ThreadPool::get_instance().resize( 1u );
+
+  BOOST_CHECK_EQUAL( colored_lambda.size(), K );
+  BOOST_CHECK( math_policy::compute_norm_inf( sorted_lambda ) > 0.0f );
+
+  for(size_t i = 0u; i < K; ++i)
+  {
+    for(size_t j = 0u; j < 4u; ++j)
+    {
+      BOOST_CHECK_SMALL( sorted_lambda(i)(j) - colored_lambda(order[i])(j), 1e-6f );
+      BOOST_CHECK_EQUAL( serial_lambda(order[i])(j), colored_lambda(order[i])(j) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
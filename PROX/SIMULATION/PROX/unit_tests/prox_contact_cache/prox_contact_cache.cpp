@@ -0,0 +1,139 @@
+#include <sparse.h>
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+#include <prox_contact_cache.h>
+#include <prox_update_body_indices.h>
+
+#include <prox_math_policy.h>
+
+#include <prox_test_scene.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector3_type    vector3_type;
+typedef math_policy::vector4_type    vector4_type;
+typedef math_policy::block4x1_type   block4x1_type;
+
+typedef prox::RigidBody< math_policy >    body_type;
+typedef prox::ContactPoint< math_policy > contact_type;
+
+
+using prox_test::make_contact;
+
+
+BOOST_AUTO_TEST_SUITE(contact_cache);
+
+BOOST_AUTO_TEST_CASE(warm_start_test)
+{
+  std::vector< body_type > bodies;
+  bodies.resize( 3u );
+
+  bodies[0].set_fixed( true );
+  bodies[1].set_position( vector3_type::make( 0.0, 1.0, 0.0) );
+  bodies[2].set_position( vector3_type::make( 3.0, 1.0, 0.0) );
+
+  prox::detail::update_body_indices( bodies.begin(), bodies.end() );
+
+  //--- Contacts of the last time step with their solved impulses -----------
+  std::vector< contact_type > contacts;
+  contacts.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.0, 0.5, 0.0), 7u, 3u, 0u ) );
+  contacts.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.5, 0.5, 0.0), 7u, 3u, 1u ) );
+  contacts.push_back( make_contact( bodies[0], bodies[2], vector3_type::make( 3.0, 0.5, 0.0), 2u, 5u, 0u ) );
+
+  vector4_type lambda;
+  lambda.resize( 3u );
+
+  for(size_t k = 0u; k < 3u; ++k)
+  {
+    lambda( k ) = block4x1_type( 0.0f );
+    lambda( k )( 0 ) = 1.0f + k;
+    lambda( k )( 1 ) = 0.5f;
+  }
+
+  prox::detail::set_contact_impulses( lambda, contacts );
+
+  prox::ContactCache< math_policy > cache;
+
+  cache.store( contacts );
+
+  BOOST_CHECK_EQUAL( cache.size(), 3u );
+
+  //--- New contacts come out of collision detection in another order -------
+  std::vector< contact_type > current;
+  current.push_back( make_contact( bodies[0], bodies[2], vector3_type::make( 3.0, 0.5, 0.0),   2u, 5u, 0u ) );
+  current.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.5, 0.5, 0.0),   7u, 3u, 1u ) );
+  current.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.0, 0.5, 0.0),   7u, 4u, 0u ) );   // New feature pair
+  current.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.0, 0.5, 0.0),   7u, 3u, 0u ) );
+
+  vector4_type seed;
+
+  size_t const matches = cache.warm_start( current, 0.01f, seed );
+
+  BOOST_CHECK_EQUAL( matches, 3u );
+  BOOST_CHECK_EQUAL( seed.size(), 4u );
+
+  BOOST_CHECK_EQUAL( seed(0)(0), 3.0f );
+  BOOST_CHECK_EQUAL( seed(1)(0), 2.0f );
+  BOOST_CHECK_EQUAL( seed(2)(0), 0.0f );
+  BOOST_CHECK_EQUAL( seed(2)(1), 0.0f );
+  BOOST_CHECK_EQUAL( seed(3)(0), 1.0f );
+  BOOST_CHECK_EQUAL( seed(3)(1), 0.5f );
+
+  //--- Positions are compared in the frame of body i, so moving both ------
+  //--- bodies together keeps the match while sliding a contact breaks it ---
+  bodies[0].set_position( vector3_type::make( 0.0, 0.0, 10.0) );
+
+  current.clear();
+  current.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.0, 0.5, 10.0), 7u, 3u, 0u ) );
+  current.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.5, 0.5, 0.0),  7u, 3u, 1u ) );
+
+  BOOST_CHECK_EQUAL( cache.warm_start( current, 0.01f, seed ), 1u );
+  BOOST_CHECK_EQUAL( seed(0)(0), 1.0f );
+  BOOST_CHECK_EQUAL( seed(1)(0), 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE(generation_pose_test)
+{
+  std::vector< body_type > bodies;
+  bodies.resize( 2u );
+
+  bodies[0].set_position( vector3_type::make( 0.0, 0.0, 0.0) );
+  bodies[1].set_position( vector3_type::make( 0.0, 1.0, 0.0) );
+
+  prox::detail::update_body_indices( bodies.begin(), bodies.end() );
+
+  std::vector< contact_type > contacts;
+  contacts.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 0.0, 0.5, 0.0), 1u, 2u, 0u ) );
+
+  vector4_type lambda;
+  lambda.resize( 1u );
+  lambda( 0 ) = block4x1_type( 0.0f );
+  lambda( 0 )( 0 ) = 4.0f;
+
+  prox::detail::set_contact_impulses( lambda, contacts );
+
+  //--- The position update moves the bodies after the impulses are set, ----
+  //--- the cache must still use the pose the contacts were generated at ----
+  bodies[0].set_position( vector3_type::make( 2.0, 0.0, 0.0) );
+  bodies[1].set_position( vector3_type::make( 2.0, 1.0, 0.0) );
+
+  prox::ContactCache< math_policy > cache;
+
+  cache.store( contacts );
+
+  std::vector< contact_type > current;
+  current.push_back( make_contact( bodies[0], bodies[1], vector3_type::make( 2.0, 0.5, 0.0), 1u, 2u, 0u ) );
+
+  vector4_type seed;
+
+  BOOST_CHECK_EQUAL( cache.warm_start( current, 0.01f, seed ), 1u );
+  BOOST_CHECK_EQUAL( seed(0)(0), 4.0f );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
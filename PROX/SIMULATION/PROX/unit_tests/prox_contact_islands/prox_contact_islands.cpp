@@ -0,0 +1,150 @@
+#include <sparse.h>
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+#include <prox_contact_islands.h>
+#include <prox_get_velocity_vector.h>
+#include <prox_get_inverse_mass_matrix.h>
+#include <prox_get_jacobian_matrix.h>
+#include <prox_get_friction_coefficient_vector.h>
+#include <prox_update_body_indices.h>
+
+#include <solvers/prox_bind_solver.h>
+#include <solvers/prox_island_solver.h>
+#include <solvers/sub/prox_bind_normal_sub_solver.h>
+#include <solvers/sub/prox_bind_friction_sub_solver.h>
+#include <solvers/strategies/prox_bind_R_strategy.h>
+
+#include <prox_math_policy.h>
+
+#include <prox_test_scene.h>
+
+#include <util_thread_pool.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector3_type    vector3_type;
+typedef math_policy::vector4_type    vector4_type;
+typedef math_policy::vector6_type    vector6_type;
+typedef math_policy::diagonal6x6_type     diagonal6x6_type;
+typedef math_policy::compressed4x6_type   compressed4x6_type;
+typedef math_policy::compressed6x4_type   compressed6x4_type;
+
+typedef prox::RigidBody< math_policy >       body_type;
+typedef prox::ContactPoint< math_policy >    contact_type;
+typedef prox::MatchStickModel< math_policy > model_type;
+
+
+BOOST_AUTO_TEST_SUITE(contact_islands);
+
+BOOST_AUTO_TEST_CASE(compute_contact_islands_test)
+{
+  std::vector< body_type >    bodies;
+  std::vector< contact_type > contacts;
+
+  prox_test::make_island_scene( bodies, contacts );
+
+  std::vector< prox::ContactIsland > islands;
+
+  prox::detail::compute_contact_islands( bodies, contacts, islands );
+
+  // The fixed ground must not join the two islands
+  BOOST_CHECK_EQUAL( islands.size(), 2u );
+
+  BOOST_CHECK_EQUAL( islands[0].m_contacts.size(), 3u );
+  BOOST_CHECK_EQUAL( islands[0].m_contacts[0], 0u );
+  BOOST_CHECK_EQUAL( islands[0].m_contacts[1], 2u );
+  BOOST_CHECK_EQUAL( islands[0].m_contacts[2], 3u );
+  BOOST_CHECK_EQUAL( islands[0].m_bodies.size(), 2u );
+  BOOST_CHECK_EQUAL( islands[0].m_bodies[0], 2u );
+  BOOST_CHECK_EQUAL( islands[0].m_bodies[1], 3u );
+
+  BOOST_CHECK_EQUAL( islands[1].m_contacts.size(), 1u );
+  BOOST_CHECK_EQUAL( islands[1].m_contacts[0], 1u );
+  BOOST_CHECK_EQUAL( islands[1].m_bodies.size(), 1u );
+  BOOST_CHECK_EQUAL( islands[1].m_bodies[0], 1u );
+
+  // Sleeping bodies behave like fixed bodies, contacts between the ground
+  // and the sleeping body are resting and must have been removed.
+  bodies[2].set_sleeping( true );
+
+  std::vector< contact_type > awake;
+  awake.push_back( contacts[1] );
+  awake.push_back( contacts[2] );
+
+  prox::detail::compute_contact_islands( bodies, awake, islands );
+
+  BOOST_CHECK_EQUAL( islands.size(), 2u );
+  BOOST_CHECK_EQUAL( islands[0].m_contacts.size(), 1u );
+  BOOST_CHECK_EQUAL( islands[0].m_contacts[0], 0u );
+  BOOST_CHECK_EQUAL( islands[1].m_contacts.size(), 1u );
+  BOOST_CHECK_EQUAL( islands[1].m_contacts[0], 1u );
+  BOOST_CHECK_EQUAL( islands[1].m_bodies.size(), 1u );
+  BOOST_CHECK_EQUAL( islands[1].m_bodies[0], 3u );
+}
+
+BOOST_AUTO_TEST_CASE(island_solver_test)
+{
+  typedef real_type T;
+
+  std::vector< body_type >    bodies;
+  std::vector< contact_type > contacts;
+
+  prox_test::make_island_scene( bodies, contacts );
+
+  size_t const K = contacts.size();
+
+  std::vector< std::vector< model_type > > models( 1u, std::vector< model_type >( 1u ) );
+
+  vector6_type       u;
+  diagonal6x6_type   W;
+  compressed4x6_type J;
+  compressed6x4_type WJT;
+  vector4_type       mu;
+  vector4_type       b;
+
+  prox::get_velocity_vector( bodies.begin(), bodies.end(), u, math_policy() );
+  prox::get_inverse_mass_matrix( bodies.begin(), bodies.end(), W, math_policy() );
+  prox::get_jacobian_matrix< body_type >( contacts.begin(), contacts.end(), bodies, models, J, math_policy(), K );
+  prox::get_friction_coefficient_vector( contacts.begin(), contacts.end(), models, mu, math_policy(), K );
+
+  math_policy::compute_WJT( W, J, WJT );
+
+  sparse::prod( J, u, b );
+
+  prox::SolverParams< math_policy > params;
+
+  params.set_profiling( false );
+  params.set_absolute_tolerance( 1e-6f );
+
+  prox::SolverBinder< math_policy >              solver          = prox::bind_solver< math_policy >( prox::gauss_seidel, prox::nonnegative, prox::analytical_sphere );
+  prox::RStrategyBinder< math_policy >           strategy        = prox::bind_strategy< math_policy >( prox::local_strategy );
+
+  std::vector< prox::ContactIsland > islands;
+
+  prox::detail::compute_contact_islands( bodies, contacts, islands );
+
+  util::ThreadPool pool(2u);
+
+  vector4_type global_lambda;
+  vector4_type island_lambda;
+
+  solver( J, WJT, b, mu, global_lambda, strategy, params, math_policy() );
+
+  prox::island_solver( islands, J, W, WJT, b, mu, island_lambda, solver, strategy, params, pool, math_policy() );
+
+  BOOST_CHECK_EQUAL( island_lambda.size(), K );
+  BOOST_CHECK( math_policy::compute_norm_inf( global_lambda ) > 0.0f );
+
+  for(size_t k = 0u; k < K; ++k)
+    for(size_t j = 0u; j < 4u; ++j)
+      BOOST_CHECK_SMALL( global_lambda(k)(j) - island_lambda(k)(j), 1e-4f );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,130 @@
+#include <sparse.h>
+
+#include <prox_position_update.h>
+#include <prox_velocity_update.h>
+
+#include <prox_math_policy.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include <cstdlib>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector6_type    vector6_type;
+typedef math_policy::vector7_type    vector7_type;
+
+namespace
+{
+
+  real_type random_value(real_type const & lower, real_type const & upper)
+  {
+    return lower + (upper - lower)*( static_cast<real_type>( std::rand() ) / static_cast<real_type>( RAND_MAX ) );
+  }
+
+  // Enough bodies to fill several lanes and leave a remainder for the scalar loop
+  size_t const N = 37u;
+
+  void make_state( vector7_type & q, vector6_type & u )
+  {
+    std::srand(42);
+
+    q.resize( N );
+    u.resize( N );
+
+    for(size_t i = 0u; i < N; ++i)
+    {
+      for(size_t j = 0u; j < 7u; ++j)
+        q(i)(j) = random_value( -1.0f, 1.0f );
+
+      for(size_t j = 0u; j < 6u; ++j)
+        u(i)(j) = random_value( -10.0f, 10.0f );
+    }
+
+    // Bodies that do not spin take a different path through the kernel
+    for(size_t j = 0u; j < 6u; ++j)
+    {
+      u(3)(j) = 0.0f;
+      u(N-1)(j) = 0.0f;
+    }
+    u(5)(3) = 0.0f;
+    u(5)(4) = 0.0f;
+    u(5)(5) = 0.0f;
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE(integration_kernels);
+
+BOOST_AUTO_TEST_CASE(position_update_test)
+{
+  vector7_type q;
+  vector6_type u;
+
+  make_state(q, u);
+
+  real_type const dt = 0.01f;
+
+  vector7_type qnew;
+
+  prox::position_update( q, u, dt, qnew, math_policy() );
+
+  BOOST_CHECK_EQUAL( qnew.size(), N );
+
+  for(size_t i = 0u; i < N; ++i)
+  {
+    math_policy::block7x1_type expected;
+
+    prox::detail::position_update_block( q(i), u(i), dt, expected, math_policy() );
+
+    for(size_t j = 0u; j < 7u; ++j)
+      BOOST_CHECK_EQUAL( qnew(i)(j), expected(j) );
+  }
+
+  // Updating in place must give the same result
+  prox::position_update( q, u, dt, q, math_policy() );
+
+  for(size_t i = 0u; i < N; ++i)
+    for(size_t j = 0u; j < 7u; ++j)
+      BOOST_CHECK_EQUAL( q(i)(j), qnew(i)(j) );
+}
+
+BOOST_AUTO_TEST_CASE(velocity_update_test)
+{
+  vector7_type q;
+  vector6_type u;
+  vector6_type Wdth;
+  vector6_type fc;
+
+  make_state(q, Wdth);
+  make_state(q, fc);
+  make_state(q, u);
+
+  for(size_t i = 0u; i < N; ++i)
+    for(size_t j = 0u; j < 6u; ++j)
+    {
+      Wdth(i)(j) *= 0.5f;
+      fc(i)(j)   *= 0.25f;
+    }
+
+  vector6_type unew;
+
+  prox::velocity_update( u, Wdth, fc, unew, math_policy() );
+
+  BOOST_CHECK_EQUAL( unew.size(), N );
+
+  for(size_t i = 0u; i < N; ++i)
+    for(size_t j = 0u; j < 6u; ++j)
+      BOOST_CHECK_EQUAL( unew(i)(j), u(i)(j) + Wdth(i)(j) + fc(i)(j) );
+
+  prox::velocity_update( u, Wdth, unew, math_policy() );
+
+  for(size_t i = 0u; i < N; ++i)
+    for(size_t j = 0u; j < 6u; ++j)
+      BOOST_CHECK_EQUAL( unew(i)(j), u(i)(j) + Wdth(i)(j) );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
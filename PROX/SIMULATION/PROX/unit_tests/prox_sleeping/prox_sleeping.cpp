@@ -0,0 +1,264 @@
+#include <sparse.h>
+
+#include <narrow.h>
+
+#include <prox_rigid_body.h>
+#include <prox_body_store.h>
+#include <prox_contact_point.h>
+#include <prox_get_velocity_vector.h>
+#include <prox_update_body_indices.h>
+#include <prox_update_sleeping.h>
+#include <prox_collision_detection.h>
+#include <prox_compute_raycast.h>
+#include <prox_compute_structure_map_constant.h>
+
+#include <prox_math_policy.h>
+
+#include <prox_test_scene.h>
+
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/auto_unit_test.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <boost/test/test_tools.hpp>
+
+typedef prox::MathPolicy<float>      math_policy;
+typedef math_policy::tiny_types      tiny_types;
+typedef math_policy::real_type       real_type;
+typedef math_policy::vector3_type    vector3_type;
+typedef math_policy::vector6_type    vector6_type;
+
+typedef prox::RigidBody< math_policy >    body_type;
+typedef prox::ContactPoint< math_policy > contact_type;
+typedef narrow::Geometry< tiny_types >    geometry_type;
+
+
+contact_type make_contact( body_type const & A, body_type const & B )
+{
+  return prox_test::make_contact( A, B, vector3_type::make( 0.0, 0.0, 0.0) );
+}
+
+
+void make_box_geometry( geometry_type & geometry )
+{
+  mesh_array::T3Mesh surface;
+  mesh_array::VertexAttribute<real_type,mesh_array::T3Mesh> sX;
+  mesh_array::VertexAttribute<real_type,mesh_array::T3Mesh> sY;
+  mesh_array::VertexAttribute<real_type,mesh_array::T3Mesh> sZ;
+
+  mesh_array::make_box<tiny_types>( 2.0f, 2.0f, 2.0f, surface, sX, sY, sZ);
+
+  mesh_array::T4Mesh mesh;
+  mesh_array::VertexAttribute<real_type,mesh_array::T4Mesh> X;
+  mesh_array::VertexAttribute<real_type,mesh_array::T4Mesh> Y;
+  mesh_array::VertexAttribute<real_type,mesh_array::T4Mesh> Z;
+
+  mesh_array::tetgen(surface, sX, sY, sZ, mesh, X, Y, Z);
+
+  geometry.set_shape( mesh, X, Y, Z );
+}
+
+
+BOOST_AUTO_TEST_SUITE(sleeping);
+
+BOOST_AUTO_TEST_CASE(sleep_and_wake_islands_test)
+{
+  prox::StepperParams< math_policy > params;
+
+  params.set_sleeping( true );
+  params.set_sleep_steps( 3u );
+
+  // Bodies 0 and 1 form a resting stack on the fixed body 3 and body 2 is
+  // moving on its own. Body 4 rests on the fixed body only.
+  std::vector< body_type > bodies;
+  bodies.resize( 5u );
+
+  bodies[0].set_velocity( vector3_type::make( 0.0, 0.01, 0.0) );
+  bodies[1].set_velocity( vector3_type::make( 0.0, 0.01, 0.0) );
+  bodies[2].set_velocity( vector3_type::make( 1.0, 0.0,  0.0) );
+  bodies[3].set_fixed( true );
+
+  prox::BodyStore< math_policy > store;
+
+  for(size_t k = 0u; k < bodies.size(); ++k)
+    store.add_body();
+
+  prox::sync_body_store( bodies.begin(), bodies.end(), store, math_policy() );
+
+  std::vector< contact_type > contacts;
+  contacts.push_back( make_contact( bodies[0], bodies[1] ) );
+  contacts.push_back( make_contact( bodies[3], bodies[0] ) );
+  contacts.push_back( make_contact( bodies[3], bodies[4] ) );
+
+  for(size_t step = 0u; step < 2u; ++step)
+    prox::detail::sleep_islands( bodies, store, contacts, params );
+
+  for(size_t k = 0u; k < bodies.size(); ++k)
+    BOOST_CHECK( !bodies[k].is_sleeping() );
+
+  prox::detail::sleep_islands( bodies, store, contacts, params );
+
+  BOOST_CHECK(  bodies[0].is_sleeping() );
+  BOOST_CHECK(  bodies[1].is_sleeping() );
+  BOOST_CHECK( !bodies[2].is_sleeping() );
+  BOOST_CHECK( !bodies[3].is_sleeping() );
+  BOOST_CHECK(  bodies[4].is_sleeping() );
+
+  // The stack is one island, the fixed body must not join it with body 4
+  BOOST_CHECK_EQUAL( bodies[0].get_island_idx(), bodies[1].get_island_idx() );
+  BOOST_CHECK( bodies[0].get_island_idx() != bodies[4].get_island_idx() );
+
+  BOOST_CHECK( bodies[0].needs_sleep_refit() );
+  BOOST_CHECK_EQUAL( bodies[0].get_velocity()(1), 0.0 );
+  BOOST_CHECK_EQUAL( store.m_u(0)(1), 0.0 );
+  BOOST_CHECK( !store.is_active(0) );
+  BOOST_CHECK(  store.is_active(2) );
+
+  // Sleeping bodies are excluded from the velocity vector
+  bodies[1].set_velocity( vector3_type::make( 0.0, 5.0, 0.0) );
+
+  vector6_type u;
+
+  prox::get_velocity_vector( bodies.begin(), bodies.end(), u, math_policy() );
+
+  BOOST_CHECK_EQUAL( u(1)(1), 0.0 );
+  BOOST_CHECK_EQUAL( u(2)(0), 1.0 );
+
+  // Contacts with the fixed body and among sleeping bodies are resting
+  std::vector< contact_type > resting = contacts;
+
+  prox::detail::remove_resting_contacts( resting );
+
+  BOOST_CHECK( resting.empty() );
+
+  // The fixed body does not wake anything
+  BOOST_CHECK( !prox::detail::wake_islands( bodies, store, contacts, params ) );
+
+  // Body 2 hits the top of the stack which wakes the whole stack
+  contacts.push_back( make_contact( bodies[2], bodies[1] ) );
+
+  // Islands are left alone when sleeping is turned off
+  prox::StepperParams< math_policy > no_sleeping = params;
+
+  no_sleeping.set_sleeping( false );
+
+  BOOST_CHECK( !prox::detail::wake_islands( bodies, store, contacts, no_sleeping ) );
+  BOOST_CHECK( bodies[1].is_sleeping() );
+
+  BOOST_CHECK( prox::detail::wake_islands( bodies, store, contacts, params ) );
+
+  BOOST_CHECK( !bodies[0].is_sleeping() );
+  BOOST_CHECK( !bodies[1].is_sleeping() );
+  BOOST_CHECK(  bodies[4].is_sleeping() );
+
+  BOOST_CHECK(  store.is_active(0) );
+  BOOST_CHECK(  store.is_active(1) );
+  BOOST_CHECK( !store.is_active(4) );
+
+  BOOST_CHECK_EQUAL( bodies[0].get_sleep_counter(), 0u );
+
+  // Woken bodies must gather at least one full sleep period again
+  prox::detail::sleep_islands( bodies, store, contacts, params );
+
+  BOOST_CHECK( !bodies[0].is_sleeping() );
+}
+
+BOOST_AUTO_TEST_CASE(wake_island_test)
+{
+  std::vector< body_type > bodies;
+  bodies.resize( 3u );
+
+  bodies[0].set_sleeping( true, 2u );
+  bodies[1].set_sleeping( true, 1u );
+  bodies[2].set_sleeping( true, 2u );
+
+  prox::detail::wake_island( bodies, 2u );
+
+  BOOST_CHECK( !bodies[0].is_sleeping() );
+  BOOST_CHECK(  bodies[1].is_sleeping() );
+  BOOST_CHECK( !bodies[2].is_sleeping() );
+}
+
+BOOST_AUTO_TEST_CASE(raycast_sleeping_body_test)
+{
+  narrow::System< tiny_types > narrow_system;
+  broad::System< real_type >   broad_system;
+  prox::Params< math_policy >  params;
+
+  narrow_system.params().set_rigid_traversal( true );
+
+  size_t const gid = narrow_system.create_geometry();
+
+  make_box_geometry( narrow_system.get_geometry( gid ) );
+
+  // Body 0 sleeps and the awake body 1 rests on top of it
+  std::vector< body_type > bodies;
+  bodies.resize( 2u );
+
+  bodies[1].set_position( vector3_type::make( 0.0, 1.9, 0.0) );
+
+  geometry_type & geometry = narrow_system.get_geometry( gid );
+
+  mesh_array::VertexAttribute<vector3_type,mesh_array::T4Mesh> structure_map;
+
+  prox::compute_structure_map_constant<tiny_types>(
+                                                   geometry.m_mesh
+                                                   , geometry.m_X0
+                                                   , geometry.m_Y0
+                                                   , geometry.m_Z0
+                                                   , vector3_type::make( 1.0, 0.0, 0.0)
+                                                   , structure_map
+                                                   );
+
+  size_t const sid = geometry.add_structure_map( structure_map );
+
+  for(size_t k = 0u; k < bodies.size(); ++k)
+  {
+    bodies[k].set_geometry_idx( gid );
+    bodies[k].set_structure_map_idx( sid );
+
+    narrow::make_kdop_bvh( narrow_system.params(), bodies[k], geometry );
+  }
+
+  prox::detail::update_body_indices( bodies.begin(), bodies.end() );
+
+  bodies[0].set_sleeping( true );
+
+  std::vector< contact_type > contacts;
+
+  prox::collision_detection( bodies, broad_system, narrow_system, contacts, params, math_policy() );
+
+  size_t const N = contacts.size();
+
+  BOOST_CHECK( N > 0u );
+  BOOST_CHECK( !bodies[0].needs_sleep_refit() );
+  BOOST_CHECK(  bodies[0].m_body_frame_tree );
+
+  // The ray comes from below and hits the sleeping body first
+  size_t       body_index = 0u;
+  vector3_type point;
+  real_type    distance;
+
+  bool const hit = prox::compute_raycast(
+                                         geometry::make_ray( vector3_type::make( 0.0, -5.0, 0.0), vector3_type::make( 0.0, 1.0, 0.0) )
+                                         , bodies
+                                         , broad_system
+                                         , narrow_system
+                                         , body_index
+                                         , point
+                                         , distance
+                                         );
+
+  BOOST_CHECK( hit );
+  BOOST_CHECK_EQUAL( body_index, 0u );
+  BOOST_CHECK( !bodies[0].m_body_frame_tree );
+
+  // The still sleeping body must be brought back into its body frame
+  // before the rigid traversal visits it
+  prox::collision_detection( bodies, broad_system, narrow_system, contacts, params, math_policy() );
+
+  BOOST_CHECK( bodies[0].is_sleeping() );
+  BOOST_CHECK( bodies[0].m_body_frame_tree );
+  BOOST_CHECK_EQUAL( contacts.size(), N );
+}
+
+BOOST_AUTO_TEST_SUITE_END();
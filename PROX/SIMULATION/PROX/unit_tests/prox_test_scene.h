@@ -0,0 +1,94 @@
+#ifndef PROX_TEST_SCENE_H
+#define PROX_TEST_SCENE_H
+
+#include <prox_rigid_body.h>
+#include <prox_contact_point.h>
+#include <prox_update_body_indices.h>
+
+#include <vector>
+
+/**
+ * Scene builders shared by the unit tests. The contacts are made by hand
+ * so the tests do not depend on collision detection.
+ */
+namespace prox_test
+{
+
+  /**
+   * Make a contact between two bodies with an upward normal.
+   */
+  template<typename M>
+  inline prox::ContactPoint<M> make_contact(
+                                            prox::RigidBody<M> const & A
+                                            , prox::RigidBody<M> const & B
+                                            , typename M::vector3_type const & p
+                                            )
+  {
+    typedef typename M::vector3_type  V;
+    typedef typename M::value_traits  VT;
+
+    prox::ContactPoint<M> contact;
+
+    contact.set_body_i( &A );
+    contact.set_body_j( &B );
+    contact.set_position( p );
+    contact.set_normal( V::make( VT::zero(), VT::one(), VT::zero() ) );
+
+    return contact;
+  }
+
+  /**
+   * Make a contact between two bodies with an upward normal that was
+   * generated by the given features.
+   */
+  template<typename M>
+  inline prox::ContactPoint<M> make_contact(
+                                            prox::RigidBody<M> const & A
+                                            , prox::RigidBody<M> const & B
+                                            , typename M::vector3_type const & p
+                                            , size_t const & feature_i
+                                            , size_t const & feature_j
+                                            , size_t const & feature
+                                            )
+  {
+    prox::ContactPoint<M> contact = make_contact( A, B, p );
+
+    contact.set_features( feature_i, feature_j, feature );
+
+    return contact;
+  }
+
+  /**
+   * Make a scene with two contact islands. Body 0 is the fixed ground, body
+   * 1 rests on the ground, body 3 is stacked on top of body 2 which rests on
+   * the ground and body 4 is flying around.
+   */
+  template<typename M>
+  inline void make_island_scene(
+                                std::vector< prox::RigidBody<M> > & bodies
+                                , std::vector< prox::ContactPoint<M> > & contacts
+                                )
+  {
+    typedef typename M::vector3_type  V;
+
+    bodies.resize( 5u );
+
+    bodies[0].set_fixed( true );
+    bodies[1].set_velocity( V::make( 0.1, -1.0, 0.0) );
+    bodies[2].set_velocity( V::make( 0.0, -1.0, 0.2) );
+    bodies[3].set_velocity( V::make( 0.0, -2.0, 0.0) );
+    bodies[4].set_velocity( V::make( 0.0, -1.0, 0.0) );
+
+    prox::detail::update_body_indices( bodies.begin(), bodies.end() );
+
+    contacts.clear();
+    contacts.push_back( make_contact( bodies[0], bodies[2], V::make( 5.0, 0.0, 0.0) ) );
+    contacts.push_back( make_contact( bodies[0], bodies[1], V::make( 0.0, 0.0, 0.0) ) );
+    contacts.push_back( make_contact( bodies[2], bodies[3], V::make( 5.0, 1.0, 0.0) ) );
+    contacts.push_back( make_contact( bodies[0], bodies[2], V::make( 5.5, 0.0, 0.0) ) );
+  }
+
+}// namespace prox_test
+
+// PROX_TEST_SCENE_H
+#endif